@@ -345,11 +345,26 @@ static void SeeLogErrorObj(SEE_interpreter* interpr_, SEE_value* errorValue)
 }
 
 
-bool SjSee::Execute(const wxString& script__)
+static wxString NormaliseLineEnds(const wxString& script__)
 {
-	wxASSERT( !m_executionScope.IsEmpty() );
+	wxString script(script__);
+	if( script.Find(wxT("\r")) != -1 ) // no "\r" - otherwise, the line numbers get out of order
+	{
+		if( script.Find(wxT("\n")) != -1 )
+			script.Replace(wxT("\r"), wxT(" "));
+		else
+			script.Replace(wxT("\r"), wxT("\n"));
+	}
+	return script;
+}
+
+
+void SjSee::InitInterpreter()
+{
+	if( m_interprInitialized )
+		return;
 
-	// log the first execution, which also inits the See object, to the command line.
+	// log the first initialisation of a See object to the command line.
 	// (for debugging purposes, it is useful to know about whether any script is executed or not).
 	static bool s_scriptUsageLogged = false;
 	if( !s_scriptUsageLogged )
@@ -358,6 +373,36 @@ bool SjSee::Execute(const wxString& script__)
 		s_scriptUsageLogged = true;
 	}
 
+	// init some global function pointers
+	static bool SEE_system_initialized = false;
+	if( !SEE_system_initialized )
+	{
+		SEE_system.abort            = SjSee_abort;
+		SEE_system.malloc           = SjSee_malloc;
+		SEE_system.malloc_string    = SjSee_malloc_string;
+		SEE_system.malloc_finalize  = SjSee_malloc_finalize;
+		SEE_system.free             = SjSee_free;
+		SEE_system_initialized      = true;
+		SEE_system_add_my_strings   ();
+	}
+
+	// init the interpreter instance and our objects
+	SEE_interpreter_init(m_interpr);
+	Player_init();
+	Program_init();
+	Rights_init();
+	Dialog_init();
+	Database_init();
+	File_init();
+	HttpRequest_init();
+	m_interprInitialized = true;
+}
+
+
+bool SjSee::Execute(const wxString& script)
+{
+	wxASSERT( !m_executionScope.IsEmpty() );
+
 	// very first, do some garbarge collection (if needed)
 	// this must be done _before_ we create SjGcLocker
 	/*if( SjGcNeedsCleanup() )
@@ -369,32 +414,7 @@ bool SjSee::Execute(const wxString& script__)
 	SjGcLocker gclocker;
 
 	// init the interpreter, if not yet done
-	if( !m_interprInitialized )
-	{
-		// init some global function pointers
-		static bool SEE_system_initialized = false;
-		if( !SEE_system_initialized )
-		{
-			SEE_system.abort            = SjSee_abort;
-			SEE_system.malloc           = SjSee_malloc;
-			SEE_system.malloc_string    = SjSee_malloc_string;
-			SEE_system.malloc_finalize  = SjSee_malloc_finalize;
-			SEE_system.free             = SjSee_free;
-			SEE_system_initialized      = true;
-			SEE_system_add_my_strings   ();
-		}
-
-		// init the interpreter instance and our objects
-		SEE_interpreter_init(m_interpr);
-		Player_init();
-		Program_init();
-		Rights_init();
-		Dialog_init();
-		Database_init();
-		File_init();
-		HttpRequest_init();
-		m_interprInitialized = true;
-	}
+	InitInterpreter();
 
 	// do what to do
 	bool success = true;
@@ -403,17 +423,7 @@ bool SjSee::Execute(const wxString& script__)
 	SEE_try_context_t   tryContext;
 
 	/* Create an input stream that provides program text */
-	{
-		wxString script(script__);
-		if( script.Find(wxT("\r")) != -1 ) // no "\r" - otherwise, the line numbers get out of order
-		{
-			if( script.Find(wxT("\n")) != -1 )
-				script.Replace(wxT("\r"), wxT(" "));
-			else
-				script.Replace(wxT("\r"), wxT("\n"));
-		}
-		input = SEE_input_string(m_interpr, WxStringToSeeString(m_interpr, script));
-	}
+	input = SEE_input_string(m_interpr, WxStringToSeeString(m_interpr, NormaliseLineEnds(script)));
 
 	/* Establish an exception context */
 	SEE_TRY(m_interpr, tryContext)
@@ -441,19 +451,57 @@ bool SjSee::ExecuteAsFunction(const wxString& script)
 {
 	wxASSERT( !m_executionScope.IsEmpty() );
 
-	// add the function, if not yet done
-	// this is a little hack as long as we have no real DOM for the skinning tree
-	static long s_cnt = 29275837;
-	long l = m_dynFunc.Lookup(script);
-	if( l == 0 )
+	// this is a little hack as long as we have no real DOM for the skinning tree.
+	// the script is compiled to an anonymous function object only once; further calls
+	// (eg. for each click on a skin button) just call the function object and avoid
+	// running the script through the lexer and parser again.
+	SjGcLocker gclocker;
+
+	InitInterpreter();
+
+	bool                success = true;
+	SEE_try_context_t   tryContext;
+	SEE_object*         fnObj = (SEE_object*)m_dynFunc.Lookup(script);
+	if( fnObj == NULL )
 	{
-		l = s_cnt++;
-		wxString declare = wxString::Format(wxT("function dynfunc%i(){%s}"), (int)l, script.c_str());
-		Execute(declare);
-		m_dynFunc.Insert(script, l);
+		SEE_input* paramInput = SEE_input_string(m_interpr, WxStringToSeeString(m_interpr, wxT("")));
+		SEE_input* bodyInput = SEE_input_string(m_interpr, WxStringToSeeString(m_interpr, NormaliseLineEnds(script)));
+
+		SEE_TRY(m_interpr, tryContext)
+		{
+			fnObj = SEE_Function_new(m_interpr, NULL, paramInput, bodyInput);
+		}
+
+		SEE_INPUT_CLOSE(bodyInput);
+		SEE_INPUT_CLOSE(paramInput);
+
+		SEE_value* errorObj;
+		if( (errorObj=SEE_CAUGHT(tryContext)) )
+		{
+			SeeLogErrorObj(m_interpr, errorObj);
+			SEE_SET_UNDEFINED(m_executeResult);
+			return false;
+		}
+
+		// the function object is referenced by the persistent list only, so the
+		// garbage collector won't free it while the SjSee object is alive
+		AddPersistentObject(fnObj, SJ_PERSISTENT_OTHER);
+		m_dynFunc.Insert(script, fnObj);
 	}
 
-	return Execute(wxString::Format(wxT("dynfunc%i()"), (int)l));
+	SEE_TRY(m_interpr, tryContext)
+	{
+		SEE_OBJECT_CALL(m_interpr, fnObj, m_interpr->Global, 0, NULL, m_executeResult);
+	}
+
+	SEE_value* errorObj;
+	if( (errorObj=SEE_CAUGHT(tryContext)) )
+	{
+		SeeLogErrorObj(m_interpr, errorObj);
+		success = false;
+	}
+
+	return success;
 }
 
 
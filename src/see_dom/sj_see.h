@@ -155,7 +155,7 @@ public:
 	// misc
 	wxString                m_executionScope;
 	SEE_value*              m_executeResult;
-	SjSLHash                m_dynFunc;
+	SjSPHash                m_dynFunc; // script => compiled SEE_object*, see ExecuteAsFunction()
 	wxString                GetFineName             (const wxString& append=wxT("")) const {return GetFineName(m_executionScope, append);}
 	static wxString         GetFineName             (const wxString& path, const wxString& append);
 
@@ -165,6 +165,9 @@ public:
 
 	// handling the timer
 	SjProgramTimer*         m_timer;
+
+private:
+	void                    InitInterpreter         ();
 };
 
 
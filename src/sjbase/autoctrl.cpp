@@ -30,6 +30,7 @@
 #include <sjbase/autoctrl.h>
 #include <sjbase/browser.h>
 #include <sjmodules/advsearch.h>
+#include <sjmodules/trackcache.h>
 #include <sjmodules/vis/vis_module.h>
 
 
@@ -1016,6 +1017,7 @@ wxString SjAutoCtrl::GetAutoPlayUrl()
 	#define MAX_ITERATIONS   1000
 
 	wxSqlt sql;
+	SjTrackCache* cache = g_mainFrame->m_libraryModule->GetTrackCache();
 	unsigned long now = SjTools::GetMsTicks();
 	long selectedTrackId = 0;
 	for( int iterations = 0; iterations < MAX_ITERATIONS; iterations++ )
@@ -1030,12 +1032,24 @@ wxString SjAutoCtrl::GetAutoPlayUrl()
 		{
 			// not in internal cache,
 			// also check agains the "avoid boredom" settings, see http://www.silverjuke.net/forum/topic-2998.html
-			sql.Query(wxString::Format(wxT("SELECT leadartistname, trackname FROM tracks WHERE id=%lu;"), selectedTrackId));
-			if( !sql.Next() )
-				break; // okay, fine track found
+			if( cache )
+			{
+				long row = cache->GetRowById(selectedTrackId);
+				if( row < 0 )
+					break; // okay, fine track found
+
+				if( !g_mainFrame->m_player.m_queue.IsBoring(cache->GetLeadArtistName(row), cache->GetTrackName(row), now) )
+					break; // okay, fine track found
+			}
+			else
+			{
+				sql.Query(wxString::Format(wxT("SELECT leadartistname, trackname FROM tracks WHERE id=%lu;"), selectedTrackId));
+				if( !sql.Next() )
+					break; // okay, fine track found
 
-			if( !g_mainFrame->m_player.m_queue.IsBoring(sql.GetString(0), sql.GetString(1), now) )
-				break; // okay, fine track found
+				if( !g_mainFrame->m_player.m_queue.IsBoring(sql.GetString(0), sql.GetString(1), now) )
+					break; // okay, fine track found
+			}
 		}
 
 		// remove the test index from trackIdsArray
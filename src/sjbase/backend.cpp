@@ -66,6 +66,7 @@ SjBackendStream::SjBackendStream(const wxString& url, SjBackend* backend, SjBack
 	m_cbp.startingTime = wxDateTime::Now().GetAsDOS();
 	m_cbp.buffer       = NULL;
 	m_cbp.bytes        = 0;
+	m_cbp.posMs        = -1;
 	m_cbp.backend      = backend;
 	m_cbp.stream       = this;
 	m_userdata         = userdata;
@@ -59,6 +59,9 @@ enum SjBackendMsg
 
 	SJBE_MSG_DSP,             // must be send by the implementation
 
+	SJBE_MSG_DSP_MIXED,       // send once per output buffer by implementations that mix all streams, see MixesStreams();
+	                          // `stream` is NULL then.  SJBE_MSG_DSP is still send for each stream before mixing.
+
 	SJBE_MSG_END_OF_STREAM,   // must be send by the implementation
 
 	SJBE_MSG_DESTROY_USERDATA // send by the base
@@ -70,6 +73,7 @@ struct SjBackendCallbackParam
     SjBackendMsg     msg;
     float*           buffer;
     long             bytes;
+    long             posMs;        // position of the buffer in the stream on SJBE_MSG_DSP, -1 if unknown
     int              samplerate;
     int              channels;
 	uint32_t         startingTime;
@@ -96,6 +100,17 @@ public:
 	virtual void             SetDeviceState   (SjBackendState state) = 0;
 	virtual void             SetDeviceVol     (double gain) = 0; // 0.0 - 1.0, only called on opened devices
 
+	// PrepareStream() is a hint that the given url will probably be given to CreateStream() soon;
+	// the implementation may open and pre-roll the stream in the background then.  The default does nothing.
+	virtual void             PrepareStream    (const wxString& url) { }
+
+	// the time between the SJBE_MSG_DSP callback and the moment the data is heard
+	virtual long             GetLatencyMs     () { return 0; }
+
+	// if true, all streams of the backend are mixed into one output and SJBE_MSG_DSP_MIXED is send for
+	// the mixed data; processing needed only once per output (eg. the equalizer) should be done there.
+	virtual bool             MixesStreams     () const { return false; }
+
 	// higher-level functions
 	bool                     IsDeviceOpened   () const { return (GetDeviceState()!=SJBE_STATE_CLOSED); }
 	SjBackendId              GetId            () const { return m_id; };
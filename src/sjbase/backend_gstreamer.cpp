@@ -49,15 +49,174 @@
 #define NANOSEC_TO_MILLISEC_DIVISOR    1000000L
 
 
-void SjGstreamerBackendStream::set_pipeline_state(GstState s)
+// the format all streams are converted to before they're mixed together
+#define SJ_GST_MIX_FORMAT              "F32LE"
+#define SJ_GST_MIX_RATE                44100
+#define SJ_GST_MIX_CHANNELS            2
+
+// the time the mixer waits for a slow stream before it outputs silence for it; this is also added to the latency
+#define SJ_GST_MIX_LATENCY_MS          100
+
+// names of the application messages posted from the streaming threads to the main thread
+#define SJ_GST_MSG_STREAM_EOS          "sjStreamEos"
+#define SJ_GST_MSG_STREAM_READY        "sjStreamReady"
+
+
+static GstCaps* create_mix_caps()
+{
+	return gst_caps_new_simple("audio/x-raw",
+				"format", G_TYPE_STRING, SJ_GST_MIX_FORMAT,
+				"layout", G_TYPE_STRING, "interleaved", // LRLRLRLRLRLRLR ...
+				"rate", G_TYPE_INT, SJ_GST_MIX_RATE,
+				"channels", G_TYPE_INT, SJ_GST_MIX_CHANNELS,
+				NULL);
+}
+
+
+// the callbacks of a stream bin do not get the stream or the backend directly but this reference: streaming threads may
+// still run while the bin is stopped in the background, see stop_stream_bin(); the reference lives as long as the bin.
+struct SjGstBinRef
+{
+	GMutex                    mutex;
+	SjGstreamerBackend*       backend;
+	SjGstreamerBackendStream* stream;   // NULL for prepared bins
+};
+
+
+static void free_bin_ref(gpointer data)
+{
+	SjGstBinRef* ref = (SjGstBinRef*)data;
+	g_mutex_clear(&ref->mutex);
+	g_free(ref);
+}
+
+
+static SjGstBinRef* create_bin_ref(GstElement* bin, SjGstreamerBackend* backend)
+{
+	SjGstBinRef* ref = g_new0(SjGstBinRef, 1);
+	g_mutex_init(&ref->mutex);
+	ref->backend = backend;
+	g_object_set_data_full(G_OBJECT(bin), "sjRef", ref, free_bin_ref);
+	return ref;
+}
+
+
+static SjGstBinRef* get_bin_ref(GstElement* bin)
 {
-	if( !m_pipeline ) {
+	return (SjGstBinRef*)g_object_get_data(G_OBJECT(bin), "sjRef");
+}
+
+
+class SjGstBinRefLocker
+{
+public:
+	// locks the reference given as userdata to a callback, the stream or the backend cannot be detached in between
+	SjGstBinRefLocker(gpointer userdata) { m_ref = (SjGstBinRef*)userdata; g_mutex_lock(&m_ref->mutex); }
+	~SjGstBinRefLocker() { g_mutex_unlock(&m_ref->mutex); }
+	SjGstBinRef* m_ref;
+};
+
+
+static void set_element_state(GstElement* e, GstState s)
+{
+	if( !e ) {
 		return; // not ready
 	}
 
-	if( gst_element_set_state(m_pipeline, s) == GST_STATE_CHANGE_ASYNC ) {
-		gst_element_get_state(m_pipeline, NULL, NULL, 3000*MILLISEC_TO_NANOSEC_FACTOR /*async change, wait max. 3 seconds*/);
+	if( gst_element_set_state(e, s) == GST_STATE_CHANGE_ASYNC ) {
+		gst_element_get_state(e, NULL, NULL, 3000*MILLISEC_TO_NANOSEC_FACTOR /*async change, wait max. 3 seconds*/);
+	}
+}
+
+
+static void set_state_async_func(GstElement* e, gpointer userdata)
+{
+	// called from a thread of the GStreamer thread pool; if the bin is stopped in between, see stop_stream_bin(), leave it alone
+	GST_STATE_LOCK(e);
+		if( g_object_get_data(G_OBJECT(e), "sjStopped") == NULL ) {
+			gst_element_sync_state_with_parent(e);
+		}
+	GST_STATE_UNLOCK(e);
+}
+
+
+static void start_stream_bin(GstElement* bin)
+{
+	// bring the stream bin to the state of the pipeline without waiting - starting the source and the
+	// decoder takes 40 ms and more, much more on network shares, this should not block the main thread
+	gst_element_call_async(bin, set_state_async_func, NULL, NULL);
+}
+
+
+static void stop_async_func(GstElement* bin, gpointer userdata)
+{
+	// called from a thread of the GStreamer thread pool, see stop_stream_bin()
+	GST_STATE_LOCK(bin);
+		set_element_state(bin, GST_STATE_NULL);
+	GST_STATE_UNLOCK(bin);
+	gst_object_unref(bin); // the reference taken by stop_stream_bin(), this finally frees the bin
+}
+
+
+static void stop_stream_bin(GstElement* bin, GstElement* pipeline)
+{
+	// detach the stream bin from its stream and from the pipeline; a pending start_stream_bin() does nothing afterwards.
+	// stopping the source and the decoder may take seconds on network shares, so this and freeing the bin is done
+	// in the background - the callbacks still called meanwhile find an empty reference.
+	SjGstBinRef* ref = get_bin_ref(bin);
+	g_mutex_lock(&ref->mutex);
+		ref->backend = NULL;
+		ref->stream  = NULL;
+	g_mutex_unlock(&ref->mutex);
+	g_object_set_data(G_OBJECT(bin), "sjStopped", (gpointer)1);
+
+	gst_object_ref(bin);
+	gst_bin_remove(GST_BIN(pipeline), bin); // this also unlinks the ghost pad
+	gst_element_call_async(bin, stop_async_func, NULL, NULL);
+}
+
+
+static void link_audio_pad(GstElement* bin, GstPad* newSourcePad)
+{
+	// link a new source pad of the "decodebin" element to the element with the name "sjAudioEntry"
+	GstElement* audioEntry = gst_bin_get_by_name(GST_BIN(bin), "sjAudioEntry");
+	if( audioEntry )
+	{
+		// get sink pad of the "audio entry element"
+		GstPad* destSinkPad = gst_element_get_static_pad(audioEntry, "sink");
+
+		// link the new source pad to the "audio entry element"
+		GstPadLinkReturn linkret = gst_pad_link(newSourcePad, destSinkPad);
+		if( linkret!=GST_PAD_LINK_OK ) {
+			wxLogError("GStreamer error: Cannot link audio.");
+		}
+
+		gst_object_unref(destSinkPad);
+		gst_object_unref(audioEntry);
+	}
+}
+
+
+static bool is_video_pad(GstPad* pad)
+{
+	bool isVideoPad = false;
+	GstCaps* caps = gst_pad_get_current_caps(pad);
+	if( caps ) {
+		GstStructure* s = gst_caps_get_structure(caps, 0); // no need to free or unref the structure, it belongs to the GstCaps.
+		const gchar* name = gst_structure_get_name (s); // sth. like "audio/x-raw" or "video/x-raw"
+		GST_TO_WXSTRING(name);
+		isVideoPad = nameWxStr.StartsWith("video");
+		gst_caps_unref(caps);
 	}
+	return isVideoPad;
+}
+
+
+static void post_stream_message(SjGstreamerBackendStream* stream, GstElement* bin, const char* name)
+{
+	// post a message from a streaming thread to the bus, the message is handled in on_bus_message() in the main thread
+	GstStructure* s = gst_structure_new(name, "stream", G_TYPE_POINTER, (gpointer)stream, NULL);
+	gst_element_post_message(bin, gst_message_new_application(GST_OBJECT(bin), s));
 }
 
 
@@ -84,16 +243,20 @@ GstBusSyncReply on_bus_sync_handler(GstBus* bus, GstMessage* msg, gpointer user_
 
 gboolean on_bus_message(GstBus* bus, GstMessage* msg, gpointer userdata)
 {
-	SjGstreamerBackendStream* stream = (SjGstreamerBackendStream*)userdata;
-	if( stream == NULL ) { return true; }
-
-	bool prepareNext = false;
+	SjGstreamerBackend* backend = (SjGstreamerBackend*)userdata;
+	if( backend == NULL ) { return true; }
 
 	switch( GST_MESSAGE_TYPE(msg) )
 	{
 		case GST_MESSAGE_ERROR:
 			// there may be series of error messages for one stream.
-			// error messages are normally not followed by a GST_MESSAGE_EOS error
+			// as the mixer never runs out of data, there is no GST_MESSAGE_EOS for the pipeline
+			if( backend->m_preparedBin && gst_object_has_as_ancestor(GST_MESSAGE_SRC(msg), GST_OBJECT(backend->m_preparedBin)) )
+			{
+				// errors in a prepared stream just discard it; if the stream is really played, the error is logged then
+				backend->DeletePreparedBin();
+			}
+			else
 			{
 				// get information about the error
 				GError* error = NULL;
@@ -109,30 +272,53 @@ gboolean on_bus_message(GstBus* bus, GstMessage* msg, gpointer userdata)
 				g_free(debug);
 				g_error_free(error);
 
-				prepareNext = true;
+				// errors inside a stream end this stream; errors in the output part are only logged
+				SjGstreamerBackendStream* stream = backend->FindStream(GST_MESSAGE_SRC(msg));
+				if( stream ) {
+					stream->SendEos();
+				}
 			}
 			break;
 
-		case GST_MESSAGE_EOS:
-			// we go here if we reach the end of the stream
-			prepareNext = true;
+		case GST_MESSAGE_APPLICATION:
+			// messages posted by our probes; the stream may be deleted in between, so check the pointer
+			{
+				const GstStructure* s = gst_message_get_structure(msg);
+				gpointer streamPtr = NULL;
+				if( s && gst_structure_get(s, "stream", G_TYPE_POINTER, &streamPtr, NULL) )
+				{
+					SjGstreamerBackendStream* stream = backend->FindStream(streamPtr);
+					if( stream )
+					{
+						if( gst_structure_has_name(s, SJ_GST_MSG_STREAM_EOS) )
+						{
+							stream->SendEos();
+						}
+						else if( gst_structure_has_name(s, SJ_GST_MSG_STREAM_READY) && stream->m_pendingSeekMs > 0 )
+						{
+							stream->SeekAbs(stream->m_pendingSeekMs.exchange(0));
+						}
+					}
+				}
+			}
 			break;
 
 		default:
 			break;
 	}
 
-	if( prepareNext )
+	return true;
+}
+
+
+void SjGstreamerBackendStream::SendEos()
+{
+	if( !m_eosSend )
 	{
-		if( prepareNext && !stream->m_eosSend )
-		{
-			stream->m_cbp.msg = SJBE_MSG_END_OF_STREAM;
-			stream->m_cb(&stream->m_cbp);
-			stream->m_eosSend = true;
-		}
+		m_cbp.msg = SJBE_MSG_END_OF_STREAM;
+		m_cb(&m_cbp);
+		m_eosSend = true;
 	}
-
-	return true;
 }
 
 
@@ -140,28 +326,19 @@ void on_pad_added(GstElement* decodebin, GstPad* newSourcePad, gpointer userdata
 {
 	// a new pad appears in the "decodebin" element - link this to the
 	// element with the name "sjAudioEntry"
-	SjGstreamerBackendStream* stream = (SjGstreamerBackendStream*)userdata;
+	SjGstBinRefLocker locker(userdata);
+	SjGstreamerBackendStream* stream = locker.m_ref->stream;
 	if( stream == NULL ) { return; }
 
-	// find out the type of the pad
-	bool isVideoPad = false;
-	{
-		GstCaps* caps = gst_pad_get_current_caps(newSourcePad);
-		if( !caps ) { return; /*error*/ }
-			GstStructure* s = gst_caps_get_structure(caps, 0); // no need to free or unref the structure, it belongs to the GstCaps.
-			const gchar* name = gst_structure_get_name (s); // sth. like "audio/x-raw" or "video/x-raw"
-			GST_TO_WXSTRING(name);
-			if( nameWxStr.StartsWith("video") )
-			{
-				stream->m_cbp.msg = SJBE_MSG_VIDEO_DETECTED;
-				stream->m_cb(&stream->m_cbp);
-				isVideoPad = true;
-			}
-		gst_caps_unref(caps);
-	}
+	GstCaps* caps = gst_pad_get_current_caps(newSourcePad);
+	if( !caps ) { return; /*error*/ }
+	gst_caps_unref(caps);
 
-	if( isVideoPad )
+	if( is_video_pad(newSourcePad) )
 	{
+		stream->m_cbp.msg = SJBE_MSG_VIDEO_DETECTED;
+		stream->m_cb(&stream->m_cbp);
+
 		// create video sink and connect the pad to it
 		if( stream->m_backend->WantsVideo() )
 		{
@@ -173,7 +350,7 @@ void on_pad_added(GstElement* decodebin, GstPad* newSourcePad, gpointer userdata
 				g_error_free(error);
 			} // no else - we may be an error and a valid return object
 			if( !videosink ) { wxLogError("GStream Error: Cannot create video sink."); return; }
-			gst_bin_add(GST_BIN(stream->m_pipeline), videosink);
+			gst_bin_add(GST_BIN(stream->m_bin), videosink);
 
 			GstPad* destSinkPad = gst_element_get_static_pad(videosink, "sink");
 			if( !destSinkPad ) { wxLogError("GStream Error: Cannot get pad of video sink."); return; }
@@ -189,27 +366,62 @@ void on_pad_added(GstElement* decodebin, GstPad* newSourcePad, gpointer userdata
 	else
 	{
 		// add audio pad to our audio sink
-		GstElement* audioEntry = gst_bin_get_by_name(GST_BIN(stream->m_pipeline), "sjAudioEntry");
-		if( audioEntry )
-		{
-			// get sink pad of the "audio entry element"
-			GstPad* destSinkPad = gst_element_get_static_pad(audioEntry, "sink");
+		link_audio_pad(stream->m_bin, newSourcePad);
+	}
+}
 
-			// link the new source pad to the "audio entry element"
-			GstPadLinkReturn linkret = gst_pad_link(newSourcePad, destSinkPad);
-			if( linkret!=GST_PAD_LINK_OK ) {
-				wxLogError("GStreamer error: Cannot link audio.");
-			}
 
-			gst_object_unref(audioEntry);
+static GstPadProbeReturn on_prepared_video_data(GstPad* pad, GstPadProbeInfo* info, gpointer userdata)
+{
+	return GST_PAD_PROBE_DROP;
+}
+
+
+void on_prepared_pad_added(GstElement* decodebin, GstPad* newSourcePad, gpointer userdata)
+{
+	// same as on_pad_added() for prepared bins, the stream object does not exist yet
+	SjGstBinRefLocker locker(userdata);
+	SjGstreamerBackend* backend = locker.m_ref->backend;
+	if( backend == NULL ) { return; }
+
+	if( is_video_pad(newSourcePad) )
+	{
+		// the video sink needs the stream object; the video data is dropped and the prepared bin
+		// is not used by CreateStream(), it creates a new one
+		backend->m_preparedHasVideo = true;
+		gst_pad_add_probe(newSourcePad, GST_PAD_PROBE_TYPE_DATA_DOWNSTREAM, on_prepared_video_data, NULL, NULL);
+	}
+	else
+	{
+		GstObject* bin = gst_element_get_parent(decodebin);
+		if( bin ) {
+			link_audio_pad(GST_ELEMENT(bin), newSourcePad);
+			gst_object_unref(bin);
 		}
 	}
 }
 
 
+GstPadProbeReturn on_prepared_pad_blocked(GstPad* pad, GstPadProbeInfo* info, gpointer userdata)
+{
+	// let the events pass to the (unlinked) ghost pad, where the sticky ones are stored until the bin is linked;
+	// the first buffer is blocked until the prepared bin is used by CreateStream()
+	if( GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM ) {
+		return GST_PAD_PROBE_PASS;
+	}
+
+	SjGstBinRefLocker locker(userdata);
+	if( locker.m_ref->backend ) {
+		locker.m_ref->backend->m_preparedReady = true;
+	}
+	return GST_PAD_PROBE_OK;
+}
+
+
 GstPadProbeReturn on_pad_data(GstPad* pad, GstPadProbeInfo* info, gpointer userdata)
 {
-	SjGstreamerBackendStream* stream = (SjGstreamerBackendStream*)userdata; if( stream == NULL ) { return GST_PAD_PROBE_OK; }
+	SjGstBinRefLocker locker(userdata);
+	SjGstreamerBackendStream* stream = locker.m_ref->stream; if( stream == NULL ) { return GST_PAD_PROBE_DROP; }
 
 	// on the first call on a new stream, correct the "channels" and "samplerate"
 	if( !stream->m_capsChecked )
@@ -233,6 +445,17 @@ GstPadProbeReturn on_pad_data(GstPad* pad, GstPadProbeInfo* info, gpointer userd
 			}
 			gst_caps_unref(caps);
 		}
+
+		if( stream->m_dropUntilFlush ) {
+			post_stream_message(stream, stream->m_bin, SJ_GST_MSG_STREAM_READY);
+		}
+	}
+
+	// on a pending seek (set on stream creation), we drop the data until the seek results in a flush;
+	// the seek itself is done in the main thread as it cannot be done from a streaming thread
+	if( stream->m_dropUntilFlush )
+	{
+		return GST_PAD_PROBE_DROP;
 	}
 
 	// forward the buffer to the given callback
@@ -242,7 +465,9 @@ GstPadProbeReturn on_pad_data(GstPad* pad, GstPadProbeInfo* info, gpointer userd
 		GstMapInfo map;
 		gst_buffer_map(buffer, &map, GST_MAP_WRITE);
 
+			GstClockTime pts = GST_BUFFER_PTS(buffer);
 			stream->m_cbp.msg    = SJBE_MSG_DSP;
+			stream->m_cbp.posMs  = GST_CLOCK_TIME_IS_VALID(pts)? (long)(pts/NANOSEC_TO_MILLISEC_DIVISOR) : -1;
 			stream->m_cbp.buffer = (float*)map.data;
 			stream->m_cbp.bytes  = map.size;
 			stream->m_cb(&stream->m_cbp);
@@ -255,6 +480,55 @@ GstPadProbeReturn on_pad_data(GstPad* pad, GstPadProbeInfo* info, gpointer userd
 }
 
 
+GstPadProbeReturn on_pad_event(GstPad* pad, GstPadProbeInfo* info, gpointer userdata)
+{
+	SjGstBinRefLocker locker(userdata);
+	SjGstreamerBackendStream* stream = locker.m_ref->stream; if( stream == NULL ) { return GST_PAD_PROBE_OK; }
+
+	GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+	switch( GST_EVENT_TYPE(event) )
+	{
+		case GST_EVENT_EOS:
+			// the mixer keeps on running (it has a silent source that never ends), so the end of a single
+			// stream does not result in a GST_MESSAGE_EOS on the bus - inform the main thread ourselves
+			post_stream_message(stream, stream->m_bin, SJ_GST_MSG_STREAM_EOS);
+			break;
+
+		case GST_EVENT_FLUSH_STOP:
+			stream->m_dropUntilFlush = false;
+			break;
+
+		default:
+			break;
+	}
+
+	return GST_PAD_PROBE_OK;
+}
+
+
+GstPadProbeReturn on_mixed_data(GstPad* pad, GstPadProbeInfo* info, gpointer userdata)
+{
+	// called for each buffer leaving the mixer, so the callback runs once per output buffer, also while crossfading
+	SjGstreamerBackend* backend = (SjGstreamerBackend*)userdata; if( backend == NULL || backend->m_mixCb == NULL ) { return GST_PAD_PROBE_OK; }
+
+	GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+	buffer = gst_buffer_make_writable(buffer);
+
+		GstMapInfo map;
+		gst_buffer_map(buffer, &map, GST_MAP_WRITE);
+
+			backend->m_mixCbp.buffer = (float*)map.data;
+			backend->m_mixCbp.bytes  = map.size;
+			backend->m_mixCb(&backend->m_mixCbp);
+
+		gst_buffer_unmap(buffer, &map);
+
+	GST_PAD_PROBE_INFO_DATA(info) = buffer;
+
+	return GST_PAD_PROBE_OK;
+}
+
+
 /*******************************************************************************
  * Public Backend Implementation
  ******************************************************************************/
@@ -263,6 +537,28 @@ GstPadProbeReturn on_pad_data(GstPad* pad, GstPadProbeInfo* info, gpointer userd
 SjGstreamerBackend::SjGstreamerBackend(SjBackendId id)
 	: SjBackend(id)
 {
+	m_outPipeline  = NULL;
+	m_mixer        = NULL;
+	m_bus_watch_id = 0;
+	m_latencyMs    = -1;
+
+	m_mixCb                   = NULL;
+	m_mixCbp.msg              = SJBE_MSG_DSP_MIXED;
+	m_mixCbp.buffer           = NULL;
+	m_mixCbp.bytes            = 0;
+	m_mixCbp.posMs            = -1;
+	m_mixCbp.samplerate       = SJ_GST_MIX_RATE;
+	m_mixCbp.channels         = SJ_GST_MIX_CHANNELS;
+	m_mixCbp.startingTime     = 0;
+	m_mixCbp.backend          = this;
+	m_mixCbp.stream           = NULL;
+
+	m_preparedBin      = NULL;
+	m_preparedBlockPad = NULL;
+	m_preparedBlockId  = 0;
+	m_preparedReady    = false;
+	m_preparedHasVideo = false;
+
 	// load settings
 	// some pipeline examples:
 	//     audioecho delay=500000000 intensity=0.6 feedback=0.4 ! autoaudiosink
@@ -293,6 +589,21 @@ SjGstreamerBackend::SjGstreamerBackend(SjBackendId id)
 }
 
 
+SjGstreamerBackend::~SjGstreamerBackend()
+{
+	// streams not yet deleted by the caller still hold pads of the mixer and bins inside m_outPipeline;
+	// detach them first, the stream objects stay valid but do not play anything afterwards
+	const wxArrayPtrVoid& allStreams = GetAllStreams();
+	size_t i, iCnt = allStreams.GetCount();
+	for( i = 0; i < iCnt; i++ ) {
+		((SjGstreamerBackendStream*)allStreams.Item(i))->DetachFromMixer();
+	}
+
+	SetDeviceState(SJBE_STATE_CLOSED);
+	DeleteOutPipeline();
+}
+
+
 void SjGstreamerBackend::GetLittleOptions(SjArrayLittleOption& lo)
 {
 	lo.Add(new SjLittleStringSel("GStreamer-Pipeline", &m_iniAudioPipeline, AUDIOPIPELINE_DEFAULT, AUDIOPIPELINE_ININAME, SJ_ICON_MODULE));
@@ -303,26 +614,28 @@ void SjGstreamerBackend::GetLittleOptions(SjArrayLittleOption& lo)
 }
 
 
-SjBackendStream* SjGstreamerBackend::CreateStream(const wxString& uri, long seekMs, SjBackendCallback* cb, SjBackendUserdata* userdata)
+bool SjGstreamerBackend::CreateOutPipeline()
 {
-	SjGstreamerBackendStream* stream = new SjGstreamerBackendStream(uri, this, cb, userdata);
-	if( stream == NULL ) { return NULL; }
+	if( m_outPipeline ) {
+		return true; // already created
+	}
 
 	/*
-	              .--> audioconvert --> capsfilter --> (X) volume -> audiosink
-	decodebin --> |                                     :
-	              '--> videosink                        :
-	                                                    : here we add our DSP handler
+	audiotestsrc --> capsfilter --> audiomixer --> volume --> audiosink
+	(silence)                          ^  ^     :
+	                                   |  |     here we add the SJBE_MSG_DSP_MIXED handler
+	                                   |  '--- stream bin (added/removed by CreateStream()/~SjGstreamerBackendStream())
+	                                   '------ stream bin (eg. while crossfading)
 	*/
 
-	// create objects
-	// NB: is is the far faster part, on my computer creating the pipeline takes 4 ms while starting the stream takes 40 ms -
-	// if there are no other problems on recreating the pipeline on every call, there is no need to change this - esp. as there are some advantages as easier cleaning up, different samplerates etc.
+	// the silent source makes sure, the mixer always has some data - so it never runs into EOS
+	// and continues to feed the sink between two tracks.  the source is live, so the mixer is live, too:
+	// it does not wait for a slow or stalled stream longer than its latency but continues with the other pads.
 	GError* error = NULL;
-	stream->m_pipeline       = gst_pipeline_new        (                 "sjPlayer"    );
-	GstElement* decodebin    = gst_element_factory_make("uridecodebin",  "sjSource"    );
-	GstElement* audioconvert = gst_element_factory_make("audioconvert",  "sjAudioEntry");
-	GstElement* capsfilter   = gst_element_factory_make("capsfilter",    NULL          );
+	m_outPipeline            = gst_pipeline_new        (                 "sjPlayer"    );
+	GstElement* silence      = gst_element_factory_make("audiotestsrc",  NULL          );
+	GstElement* silencecaps  = gst_element_factory_make("capsfilter",    NULL          );
+	m_mixer                  = gst_element_factory_make("audiomixer",    "sjMixer"     );
 	GstElement* volume       = gst_element_factory_make("volume",        "sjVolume"    );
 	GstElement* audiosink    = gst_parse_bin_from_description(m_iniAudioPipeline, true, &error);
 	if( error ) {
@@ -330,119 +643,385 @@ SjBackendStream* SjGstreamerBackend::CreateStream(const wxString& uri, long seek
 		wxLogError("GStreamer Error: %s. Please check the audio configuration at Settings/Advanced.", errormessageWxStr.c_str());
 		g_error_free(error);
 	} // no "return", no "else" - it may be possible, the pipeline is created even on errors, see http://gstreamer.freedesktop.org/data/doc/gstreamer/head/gstreamer/html/gstreamer-GstParse.html#gst-parse-launch
-	if( !stream->m_pipeline || !decodebin || !audioconvert || !capsfilter || !volume || !audiosink ) {
+	if( !m_outPipeline || !silence || !silencecaps || !m_mixer || !volume || !audiosink ) {
 		wxLogError("GStreamer error: Cannot create objects.");
-		delete stream;
-		return NULL; // error
+		if( m_outPipeline ) { gst_object_unref(GST_OBJECT(m_outPipeline)); m_outPipeline = NULL; }
+		m_mixer = NULL; // the other objects are floating references and are not leaked on errors
+		return false; // error
 	}
 
-	// create pipeline
-	gst_bin_add_many(GST_BIN(stream->m_pipeline), decodebin, audioconvert, capsfilter, volume, audiosink, NULL); // NULL marks end of list
-	gst_element_link_many(audioconvert, capsfilter, volume, audiosink, NULL);
-	g_signal_connect(decodebin, "pad-added", G_CALLBACK(on_pad_added), stream /*userdata*/);
+	gst_util_set_object_arg(G_OBJECT(silence), "wave", "silence");
+	g_object_set(G_OBJECT(silence), "is-live", TRUE, NULL);
+	g_object_set(G_OBJECT(m_mixer), "latency", (guint64)(SJ_GST_MIX_LATENCY_MS*MILLISEC_TO_NANOSEC_FACTOR), NULL);
+	GstCaps* caps = create_mix_caps();
+		g_object_set(G_OBJECT(silencecaps), "caps", caps, NULL);
+	gst_caps_unref(caps);
 
-	// add a message handler
-	GstBus* bus = gst_pipeline_get_bus(GST_PIPELINE(stream->m_pipeline));
-		stream->m_bus_watch_id = gst_bus_add_watch(bus, on_bus_message, stream /*userdata*/);
-		gst_bus_set_sync_handler(bus, on_bus_sync_handler, stream /*userdata*/, NULL);
+	gst_bin_add_many(GST_BIN(m_outPipeline), silence, silencecaps, m_mixer, volume, audiosink, NULL); // NULL marks end of list
+	gst_element_link_many(silence, silencecaps, m_mixer, volume, audiosink, NULL);
+
+	GstPad* pad = gst_element_get_static_pad(m_mixer, "src");
+		if( gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, on_mixed_data, (gpointer)this/*userdata*/, NULL) == 0 ) {
+			wxLogError("GStreamer Error: Cannot add probe callback.");
+		}
+	gst_object_unref(pad);
+
+	// add a message handler - there is only one bus for all streams, see FindStream()
+	GstBus* bus = gst_pipeline_get_bus(GST_PIPELINE(m_outPipeline));
+		m_bus_watch_id = gst_bus_add_watch(bus, on_bus_message, this /*userdata*/);
+		gst_bus_set_sync_handler(bus, on_bus_sync_handler, this /*userdata*/, NULL);
 	gst_object_unref(bus);
 
-	// setup capsfilter and dsp callback
-	GstCaps* caps = gst_caps_new_simple("audio/x-raw",
-				"format", G_TYPE_STRING, "F32LE",       // or S16LE, U8, ...
-				"layout", G_TYPE_STRING, "interleaved", // LRLRLRLRLRLRLR ...
-				//"rate", G_TYPE_INT, info->rate,       // if we set a fixed rate, we must probably add a resampler to the pipeline, however, currently this is not needed
-				//"channels", G_TYPE_INT, 2,            // enable this to force a fixed number of channels, currently not needed
-				NULL);
-		 g_object_set(G_OBJECT(capsfilter), "caps", caps, NULL);
-	gst_caps_unref(caps);
+	return true;
+}
 
-	GstPad* pad = gst_element_get_static_pad(volume, "sink"); // sink/src is defined from the view of within the element: elements receive data on their sink pads and generate data on their source pads.
-		gulong probeid = gst_pad_add_probe(pad,
-			(GstPadProbeType)(GST_PAD_PROBE_TYPE_BUFFER),
-			on_pad_data, (gpointer)stream/*userdata*/, NULL);
-		if( probeid==0 ) {
-			wxLogError("GStreamer Error: Cannot add probe callback.");
+
+void SjGstreamerBackend::DeleteOutPipeline()
+{
+	DeletePreparedBin();
+
+	if( m_outPipeline )
+	{
+		set_element_state(m_outPipeline, GST_STATE_NULL);
+		gst_object_unref(GST_OBJECT(m_outPipeline));
+		m_outPipeline = NULL;
+		m_mixer = NULL; // owned by m_outPipeline
+		g_source_remove(m_bus_watch_id);
+		m_bus_watch_id = 0;
+	}
+}
+
+
+gint64 SjGstreamerBackend::GetMixerRunningTime()
+{
+	// get the running time the mixer will output next; new or seeked streams are shifted to this time,
+	// otherwise their data would be too late and would be dropped by the mixer
+	gint64 ns = 0;
+	if( !m_mixer || !gst_element_query_position(m_mixer, GST_FORMAT_TIME, &ns) || ns < 0 )
+	{
+		ns = 0;
+		GstClock* clock = gst_element_get_clock(m_outPipeline);
+		if( clock ) {
+			ns = gst_clock_get_time(clock) - gst_element_get_base_time(m_outPipeline);
+			gst_object_unref(clock);
+		}
+	}
+	return ns;
+}
+
+
+SjGstreamerBackendStream* SjGstreamerBackend::FindStream(GstObject* elem)
+{
+	const wxArrayPtrVoid& allStreams = GetAllStreams();
+	size_t i, iCnt = allStreams.GetCount();
+	for( i = 0; i < iCnt; i++ )
+	{
+		SjGstreamerBackendStream* stream = (SjGstreamerBackendStream*)allStreams.Item(i);
+		if( stream->m_bin && (elem == GST_OBJECT(stream->m_bin) || gst_object_has_as_ancestor(elem, GST_OBJECT(stream->m_bin))) ) {
+			return stream;
 		}
+	}
+	return NULL;
+}
+
+
+SjGstreamerBackendStream* SjGstreamerBackend::FindStream(gpointer streamPtr)
+{
+	const wxArrayPtrVoid& allStreams = GetAllStreams();
+	if( allStreams.Index(streamPtr) == wxNOT_FOUND ) {
+		return NULL; // stream already deleted
+	}
+	return (SjGstreamerBackendStream*)streamPtr;
+}
+
+
+GstElement* SjGstreamerBackend::CreateStreamBin(const wxString& uri)
+{
+	/*
+	              .--> audioconvert --> audioresample --> capsfilter --> (X) ghostpad --> (mixer)
+	decodebin --> |                                           :           :
+	              '--> videosink                              :           :
+	                                                          :           here we add our DSP handler
+	                                                          here prepared bins are blocked
+	*/
+
+	// create objects
+	// NB: creating the stream bin is the fast part; the expensive audio sink is created only once in CreateOutPipeline()
+	GstElement* bin          = gst_bin_new             (                 NULL          );
+	GstElement* decodebin    = gst_element_factory_make("uridecodebin",  "sjSource"    );
+	GstElement* audioconvert = gst_element_factory_make("audioconvert",  "sjAudioEntry");
+	GstElement* resample     = gst_element_factory_make("audioresample", NULL          );
+	GstElement* capsfilter   = gst_element_factory_make("capsfilter",    "sjCapsfilter");
+	if( !bin || !decodebin || !audioconvert || !resample || !capsfilter ) {
+		wxLogError("GStreamer error: Cannot create objects.");
+		if( bin ) { gst_object_unref(GST_OBJECT(bin)); }
+		return NULL; // error
+	}
+
+	// create bin, all streams are converted to the same format as needed by the mixer
+	gst_bin_add_many(GST_BIN(bin), decodebin, audioconvert, resample, capsfilter, NULL); // NULL marks end of list
+	gst_element_link_many(audioconvert, resample, capsfilter, NULL);
+
+	GstCaps* caps = create_mix_caps();
+		g_object_set(G_OBJECT(capsfilter), "caps", caps, NULL);
+	gst_caps_unref(caps);
+
+	GstPad* pad = gst_element_get_static_pad(capsfilter, "src");
+		gst_element_add_pad(bin, gst_ghost_pad_new("src", pad));
 	gst_object_unref(pad);
 
-	// open stream
-	stream->set_pipeline_state(GST_STATE_READY);
+	// set source uri
+	{
+		WXSTRING_TO_GST(uri);
+		g_object_set(G_OBJECT(decodebin), "uri", uriGstStr, NULL /*NULL marks end of list*/);
+	}
+
+	create_bin_ref(bin, this);
+	return bin;
+}
+
+
+SjBackendStream* SjGstreamerBackend::CreateStream(const wxString& uri, long seekMs, SjBackendCallback* cb, SjBackendUserdata* userdata)
+{
+	SjGstreamerBackendStream* stream = new SjGstreamerBackendStream(uri, this, cb, userdata);
+	if( stream == NULL ) { return NULL; }
+
+	if( !CreateOutPipeline() ) {
+		delete stream;
+		return NULL; // error
+	}
+
+	m_mixCb = cb; // the same for all streams, set before the pipeline is started below
 
-		GstElement* source = gst_bin_get_by_name(GST_BIN(stream->m_pipeline), "sjSource");
-		if( source )
+	// use the prepared bin, if any; it must be for the same url and must already be pre-rolled - otherwise
+	// we cannot say if the stream contains video and waiting for it would be slower than starting over
+	bool prepared = false;
+	if( m_preparedBin )
+	{
+		if( m_preparedUrl == uri && m_preparedReady && !m_preparedHasVideo && seekMs <= 0 )
+		{
+			stream->m_bin = m_preparedBin;
+			m_preparedBin = NULL;
+			m_preparedUrl.Clear();
+			prepared = true;
+		}
+		else
 		{
-			WXSTRING_TO_GST(uri);
-			g_object_set(G_OBJECT(source), "uri", uriGstStr, NULL /*NULL marks end of list*/);
+			DeletePreparedBin();
+		}
+	}
+
+	if( !prepared )
+	{
+		stream->m_bin = CreateStreamBin(uri);
+		if( stream->m_bin == NULL ) {
+			delete stream;
+			return NULL; // error
 		}
 
-	stream->set_pipeline_state(GST_STATE_PLAYING);
+		GstElement* decodebin = gst_bin_get_by_name(GST_BIN(stream->m_bin), "sjSource");
+			g_signal_connect(decodebin, "pad-added", G_CALLBACK(on_pad_added), get_bin_ref(stream->m_bin) /*userdata*/);
+		gst_object_unref(decodebin);
+	}
+
+	SjGstBinRef* ref = get_bin_ref(stream->m_bin);
+	g_mutex_lock(&ref->mutex);
+		ref->stream = stream;
+	g_mutex_unlock(&ref->mutex);
+
+	stream->m_srcPad = gst_element_get_static_pad(stream->m_bin, "src");
+	gst_object_unref(stream->m_srcPad); // owned by m_bin
+
+	// the data probe sits on the ghost pad, behind a blocking probe of a prepared bin, see PrepareStream()
+	gulong probeid = gst_pad_add_probe(stream->m_srcPad,
+		(GstPadProbeType)(GST_PAD_PROBE_TYPE_BUFFER),
+		on_pad_data, (gpointer)ref/*userdata*/, NULL);
+	if( probeid==0 ) {
+		wxLogError("GStreamer Error: Cannot add probe callback.");
+	}
+
+	gst_pad_add_probe(stream->m_srcPad,
+		(GstPadProbeType)(GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM|GST_PAD_PROBE_TYPE_EVENT_FLUSH),
+		on_pad_event, (gpointer)ref/*userdata*/, NULL);
 
+	// seeking is only possible after the stream is prerolled - remember the position and
+	// drop all data until the seek is done, see on_pad_data() and on_bus_message()
 	if( seekMs > 0 )
 	{
-		gst_element_seek_simple(stream->m_pipeline, GST_FORMAT_TIME,
-			(GstSeekFlags)(GST_SEEK_FLAG_FLUSH|GST_SEEK_FLAG_KEY_UNIT), seekMs*MILLISEC_TO_NANOSEC_FACTOR);
+		stream->m_pendingSeekMs  = seekMs;
+		stream->m_dropUntilFlush = true;
+	}
+
+	// attach the stream to the mixer; a prepared bin is already part of the pipeline
+	if( !prepared ) {
+		gst_bin_add(GST_BIN(m_outPipeline), stream->m_bin);
+	}
+	stream->m_mixerPad = gst_element_get_request_pad(m_mixer, "sink_%u");
+	gst_pad_set_offset(stream->m_srcPad, GetMixerRunningTime());
+	if( !stream->m_mixerPad || gst_pad_link(stream->m_srcPad, stream->m_mixerPad) != GST_PAD_LINK_OK ) {
+		wxLogError("GStreamer error: Cannot link stream to mixer.");
+	}
+
+	// open stream; none of the state changes is waited for
+	gst_element_set_state(m_outPipeline, GST_STATE_PLAYING);
+	if( prepared )
+	{
+		// the first buffer is already waiting, let it flow
+		gst_pad_remove_probe(m_preparedBlockPad, m_preparedBlockId);
+		gst_object_unref(m_preparedBlockPad);
+		m_preparedBlockPad = NULL;
+		m_preparedBlockId  = 0;
+	}
+	else
+	{
+		start_stream_bin(stream->m_bin);
 	}
 
 	return stream;
 }
 
 
+void SjGstreamerBackend::PrepareStream(const wxString& uri)
+{
+	if( m_preparedBin && m_preparedUrl == uri ) {
+		return; // already prepared
+	}
+
+	DeletePreparedBin();
+
+	if( m_outPipeline == NULL || GetAllStreams().GetCount() == 0 ) {
+		return; // device not opened, nothing to prepare for
+	}
+
+	GstElement* bin = CreateStreamBin(uri);
+	if( bin == NULL ) {
+		return; // error
+	}
+
+	GstElement* decodebin = gst_bin_get_by_name(GST_BIN(bin), "sjSource");
+		g_signal_connect(decodebin, "pad-added", G_CALLBACK(on_prepared_pad_added), get_bin_ref(bin) /*userdata*/);
+	gst_object_unref(decodebin);
+
+	GstElement* capsfilter = gst_bin_get_by_name(GST_BIN(bin), "sjCapsfilter");
+		m_preparedBlockPad = gst_element_get_static_pad(capsfilter, "src");
+		m_preparedBlockId = gst_pad_add_probe(m_preparedBlockPad,
+			GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
+			on_prepared_pad_blocked, (gpointer)get_bin_ref(bin)/*userdata*/, NULL);
+	gst_object_unref(capsfilter);
+
+	m_preparedBin      = bin;
+	m_preparedUrl      = uri;
+	m_preparedReady    = false;
+	m_preparedHasVideo = false;
+
+	// add the bin unlinked to the pipeline, it uses the pipeline's clock and bus then
+	gst_bin_add(GST_BIN(m_outPipeline), m_preparedBin);
+	start_stream_bin(m_preparedBin);
+}
+
+
+void SjGstreamerBackend::DeletePreparedBin()
+{
+	if( m_preparedBin )
+	{
+		// stopping the bin also releases a blocked streaming thread
+		stop_stream_bin(m_preparedBin, m_outPipeline); // this also unrefs m_preparedBin
+		m_preparedBin = NULL;
+		m_preparedUrl.Clear();
+	}
+
+	if( m_preparedBlockPad )
+	{
+		gst_object_unref(m_preparedBlockPad);
+		m_preparedBlockPad = NULL;
+		m_preparedBlockId  = 0;
+	}
+}
+
+
 SjBackendState SjGstreamerBackend::GetDeviceState() const
 {
-	const wxArrayPtrVoid& allStreams = GetAllStreams();
-	size_t i, iCnt = allStreams.GetCount();
-	if( iCnt == 0 ) {
+	if( GetAllStreams().GetCount() == 0 || m_outPipeline == NULL ) {
 		return SJBE_STATE_CLOSED;
 	}
 
-	for( i = 0; i < iCnt; i++ )
-	{
-		SjGstreamerBackendStream* stream = (SjGstreamerBackendStream*)allStreams.Item(i);
-		GstState state;
-		if( gst_element_get_state(stream->m_pipeline, &state, NULL, 3000*MILLISEC_TO_NANOSEC_FACTOR /*wait max. 3 seconds*/) != GST_STATE_CHANGE_SUCCESS ) {
-			return SJBE_STATE_PLAYING; // we assume, a stream is coming very soon
-		}
-		if( state != GST_STATE_PAUSED ) {
-			return SJBE_STATE_PLAYING;
-		}
+	// do not wait for asynchronous changes, use the state we're going to instead
+	GstState state, pending;
+	GstStateChangeReturn ret = gst_element_get_state(m_outPipeline, &state, &pending, 0);
+	if( ret == GST_STATE_CHANGE_ASYNC && pending != GST_STATE_VOID_PENDING ) {
+		state = pending;
+	}
+	else if( ret == GST_STATE_CHANGE_FAILURE ) {
+		return SJBE_STATE_PLAYING; // we assume, a stream is coming very soon
 	}
 
-	return SJBE_STATE_PAUSED;
+	return state == GST_STATE_PAUSED? SJBE_STATE_PAUSED : SJBE_STATE_PLAYING;
 }
 
 
 void SjGstreamerBackend::SetDeviceState(SjBackendState state)
 {
 	if( state == SJBE_STATE_CLOSED ) {
-		return; // if there are no streams on the device, it is closed, nothing special to do here
+		// if there are no streams on the device, it is closed - release the audio sink; the pipeline is kept for reuse
+		if( GetAllStreams().GetCount() == 0 ) {
+			DeletePreparedBin();
+			set_element_state(m_outPipeline, GST_STATE_NULL);
+			m_latencyMs = -1; // the sink may be another one on the next opening
+		}
+		return;
 	}
 
-	const wxArrayPtrVoid& allStreams = GetAllStreams();
-	size_t i, iCnt = allStreams.GetCount();
-	for( i = 0; i < iCnt; i++ )
-	{
-		SjGstreamerBackendStream* stream = (SjGstreamerBackendStream*)allStreams.Item(i);
+	// pausing and resuming is not waited for, see GetDeviceState()
+	if( m_outPipeline ) {
+		gst_element_set_state(m_outPipeline, state==SJBE_STATE_PLAYING? GST_STATE_PLAYING : GST_STATE_PAUSED);
+	}
+}
+
 
-		stream->set_pipeline_state(state==SJBE_STATE_PLAYING? GST_STATE_PLAYING : GST_STATE_PAUSED);
+long SjGstreamerBackend::GetLatencyMs()
+{
+	// the stream data pass the mixer and are buffered by the audio sink before they're heard; so we use the
+	// latency of the mixer plus the buffer size of the sink.  autoaudiosink creates the real sink
+	// not before the device is opened, so we calculate this on the first request while playing.
+	if( m_latencyMs < 0 && m_outPipeline && GST_STATE(m_outPipeline) == GST_STATE_PLAYING )
+	{
+		long sinkMs = 0;
+		GstIterator* it = gst_bin_iterate_recurse(GST_BIN(m_outPipeline));
+			GValue item = G_VALUE_INIT;
+			while( gst_iterator_next(it, &item) == GST_ITERATOR_OK )
+			{
+				GstElement* e = GST_ELEMENT(g_value_get_object(&item));
+				if( GST_OBJECT_FLAG_IS_SET(e, GST_ELEMENT_FLAG_SINK)
+				 && g_object_class_find_property(G_OBJECT_GET_CLASS(e), "buffer-time") )
+				{
+					gint64 us = 0;
+					g_object_get(G_OBJECT(e), "buffer-time", &us, NULL);
+					if( us/1000 > sinkMs ) {
+						sinkMs = (long)(us/1000);
+					}
+				}
+				g_value_reset(&item);
+			}
+			g_value_unset(&item);
+		gst_iterator_free(it);
+		m_latencyMs = SJ_GST_MIX_LATENCY_MS + sinkMs;
 	}
+
+	return m_latencyMs > 0? m_latencyMs : 0;
 }
 
 
 void SjGstreamerBackend::SetDeviceVol(double gain)
 {
-	const wxArrayPtrVoid& allStreams = GetAllStreams();
-	size_t i, iCnt = allStreams.GetCount();
-	for( i = 0; i < iCnt; i++ )
+	// this does not set the "main" volume but the volume of the mixed output;
+	// we cannot get louder than the OS-setting this way.
+	if( m_outPipeline )
 	{
-		SjGstreamerBackendStream* stream = (SjGstreamerBackendStream*)allStreams.Item(i);
-
-		// this does not set the "main" volume but the volume of the stream;
-		// we cannot get louder than the OS-setting this way, however, this may be useful for our crossfading.
-		GstElement* volumeElem = gst_bin_get_by_name(GST_BIN(stream->m_pipeline), "sjVolume");
+		GstElement* volumeElem = gst_bin_get_by_name(GST_BIN(m_outPipeline), "sjVolume");
 		if( volumeElem )
 		{
 			g_object_set(G_OBJECT(volumeElem), "volume", (gdouble)gain /*0: mute, 1.0: 100%, >1.0: additional gain*/, NULL /*NULL marks end of list*/);
+			gst_object_unref(volumeElem);
 		}
 	}
 }
@@ -453,12 +1032,17 @@ void SjGstreamerBackendStream::GetTime(long& totalMs, long& elapsedMs)
 	totalMs   = -1; // unknown total time
 	elapsedMs = -1; // unknown elapsed time
 
+	if( !m_srcPad ) {
+		return;
+	}
+
+	// the queries are forwarded upstream to the demuxer/decoder of this stream
 	gint64 ns;
-	if( gst_element_query_duration(m_pipeline, GST_FORMAT_TIME, &ns) ) {
+	if( gst_pad_query_duration(m_srcPad, GST_FORMAT_TIME, &ns) ) {
 		totalMs = ns/NANOSEC_TO_MILLISEC_DIVISOR;
 	}
 
-	if( gst_element_query_position(m_pipeline, GST_FORMAT_TIME, &ns) ) {
+	if( gst_pad_query_position(m_srcPad, GST_FORMAT_TIME, &ns) ) {
 		elapsedMs = ns/NANOSEC_TO_MILLISEC_DIVISOR;
 	}
 }
@@ -466,18 +1050,42 @@ void SjGstreamerBackendStream::GetTime(long& totalMs, long& elapsedMs)
 
 void SjGstreamerBackendStream::SeekAbs(long seekMs)
 {
-	gst_element_seek_simple(m_pipeline, GST_FORMAT_TIME,
-		(GstSeekFlags)(GST_SEEK_FLAG_FLUSH|GST_SEEK_FLAG_KEY_UNIT), seekMs*MILLISEC_TO_NANOSEC_FACTOR);
+	if( !m_srcPad ) {
+		return;
+	}
+
+	// after a flushing seek, the stream starts over at running time 0, so shift it to the current mixer time.
+	// the seek event travels upstream from our ghost pad, the flush affects only this stream, not the mixer.
+	gst_pad_set_offset(m_srcPad, m_backend->GetMixerRunningTime());
+	gst_pad_send_event(m_srcPad, gst_event_new_seek(1.0, GST_FORMAT_TIME,
+		(GstSeekFlags)(GST_SEEK_FLAG_FLUSH|GST_SEEK_FLAG_KEY_UNIT),
+		GST_SEEK_TYPE_SET, seekMs*MILLISEC_TO_NANOSEC_FACTOR, GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE));
 }
 
 
 SjGstreamerBackendStream::~SjGstreamerBackendStream()
 {
-	set_pipeline_state(GST_STATE_NULL);
-	gst_object_unref(GST_OBJECT(m_pipeline));
-	m_pipeline = NULL;
-	g_source_remove(m_bus_watch_id);
-	m_bus_watch_id = 0;
+	DetachFromMixer();
+}
+
+
+void SjGstreamerBackendStream::DetachFromMixer()
+{
+	if( m_bin )
+	{
+		// detach the stream from the mixer, the mixer and the audio sink continue running
+		if( m_mixerPad ) {
+			gst_pad_unlink(m_srcPad, m_mixerPad);
+			gst_element_release_request_pad(m_backend->m_mixer, m_mixerPad);
+			gst_object_unref(m_mixerPad);
+			m_mixerPad = NULL;
+		}
+
+		// the bin is stopped and freed in the background, we do not wait for it
+		stop_stream_bin(m_bin, m_backend->m_outPipeline); // this also unrefs m_bin
+		m_bin = NULL;
+		m_srcPad = NULL; // owned by m_bin
+	}
 }
 
 
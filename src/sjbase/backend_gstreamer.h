@@ -32,6 +32,7 @@
 
 #include <sjbase/backend.h>
 #include <gst/gst.h>
+#include <atomic>
 
 
 class SjGstreamerBackendStream;
@@ -41,17 +42,54 @@ class SjGstreamerBackend : public SjBackend
 {
 public:
 	                 SjGstreamerBackend  (SjBackendId);
-	                 ~SjGstreamerBackend () { SetDeviceState(SJBE_STATE_CLOSED); }
+	                 ~SjGstreamerBackend ();
 	void             GetLittleOptions    (SjArrayLittleOption&);
 	SjBackendStream* CreateStream        (const wxString& url, long seekMs, SjBackendCallback*, SjBackendUserdata* userdata);
 	SjBackendState   GetDeviceState      () const;
 	void             SetDeviceState      (SjBackendState);
 	void             SetDeviceVol        (double gain);
+	void             PrepareStream       (const wxString& url);
+	long             GetLatencyMs        ();
+	bool             MixesStreams        () const { return true; }
 
 protected:
 	wxString         m_iniAudioPipeline;
 	wxString         m_iniVideoPipeline;
+
+	// all streams are mixed into one long-lived output pipeline:
+	// streams are attached to and detached from m_mixer, the audio sink stays opened
+	// until the device is closed, so gapless playback and crossfading need no new sink.
+	GstElement*      m_outPipeline;
+	GstElement*      m_mixer;
+	guint            m_bus_watch_id;
+	long             m_latencyMs;        // -1 if not yet calculated
+	bool             CreateOutPipeline   ();
+	void             DeleteOutPipeline   ();
+	gint64           GetMixerRunningTime ();
+	SjGstreamerBackendStream* FindStream (GstObject* elem);
+	SjGstreamerBackendStream* FindStream (gpointer streamPtr);
+	GstElement*      CreateStreamBin     (const wxString& url);
+
+	// the callback for SJBE_MSG_DSP_MIXED is the one given to CreateStream(), it is called from a probe on the mixer's source pad
+	SjBackendCallback* m_mixCb;
+	SjBackendCallbackParam m_mixCbp;
+
+	// the next stream may be prepared by PrepareStream(): its bin is added to m_outPipeline unlinked and
+	// started in the background; the first decoded buffer is blocked until CreateStream() asks for the same url.
+	GstElement*      m_preparedBin;
+	wxString         m_preparedUrl;
+	GstPad*          m_preparedBlockPad;
+	gulong           m_preparedBlockId;
+	std::atomic<bool> m_preparedReady;   // set from a streaming thread if the first buffer is blocked
+	std::atomic<bool> m_preparedHasVideo;// set from a streaming thread, video streams are not prepared
+	void             DeletePreparedBin   ();
+
+	friend class     SjGstreamerBackendStream;
 	friend void      on_pad_added        (GstElement*, GstPad*, gpointer);
+	friend void      on_prepared_pad_added(GstElement*, GstPad*, gpointer);
+	friend GstPadProbeReturn on_prepared_pad_blocked(GstPad*, GstPadProbeInfo*, gpointer);
+	friend gboolean  on_bus_message      (GstBus*, GstMessage*, gpointer);
+	friend GstPadProbeReturn on_mixed_data(GstPad*, GstPadProbeInfo*, gpointer);
 };
 
 
@@ -66,23 +104,31 @@ protected:
 	SjGstreamerBackendStream(const wxString& url, SjGstreamerBackend* backend, SjBackendCallback* cb, SjBackendUserdata* userdata)
 		: SjBackendStream(url, backend, cb, userdata)
     {
-		m_backend      = backend;
-		m_pipeline     = NULL;
-		m_bus_watch_id = 0;
-		m_capsChecked  = false;
-		m_eosSend      = false;
+		m_backend       = backend;
+		m_bin           = NULL;
+		m_srcPad        = NULL;
+		m_mixerPad      = NULL;
+		m_capsChecked   = false;
+		m_eosSend       = false;
+		m_pendingSeekMs = 0;
+		m_dropUntilFlush= false;
     }
 
-	GstElement*         m_pipeline;
-	guint               m_bus_watch_id;
+	GstElement*         m_bin;          // uridecodebin -> audioconvert -> audioresample -> capsfilter, owned by m_backend->m_outPipeline
+	GstPad*             m_srcPad;       // ghost pad of m_bin
+	GstPad*             m_mixerPad;     // request pad of m_backend->m_mixer, linked to m_srcPad
 	SjGstreamerBackend* m_backend;
 	bool                m_capsChecked;
 	bool                m_eosSend;
-	void                set_pipeline_state  (GstState s);
+	std::atomic<long>   m_pendingSeekMs;
+	std::atomic<bool>   m_dropUntilFlush; // set in the main thread, cleared by a streaming thread on flush
+	void                SendEos             ();
+	void                DetachFromMixer     ();
 
 	friend class             SjGstreamerBackend;
 	friend void              on_pad_added  (GstElement*, GstPad*, gpointer);
 	friend GstPadProbeReturn on_pad_data   (GstPad*, GstPadProbeInfo*, gpointer);
+	friend GstPadProbeReturn on_pad_event  (GstPad*, GstPadProbeInfo*, gpointer);
 	friend gboolean          on_bus_message(GstBus*, GstMessage*, gpointer);
 };
 
@@ -1706,10 +1706,10 @@ wxString SjListBrowser::GetFirstVisiblePos()
 {
 	if( m_listView )
 	{
-		SjTrackInfo ti;
-		long albumId, special;
-		m_listView->GetTrack(m_scrollPos, ti, albumId, special);
-		return ti.m_url;
+		wxString url;
+		long albumId;
+		m_listView->GetTrackUrl(m_scrollPos, url, albumId);
+		return url;
 	}
 	return wxEmptyString;
 }
@@ -1725,11 +1725,11 @@ wxString SjListBrowser::GetFirstSelectedOrVisiblePos(long& retViewOffset)
 		if( offset == -1 )
 			return GetFirstVisiblePos();
 
-		SjTrackInfo ti;
-		long albumId, special;
-		m_listView->GetTrack(offset, ti, albumId, special);
+		wxString url;
+		long albumId;
+		m_listView->GetTrackUrl(offset, url, albumId);
 		retViewOffset = (offset-m_scrollPos) | (SJ_BROWSER_LIST_VIEW<<24);
-		return ti.m_url;
+		return url;
 	}
 
 	wxASSERT( 0 );
@@ -1746,11 +1746,11 @@ wxString SjListBrowser::GetFirstSelectedAndVisiblePos(long& retViewOffset)
 		long offset = GetFirstSelectedAndVisible();
 		if( offset != -1 )
 		{
-			SjTrackInfo ti;
-			long albumId, special;
-			m_listView->GetTrack(offset, ti, albumId, special);
+			wxString url;
+			long albumId;
+			m_listView->GetTrackUrl(offset, url, albumId);
 			retViewOffset = (offset-m_scrollPos) | (SJ_BROWSER_LIST_VIEW<<24);
-			return ti.m_url;
+			return url;
 		}
 	}
 
@@ -2198,9 +2198,8 @@ void SjListBrowser::DoPaint(wxDC& dc)
 				}
 				else if( m_listView->GetTrackSpecial(index)&SJ_LISTVIEW_SPECIAL_FIRST_TRACK )
 				{
-					SjTrackInfo  tiDummy;
-					long         tiSpecial;
-					m_listView->GetTrack(index, tiDummy, tiAlbumId, tiSpecial);
+					wxString     tiUrl;
+					m_listView->GetTrackUrl(index, tiUrl, tiAlbumId);
 				}
 
 				if( tiAlbumId )
@@ -77,6 +77,10 @@
 #define SJ_DEF_SQLITE_SYNC  0L      // 0=off (fast), 1=normal (save but slower), 2=full (very save and slow)
 #endif
 
+#ifndef SJ_DEF_SQLITE_WAL
+#define SJ_DEF_SQLITE_WAL   1L      // use write-ahead logging if the jukebox is not on a network filesystem
+#endif
+
 #ifndef SJ_DEF_SQLITE_CACHE_BYTES
 #define SJ_DEF_SQLITE_CACHE_BYTES 0x100000L
 #endif
@@ -1160,6 +1160,13 @@ Done:
 
 	// invoke auto control stuff
 	m_autoCtrl.OnOneSecondTimer();
+
+	// write back changed configuration values
+	wxSqltDb* db = wxSqltDb::GetDefault();
+	if( db )
+	{
+		db->ConfigFlush();
+	}
 }
 
 
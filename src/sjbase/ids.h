@@ -309,6 +309,10 @@
 #define IDO_SCRIPT_MENU00       8613 /* range start */
 #define IDO_SCRIPT_MENU99       8712 /* range end */
 #define IDO_CONSOLE             8713
+#define IDO_AUTOVOLANALYZED     8714
+#define IDO_URLSVERIFIED        8715
+#define IDO_SKINFLUSHDIRTY      8716
+#define IDO_LOADPLUGINS         8717
 /* take care, we're close to end! At 8800 the IDPLAYER_ IDs start! */
 
 /* [PLAYER] [ID]s, IDPLAYER_*, posted from SjPlayer -> SjMainFrame -> SjPlayer.OnPostBack()
@@ -327,6 +331,7 @@
 #define IDTIMER_TRIGGERBALLOON  8908
 #define IDTIMER_CLOSEBALLOON    8909
 #define IDTIMER_SETSIZEHACK     8910
+#define IDTIMER_AUTOVOLANALYZER 8911
 
 #define ID_HTTP_SERVER          8980
 #define ID_HTTP_SOCKET          8981
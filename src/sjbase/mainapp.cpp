@@ -236,7 +236,9 @@ public:
  ******************************************************************************/
 
 
+#if !SJ_BENCHMARK_APP // the benchmark program has its own entry point, see benchmark_app.cpp
 IMPLEMENT_APP(SjMainApp)
+#endif
 
 
 BEGIN_EVENT_TABLE(SjMainApp, wxApp)
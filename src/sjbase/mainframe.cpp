@@ -475,6 +475,29 @@ public:
 };
 
 
+void SjMainFrame::OnLoadPlugins(wxCommandEvent&)
+{
+	// load the external plugins; this is done after the main window is constructed and shown,
+	// opening the libraries should not delay the first paint
+	SjModuleList* list = m_moduleSystem.GetModules(SJ_MODULETYPE_ALL);
+	SjModuleList::Node* moduleNode = list->GetFirst();
+	while( moduleNode )
+	{
+		SjModule* module = moduleNode->GetData();
+		wxASSERT(module);
+
+		if( (module->m_type == SJ_MODULETYPE_COMMON || module->m_type == SJ_MODULETYPE_SCANNER)
+		 && module->m_interface != g_internalInterface
+		 && !module->IsLoaded() )
+		{
+			module->Load();
+		}
+
+		moduleNode = moduleNode->GetNext();
+	}
+}
+
+
 void SjMainFrame::OnIDO_DND_ONDATA(wxCommandEvent& evt)
 {
 	SjDropTarget* dropTarget = (SjDropTarget*)evt.GetClientData();
@@ -1155,33 +1178,29 @@ SjMainFrame::SjMainFrame(SjMainApp* mainApp, int id, long skinFlags, const wxPoi
 
 	m_showRemainingTime = g_tools->m_config->Read(wxT("main/showRemainingTime"), 1L)!=0;
 
-	/* (/) load other GUI modules, this sets MANY global pointers to the modules
+	/* (/) load other GUI modules, this sets MANY global pointers to the modules;
+	 * external plugins are not needed for the first paint, they're loaded by OnLoadPlugins()
 	 */
 	{
 		int i, iCount;
-		for( i = 0; i < 2; i++ )
+		SjModuleList* list = m_moduleSystem.GetModules(SJ_MODULETYPE_ALL);
+		SjModuleList::Node* moduleNode = list->GetFirst();
+		while( moduleNode )
 		{
-			SjModuleList* list = m_moduleSystem.GetModules(SJ_MODULETYPE_ALL);
-			SjModuleList::Node* moduleNode = list->GetFirst();
-			while( moduleNode )
-			{
-				SjModule* module = moduleNode->GetData();
-				wxASSERT(module);
+			SjModule* module = moduleNode->GetData();
+			wxASSERT(module);
 
-				if( module->m_type == SJ_MODULETYPE_COMMON
-				 || module->m_type == SJ_MODULETYPE_SCANNER )
-				{
-					if( (i==0 && module->m_interface == g_internalInterface)
-					 || (i==1 && module->m_interface != g_internalInterface) )
-					{
-						module->Load();
-					}
-				}
-
-				moduleNode = moduleNode->GetNext();
+			if( (module->m_type == SJ_MODULETYPE_COMMON || module->m_type == SJ_MODULETYPE_SCANNER)
+			 && module->m_interface == g_internalInterface )
+			{
+				module->Load();
 			}
+
+			moduleNode = moduleNode->GetNext();
 		}
 
+		GetEventHandler()->QueueEvent(new wxCommandEvent(wxEVT_COMMAND_MENU_SELECTED, IDO_LOADPLUGINS));
+
 		// Load scripts - if things are not ready at this point, make it safe to use them anyway.
 		// Remember, the skin, which may also use scripts, is also already loaded.
 		wxFileSystem fs;
@@ -1291,6 +1310,11 @@ SjMainFrame::SjMainFrame(SjMainApp* mainApp, int id, long skinFlags, const wxPoi
 		m_player.LoadFromResumeFile();
 	}
 
+	if( m_player.m_queue.GetQueueFlags()&SJ_QUEUEF_RESUME )
+	{
+		m_player.StartResumeJournal(); // from now on, all queue operations are written to the resume file
+	}
+
 	/* (/) Show the window, init Drag'n'Drop
 	 */
 	if( startMinimized )
@@ -1491,6 +1515,7 @@ BEGIN_EVENT_TABLE(SjMainFrame, SjSkinWindow)
 	EVT_MENU_RANGE  (IDPLAYER_FIRST,
 	                 IDPLAYER_LAST,             SjMainFrame::OnFwdToPlayer          )
 	EVT_MENU        (IDO_DND_ONDATA,            SjMainFrame::OnIDO_DND_ONDATA       )
+	EVT_MENU        (IDO_LOADPLUGINS,           SjMainFrame::OnLoadPlugins          )
 	EVT_MENU        (IDO_PASTE,                 SjMainFrame::OnPaste                )
 	EVT_MENU        (IDO_PASTE_USING_COORD,     SjMainFrame::OnPaste                )
 	EVT_MENU        (IDO_ESC,                   SjMainFrame::OnEsc                  )
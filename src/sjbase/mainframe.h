@@ -132,6 +132,7 @@ public:
 	#define         SJ_OPENFILES_PLAY       1
 	#define         SJ_OPENFILES_ENQUEUE    2
 	void            OnIDO_DND_ONDATA    (wxCommandEvent&);
+	void            OnLoadPlugins       (wxCommandEvent&);
 	bool            OpenFiles           (const wxArrayString&, int command=SJ_OPENFILES_DEFCMD, int x=0, int y=0);
 	bool            OpenData            (SjDataObject*, int command=SJ_OPENFILES_DEFCMD, int x=0, int y=0);
 	bool            DragNDrop           (SjDragNDropAction, wxWindow*, const wxPoint&, SjDataObject* data, wxArrayString* files);
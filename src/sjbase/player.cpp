@@ -38,11 +38,13 @@
 
 
 #include <sjbase/base.h>
+#include <sjbase/queuejournal.h>
 #include <sjbase/queue.h>
 #include <sjbase/player.h>
 #include <sjbase/columnmixer.h>
 #include <sjtools/volumecalc.h>
 #include <sjtools/volumefade.h>
+#include <sjtools/playbackclock.h>
 #include <sjmodules/vis/vis_module.h>
 #include <sjmodules/fx/eq_equalizer.h>
 #include <see_dom/sj_see.h>
@@ -139,6 +141,7 @@ SjPlayer::SjPlayer()
 	m_avCalculatedGain      = 1.0F;
 
 	m_eqEnabled             = SJ_EQ_DEF_ENABLED;
+	m_mixEqualizer          = NULL;
 
 	m_autoCrossfade         = SJ_DEF_AUTO_CROSSFADE_ENABLED;
 	m_autoCrossfadeSubseqDetect = false;
@@ -195,6 +198,8 @@ void SjPlayer::Init()
 
 	m_eqEnabled                 = (c->Read("player/eqActive",          SJ_EQ_DEF_ENABLED? 1L : 0L))!=0;
 	m_eqParam.FromString        (  c->Read("player/eqParam",           ""));
+	m_mixEqualizer = new SjEqualizer();
+	m_mixEqualizer->SetParam(m_eqEnabled, m_eqParam);
 
 	m_prelistenDest             =c->Read("player/prelistenDest",       SJ_PL_DEFAULT);
 	m_prelistenUseSysVol        =c->Read("player/prelistenUseSysVol",  SJ_SYSVOL_DEFAULT);
@@ -272,6 +277,12 @@ void SjPlayer::Exit()
 			m_prelistenBackend = NULL;
 		}
 
+		if( m_mixEqualizer )
+		{
+			delete m_mixEqualizer;
+			m_mixEqualizer = NULL;
+		}
+
 		m_queue.Exit();
 	}
 }
@@ -321,61 +332,33 @@ wxString SjPlayer::GetResumeFile() const
 void SjPlayer::SaveToResumeFile()
 {
 	// this function is called on shutdown, where our program may be _killed_ by the operating system.
-	// so we do not risk to write larger data to the sqlite database but use a simple text file instead.
-
-	// create header with common information
-	unsigned long startMs = SjTools::GetMsTicks();
-	wxString content("resumeversion=2\n");
-	int i, iCount = m_queue.GetCount(), iPos = m_queue.GetCurrPos();
-
-	// collect all URLs
-	bool addPlayed = (m_queue.GetQueueFlags()&SJ_QUEUEF_RESUME_LOAD_PLAYED)!=0;
-	long playcount, entryflags;
-	for( i = 0; i < iCount; i++ )
-	{
-		SjPlaylistEntry& e = m_queue.GetInfo(i);
-		playcount = e.GetPlayCount();
-		entryflags = e.GetFlags();
-		if( playcount==0 || addPlayed || i==iPos )
-		{
-			if( playcount > 0 ) {
-				content += "played=1\n"; // setting for the URL following
-			}
-
-			if( entryflags & SJ_PLAYLISTENTRY_AUTOPLAY ) {
-				content += "autoplay=1\n"; // setting for the URL following
-			}
-
-			if( i==iPos ) {
-				long totalMs, elapsedMs = -1/*stop or pause*/, remainingMs;
-				if( IsPlaying() ) {
-					GetTime(totalMs, elapsedMs/*may be -1 for 'unknown'*/, remainingMs);
-					if( elapsedMs < 0 ) {
-						elapsedMs = 0; // >=0: playing
-					}
-				}
-				content += wxString::Format("playing=%i\n", (int)elapsedMs); // setting for the URL following, save independingly of SJ_QUEUEF_RESUME_START_PLAYBACK as we always init the queue positions
-			}
-
-			content += "url=" + e.GetUnverifiedUrl() + "\n"; // the unverified URL may contain Tabs! When we reload the information. If we load the file later, we treat all URLs as unverfied (eg. the files may have changed)
+	// the queue itself is already in the journal, see SjQueueJournal, so we only add the elapsed time
+	// and wait until everything is written.
+	long totalMs, elapsedMs = -1/*stop or pause*/, remainingMs;
+	if( IsPlaying() ) {
+		GetTime(totalMs, elapsedMs/*may be -1 for 'unknown'*/, remainingMs);
+		if( elapsedMs < 0 ) {
+			elapsedMs = 0; // >=0: playing
 		}
 	}
 
-	// open file to write
+	if( !m_queue.IsJournaling() )
 	{
-		wxLogNull null;
-		wxFile file(GetResumeFile(), wxFile::write);
-		if( !file.IsOpened() )
-		{
-			return; // do not log any error, we're in shutdown
-		}
+		StartResumeJournal(); // resuming was enabled just now
+	}
+
+	m_queue.FlushJournal(elapsedMs);
+}
 
-		// add some footer information and write
-		wxDateTime dt = wxDateTime::Now().ToUTC();
-		content += dt.Format("created=%Y-%m-%dT%H:%M:%S+00:00\n");
 
-		content += wxString::Format("ms=%i\n", (int)(SjTools::GetMsTicks()-startMs)); // speed is about 500 tracks per millisecond on my system from the year 2012
-		file.Write(content, wxConvUTF8);
+void SjPlayer::StartResumeJournal()
+{
+	// should be called after LoadFromResumeFile() - or instead of it if the queue is
+	// loaded otherwise - the journal is overwritten by the current queue then.
+	wxString resumeFile = GetResumeFile();
+	if( !resumeFile.IsEmpty() )
+	{
+		m_queue.StartJournal(resumeFile);
 	}
 }
 
@@ -384,62 +367,34 @@ void SjPlayer::LoadFromResumeFile()
 {
 	// load content from file
     // we do not delete the file physically after loading.
-    // If the next shutdown fails it is better to load "too many" tracks with a repeated playing position than nothing.	wxString content;
-	wxString content;
+    // If the next shutdown fails it is better to load "too many" tracks with a repeated playing position than nothing.
+	wxString resumeFile = GetResumeFile();
+	SjQueueJournalState state;
+	if( !SjQueueJournal::Load(resumeFile, state) )
 	{
-		wxString resumeFile = GetResumeFile();
-		wxFileSystem fileSystem;
-		wxFSFile* fsFile = fileSystem.OpenFile(resumeFile, wxFS_READ);
-		if( fsFile == NULL )
-		{
-			return; // do not log any error, there is simply no resume file
-		}
-
-		wxLogInfo("Loading %s", resumeFile.c_str());
-		content = SjTools::GetFileContent(fsFile->GetStream(), &wxConvUTF8);
-		delete fsFile;
+		return; // do not log any error, there is simply no resume file
 	}
+	wxLogInfo("Loading %s", resumeFile.c_str());
 
-	// go through all lines of the content
-	wxString            istVersion;
-	SjLineTokenizer     tkz(content);
-	wxChar*             currLinePtr;
-	wxString            currLine, currKey, currValue;
-	long                currPlayed = 0, currAutoplay = 0;
+	// collect the URLs to load; played URLs are skipped unless wanted, however,
+	// the URL at the playing position is always loaded
+	bool                addPlayed = (m_queue.GetQueueFlags()&SJ_QUEUEF_RESUME_LOAD_PLAYED)!=0;
 	wxArrayString       allUrls;
 	wxArrayLong         allPlayed;
 	wxArrayLong         allAutoplay;
-	long                allPos = -1, allElapsed = -1;
-	while( (currLinePtr=tkz.GetNextLine()) )
+	long                allPos = -1, allElapsed = state.m_elapsedMs;
+	int i, iCount = state.m_urls.GetCount();
+	for( i = 0; i < iCount; i++ )
 	{
-		currLine  = currLinePtr;
-		currKey   = currLine.BeforeFirst('=');
-		currValue = currLine.AfterFirst('=');
-
-		if( currKey == "played" )
-		{
-			currPlayed = 1;
-		}
-		else if( currKey == "autoplay" )
-		{
-			currAutoplay = 1;
-		}
-		else if( currKey == "playing" )
+		if( state.m_playCounts[i]==0 || addPlayed || i==state.m_pos )
 		{
-			allPos = allUrls.Count(); // the next added URL is our queue position
-			if( !currValue.ToLong(&allElapsed) ) {
-				allElapsed = -1; // stopped or paused, to not play
+			if( i==state.m_pos ) {
+				allPos = allUrls.Count(); // the next added URL is our queue position
 			}
-		}
-		else if( currKey == "url" )
-		{
-			allUrls.Add(currValue);
-			allPlayed.Add(currPlayed);
-			allAutoplay.Add(currAutoplay);
 
-			// prepare for next URL
-			currPlayed = 0;
-			currAutoplay = 0;
+			allUrls.Add(state.m_urls[i]);
+			allPlayed.Add(state.m_playCounts[i]>0? 1 : 0);
+			allAutoplay.Add((state.m_flags[i]&SJ_PLAYLISTENTRY_AUTOPLAY)? 1 : 0);
 		}
 	}
 
@@ -459,7 +414,7 @@ void SjPlayer::LoadFromResumeFile()
 	// mark URLs as autoplay/played
 	wxASSERT( allUrls.Count() == allPlayed.Count() );
 	wxASSERT( allUrls.Count() == allAutoplay.Count() );
-	int i, iCount = m_queue.GetCount(); if( iCount > (int)allUrls.Count() ) { iCount = (int)allUrls.Count(); } // get min
+	iCount = m_queue.GetCount(); if( iCount > (int)allUrls.Count() ) { iCount = (int)allUrls.Count(); } // get min
 	for( i = 0; i < iCount; i++ )
 	{
 		SjPlaylistEntry& e = m_queue.GetInfo(i);
@@ -496,6 +451,7 @@ public:
 		m_onCreateFadeDestGain = onCreateFadeDestGain;
 		m_isVideo              = false;
 		m_realMs               = 0;
+		m_realMsTimestamp      = 0;
 		m_autoDelete           = false; // if set, the stream is deleted on EOS or if fading is done
 		m_autoDeleteSend       = false;
 	}
@@ -504,10 +460,12 @@ public:
 	SjPlayer*     m_player;
 	bool          m_isPrelistenStream;
 	bool          m_isVideo;
-	long          m_realMs;
+	long          m_realMs;          // the total time as last queried from the stream, see SjPlayer::GetTime()
+	unsigned long m_realMsTimestamp;
 	SjVolumeCalc  m_volumeCalc;
 	SjVolumeFade  m_volumeFade;
 	SjEqualizer   m_equalizer;
+	SjPlaybackClock m_clock;
 
 	bool              m_autoDelete;
 	bool              m_autoDeleteSend;
@@ -522,6 +480,26 @@ void SjPlayer_BackendCallback(SjBackendCallbackParam* cbp)
 
 	// TAKE CARE II: `stream` may lay on different backends!
 
+	if( cbp->msg == SJBE_MSG_DSP_MIXED )
+	{
+		/* DSP on the mixed output, see SjBackend::MixesStreams()
+		***********************************************************************/
+
+		// the equalizer and the visualisation need the data only once, not once per stream; as the equalizer
+		// is linear, this is the same as equalizing each stream before mixing, but needs half the time while crossfading
+		SjPlayer* player = &g_mainFrame->m_player;
+		if( cbp->backend == player->m_backend && player->m_mixEqualizer && cbp->buffer != NULL && cbp->bytes > 0 )
+		{
+			player->m_mixEqualizer->AdjustBuffer(cbp->buffer, cbp->bytes, cbp->samplerate, cbp->channels);
+
+			if( g_visModule->IsVisStarted() )
+			{
+				g_visModule->AddVisData(cbp->buffer, cbp->bytes);
+			}
+		}
+		return;
+	}
+
 	SjBackendStream*   stream     = cbp->stream;        if( stream == NULL )   { return; }
 	SjBackendUserdata* userdata   = stream->m_userdata; if( userdata == NULL ) { return; }
 	SjPlayer*          player     = userdata->m_player; if( player == NULL )   { return; }
@@ -537,6 +515,13 @@ void SjPlayer_BackendCallback(SjBackendCallbackParam* cbp)
 
 		if( buffer != NULL && bytes > 0 )
 		{
+			// on a backend mixing its streams, the equalizer and the visualisation of the main output
+			// are done on SJBE_MSG_DSP_MIXED; streams of the prelisten output still use their own equalizer
+			bool mixedOutput = (cbp->backend == player->m_backend && cbp->backend->MixesStreams());
+
+			// update the playback position, this is what SjPlayer::GetTime() returns
+			userdata->m_clock.AddBuffer(cbp->posMs, bytes, samplerate, channels);
+
 			// calculate the volume - we do this ALWAYS, if autovol is enabled or not
 			userdata->m_volumeCalc.AddBuffer(buffer, bytes, samplerate, channels);
 
@@ -552,11 +537,14 @@ void SjPlayer_BackendCallback(SjBackendCallbackParam* cbp)
 
 			// equalizer - after volumeCalc, otherwise, volumeCalc would calculate the volume depending on the eq settings
 			// do not check for m_eqEnabled here, this state is forwarded to the corresponsing equalizer object, if needed
-			userdata->m_equalizer.AdjustBuffer(buffer, bytes, samplerate, channels);
+			if( !mixedOutput )
+			{
+				userdata->m_equalizer.AdjustBuffer(buffer, bytes, samplerate, channels);
+			}
 
 			// forward the data to the visualisation -
 			// we do this after autovol, equalizers etc. so that these changes become visible eg. in the spectrum analyzer
-			if( g_visModule->IsVisStarted() && stream == player->m_streamA /*this also excludes prelistening*/ )
+			if( !mixedOutput && g_visModule->IsVisStarted() && stream == player->m_streamA /*this also excludes prelistening*/ )
 			{
 				g_visModule->AddVisData(buffer, bytes);
 			}
@@ -920,6 +908,9 @@ void SjPlayer::GotoAbsPos(long queuePos, bool fadeToPos)
 void SjPlayer::Seek(long seekMs)
 {
 	if( m_streamA ) {
+		if( m_streamA->m_userdata ) {
+			m_streamA->m_userdata->m_clock.Seek(seekMs);
+		}
 		m_streamA->SeekAbs(seekMs);
 	}
 }
@@ -945,9 +936,41 @@ void SjPlayer::GetTime(long& totalMs, long& elapsedMs, long& remainingMs)
 	}
 
 	// calculate totalMs and elapsedMs, if unknown, -1 is returned.
-	m_streamA->GetTime(totalMs, elapsedMs);
-	if( totalMs > 0 ) {
-		m_streamA->m_userdata->m_realMs = totalMs;
+	// the elapsed time comes from the playback clock fed by the DSP callback; the backend is only
+	// queried until the clock has data.  the total time is remembered for the stream (so a new
+	// track starts without it) but queried again from time to time, it may change while playing,
+	// eg. for VBR files without header or for streams that are still loading.
+	#define SJ_REALMS_REQUERY_MS 5000
+	SjBackendUserdata* userdata = m_streamA->m_userdata;
+	elapsedMs = -1;
+	totalMs = -1;
+	if( userdata ) {
+		elapsedMs = userdata->m_clock.GetElapsedMs(m_backend->GetLatencyMs(), !m_paused);
+		if( userdata->m_realMs > 0 && SjTools::GetMsTicks() - userdata->m_realMsTimestamp < SJ_REALMS_REQUERY_MS ) {
+			totalMs = userdata->m_realMs;
+		}
+	}
+
+	if( elapsedMs == -1 || totalMs == -1 ) {
+		long queriedTotalMs, queriedElapsedMs;
+		m_streamA->GetTime(queriedTotalMs, queriedElapsedMs);
+		if( elapsedMs == -1 ) {
+			elapsedMs = queriedElapsedMs;
+		}
+		if( totalMs == -1 && userdata ) {
+			if( queriedTotalMs > 0 ) {
+				userdata->m_realMs = queriedTotalMs;
+				userdata->m_realMsTimestamp = SjTools::GetMsTicks();
+			}
+			totalMs = userdata->m_realMs > 0? userdata->m_realMs : -1; // on errors, use the last known time
+		}
+		else if( totalMs == -1 ) {
+			totalMs = queriedTotalMs;
+		}
+	}
+
+	if( totalMs > 0 && elapsedMs > totalMs ) {
+		elapsedMs = totalMs;
 	}
 
 	// remaining time
@@ -1094,6 +1117,11 @@ void SjPlayer::EqSetParam(const bool* newEnabled, const SjEqParam* newParam)
 
 		m_streamA->m_userdata->m_equalizer.SetParam(m_eqEnabled, m_eqParam);
 	}
+
+	if( m_mixEqualizer )
+	{
+		m_mixEqualizer->SetParam(m_eqEnabled, m_eqParam);
+	}
 }
 
 
@@ -1150,14 +1178,52 @@ void SjPlayer::GetPrelistenInfo(wxString& url, long& totalMs, long& elapsedMs, l
 }
 
 
+void SjPlayer::PrepareNextStream(long totalMs, long elapsedMs)
+{
+	// let the backend open and pre-roll the next track some seconds before it is needed,
+	// so that the track change or the crossfade starts without delay
+	#define PREPARE_AHEAD_MS 8000
+	if( totalMs <= 0 || elapsedMs < 0 || m_stopAfterThisTrack || m_stopAfterEachTrack ) {
+		return;
+	}
+
+	long prepareAtMs = totalMs - PREPARE_AHEAD_MS;
+	if( m_autoCrossfade ) { prepareAtMs -= m_autoCrossfadeMs+m_crossfadeOffsetEndMs; }
+	if( elapsedMs < prepareAtMs ) {
+		return; // still waiting for the correct moment
+	}
+
+	// no auto-play here, this is done when the track really ends
+	long nextQueuePos = m_queue.GetNextPos(SJ_PREVNEXT_REGARD_REPEAT);
+	if( nextQueuePos == -1 ) {
+		return;
+	}
+
+	wxString nextUrl = m_queue.GetUrlByPos(nextQueuePos);
+	if( m_failedUrls.Index(nextUrl) != wxNOT_FOUND ) {
+		return;
+	}
+
+	m_backend->PrepareStream(nextUrl); // does nothing if the url is already prepared
+}
+
+
 void SjPlayer::OneSecondTimer()
 {
-	if( !m_autoCrossfade || m_streamA == NULL || m_streamA->m_userdata == NULL ) {
-		return; // crossfading and silence detection disabled OR no stream
+	if( m_streamA == NULL || m_streamA->m_userdata == NULL ) {
+		return; // no stream
+	}
+
+	long totalMs, elapsedMs, remainingMs;
+	GetTime(totalMs, elapsedMs, remainingMs);
+	if( !m_paused ) {
+		PrepareNextStream(totalMs, elapsedMs);
+	}
+
+	if( !m_autoCrossfade ) {
+		return; // crossfading and silence detection disabled
 	}
 
-	long totalMs = -1, elapsedMs = -1;
-	m_streamA->GetTime(totalMs, elapsedMs);
 	if( totalMs < m_autoCrossfadeMs*2 || elapsedMs < 0 || m_streamA->m_userdata->m_isVideo ) {
 		return; // do not crossfade on very short tracks OR if the position is unknwon OR if the current stream is a video (may cause problems if the next stream is also a video)
 	}
@@ -43,6 +43,7 @@ class SjBackend;
 class SjBackendStream;
 struct SjBackendCallbackParam;
 class SjVolumeCalc;
+class SjEqualizer;
 
 
 class SjPlayer
@@ -59,6 +60,7 @@ public:
 	// resume
 	void            SaveToResumeFile    ();
 	void            LoadFromResumeFile  ();
+	void            StartResumeJournal  ();
 	wxString        GetResumeFile       () const;
 
 	// Basic Player Control.
@@ -162,6 +164,7 @@ private:
 	SjBackendStream* m_streamA;
 	SjBackendStream* CreateStream       (const wxString& url, bool createPrelistenStream, long seekMs, long fadeMs);
 	void             DeleteStream       (SjBackendStream**, long fadeMs); // the given pointer must not be used by the caller after using this function!
+	void             PrepareNextStream  (long totalMs, long elapsedMs);
 
 	#define          SJ_SYSVOL_DONTUSE  0
 	#define          SJ_SYSVOL_USE      1
@@ -210,6 +213,7 @@ private:
 	#define         SJ_EQ_DEF_ENABLED     false
 	bool            m_eqEnabled;
 	SjEqParam       m_eqParam;
+	SjEqualizer*    m_mixEqualizer; // used for the mixed output of m_backend if it MixesStreams()
 
 	// crossfading etc.
 	#define         SJ_DEF_AUTO_CROSSFADE_ENABLED   true
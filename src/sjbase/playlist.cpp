@@ -49,6 +49,7 @@
 
 #include <sjbase/base.h>
 #include <sjbase/playlist.h>
+#include <sjbase/urlverifier.h>
 #include <tagger/tg_a_tagger_frontend.h>
 #include <wx/html/htmlwin.h>
 
@@ -306,7 +307,7 @@ void SjPlaylistEntry::VerifyUrl()
 
 				if( fsFile == NULL )
 				{
-					m_url = m_url.BeforeFirst('\t');
+					SetVerifiedUrl(m_url.BeforeFirst('\t'), false);
 					return; // Url not found
 				}
 			}
@@ -348,15 +349,7 @@ void SjPlaylistEntry::VerifyUrl()
 	#endif
 
 	// file opened - save the location as the verified URL
-	// and close the file
-	if( m_playlist )
-	{
-		m_playlist->RehashUrl(m_url/*really the original URL*/, fsFileLocation);
-	}
-
-	m_url = fsFileLocation;
-
-	m_urlOk = TRUE; // assume, it is also playable, we cannot be more exact berfore we really try it
+	SetVerifiedUrl(fsFileLocation, true);
 
 	// done
 	#ifdef DEBUG_VERIFY
@@ -365,6 +358,61 @@ void SjPlaylistEntry::VerifyUrl()
 }
 
 
+void SjPlaylistEntry::SetVerifiedUrl(const wxString& url, bool ok)
+{
+	// called by VerifyUrl() and by SjUrlVerifier for entries not yet verified
+	// by VerifyUrl(); if ok is false, url is the unverified URL without the
+	// additional information
+	m_urlVerified = TRUE;
+
+	if( ok && m_playlist )
+	{
+		m_playlist->RehashUrl(m_url/*really the original URL*/, url);
+	}
+
+	m_url = url;
+
+	m_urlOk = ok; // assume, it is also playable, we cannot be more exact berfore we really try it
+}
+
+
+SjPlaylist::~SjPlaylist()
+{
+	StopVerifying();
+}
+
+
+void SjPlaylist::VerifyInBackground()
+{
+	// This function may only be called from the main thread.
+	wxASSERT( wxThread::IsMain() );
+
+	long i, iCount = m_array.GetCount();
+	for( i = 0; i < iCount; i++ )
+	{
+		SjPlaylistEntry& entry = m_array[i];
+		if( !entry.m_urlVerified )
+		{
+			if( m_verifier == NULL )
+			{
+				m_verifier = new SjUrlVerifier(this);
+			}
+			m_verifier->Add(entry.GetId(), entry.m_url);
+		}
+	}
+}
+
+
+void SjPlaylist::StopVerifying()
+{
+	if( m_verifier )
+	{
+		delete m_verifier; // waits for the worker
+		m_verifier = NULL;
+	}
+}
+
+
 void SjPlaylist::RehashUrl(const wxString& oldUrl, const wxString& newUrl)
 {
 	// Get the sum of occurences from old and new url
@@ -698,28 +746,25 @@ bool SjPlaylist::AddFromM3uFile(const wxString& nativePath, long addMax, long fl
 		fileContentMbConv = &wxConvUTF8;
 	}
 
-	wxString content = SjTools::GetFileContent(fsFile->GetStream(), fileContentMbConv); // GetFileContent() will also check for the BOM (Byte order mark)
-
-	// process
-	SjLineTokenizer     tkz(content);
-	wxChar*             currLinePtr;
+	// process, the file is read line by line
+	SjStreamTokenizer   tkz(fsFile->GetStream(), fileContentMbConv); // SjStreamTokenizer will also check for the BOM (Byte order mark)
+	wxString            currLine;
 	wxString            currTitle;
 	long                filesAdded = 0;
 
-	while( (currLinePtr=tkz.GetNextLine()) )
+	while( tkz.GetNextLine(currLine) )
 	{
-		if( *currLinePtr == 0 )
+		if( currLine.IsEmpty() )
 		{
 			// skip empty lines
 			continue;
 		}
-		else if( *currLinePtr == '#' )
+		else if( currLine[0] == '#' )
 		{
 			// read comment - the comment is used by VerifyUrl() to find the track in the library if the URL cannot be found (bad path, bad name etc.)
-			if( wxStrncmp(currLinePtr, "#EXTINF:", 8)==0 )
+			if( currLine.StartsWith("#EXTINF:") )
 			{
-				currTitle = wxString(&currLinePtr[8]);
-				currTitle = currTitle.AfterFirst(',');              // skip seconds parameter from "#EXTINF:seconds,artiest ..."
+				currTitle = currLine.AfterFirst(',');               // skip seconds parameter from "#EXTINF:seconds,artiest ..."
 
 				if( currTitle.Replace(" - ", "\t\t") < 1 )          // normally, the format ist "Artist - Title" ...
 				{                                                   // ... however, since 3.02, we also allow "Artist-Title" ...
@@ -729,7 +774,7 @@ bool SjPlaylist::AddFromM3uFile(const wxString& nativePath, long addMax, long fl
 			continue;
 		}
 
-		Add(wxString(currLinePtr) + "\t" + nativePath + "\t" + currTitle, FALSE, 0);
+		Add(currLine + "\t" + nativePath + "\t" + currTitle, FALSE, 0);
 		currTitle.Empty();
 
 		filesAdded++;
@@ -794,10 +839,8 @@ bool SjPlaylist::AddFromPlsFile(const wxString& nativePath, long addMax, long fl
 		return false;
 	}
 
-	// parse file
-	wxString            content = SjTools::GetFileContent(fsFile->GetStream(), &wxConvISO8859_1);
-	SjLineTokenizer     tkz(content);
-	wxChar*             currLinePtr;
+	// parse file, the file is read line by line
+	SjStreamTokenizer   tkz(fsFile->GetStream(), &wxConvISO8859_1);
 	wxString            currLine, currBegin, currNumStr, currRest;
 	long                currNumLong;
 
@@ -807,12 +850,9 @@ bool SjPlaylist::AddFromPlsFile(const wxString& nativePath, long addMax, long fl
 	wxArrayString       titles;
 	long                titleCount = 0;
 
-	while( (currLinePtr=tkz.GetNextLine()) )
+	while( tkz.GetNextLine(currLine) )
 	{
-		if( *currLinePtr == 0 ) continue; // skip empty line
-
-		// read line
-		currLine = currLinePtr;
+		if( currLine.IsEmpty() ) continue; // skip empty line
 
 		// split line at '='
 		currBegin = currLine.BeforeFirst('=');
@@ -934,19 +974,16 @@ bool SjPlaylist::AddFromCueFile(const wxString& nativePath, long addMax, long fl
 		return false;
 	}
 
-	// parse file
-	wxString            content = SjTools::GetFileContent(fsFile->GetStream(), &wxConvISO8859_1);
-	SjLineTokenizer     tkz(content);
-	wxChar*             currLinePtr;
+	// parse file, the file is read line by line
+	SjStreamTokenizer   tkz(fsFile->GetStream(), &wxConvISO8859_1);
 	wxString            currLine;
 	long                filesAdded = 0;
 
-	while( (currLinePtr=tkz.GetNextLine()) )
+	while( tkz.GetNextLine(currLine) )
 	{
-		if( *currLinePtr == 0 ) continue; // skip empty line
+		if( currLine.IsEmpty() ) continue; // skip empty line
 
 		// read line
-		currLine = currLinePtr;
 		currLine.Replace("\t", " ");
 		if( currLine.Left(5).Upper()!="FILE " ) continue;
 
@@ -1043,29 +1080,19 @@ bool SjPlaylist::AddFromXspfXmlWplFile(const wxString& nativePath, long addMax,
 	    <title>Nobody Move, Nobody Get Hurt</title>
 	    <location>file:///mp3s/titel_1.mp3</location>
 	    ...
-	</track> */
-	wxString content = SjTools::GetFileContent(fsFile->GetStream(), &wxConvUTF8);
-	content.Replace("\n", ""); // remove line-ends, this allows to put tags over several lines as
-	content.Replace("\r", ""); // <location> \n \n \n bla \n \n \n</location>.
-	// below, we will convert the character "<" to a linebreak ...
+	</track>
 
-	/* ... convert the following XML/iTunes format to XSPF ...
+	... the following XML/iTunes format is read the same way, the values are assigned by the
+	preceding <key> and </dict> is handled as </track> ...
 	<dict>
 	    <key>Artist</key><string>Led Zeppelin</string>
 	    <key>Album</key><string>Coda</string>
 	    <key>Name</key><string>Ozone Baby</string>
 	    <key>Location</key><string>file://localhost/Volumes/music/mp3/L/Led%20Zeppelin/1982%20Coda/05%20Ozone%20Baby.mp3</string>
 	    ...
-	</dict> */
-	if( content.Replace("<key>Name</key><string>", "<title>") > 0 )
-	{
-		content.Replace("<key>Artist</key><string>", "<creator>");
-		content.Replace("<key>Album</key><string>", "<album>");
-		content.Replace("<key>Location</key><string>", "<location>");
-		content.Replace("/dict", "/track");
-	}
+	</dict>
 
-	/* ... convert the following Windows Media Player/WPL format  to XSPF ...
+	... and for the Windows Media Player/WPL format, each <media> is a track:
 	<?wpl version="1.0"?>
 	<smil>
 	<head>
@@ -1079,23 +1106,16 @@ bool SjPlaylist::AddFromXspfXmlWplFile(const wxString& nativePath, long addMax,
 	        <media src="file2.mp3"/>
 	        ...
 	    </seq>
-	</body> */
-	if( content.Find("<?wpl") != wxNOT_FOUND )
-	{
-		if( content.Replace("<media src=\"", "<location>") > 0 )
-		{
-			content.Replace("\"", "</track>");
-			content.Replace("&apos;", "'"); // &apos; is no real html entity. normal entities are handled below
-		}
-	}
+	</body>
 
-	// treat "<" as a new line mark, this allows easy parsing without using a XML tree
-	content.Replace("<", "\n");
+	The file is read tag by tag, so even large iTunes libraries are read with little memory; line-ends
+	inside the values are removed, this allows to put tags over several lines as
+	<location> \n \n \n bla \n \n \n</location>. */
 
-	// go through the content
+	SjStreamTokenizer       tkz(fsFile->GetStream(), &wxConvUTF8);
+	wxString                currTag, currText, lastKey;
 	long                    filesAdded = 0;
-	SjLineTokenizer         tkz(content);
-	wxChar*                 currLinePtr;
+	bool                    isWpl = false, flush;
 
 	wxString                lastArtistName;
 	wxString                lastAlbumName;
@@ -1104,45 +1124,76 @@ bool SjPlaylist::AddFromXspfXmlWplFile(const wxString& nativePath, long addMax,
 
 	wxHtmlEntitiesParser    entPars;
 
-	while( (currLinePtr=tkz.GetNextLine()) )
+	while( tkz.GetNextTag(currTag, currText) )
 	{
-		if( *currLinePtr == 0 ) continue; // skip empty line
+		if( currTag.IsEmpty() ) continue; // skip empty tag
 
 		// remove xspf prefix, if any (used by some apps, see http://wiki.xiph.org/List_of_known_XSPF_extensions )
-		if( wxStrncmp(currLinePtr, "xspf:", 5)==0 )
-			currLinePtr += 5;
+		if( currTag.StartsWith("xspf:") )
+			currTag.Remove(0, 5);
+
+		flush = false;
 
-		if( wxStrncmp(currLinePtr, "creator", 7)==0 )
+		if( currTag == "key" )
+		{
+			// iTunes: remember the key, the value follows in the next tag
+			lastKey = currText;
+			continue;
+		}
+		else if( currTag == "/key" )
+		{
+			// iTunes: keep the key until the value tag is read
+			continue;
+		}
+		else if( currTag == "string" && !lastKey.IsEmpty() )
+		{
+			// iTunes: set the value of the last key
+			     if( lastKey == "Artist" )   { lastArtistName = entPars.Parse(currText); }
+			else if( lastKey == "Album" )    { lastAlbumName  = entPars.Parse(currText); }
+			else if( lastKey == "Name" )     { lastTrackName  = entPars.Parse(currText); }
+			else if( lastKey == "Location" ) { lastLocation   = entPars.Parse(currText); }
+		}
+		else if( currTag.StartsWith("creator") )
 		{
 			// set last artist name
-			lastArtistName = currLinePtr;
-			lastArtistName = lastArtistName.AfterFirst('>');
-			lastArtistName = entPars.Parse(lastArtistName);
+			lastArtistName = entPars.Parse(currText);
 		}
-		else if( wxStrncmp(currLinePtr, "album", 5)==0 )
+		else if( currTag.StartsWith("album") )
 		{
 			// set last album name
-			lastAlbumName = currLinePtr;
-			lastAlbumName = lastAlbumName.AfterFirst('>');
-			lastAlbumName = entPars.Parse(lastAlbumName);
+			lastAlbumName = entPars.Parse(currText);
 		}
-		else if( wxStrncmp(currLinePtr, "title", 5)==0 )
+		else if( currTag.StartsWith("title") )
 		{
 			// set last track name
-			lastTrackName = currLinePtr;
-			lastTrackName = lastTrackName.AfterFirst('>');
-			lastTrackName = entPars.Parse(lastTrackName);
+			lastTrackName = entPars.Parse(currText);
 		}
-		else if( wxStrncmp(currLinePtr, "location", 8)==0 )
+		else if( currTag.StartsWith("location") )
 		{
 			// set last location
-			lastLocation = currLinePtr;
-			lastLocation = lastLocation.AfterFirst('>');
-			lastLocation = entPars.Parse(lastLocation);
+			lastLocation = entPars.Parse(currText);
 		}
-		else if( wxStrncmp(currLinePtr, "/track", 6)==0 )
+		else if( currTag.StartsWith("/track") || currTag.StartsWith("/dict") )
+		{
+			flush = true;
+		}
+		else if( currTag.StartsWith("?wpl") )
+		{
+			isWpl = true;
+		}
+		else if( isWpl && currTag.StartsWith("media ") )
+		{
+			// WPL: set the location from the src attribute and flush
+			wxString src = currTag.AfterFirst('"').BeforeFirst('"');
+			src.Replace("&apos;", "'"); // &apos; is no real html entity. normal entities are handled below
+			lastLocation = entPars.Parse(src);
+			flush = true;
+		}
+
+		lastKey.Empty(); // any other tag is the value of the last key or has no key
+
+		if( flush )
 		{
-			// flush
 			if( lastLocation.IsEmpty() && !lastTrackName.IsEmpty() && !lastArtistName.IsEmpty() )
 			{
 				lastLocation = "stub://" + SjTools::EnsureValidFileNameChars(lastArtistName) + "-" + SjTools::EnsureValidFileNameChars(lastAlbumName) + "-" + SjNormaliseString(lastTrackName, 0) + ".mp3";
@@ -1360,7 +1411,6 @@ bool SjPlaylist::AddFromFile(const wxString& nativePath, long addMax, long flags
 	wxString        ext = SjTools::GetExt(nativePath);
 	bool            ret;
 
-	if( !g_mainFrame ) return FALSE;
 	if( addMax <= 0 ) addMax = 0x7FFFFFFL;
 
 	// load basic urls - the AddFrom*() function should not validate the files!
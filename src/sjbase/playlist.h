@@ -31,6 +31,7 @@
 
 
 class SjPlaylist;
+class SjUrlVerifier;
 
 
 class SjPlaylistAddInfo
@@ -142,6 +143,9 @@ private:
 	void            CheckAddInfo        (long what) { if(m_addInfo==NULL||!(m_addInfo->m_what&what)) { LoadAddInfo(what); } }
 	void            LoadAddInfo         (long what);
 	void            VerifyUrl           ();
+	void            SetVerifiedUrl      (const wxString& url, bool ok);
+	friend class    SjPlaylist;
+	friend class    SjUrlVerifier;
 };
 
 WX_DECLARE_OBJARRAY(SjPlaylistEntry, SjArrayPlaylistEntry);
@@ -151,7 +155,8 @@ WX_DECLARE_OBJARRAY(SjPlaylistEntry, SjArrayPlaylistEntry);
 class SjPlaylist
 {
 public:
-	                SjPlaylist          () { m_cacheFlags=0; }
+	                SjPlaylist          () { m_cacheFlags=0; m_verifier=NULL; }
+	                ~SjPlaylist         ();
 
 	// clear playlist
 	void            Clear               () { m_cacheFlags=0; m_array.Clear(); m_urlCounts.Clear(); };
@@ -221,6 +226,13 @@ public:
 
 	void            RehashUrl           (const wxString& oldUrl, const wxString& newUrl);
 
+	// verify the URLs of all unverified entries in background; entries
+	// needed before are still verified as usual when they're accessed.
+	// StopVerifying() waits for the worker and should be called before the
+	// library is unloaded.
+	void            VerifyInBackground  ();
+	void            StopVerifying       ();
+
 	// OnUrlChanged() checks if the old url is in the playlist. If so,
 	// all references are modified to use the new url.
 	void            OnUrlChanged        (const wxString& oldUrl, const wxString& newUrl);
@@ -234,6 +246,9 @@ private:
 	SjArrayPlaylistEntry m_array;
 	SjSLHash        m_urlCounts;
 
+	// created on the first call to VerifyInBackground()
+	SjUrlVerifier*  m_verifier;
+
 	// meta data
 	wxString        m_playlistName;
 	wxString        m_playlistUrl;
@@ -27,6 +27,7 @@
 
 
 #include <sjbase/base.h>
+#include <sjbase/queuejournal.h>
 
 
 /*******************************************************************************
@@ -56,6 +57,9 @@ SjQueue::SjQueue()
 
 	m_isInitialized         = false;
 
+	m_journal               = NULL;
+	m_journalPosId          = 0;
+
 	CleanupNextShufflePos();
 }
 
@@ -298,6 +302,7 @@ long SjQueue::GetNextPos(int flags)
 
 				// move "betterPos" to "newPos", the returned "newPos" will not be changed
 				wxASSERT( betterPos > newPos  );
+				if( m_journal ) { m_journal->Move(GetIdByPos(betterPos), newPos); }
 				m_playlist.MovePos(betterPos, newPos);
 			}
 		}
@@ -657,9 +662,21 @@ void SjQueue::SetCurrPos(long pos)
 
 	// mark as played
 	m_playlist.Item(pos).SetPlayCount(m_repeatRound);
+	if( m_journal ) { m_journal->SetPlayCount(GetIdByPos(pos), m_repeatRound); }
 
 	// add to history (needed for the "previous" button and for "avoid boredom")
 	AddToHistory(pos);
+
+	SyncJournal();
+}
+
+
+void SjQueue::ResetPlayCount(long pos)
+{
+	m_playlist.Item(pos).SetPlayCount(0);
+	if( m_journal ) { m_journal->SetPlayCount(GetIdByPos(pos), 0); }
+
+	CleanupNextShufflePos();
 }
 
 
@@ -729,6 +746,7 @@ long SjQueue::MoveByIds(const SjLLHash& idsToMove, long motionAmount)
 	{
 		for( i = 0; i < iCount; i++ )
 		{
+			if( m_journal ) { m_journal->Move(GetIdByPos(posToMove[i]), posToMove[i]+motionAmount); }
 			m_playlist.MovePos(posToMove[i], posToMove[i]+motionAmount);
 		}
 	}
@@ -736,6 +754,7 @@ long SjQueue::MoveByIds(const SjLLHash& idsToMove, long motionAmount)
 	{
 		for( i = iCount-1; i >= 0; i-- )
 		{
+			if( m_journal ) { m_journal->Move(GetIdByPos(posToMove[i]), posToMove[i]+motionAmount); }
 			m_playlist.MovePos(posToMove[i], posToMove[i]+motionAmount);
 		}
 	}
@@ -746,6 +765,8 @@ long SjQueue::MoveByIds(const SjLLHash& idsToMove, long motionAmount)
 		m_pos = GetPosById(currPosId);
 	}
 
+	SyncJournal();
+
 	return motionAmount;
 }
 
@@ -809,6 +830,11 @@ long SjQueue::EnqueueDo__(const wxString& url, long addBeforeThisPos, bool verif
 		}
 	}
 
+	if( m_journal )
+	{
+		m_journal->Add(m_playlist[newPos].GetId(), newPos, playlistEntryFlags, url);
+	}
+
 	return newPos;
 }
 
@@ -827,6 +853,8 @@ void SjQueue::EnqueueFinish__(long oldPos)
 			SetCurrPos(newPos); // in Silverjuke <= 2.52beta15, we set m_pos directly instead of calling SetCurrPos() --
 		// this results in a missing playing mark for the first track played -- s. http://www.silverjuke.net/forum/topic-2593.html
 	}
+
+	SyncJournal();
 }
 
 
@@ -881,6 +909,13 @@ long SjQueue::Enqueue(const wxArrayString& urls, long addBeforeThisPos, bool ver
 
 	EnqueueFinish__(oldPos);
 
+	// verify larger numbers of unverified URLs, eg. from imported playlists or
+	// from the resume file, in background; single URLs are verified on access
+	if( !verified && urlsCount >= SJ_QUEUE_VERIFY_IN_BACKGROUND )
+	{
+		m_playlist.VerifyInBackground();
+	}
+
 	return newPos;
 }
 
@@ -973,6 +1008,7 @@ long SjQueue::UnqueueByPos(long pos, SjPlayer* player, int* replayRet)
 
 	wxASSERT( wxThread::IsMain() );
 
+	if( m_journal ) { m_journal->Remove(GetIdByPos(pos)); }
 	long restUrls = m_playlist.RemoveAt(pos);
 	int  replayHere = 0;
 
@@ -1020,6 +1056,8 @@ long SjQueue::UnqueueByPos(long pos, SjPlayer* player, int* replayRet)
 
 	CleanupNextShufflePos();
 
+	SyncJournal();
+
 	return restUrls;
 }
 
@@ -1121,8 +1159,11 @@ void SjQueue::UnqueueAll(SjPlayer* player, bool stopVisIfPlaying)
 	m_pos = -1;
 	m_playlist.Clear();
 	m_historyIds.Clear();
+	if( m_journal ) { m_journal->Clear(); }
 
 	CleanupNextShufflePos();
+
+	SyncJournal();
 }
 
 
@@ -1176,3 +1217,84 @@ bool SjQueue::MoveToTopOnEoq() const
 }
 
 
+
+
+/*******************************************************************************
+ * Journal
+ ******************************************************************************/
+
+
+void SjQueue::StartJournal(const wxString& file)
+{
+	// This function may only be called from the main thread.
+	wxASSERT( wxThread::IsMain() );
+
+	if( m_journal == NULL )
+	{
+		m_journal = new SjQueueJournal(file);
+		CompactJournal(); // the IDs used by older records are no longer valid
+	}
+}
+
+
+void SjQueue::FlushJournal(long elapsedMs)
+{
+	if( m_journal )
+	{
+		m_journalPosId = GetIdByCurrPos();
+		m_journal->SetPos(m_journalPosId, m_journalPosId<0? -1 : elapsedMs);
+		m_journal->Close(); // waits for the writer, the next record starts a new one
+	}
+}
+
+
+void SjQueue::StopJournal()
+{
+	if( m_journal )
+	{
+		delete m_journal; // waits for the writer
+		m_journal = NULL;
+	}
+}
+
+
+void SjQueue::SyncJournal()
+{
+	if( m_journal == NULL )
+	{
+		return;
+	}
+
+	// the position is journaled by the ID, so only changes of the current
+	// entry are written and not all position corrections on unqueueing
+	long currId = GetIdByCurrPos();
+	if( currId != m_journalPosId )
+	{
+		m_journalPosId = currId;
+		m_journal->SetPos(currId, currId<0? -1 : 0);
+	}
+
+	// compacting the journal needs O(n), as this is needed only after O(n)
+	// records, the time per record is still constant
+	if( m_journal->NeedsCompaction(GetCount()) )
+	{
+		CompactJournal();
+	}
+}
+
+
+void SjQueue::CompactJournal()
+{
+	wxString snapshot;
+	long i, iCount = GetCount();
+	for( i = 0; i < iCount; i++ )
+	{
+		SjPlaylistEntry& entry = m_playlist.Item(i);
+		SjQueueJournal::AddToSnapshot(snapshot, entry.GetId(), i, entry.GetFlags(), entry.GetPlayCount(), entry.GetUnverifiedUrl());
+	}
+
+	m_journalPosId = GetIdByCurrPos();
+	SjQueueJournal::AddPosToSnapshot(snapshot, m_journalPosId, m_journalPosId<0? -1 : 0);
+
+	m_journal->Compact(snapshot);
+}
@@ -39,6 +39,7 @@ enum SjRepeat
 
 
 class SjPlayer;
+class SjQueueJournal;
 
 
 class SjQueue
@@ -46,10 +47,13 @@ class SjQueue
 public:
 	                SjQueue             ();
 	void            Init                ()  { m_isInitialized = true; }
-	void            Exit                ()  { m_isInitialized = false; }
+	void            Exit                ()  { m_playlist.StopVerifying(); StopJournal(); m_isInitialized = false; }
 
 	// enqueue / unqueue.  The player object for unqueing is needed to stop the
-	// playback if there is nothing left in the queue.
+	// playback if there is nothing left in the queue.  If at least
+	// SJ_QUEUE_VERIFY_IN_BACKGROUND unverified URLs are enqueued at once, they
+	// are verified in background.
+	#define         SJ_QUEUE_VERIFY_IN_BACKGROUND 16
 	long            Enqueue             (const wxArrayString& urls, long addBeforeThisPos, bool verified, SjLLHash* addedIds, long flags);
 	long            UnqueueByPos        (long pos, SjPlayer*, int* replayRet=NULL); // returns the number of identical URLs still in the queue at other positions
 	void            UnqueueByUrl        (const wxString& url, SjPlayer*, int* replayRet=NULL);
@@ -77,7 +81,7 @@ public:
 	wxArrayString   GetUrls             () const;
 	bool            WasPlayed           (long pos) const            { return m_playlist.Item(pos).GetPlayCount()>0; }
 	long            GetPlayCount        (long pos) const            { return m_playlist.Item(pos).GetPlayCount(); }
-	void            ResetPlayCount      (long pos)                  { m_playlist.Item(pos).SetPlayCount(0); CleanupNextShufflePos(); }
+	void            ResetPlayCount      (long pos);
 	long            GetFlags            (long pos) const            { return m_playlist.Item(pos).GetFlags(); }
 	void            SetFlags            (long pos, long flags)      { m_playlist.Item(pos).SetFlags(flags); }
 	void            SetCurrErroneous    ();
@@ -130,6 +134,7 @@ public:
 		m_boredomTrackMinutes = t;
 		m_boredomArtistMinutes = a;
 		CleanupNextShufflePos();
+		if( !(flags&SJ_QUEUEF_RESUME) ) { StopJournal(); }
 	}
 
 	long            GetQueueFlags       () const
@@ -149,6 +154,14 @@ public:
 
 	void            OnUrlChanged        (const wxString& oldUrl, const wxString& newUrl) { m_playlist.OnUrlChanged(oldUrl, newUrl); }
 
+	// journal all queue operations to the given file, see SjQueueJournal;
+	// StartJournal() replaces the journal by the current queue.  FlushJournal()
+	// adds the elapsed time of the current track and waits until all is written.
+	void            StartJournal        (const wxString& file);
+	void            FlushJournal        (long elapsedMs);
+	void            StopJournal         ();
+	bool            IsJournaling        () const { return m_journal!=NULL; }
+
 	// move tracks
 	long            MoveByIds           (const SjLLHash& idsToMove, long motionAmount);
 
@@ -205,6 +218,13 @@ private:
 	long            m_queueFlags;
 	int             m_boredomTrackMinutes, m_boredomArtistMinutes;
 
+	// the journal, NULL if resuming is disabled; SyncJournal() should be
+	// called after the queue is modified.
+	SjQueueJournal* m_journal;
+	long            m_journalPosId;
+	void            SyncJournal         ();
+	void            CompactJournal      ();
+
 	// Misc.
 	SjPlaylistEntry m_dummyPlaylistInfo;
 };
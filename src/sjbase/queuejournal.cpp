@@ -0,0 +1,462 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    queuejournal.cpp
+ * Authors: Björn Petersen
+ * Purpose: Append-only journal of the queue operations, used for resuming
+ *
+ *******************************************************************************
+ *
+ * Up to Silverjuke 16.x, the whole queue was written to the resume file on
+ * shutdown; if the program crashed or was killed, the queue was lost.  Now,
+ * each queue operation is appended to the file as a single line as it happens:
+ *
+ *      add=<id>,<pos>,<flags>,<url>
+ *      del=<id>
+ *      move=<id>,<pos>
+ *      count=<id>,<playCount>
+ *      pos=<id>,<elapsedMs>
+ *      clear=
+ *
+ * The IDs are the entry IDs of the session that has written the records.  The
+ * lines are written and flushed in a worker thread, several lines at once.  If
+ * the journal grows too large, it is replaced by a snapshot of the queue in the
+ * same format, written to a temporary file which is renamed then.  A broken
+ * last line, eg. on a power loss, is ignored on loading.
+ *
+ * Load() also reads the old resume files using the keys played, autoplay,
+ * playing and url.
+ *
+ ******************************************************************************/
+
+
+#include <sjbase/base.h>
+#include <sjbase/queuejournal.h>
+
+
+#define SJ_QUEUEJOURNAL_SYNC_MS 200
+
+
+/*******************************************************************************
+ * SjQueueJournalWriter
+ ******************************************************************************/
+
+
+class SjQueueJournalWriter : public wxThread
+{
+public:
+	SjQueueJournalWriter(SjQueueJournal* journal)
+		: wxThread(wxTHREAD_JOINABLE)
+	{
+		m_journal = journal;
+		Create();
+		Run();
+	}
+
+	void*           Entry               ();
+
+private:
+	SjQueueJournal* m_journal;
+	bool            WriteSnapshot       (const wxString& snapshot);
+};
+
+
+void* SjQueueJournalWriter::Entry()
+{
+	// do not log any error, the journal is written in background
+	wxLogNull null;
+
+	wxFile file;
+	while( 1 )
+	{
+		wxString pending, snapshot;
+		bool     snapshotPending, exit;
+		{
+			wxMutexLocker locker(m_journal->m_mutex);
+			while( m_journal->m_pending.IsEmpty() && !m_journal->m_snapshotPending && !m_journal->m_exit )
+			{
+				m_journal->m_condition.Wait();
+			}
+
+			// wait a little moment to write the records following in the
+			// same block, so that we flush at most 5 times per second
+			if( !m_journal->m_exit )
+			{
+				m_journal->m_condition.WaitTimeout(SJ_QUEUEJOURNAL_SYNC_MS);
+			}
+
+			pending         = m_journal->m_pending.Clone(); // deep copy, the strings are used in another thread
+			snapshot        = m_journal->m_snapshot.Clone();
+			snapshotPending = m_journal->m_snapshotPending;
+			exit            = m_journal->m_exit;
+			m_journal->m_pending.Empty();
+			m_journal->m_snapshot.Empty();
+			m_journal->m_snapshotPending = false;
+		}
+
+		if( snapshotPending )
+		{
+			file.Close();
+			WriteSnapshot(snapshot);
+		}
+
+		if( !pending.IsEmpty() )
+		{
+			if( !file.IsOpened() )
+			{
+				file.Open(m_journal->m_file, wxFile::write_append);
+			}
+
+			if( file.IsOpened() )
+			{
+				file.Write(pending, wxConvUTF8);
+				file.Flush();
+			}
+		}
+
+		if( exit )
+		{
+			break; // no more records are added after Close() was called
+		}
+	}
+
+	return 0;
+}
+
+
+bool SjQueueJournalWriter::WriteSnapshot(const wxString& snapshot)
+{
+	// write the snapshot to a temporary file, so that we still have the old
+	// journal if we get killed while writing
+	wxString tempFile = m_journal->m_file + ".tmp";
+	{
+		wxFile file(tempFile, wxFile::write);
+		if( !file.IsOpened() )
+		{
+			return false;
+		}
+
+		if( !file.Write(snapshot, wxConvUTF8) || !file.Flush() )
+		{
+			return false;
+		}
+	}
+
+	return ::wxRenameFile(tempFile, m_journal->m_file, true/*overwrite*/);
+}
+
+
+/*******************************************************************************
+ * SjQueueJournal - Writing
+ ******************************************************************************/
+
+
+SjQueueJournal::SjQueueJournal(const wxString& file)
+	: m_condition(m_mutex)
+{
+	m_file              = file;
+	m_recordCount       = 0;
+	m_snapshotPending   = false;
+	m_exit              = false;
+	m_writer            = NULL;
+}
+
+
+SjQueueJournal::~SjQueueJournal()
+{
+	Close();
+}
+
+
+void SjQueueJournal::AddRecord(const wxString& record)
+{
+	wxASSERT( wxThread::IsMain() );
+
+	m_recordCount++;
+
+	if( m_writer == NULL )
+	{
+		m_writer = new SjQueueJournalWriter(this);
+	}
+
+	wxMutexLocker locker(m_mutex);
+	bool wakeUp = m_pending.IsEmpty(); // otherwise, the writer is already awake
+	m_pending += record;
+	if( wakeUp )
+	{
+		m_condition.Signal();
+	}
+}
+
+
+void SjQueueJournal::Add(long id, long pos, long flags, const wxString& unverifiedUrl)
+{
+	AddRecord(wxString::Format("add=%i,%i,%i,", (int)id, (int)pos, (int)(flags&SJ_PLAYLISTENTRY_AUTOPLAY)) + unverifiedUrl + "\n");
+}
+
+
+void SjQueueJournal::Remove(long id)
+{
+	AddRecord(wxString::Format("del=%i\n", (int)id));
+}
+
+
+void SjQueueJournal::Move(long id, long pos)
+{
+	AddRecord(wxString::Format("move=%i,%i\n", (int)id, (int)pos));
+}
+
+
+void SjQueueJournal::SetPlayCount(long id, long playCount)
+{
+	AddRecord(wxString::Format("count=%i,%i\n", (int)id, (int)playCount));
+}
+
+
+void SjQueueJournal::SetPos(long id, long elapsedMs)
+{
+	AddRecord(wxString::Format("pos=%i,%i\n", (int)id, (int)elapsedMs));
+}
+
+
+void SjQueueJournal::Clear()
+{
+	AddRecord("clear=\n");
+}
+
+
+void SjQueueJournal::AddToSnapshot(wxString& snapshot, long id, long pos, long flags, long playCount, const wxString& unverifiedUrl)
+{
+	if( snapshot.IsEmpty() )
+	{
+		snapshot = "resumeversion=3\n";
+	}
+
+	snapshot += wxString::Format("add=%i,%i,%i,", (int)id, (int)pos, (int)(flags&SJ_PLAYLISTENTRY_AUTOPLAY)) + unverifiedUrl + "\n";
+	if( playCount )
+	{
+		snapshot += wxString::Format("count=%i,%i\n", (int)id, (int)playCount);
+	}
+}
+
+
+void SjQueueJournal::AddPosToSnapshot(wxString& snapshot, long id, long elapsedMs)
+{
+	if( snapshot.IsEmpty() )
+	{
+		snapshot = "resumeversion=3\n";
+	}
+
+	snapshot += wxString::Format("pos=%i,%i\n", (int)id, (int)elapsedMs);
+}
+
+
+void SjQueueJournal::Compact(const wxString& snapshot)
+{
+	wxASSERT( wxThread::IsMain() );
+
+	m_recordCount = 0;
+
+	if( m_writer == NULL )
+	{
+		m_writer = new SjQueueJournalWriter(this);
+	}
+
+	wxMutexLocker locker(m_mutex);
+	m_snapshot = snapshot.Clone();
+	m_snapshotPending = true;
+	m_pending.Empty(); // these records are part of the snapshot
+	m_condition.Signal();
+}
+
+
+void SjQueueJournal::Close()
+{
+	if( m_writer == NULL )
+	{
+		return;
+	}
+
+	{
+		wxMutexLocker locker(m_mutex);
+		m_exit = true;
+		m_condition.Signal();
+	}
+
+	m_writer->Wait();
+	delete m_writer;
+	m_writer = NULL;
+
+	m_exit = false; // the next record starts a new writer
+}
+
+
+/*******************************************************************************
+ * SjQueueJournal - Loading
+ ******************************************************************************/
+
+
+bool SjQueueJournal::Load(const wxString& file, SjQueueJournalState& ret)
+{
+	wxString content;
+	{
+		wxLogNull null;
+		wxFileSystem fileSystem;
+		wxFSFile* fsFile = fileSystem.OpenFile(file, wxFS_READ);
+		if( fsFile == NULL )
+		{
+			return false; // there is simply no journal
+		}
+
+		content = SjTools::GetFileContent(fsFile->GetStream(), &wxConvUTF8);
+		delete fsFile;
+	}
+
+	// a last line without a line end may be broken by a crash
+	if( !content.IsEmpty() && content.Last() != '\n' )
+	{
+		content = content.BeforeLast('\n');
+	}
+
+	// replay the records; this may need O(n) per record, but is done only once on startup
+	wxArrayLong         ids;
+	long                currId = 0, nextOldId = -1, oldPlayed = 0, oldAutoplay = 0;
+	bool                oldPlaying = false;
+	SjLineTokenizer     tkz(content);
+	wxChar*             currLinePtr;
+	wxString            currLine, currKey, currValue;
+	long                id, pos, value, index;
+	while( (currLinePtr=tkz.GetNextLine()) )
+	{
+		currLine  = currLinePtr;
+		currKey   = currLine.BeforeFirst('=');
+		currValue = currLine.AfterFirst('=');
+
+		if( currKey == "add" )
+		{
+			// add=<id>,<pos>,<flags>,<url>
+			if( currValue.BeforeFirst(',').ToLong(&id)
+			 && currValue.AfterFirst(',').BeforeFirst(',').ToLong(&pos)
+			 && currValue.AfterFirst(',').AfterFirst(',').BeforeFirst(',').ToLong(&value) )
+			{
+				if( pos < 0 || pos > (long)ids.GetCount() ) { pos = ids.GetCount(); }
+				ids.Insert(id, pos);
+				ret.m_urls.Insert(currValue.AfterFirst(',').AfterFirst(',').AfterFirst(','), pos);
+				ret.m_playCounts.Insert(0, pos);
+				ret.m_flags.Insert(value, pos);
+			}
+		}
+		else if( currKey == "del" )
+		{
+			if( currValue.ToLong(&id) && (index=ids.Index(id)) != wxNOT_FOUND )
+			{
+				ids.RemoveAt(index);
+				ret.m_urls.RemoveAt(index);
+				ret.m_playCounts.RemoveAt(index);
+				ret.m_flags.RemoveAt(index);
+				if( id == currId ) { currId = 0; } // the next pos= record follows
+			}
+		}
+		else if( currKey == "move" )
+		{
+			if( currValue.BeforeFirst(',').ToLong(&id)
+			 && currValue.AfterFirst(',').ToLong(&pos)
+			 && (index=ids.Index(id)) != wxNOT_FOUND )
+			{
+				wxString url = ret.m_urls[index];
+				long playCount = ret.m_playCounts[index], flags = ret.m_flags[index];
+				ids.RemoveAt(index);
+				ret.m_urls.RemoveAt(index);
+				ret.m_playCounts.RemoveAt(index);
+				ret.m_flags.RemoveAt(index);
+
+				if( pos < 0 || pos > (long)ids.GetCount() ) { pos = ids.GetCount(); }
+				ids.Insert(id, pos);
+				ret.m_urls.Insert(url, pos);
+				ret.m_playCounts.Insert(playCount, pos);
+				ret.m_flags.Insert(flags, pos);
+			}
+		}
+		else if( currKey == "count" )
+		{
+			if( currValue.BeforeFirst(',').ToLong(&id)
+			 && currValue.AfterFirst(',').ToLong(&value)
+			 && (index=ids.Index(id)) != wxNOT_FOUND )
+			{
+				ret.m_playCounts[index] = value;
+			}
+		}
+		else if( currKey == "pos" )
+		{
+			if( currValue.BeforeFirst(',').ToLong(&id)
+			 && currValue.AfterFirst(',').ToLong(&value) )
+			{
+				currId = id;
+				ret.m_elapsedMs = value;
+			}
+		}
+		else if( currKey == "clear" )
+		{
+			ids.Empty();
+			ret.m_urls.Empty();
+			ret.m_playCounts.Empty();
+			ret.m_flags.Empty();
+			currId = 0;
+		}
+		// the keys of the old resume files, the settings are for the URL following
+		else if( currKey == "played" )
+		{
+			oldPlayed = 1;
+		}
+		else if( currKey == "autoplay" )
+		{
+			oldAutoplay = 1;
+		}
+		else if( currKey == "playing" )
+		{
+			oldPlaying = true;
+			if( !currValue.ToLong(&ret.m_elapsedMs) ) {
+				ret.m_elapsedMs = -1; // stopped or paused, to not play
+			}
+		}
+		else if( currKey == "url" )
+		{
+			ids.Add(nextOldId);
+			ret.m_urls.Add(currValue);
+			ret.m_playCounts.Add(oldPlayed);
+			ret.m_flags.Add(oldAutoplay? SJ_PLAYLISTENTRY_AUTOPLAY : 0);
+			if( oldPlaying ) { currId = nextOldId; }
+
+			// prepare for next URL
+			nextOldId--;
+			oldPlayed = 0;
+			oldAutoplay = 0;
+			oldPlaying = false;
+		}
+	}
+
+	ret.m_pos = currId? ids.Index(currId) : -1;
+	if( ret.m_pos == wxNOT_FOUND )
+	{
+		ret.m_pos = -1;
+	}
+	return true;
+}
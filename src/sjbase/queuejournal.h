@@ -0,0 +1,99 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    queuejournal.h
+ * Authors: Björn Petersen
+ * Purpose: Append-only journal of the queue operations, used for resuming
+ *
+ ******************************************************************************/
+
+
+#ifndef __SJ_QUEUEJOURNAL_H__
+#define __SJ_QUEUEJOURNAL_H__
+
+
+class SjQueueJournalWriter;
+
+
+// the result of SjQueueJournal::Load()
+class SjQueueJournalState
+{
+public:
+	                SjQueueJournalState () { m_pos = -1; m_elapsedMs = -1; }
+	wxArrayString   m_urls;             // unverified URLs
+	wxArrayLong     m_playCounts;
+	wxArrayLong     m_flags;            // only SJ_PLAYLISTENTRY_AUTOPLAY
+	long            m_pos;              // -1 for none
+	long            m_elapsedMs;        // -1 for stopped or paused
+};
+
+
+class SjQueueJournal
+{
+public:
+	// the journal is opened for appending; before records are added,
+	// Compact() should be called to get rid of the records of previous
+	// sessions which use other entry IDs.
+	                SjQueueJournal      (const wxString& file);
+	                ~SjQueueJournal     ();
+
+	// read a journal or an old resume file, returns false if there is none
+	static bool     Load                (const wxString& file, SjQueueJournalState& ret);
+
+	// the operations; the records are written in background, all records added
+	// within SJ_QUEUEJOURNAL_SYNC_MS are written and flushed together
+	void            Add                 (long id, long pos, long flags, const wxString& unverifiedUrl);
+	void            Remove              (long id);
+	void            Move                (long id, long pos);
+	void            SetPlayCount        (long id, long playCount);
+	void            SetPos              (long id, long elapsedMs);
+	void            Clear               ();
+
+	// replace the journal by a snapshot of the queue as created by the Add*()
+	// functions below; the file is written in background.
+	bool            NeedsCompaction     (long queueCount) const { return m_recordCount > queueCount*2 + 1000; }
+	void            Compact             (const wxString& snapshot);
+	static void     AddToSnapshot       (wxString& snapshot, long id, long pos, long flags, long playCount, const wxString& unverifiedUrl);
+	static void     AddPosToSnapshot    (wxString& snapshot, long id, long elapsedMs);
+
+	// wait until all records are written
+	void            Close               ();
+
+private:
+	void            AddRecord           (const wxString& record);
+
+	wxString        m_file;
+	long            m_recordCount;      // records since the last compaction, main thread only
+
+	// the following members are protected by m_mutex
+	wxMutex         m_mutex;
+	wxCondition     m_condition;
+	wxString        m_pending;
+	wxString        m_snapshot;
+	bool            m_snapshotPending;
+	bool            m_exit;
+
+	SjQueueJournalWriter* m_writer;
+	friend class    SjQueueJournalWriter;
+};
+
+
+#endif // __SJ_QUEUEJOURNAL_H__
@@ -797,6 +797,43 @@ wxString SjRule::GetAsSql() const
 }
 
 
+bool SjRule::IsVolatile() const
+{
+	// a rule is volatile if its result may change without any change to the
+	// tracks table - eg. if it depends on the current time or on the queue
+	if( m_field == SJ_PSEUDOFIELD_SQL
+	 || m_field == SJ_PSEUDOFIELD_QUEUEPOS )
+	{
+		return TRUE;
+	}
+	else if( m_field == SJ_PSEUDOFIELD_LIMIT )
+	{
+		long orderById; SjTools::ParseNumber(m_value[1], &orderById);
+		return (orderById == SJ_PSEUDOFIELD_RANDOM);
+	}
+	else if( m_op == SJ_FIELDOP_IS_IN_THE_LAST
+	      || m_op == SJ_FIELDOP_IS_NOT_IN_THE_LAST )
+	{
+		return TRUE;
+	}
+	else if( GetFieldType(m_field) == SJ_FIELDTYPE_DATE )
+	{
+		for( int i = 0; i < 2; i++ )
+		{
+			wxString value = m_value[i].Lower();
+			if( value.Find(wxT("today")) != wxNOT_FOUND
+			 || value.Find(wxT("yesterday")) != wxNOT_FOUND
+			 || value.Find(wxT("now")) != wxNOT_FOUND )
+			{
+				return TRUE;
+			}
+		}
+	}
+
+	return FALSE;
+}
+
+
 /*******************************************************************************
  * SjRule::Convert()
  ******************************************************************************/
@@ -1211,7 +1248,7 @@ bool SjAdvSearch::IsOk(wxString& retError, wxString& retWarning) const
 
 
 /*******************************************************************************
- *  SjAdvSearch::GetAsSql() and the SjLimitValues help class
+ *  SjAdvSearch::CalcAsSql() and the SjLimitValues help class
  ******************************************************************************/
 
 
@@ -1251,7 +1288,110 @@ bool LimitValues::Set(int fieldIndex, long max__, long multiplier)
 }
 
 
+/*******************************************************************************
+ * SjAdvSearch::GetAsSql() and the selection cache
+ ******************************************************************************/
+
+
+// Calculating a music selection needs a full scan of the tracks table and is
+// repeated each time the kiosk or the browser switches between selections.
+// As long as the library is unchanged, the result is always the same, so the
+// ID sets of the last used selections are kept; the library module increments
+// its generation on each change of the tracks table.
+#define SJ_ADVSEARCH_CACHE_MAX 8
+
+
+class SjAdvSearchCacheEntry
+{
+public:
+	                SjAdvSearchCacheEntry () { m_generation = 0; m_lastUsed = 0; }
+	wxString        m_key;
+	unsigned long   m_generation;
+	unsigned long   m_lastUsed;
+	SjLLHash        m_ids;
+	SjSearchStat    m_stat;
+};
+
+
+static SjAdvSearchCacheEntry s_advSearchCache[SJ_ADVSEARCH_CACHE_MAX];
+static unsigned long         s_advSearchCacheUsage = 0;
+
+
+bool SjAdvSearch::IsVolatile() const
+{
+	for( size_t r = 0; r < m_rules.GetCount(); r++ )
+	{
+		if( m_rules[r].IsVolatile() )
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+
 SjSearchStat SjAdvSearch::GetAsSql(SjLLHash* retHash, wxString& retSql) const
+{
+	// the cache is only used from the main thread and outside of transactions,
+	// where the update hook may see changes that are rolled back later
+	if( !IsSet()
+	 || !wxThread::IsMain()
+	 || g_mainFrame == NULL
+	 || g_mainFrame->m_libraryModule == NULL
+	 || wxSqltDb::GetDefault() == NULL
+	 || wxSqltDb::GetDefault()->InTransaction()
+	 || IsVolatile() )
+	{
+		return CalcAsSql(retHash, retSql);
+	}
+
+	// the key is the selection without the ID and the name
+	SjStringSerializer ser;
+	ser.AddLong(m_selectScope);
+	ser.AddLong(m_selectOp);
+	ser.AddLong((long)m_rules.GetCount());
+	for( size_t r = 0; r < m_rules.GetCount(); r++ )
+	{
+		m_rules[r].Serialize(ser);
+	}
+	wxString        key = ser.GetResult();
+	unsigned long   generation = g_mainFrame->m_libraryModule->GetGeneration();
+
+	// search the cache, remember the least recently used entry on the way
+	SjAdvSearchCacheEntry* entry = &s_advSearchCache[0];
+	for( int i = 0; i < SJ_ADVSEARCH_CACHE_MAX; i++ )
+	{
+		SjAdvSearchCacheEntry* curr = &s_advSearchCache[i];
+		if( curr->m_lastUsed && curr->m_key == key )
+		{
+			if( curr->m_generation == generation )
+			{
+				curr->m_lastUsed = ++s_advSearchCacheUsage;
+				*retHash = curr->m_ids;
+				retSql = curr->m_stat.m_advResultCount > 0? wxT("INFILTER(tracks.id)") : wxT("(0)");
+				return curr->m_stat;
+			}
+			entry = curr; // outdated, overwrite it
+			break;
+		}
+		else if( curr->m_lastUsed < entry->m_lastUsed )
+		{
+			entry = curr;
+		}
+	}
+
+	// calculate and store the result
+	SjSearchStat stat = CalcAsSql(retHash, retSql);
+	entry->m_key        = key;
+	entry->m_generation = generation;
+	entry->m_lastUsed   = ++s_advSearchCacheUsage;
+	entry->m_ids        = *retHash;
+	entry->m_stat       = stat;
+	return stat;
+}
+
+
+SjSearchStat SjAdvSearch::CalcAsSql(SjLLHash* retHash, wxString& retSql) const
 {
 	SjSearchStat stat;
 
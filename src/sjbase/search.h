@@ -293,6 +293,7 @@ private:
 	static wxString GetAsSql            (const wxString& value, SjField, SjFieldOp, SjUnit, bool forceSet, bool recursiveCall=FALSE);
 	static wxString GetAsSql            (SjField, SjFieldOp, bool forceSet);
 	wxString        GetAsSql            () const;
+	bool            IsVolatile          () const;
 	void            CopyFrom            (const SjRule& o);
 	bool            IsEqualTo           (const SjRule& o) const;
 
@@ -370,6 +371,12 @@ private:
 	void            CopyFrom            (const SjAdvSearch& o);
 	bool            IsEqualTo           (const SjAdvSearch& o) const;
 
+	// the results of GetAsSql() are cached as long as the library does not
+	// change; volatile searches depending on the time or on the queue are
+	// always calculated
+	bool            IsVolatile          () const;
+	SjSearchStat    CalcAsSql           (SjLLHash* retHash, wxString& retSql) const;
+
 	friend class    SjAdvSearchDialog;
 	friend class    SjAdvSearchModule;
 };
@@ -77,6 +77,8 @@ SjSkinItem::SjSkinItem()
 	m_usesPaint             = TRUE;
 	m_image                 = NULL;
 	m_alwaysRedrawBackground= FALSE;
+	m_underlay              = NULL;
+	m_redrawPending         = FALSE;
 	m_skinWindow            = NULL;
 	m_colours               = NULL; // set to SjSkinSkin::m_itemDefColours()
 	m_parent                = NULL;
@@ -101,6 +103,9 @@ SjSkinItem::~SjSkinItem()
 
 	if( m_itemTooltip )
 		delete m_itemTooltip;
+
+	if( m_underlay )
+		delete m_underlay;
 }
 
 
@@ -255,7 +260,6 @@ void SjSkinItem::ShowDragImage()
 void SjSkinItem::RedrawMe()
 {
 	wxASSERT(m_skinWindow);
-	wxClientDC dc(m_skinWindow);
 
 	// anything to redraw?
 	if( m_rect.width == 0 || m_rect.height == 0
@@ -302,42 +306,74 @@ void SjSkinItem::RedrawMe()
 	{
 		// ...the item needs the background to be repainted first (maybe it
 		// uses a mask) or the item has overlaying items.  In any case, we'll
-		// paint several items in the item rect...
-		bool drawDone = FALSE;
+		// paint several items in the item rect; this is done together with
+		// all other items changed until the next event loop iteration, see
+		// SjSkinWindow::FlushDirtyItems()
+		m_skinWindow->AddDirtyItem(this);
+	}
+	else
+	{
+		// ...very good and very fast: the item does not need the background
+		// to be drawn first and the item has no overlaying items. We can
+		// just call the drawing function.
+		wxClientDC dc(m_skinWindow);
+		HideDragImage();
+		OnPaint(dc);
+		m_skinWindow->RedrawFinalLines(dc);
+		ShowDragImage();
+	}
+}
 
-		// ...drawing offscreen to avoid flickering
-		wxBitmap    memBitmap(m_rect.width, m_rect.height);
+
+void SjSkinItem::RedrawWithBackground(wxDC& dc)
+{
+	bool drawDone = FALSE;
+
+	// the items below us change seldom, so they're rendered once to
+	// the underlay and reused until one of them is redrawn
+	HideDragImage();
+	if( m_underlay == NULL )
+	{
+		m_underlay = new wxBitmap(m_rect.width, m_rect.height);
+		wxMemoryDC underlayDc;
+		underlayDc.SelectObject(*m_underlay);
+		if( underlayDc.IsOk() )
+		{
+			m_skinWindow->RedrawAll(underlayDc, &m_rect, 0-m_rect.x, 0-m_rect.y, NULL, this);
+			underlayDc.SelectObject(wxNullBitmap);
+		}
+		else
+		{
+			delete m_underlay;
+			m_underlay = NULL;
+		}
+	}
+
+	// composing the underlay, this item and the overlaying items
+	// offscreen to avoid flickering; one blit to the screen
+	if( m_underlay )
+	{
 		wxMemoryDC  memDc;
-		memDc.SelectObject(memBitmap);
+		memDc.SelectObject(m_skinWindow->GetBackBuffer(m_rect.width, m_rect.height));
 		if( memDc.IsOk() )
 		{
-			HideDragImage();
-			m_skinWindow->RedrawAll(memDc, &m_rect, 0-m_rect.x, 0-m_rect.y);
+			memDc.DrawBitmap(*m_underlay, 0, 0, FALSE);
+			m_skinWindow->RedrawAll(memDc, &m_rect, 0-m_rect.x, 0-m_rect.y, this, NULL);
 			m_skinWindow->RedrawFinalLines(memDc, 0-m_rect.x, 0-m_rect.y);
 			dc.Blit(m_rect.x, m_rect.y, m_rect.width, m_rect.height, &memDc, 0, 0);
-			ShowDragImage();
 			drawDone = TRUE;
 		}
-
-		if( !drawDone )
-		{
-			// ...drawing onscreen, faster but with flickering.
-			// We do not call dc.SetClippingRegion(m_rect) as nested clippings via GetClippingBox() do not work well
-			// and the dc.SetClippingRegion() is needed by the called classes
-			// (dc.SetClippingRegion() should only be used in the last iteration before _really_ drawing).
-			HideDragImage();
-			m_skinWindow->RedrawAll(dc, &m_rect);
-			m_skinWindow->RedrawFinalLines(dc);
-			ShowDragImage();
-		}
 	}
-	else
+	ShowDragImage();
+
+	if( !drawDone )
 	{
-		// ...very good and very fast: the item does not need the background
-		// to be drawn first and the item has no overlaying items. We can
-		// just call the drawing function.
+		// drawing onscreen, faster but with flickering.
+		// We do not call dc.SetClippingRegion(m_rect) as nested clippings via GetClippingBox() do not work well
+		// and the dc.SetClippingRegion() is needed by the called classes
+		// (dc.SetClippingRegion() should only be used in the last iteration before _really_ drawing).
 		HideDragImage();
-		OnPaint(dc);
+		m_skinWindow->RedrawAll(dc, &m_rect);
 		m_skinWindow->RedrawFinalLines(dc);
 		ShowDragImage();
 	}
@@ -2698,6 +2734,7 @@ BEGIN_EVENT_TABLE(SjSkinWindow, wxFrame)
 	EVT_PAINT               (SjSkinWindow::OnPaint              )
 	EVT_ERASE_BACKGROUND    (SjSkinWindow::OnEraseBackground    )
 	EVT_IMAGE_THERE         (SjSkinWindow::OnImageThere         )
+	EVT_MENU                (IDO_SKINFLUSHDIRTY, SjSkinWindow::OnFlushDirtyItems)
 	#ifdef __WXGTK__
 	EVT_TIMER               (IDTIMER_SETSIZEHACK, SjMainFrame::OnSetSizeHackTimer)
 	#endif
@@ -2725,6 +2762,7 @@ SjSkinWindow::SjSkinWindow(wxWindow* parent, wxWindowID id, long skinFlags, cons
 
 SjSkinWindow::~SjSkinWindow()
 {
+	ForgetDirtyItems();
 	if( m_currSkin )
 	{
 		delete m_currSkin;
@@ -2878,7 +2916,9 @@ void SjSkinWindow::LoadLayout(SjSkinLayout* newLayout /*may be NULL*/,
 	//      set the new layout
 	//          >>>>>>>>>>>>>>>>>>
 
+	ForgetDirtyItems(); // items of the old layout are not drawn any longer
 	m_currLayout = newLayout; // m_currLayout may be NULL now
+	InvalidateUnderlays(); // underlays cached when the layout was used the last time may be outdated
 
 	// create an item list for every target
 	int i;
@@ -3321,6 +3361,12 @@ void SjSkinWindow::CalcItemRectangles(long width, long height)
 		CalcChildItemRectangles(item);
 	}
 
+	// all positions may have changed, the cached renderings are useless;
+	// pending redraws are done by the following full repaint
+	InvalidateUnderlays();
+	ForgetDirtyItems();
+	m_backBuffer = wxNullBitmap;
+
 	// move away unused windows
 	if(   m_workspaceWindow
 	 && (   !m_currLayout->m_hasWorkspace
@@ -3891,15 +3937,37 @@ void SjSkinWindow::OnPaint(wxPaintEvent& event)
 	wxRegion updateRegion = GetUpdateRegion();
 	wxRect updateRect = updateRegion.GetBox();
 
-	wxBitmap    memBitmap(updateRect.width, updateRect.height);
+	// if the damaged rectangles are far apart, painting them one by one
+	// is cheaper than painting the whole bounding box
+	long rectCount = 0, rectArea = 0;
+	wxRegionIterator ri(updateRegion);
+	while( ri )
+	{
+		rectCount++;
+		rectArea += ri.GetW() * ri.GetH();
+		ri++;
+	}
+
 	wxMemoryDC  memDc;
-	memDc.SelectObject(memBitmap);
+	memDc.SelectObject(GetBackBuffer(updateRect.width, updateRect.height));
 	if( memDc.IsOk() )
 	{
-		RedrawAll(memDc, &updateRect, 0-updateRect.x, 0-updateRect.y);
-		RedrawFinalLines(memDc, 0-updateRect.x, 0-updateRect.y);
-
-		dc.Blit(updateRect.x, updateRect.y, updateRect.width, updateRect.height, &memDc, 0, 0);
+		if( rectCount > 1 && rectArea*2 < updateRect.width*updateRect.height )
+		{
+			for( ri.Reset(updateRegion); ri; ri++ )
+			{
+				wxRect r = ri.GetRect();
+				RedrawAll(memDc, &r, 0-r.x, 0-r.y);
+				RedrawFinalLines(memDc, 0-r.x, 0-r.y);
+				dc.Blit(r.x, r.y, r.width, r.height, &memDc, 0, 0);
+			}
+		}
+		else
+		{
+			RedrawAll(memDc, &updateRect, 0-updateRect.x, 0-updateRect.y);
+			RedrawFinalLines(memDc, 0-updateRect.x, 0-updateRect.y);
+			dc.Blit(updateRect.x, updateRect.y, updateRect.width, updateRect.height, &memDc, 0, 0);
+		}
 		drawDone = TRUE;
 	}
 #endif
@@ -3927,7 +3995,10 @@ void SjSkinWindow::OnImageThere(SjImageThereEvent& event)
 
 		if( item->m_usesPaint )
 		{
-			item->OnImageThere(dc, obj);
+			if( item->OnImageThere(dc, obj) )
+			{
+				InvalidateUnderlays(item);
+			}
 		}
 
 		itemnode = itemnode->GetNext();
@@ -3939,7 +4010,9 @@ void SjSkinWindow::OnImageThere(SjImageThereEvent& event)
 
 void SjSkinWindow::RedrawAll(wxDC& dc,
                              const wxRect* rect /*may be NULL*/,
-                             long finalMoveX, long finalMoveY)
+                             long finalMoveX, long finalMoveY,
+                             const SjSkinItem* firstItem /*may be NULL*/,
+                             const SjSkinItem* stopItem /*may be NULL*/)
 {
 	// layout okay?
 	if( !m_currLayout )
@@ -3951,14 +4024,25 @@ void SjSkinWindow::RedrawAll(wxDC& dc,
 		return; // error
 	}
 
-	// draw all items
+	// draw all items from firstItem (inclusive) to stopItem (exclusive)
 	SjSkinItem*           item;
 	SjSkinItemList::Node* itemnode = m_currLayout->m_itemList.GetFirst();
+	if( firstItem )
+	{
+		while( itemnode && itemnode->GetData() != firstItem )
+			itemnode = itemnode->GetNext();
+	}
+
 	while( itemnode )
 	{
 		item = itemnode->GetData();
 		wxASSERT(item);
 
+		if( item == stopItem )
+		{
+			break;
+		}
+
 		// paint item
 		if( item->m_usesPaint )
 		{
@@ -3997,6 +4081,154 @@ void SjSkinWindow::RedrawAll(wxDC& dc,
 }
 
 
+void SjSkinWindow::InvalidateUnderlays(const SjSkinItem* changedItem)
+{
+	if( !m_currLayout )
+	{
+		return;
+	}
+
+	bool                  changedItemFound = (changedItem==NULL);
+	SjSkinItem*           item;
+	SjSkinItemList::Node* itemnode = m_currLayout->m_itemList.GetFirst();
+	while( itemnode )
+	{
+		item = itemnode->GetData();
+		wxASSERT(item);
+
+		if( changedItemFound )
+		{
+			if( item->m_underlay
+			 && (changedItem==NULL || changedItem->m_rect.Intersects(item->m_rect)) )
+			{
+				delete item->m_underlay;
+				item->m_underlay = NULL;
+			}
+		}
+		else if( item == changedItem )
+		{
+			changedItemFound = TRUE;
+		}
+
+		itemnode = itemnode->GetNext();
+	}
+}
+
+
+void SjSkinWindow::AddDirtyItem(SjSkinItem* item)
+{
+	if( item->m_redrawPending )
+	{
+		return; // already waiting for the next flush
+	}
+
+	item->m_redrawPending = TRUE;
+	m_dirtyItems.Add(item);
+
+	if( m_dirtyItems.GetCount() == 1 )
+	{
+		QueueEvent(new wxCommandEvent(wxEVT_COMMAND_MENU_SELECTED, IDO_SKINFLUSHDIRTY));
+	}
+}
+
+
+void SjSkinWindow::ForgetDirtyItems()
+{
+	size_t i, iCount = m_dirtyItems.GetCount();
+	for( i = 0; i < iCount; i++ )
+	{
+		((SjSkinItem*)m_dirtyItems.Item(i))->m_redrawPending = FALSE;
+	}
+	m_dirtyItems.Empty();
+}
+
+
+void SjSkinWindow::FlushDirtyItems()
+{
+	if( m_dirtyItems.IsEmpty() )
+	{
+		return;
+	}
+
+	if( !m_currLayout )
+	{
+		ForgetDirtyItems();
+		return;
+	}
+
+	// one walk through the items in z-order for all dirty items: the
+	// underlays of items above a dirty item get outdated; a dirty item
+	// lying completely inside the rectangle of a dirty item below is drawn
+	// together with that item.
+	wxClientDC            dc(this);
+	wxArrayPtrVoid        drawnItems;
+	size_t                i, iCount;
+	bool                  skip;
+	SjSkinItem*           item;
+	SjSkinItemList::Node* itemnode = m_currLayout->m_itemList.GetFirst();
+	while( itemnode )
+	{
+		item = itemnode->GetData();
+		wxASSERT(item);
+
+		skip = FALSE;
+		iCount = drawnItems.GetCount();
+		for( i = 0; i < iCount; i++ )
+		{
+			const wxRect& dirtyRect = ((SjSkinItem*)drawnItems.Item(i))->m_rect;
+			if( dirtyRect.Intersects(item->m_rect) )
+			{
+				if( item->m_underlay )
+				{
+					delete item->m_underlay;
+					item->m_underlay = NULL;
+				}
+
+				if( dirtyRect.Contains(item->m_rect) )
+				{
+					skip = TRUE;
+				}
+			}
+		}
+
+		if( item->m_redrawPending )
+		{
+			item->m_redrawPending = FALSE;
+			m_dirtyItems.Remove(item);
+
+			if( !skip && item->m_rect.width && item->m_rect.height )
+			{
+				item->RedrawWithBackground(dc);
+			}
+
+			drawnItems.Add(item);
+		}
+
+		itemnode = itemnode->GetNext();
+	}
+
+	// items not in the current layout are not drawn
+	ForgetDirtyItems();
+}
+
+
+wxBitmap& SjSkinWindow::GetBackBuffer(int width, int height)
+{
+	if( !m_backBuffer.IsOk()
+	 || m_backBuffer.GetWidth() < width
+	 || m_backBuffer.GetHeight() < height )
+	{
+		if( m_backBuffer.IsOk() )
+		{
+			width  = wxMax(width,  m_backBuffer.GetWidth());
+			height = wxMax(height, m_backBuffer.GetHeight());
+		}
+		m_backBuffer = wxBitmap(wxMax(width, 1), wxMax(height, 1));
+	}
+	return m_backBuffer;
+}
+
+
 void SjSkinWindow::RedrawFinalLines(wxDC& dc, long finalMoveX, long finalMoveY)
 {
 	// draw debug outline
@@ -279,6 +279,12 @@ public:
 	void            ShowDragImage       ();
 	void            RedrawMe            ();
 
+	// cached rendering of all items below this item, used by RedrawMe() for
+	// items drawn with the background; NULL if not yet rendered or outdated
+	wxBitmap*       m_underlay;
+	void            RedrawWithBackground(wxDC&);
+	bool            m_redrawPending; // set while in SjSkinWindow::m_dirtyItems
+
 	// start/stop a timer, running timers will call OnTimer()
 	void            CreateTimer         (long ms);
 	SjSkinItemTimer* m_timer; // may be NULL!
@@ -920,8 +926,25 @@ private:
 	void            OnImageThere        (SjImageThereEvent&);
 
 	// drawing
-	void            RedrawAll           (wxDC&, const wxRect* rect = NULL, long finalMoveX = 0, long finalMoveY = 0);
+	void            RedrawAll           (wxDC&, const wxRect* rect = NULL, long finalMoveX = 0, long finalMoveY = 0,
+	                                     const SjSkinItem* firstItem = NULL, const SjSkinItem* stopItem = NULL);
 	void            RedrawFinalLines    (wxDC&, long finalMoveX = 0, long finalMoveY = 0);
+
+	// the underlays of all items above the changed item get outdated;
+	// with changedItem=NULL, all underlays are freed
+	void            InvalidateUnderlays (const SjSkinItem* changedItem = NULL);
+
+	// items to redraw with their background are collected by RedrawMe() and
+	// drawn together once the event loop is idle again
+	void            AddDirtyItem        (SjSkinItem*);
+	void            FlushDirtyItems     ();
+	void            ForgetDirtyItems    ();
+	void            OnFlushDirtyItems   (wxCommandEvent&) { FlushDirtyItems(); }
+	wxArrayPtrVoid  m_dirtyItems;
+
+	// offscreen bitmap reused by all redraws, at least as large as requested
+	wxBitmap&       GetBackBuffer       (int width, int height);
+	wxBitmap        m_backBuffer;
 	                DECLARE_EVENT_TABLE ()
 
 	// friend classes
@@ -0,0 +1,676 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    urlverifier.cpp
+ * Authors: Björn Petersen
+ * Purpose: Verify the URLs of playlist entries in background
+ *
+ *******************************************************************************
+ *
+ * SjPlaylistEntry::VerifyUrl() verifies a single entry when it is needed;
+ * for a large imported playlist or a resumed queue this results in thousands
+ * of file opens and library queries in the main thread.
+ *
+ * The verifier does the same for many entries at once in a worker thread:
+ *
+ * (1) the local URLs are looked up in the library, using a few queries with
+ *     IN (...) lists; tracks found there are assumed to exist.
+ * (2) the existence of the remaining files is checked using several threads,
+ *     this helps esp. with network drives.
+ * (3) entries still not found are looked up by artist/album/track as done by
+ *     SjLibraryModule::GetUrl(), for all entries using a single scan of the
+ *     tracks table.
+ *
+ * The results are applied in the main thread.  Streams, archives and stubs
+ * are left to SjPlaylistEntry::VerifyUrl().
+ *
+ ******************************************************************************/
+
+
+#include <sjbase/base.h>
+#include <sjbase/urlverifier.h>
+#include <wx/filename.h>
+
+
+#define SJ_VERIFY_IN_BATCH      256
+#define SJ_VERIFY_STAT_THREADS  4
+
+
+// the state of an entry while verifying
+#define SJ_VERIFY_PENDING       0
+#define SJ_VERIFY_OK            1
+#define SJ_VERIFY_FAILED        2
+#define SJ_VERIFY_LAZY          3 // not handled here, left to SjPlaylistEntry::VerifyUrl()
+
+
+/*******************************************************************************
+ * SjUrlStatWorker
+ ******************************************************************************/
+
+
+class SjUrlStatWorker : public wxThread
+{
+public:
+	// checks every step-th path starting at first; the threads write to
+	// different elements of exists, so no locking is needed
+	SjUrlStatWorker(const wxArrayString& paths, const wxArrayLong& state, wxArrayLong& exists,
+	                size_t first, size_t step, const bool* stop)
+		: wxThread(wxTHREAD_JOINABLE), m_paths(paths), m_state(state), m_exists(exists)
+	{
+		m_first = first;
+		m_step  = step;
+		m_stop  = stop;
+		Create();
+		Run();
+	}
+
+	void* Entry()
+	{
+		size_t i, count = m_paths.GetCount();
+		for( i = m_first; i < count && !*m_stop; i += m_step )
+		{
+			if( m_state[i] == SJ_VERIFY_PENDING && !m_paths[i].IsEmpty() )
+			{
+				m_exists[i] = wxFileName::FileExists(m_paths[i])? 1 : 0;
+			}
+		}
+		return 0;
+	}
+
+private:
+	const wxArrayString& m_paths;
+	const wxArrayLong&   m_state;
+	wxArrayLong&         m_exists;
+	size_t          m_first;
+	size_t          m_step;
+	const bool*     m_stop;
+};
+
+
+/*******************************************************************************
+ * SjUrlVerifierWorker
+ ******************************************************************************/
+
+
+class SjUrlVerifierWorker : public wxThread
+{
+public:
+	                SjUrlVerifierWorker (SjUrlVerifier*);
+	void*           Entry               ();
+
+private:
+	SjUrlVerifier*  m_verifier;
+
+	bool            TakeTodo            ();
+	void            Verify              ();
+	void            LookupUrls          ();
+	void            CheckFiles          ();
+	void            LookupNames         ();
+	void            Publish             ();
+
+	static wxString GetLocalPath        (const wxString& unverifiedUrl);
+	static wxString GetField            (const wxString& unverifiedUrl, int index);
+
+	// the current batch, the arrays have the same size
+	wxArrayLong     m_ids;
+	wxArrayString   m_unverifiedUrls;
+	wxArrayString   m_paths;            // native path of local files, empty if unknown
+	wxArrayString   m_urls;             // the verified URL, if any
+	wxArrayLong     m_state;
+	wxArrayLong     m_published;
+};
+
+
+SjUrlVerifierWorker::SjUrlVerifierWorker(SjUrlVerifier* verifier)
+	: wxThread(wxTHREAD_JOINABLE)
+{
+	m_verifier = verifier;
+
+	Create();
+	SetPriority(WXTHREAD_MIN_PRIORITY);
+	Run();
+}
+
+
+void* SjUrlVerifierWorker::Entry()
+{
+	// as we're verifing, don't log any errors (wxLogNull is thread-specific)
+	wxLogNull null;
+
+	while( TakeTodo() )
+	{
+		Verify();
+	}
+
+	return 0;
+}
+
+
+bool SjUrlVerifierWorker::TakeTodo()
+{
+	wxCriticalSectionLocker locker(m_verifier->m_critical);
+
+	m_ids.Empty();
+	m_unverifiedUrls.Empty();
+	if( m_verifier->m_stop || m_verifier->m_todoIds.IsEmpty() )
+	{
+		m_verifier->m_running = false; // Add() starts a new worker for new entries after this point
+		return false;
+	}
+
+	size_t i, count = m_verifier->m_todoIds.GetCount();
+	for( i = 0; i < count; i++ )
+	{
+		m_ids.Add(m_verifier->m_todoIds[i]);
+		m_unverifiedUrls.Add(m_verifier->m_todoUrls[i].Clone()); // deep copy, the string is used in another thread
+	}
+	m_verifier->m_todoIds.Empty();
+	m_verifier->m_todoUrls.Empty();
+	return true;
+}
+
+
+wxString SjUrlVerifierWorker::GetField(const wxString& unverifiedUrl, int index)
+{
+	// the unverified URL has the format "url.mp3 \t playlist.m3u \t Artist \t Album \t Track",
+	// see SjPlaylistEntry::VerifyUrl()
+	wxString rest(unverifiedUrl);
+	for( int i = 0; i < index; i++ )
+	{
+		if( rest.Find('\t') == wxNOT_FOUND )
+		{
+			return wxEmptyString;
+		}
+		rest = rest.AfterFirst('\t');
+	}
+	return rest.BeforeFirst('\t');
+}
+
+
+wxString SjUrlVerifierWorker::GetLocalPath(const wxString& unverifiedUrl)
+{
+	// get the long and absolute path of a local file the same way as
+	// SjPlaylistEntry::VerifyUrl() does; the existence is checked later
+	wxString url = unverifiedUrl.BeforeFirst('\t');
+	if( url.StartsWith("file:") )
+	{
+		return wxFileSystem::URLToFileName(url).GetLongPath();
+	}
+
+	wxFileName urlFn(url, wxPATH_NATIVE);
+	if( urlFn.IsAbsolute() )
+	{
+		return urlFn.GetLongPath();
+	}
+
+	wxString containerPath = GetField(unverifiedUrl, 1);
+	if( !containerPath.IsEmpty() )
+	{
+		#ifdef __WXMSW__
+			containerPath.Replace("/", "\\");
+		#endif
+		wxFileName tempFn(containerPath, wxPATH_NATIVE);
+		urlFn.MakeAbsolute(tempFn.GetPath(wxPATH_GET_VOLUME));
+		return urlFn.GetLongPath();
+	}
+
+	return wxEmptyString; // relative path without container
+}
+
+
+void SjUrlVerifierWorker::Verify()
+{
+	size_t i, count = m_ids.GetCount();
+
+	m_paths.Empty();
+	m_urls.Empty();
+	m_state.Empty();
+	m_published.Empty();
+	for( i = 0; i < count; i++ )
+	{
+		const wxString& unverifiedUrl = m_unverifiedUrls[i];
+		long state = SJ_VERIFY_PENDING;
+		if( unverifiedUrl.StartsWith("http:")
+		 || unverifiedUrl.StartsWith("https:")
+		 || unverifiedUrl.StartsWith("ftp:")
+		 || unverifiedUrl.StartsWith("stub:")
+		 || unverifiedUrl.BeforeFirst('\t').Find('#') != wxNOT_FOUND /*archives as "file.zip#zip:track.mp3"*/ )
+		{
+			state = SJ_VERIFY_LAZY;
+		}
+
+		m_paths.Add(state==SJ_VERIFY_PENDING? GetLocalPath(unverifiedUrl) : wxString());
+		m_urls.Add(wxEmptyString);
+		m_state.Add(state);
+		m_published.Add(state==SJ_VERIFY_LAZY? 1 : 0);
+	}
+
+	LookupUrls();
+	Publish();
+
+	CheckFiles();
+	Publish();
+
+	LookupNames();
+
+	// what is still pending is not found
+	for( i = 0; i < count; i++ )
+	{
+		if( m_state[i] == SJ_VERIFY_PENDING )
+		{
+			m_urls[i] = m_unverifiedUrls[i].BeforeFirst('\t');
+			m_state[i] = SJ_VERIFY_FAILED;
+		}
+	}
+	Publish();
+}
+
+
+void SjUrlVerifierWorker::LookupUrls()
+{
+	wxSqltReader reader;
+	if( reader.GetDb() == NULL )
+	{
+		return;
+	}
+	wxSqlt sql(reader.GetDb());
+
+	size_t i, count = m_ids.GetCount(), start = 0;
+	while( start < count && !m_verifier->m_stop /*just reading a bool, no need to lock*/ )
+	{
+		// collect the URLs of the next batch
+		wxString query;
+		size_t end = start;
+		int inCount = 0;
+		for( ; end < count && inCount < SJ_VERIFY_IN_BATCH; end++ )
+		{
+			if( m_state[end] == SJ_VERIFY_PENDING && !m_paths[end].IsEmpty() )
+			{
+				m_urls[end] = wxFileSystem::FileNameToURL(m_paths[end]);
+				query += query.IsEmpty()? wxT("'") : wxT(",'");
+				query += sql.QParam(m_urls[end]) + wxT("'");
+				inCount++;
+			}
+		}
+
+		// look them up
+		if( inCount )
+		{
+			SjSLHash found;
+			sql.Query(wxT("SELECT url FROM tracks WHERE url IN (") + query + wxT(");"));
+			while( sql.Next() )
+			{
+				found.Insert(sql.GetString(0), 1);
+			}
+
+			for( i = start; i < end; i++ )
+			{
+				if( m_state[i] == SJ_VERIFY_PENDING && !m_paths[i].IsEmpty() && found.Lookup(m_urls[i]) )
+				{
+					m_state[i] = SJ_VERIFY_OK;
+				}
+			}
+		}
+
+		start = end;
+	}
+}
+
+
+void SjUrlVerifierWorker::CheckFiles()
+{
+	size_t i, count = m_ids.GetCount();
+	wxArrayLong exists;
+	exists.Add(0, count);
+
+	int threadCount = SJ_VERIFY_STAT_THREADS;
+	if( (size_t)threadCount > count ) threadCount = (int)count;
+	if( threadCount < 1 ) return;
+
+	wxArrayPtrVoid threads;
+	for( i = 0; i < (size_t)threadCount; i++ )
+	{
+		threads.Add(new SjUrlStatWorker(m_paths, m_state, exists, i, threadCount, &m_verifier->m_stop));
+	}
+	for( i = 0; i < (size_t)threadCount; i++ )
+	{
+		SjUrlStatWorker* thread = (SjUrlStatWorker*)threads[i];
+		thread->Wait();
+		delete thread;
+	}
+
+	for( i = 0; i < count; i++ )
+	{
+		if( exists[i] )
+		{
+			m_urls[i] = wxFileSystem::FileNameToURL(m_paths[i]);
+
+			// make sure, we're using the correct case, see SjPlaylistEntry::VerifyUrl()
+			#ifdef __WXMSW__
+			{
+				wxSqltReader reader;
+				if( reader.GetDb() )
+				{
+					wxSqlt sql(reader.GetDb());
+					sql.Query("SELECT url FROM tracks WHERE url LIKE '" + sql.QParam(m_urls[i]) + "';");
+					while( sql.Next() )
+					{
+						wxString test = sql.GetString(0);
+						if( test.Lower() == m_urls[i].Lower() )
+						{
+							m_urls[i] = test;
+							break;
+						}
+					}
+				}
+			}
+			#endif
+
+			m_state[i] = SJ_VERIFY_OK;
+		}
+	}
+}
+
+
+void SjUrlVerifierWorker::LookupNames()
+{
+	// collect the names of the entries that can be looked up by artist/track;
+	// as the artist and the track may be swapped, both are needed
+	size_t i, count = m_ids.GetCount();
+	SjSLHash wantedNames;
+	for( i = 0; i < count; i++ )
+	{
+		if( m_state[i] == SJ_VERIFY_PENDING )
+		{
+			wxString artistName = GetField(m_unverifiedUrls[i], 2).Trim(true).Trim(false);
+			wxString trackName  = GetField(m_unverifiedUrls[i], 4).Trim(true).Trim(false);
+			if( !artistName.IsEmpty() && !trackName.IsEmpty() /*album may be empty, eg. for m3u*/ )
+			{
+				wantedNames.Insert(artistName.Lower(), 1);
+				wantedNames.Insert(trackName.Lower(), 1);
+			}
+		}
+	}
+
+	if( wantedNames.GetCount() == 0 )
+	{
+		return;
+	}
+
+	// read all tracks with a wanted track name in a single scan;
+	// rowsByTrack maps the lower-case track name to the first row+1,
+	// the following rows with the same name are linked by nextRow
+	wxArrayString rowUrls, rowArtists, rowAlbums, rowTracks;
+	wxArrayLong   nextRow;
+	SjSLHash      rowsByTrack;
+	{
+		wxSqltReader reader;
+		if( reader.GetDb() == NULL )
+		{
+			// no reader without write-ahead logging, leave the lookup to SjPlaylistEntry::VerifyUrl()
+			for( i = 0; i < count; i++ )
+			{
+				if( m_state[i] == SJ_VERIFY_PENDING )
+				{
+					m_state[i] = SJ_VERIFY_LAZY;
+					m_published[i] = 1;
+				}
+			}
+			return;
+		}
+		wxSqlt sql(reader.GetDb());
+		sql.Query(wxT("SELECT url, leadartistname, albumname, trackname FROM tracks;"));
+		while( sql.Next() )
+		{
+			wxString trackLower = sql.GetString(3).Lower();
+			if( wantedNames.Lookup(trackLower) )
+			{
+				rowUrls.Add(sql.GetString(0));
+				rowArtists.Add(sql.GetString(1));
+				rowAlbums.Add(sql.GetString(2));
+				rowTracks.Add(sql.GetString(3));
+				nextRow.Add(rowsByTrack.Lookup(trackLower));
+				rowsByTrack.Insert(trackLower, rowUrls.GetCount());
+			}
+
+			if( m_verifier->m_stop )
+			{
+				return;
+			}
+		}
+	}
+
+	// match the entries in the same order as SjLibraryModule::GetUrl() does
+	for( i = 0; i < count; i++ )
+	{
+		if( m_state[i] != SJ_VERIFY_PENDING )
+		{
+			continue;
+		}
+
+		wxString artistName = GetField(m_unverifiedUrls[i], 2).Trim(true).Trim(false);
+		wxString albumName  = GetField(m_unverifiedUrls[i], 3).Trim(true).Trim(false);
+		wxString trackName  = GetField(m_unverifiedUrls[i], 4).Trim(true).Trim(false);
+		if( artistName.IsEmpty() || trackName.IsEmpty() )
+		{
+			continue;
+		}
+
+		long found = 0, row, stage;
+		for( stage = albumName.IsEmpty()? 2 : 0; stage < 5 && !found; stage++ )
+		{
+			row = rowsByTrack.Lookup(stage==4? artistName.Lower() : trackName.Lower());
+			for( ; row && !found; row = nextRow[row-1] )
+			{
+				const wxString& a = rowArtists[row-1];
+				const wxString& t = rowTracks[row-1];
+				switch( stage )
+				{
+					case 0: if( a==artistName && rowAlbums[row-1]==albumName && t==trackName ) found = row; break;
+					case 1: if( a.CmpNoCase(artistName)==0 && rowAlbums[row-1].CmpNoCase(albumName)==0 && t.CmpNoCase(trackName)==0 ) found = row; break;
+					case 2: if( a==artistName && t==trackName ) found = row; break;
+					case 3: if( a.CmpNoCase(artistName)==0 && t.CmpNoCase(trackName)==0 ) found = row; break;
+					case 4: if( a.CmpNoCase(trackName)==0 && t.CmpNoCase(artistName)==0 ) found = row; break;
+				}
+			}
+		}
+
+		if( found )
+		{
+			// SjPlaylistEntry::VerifyUrl() opens the found URL; we do the same for
+			// local files and leave the others to it
+			const wxString& url = rowUrls[found-1];
+			if( !url.StartsWith("file:") || url.Find('#') != wxNOT_FOUND )
+			{
+				m_state[i] = SJ_VERIFY_LAZY;
+				m_published[i] = 1;
+			}
+			else if( wxFileSystem::URLToFileName(url).FileExists() )
+			{
+				m_urls[i] = url;
+				m_state[i] = SJ_VERIFY_OK;
+			}
+		}
+	}
+}
+
+
+void SjUrlVerifierWorker::Publish()
+{
+	bool added = false;
+	{
+		wxCriticalSectionLocker locker(m_verifier->m_critical);
+		if( m_verifier->m_stop )
+		{
+			return;
+		}
+
+		size_t i, count = m_ids.GetCount();
+		for( i = 0; i < count; i++ )
+		{
+			if( m_state[i] != SJ_VERIFY_PENDING && !m_published[i] )
+			{
+				m_verifier->m_resultIds.Add(m_ids[i]);
+				m_verifier->m_resultUrls.Add(m_urls[i].Clone()); // deep copy, the string is used in another thread
+				m_verifier->m_resultOk.Add(m_state[i]==SJ_VERIFY_OK? 1 : 0);
+				m_published[i] = 1;
+				added = true;
+			}
+		}
+	}
+
+	if( added )
+	{
+		m_verifier->QueueEvent(new wxCommandEvent(wxEVT_COMMAND_MENU_SELECTED, IDO_URLSVERIFIED));
+	}
+}
+
+
+/*******************************************************************************
+ * SjUrlVerifier
+ ******************************************************************************/
+
+
+BEGIN_EVENT_TABLE(SjUrlVerifier, wxEvtHandler)
+	EVT_MENU        (IDO_URLSVERIFIED,          SjUrlVerifier::OnVerified   )
+END_EVENT_TABLE()
+
+
+SjUrlVerifier::SjUrlVerifier(SjPlaylist* playlist)
+{
+	m_playlist      = playlist;
+	m_lastAddedId   = 0;
+	m_running       = false;
+	m_stop          = false;
+	m_worker        = NULL;
+}
+
+
+SjUrlVerifier::~SjUrlVerifier()
+{
+	Stop();
+}
+
+
+void SjUrlVerifier::Add(long entryId, const wxString& unverifiedUrl)
+{
+	wxASSERT( wxThread::IsMain() );
+
+	if( entryId <= m_lastAddedId
+	 || SjMainApp::IsInShutdown() )
+	{
+		return;
+	}
+	m_lastAddedId = entryId;
+
+	wxCriticalSectionLocker locker(m_critical);
+
+	m_todoIds.Add(entryId);
+	m_todoUrls.Add(unverifiedUrl.Clone());
+
+	if( !m_running )
+	{
+		// a worker that has finished is just about to return from Entry()
+		if( m_worker )
+		{
+			m_worker->Wait();
+			delete m_worker;
+		}
+
+		m_stop    = false;
+		m_running = true;
+		m_worker  = new SjUrlVerifierWorker(this);
+	}
+}
+
+
+void SjUrlVerifier::Stop()
+{
+	{
+		wxCriticalSectionLocker locker(m_critical);
+		m_stop = true;
+		m_todoIds.Empty();
+		m_todoUrls.Empty();
+		m_resultIds.Empty();
+		m_resultUrls.Empty();
+		m_resultOk.Empty();
+	}
+
+	if( m_worker )
+	{
+		m_worker->Wait();
+		delete m_worker;
+		m_worker = NULL;
+	}
+
+	m_running = false;
+}
+
+
+void SjUrlVerifier::OnVerified(wxCommandEvent&)
+{
+	// take the results
+	wxArrayLong   ids, oks;
+	wxArrayString urls;
+	{
+		wxCriticalSectionLocker locker(m_critical);
+		ids  = m_resultIds;
+		urls = m_resultUrls;
+		oks  = m_resultOk;
+		m_resultIds.Empty();
+		m_resultUrls.Empty();
+		m_resultOk.Empty();
+	}
+
+	size_t r, resultCount = ids.GetCount();
+	if( resultCount == 0 )
+	{
+		return; // already taken by a previous event
+	}
+
+	// apply them to the entries; the IDs are mapped to the positions
+	// only once as GetPosById() would be too slow for large playlists
+	SjLLHash positions;
+	long i, count = m_playlist->GetCount();
+	for( i = 0; i < count; i++ )
+	{
+		positions.Insert(m_playlist->Item(i).GetId(), i+1);
+	}
+
+	for( r = 0; r < resultCount; r++ )
+	{
+		long pos = positions.Lookup(ids[r]) - 1;
+		if( pos >= 0 )
+		{
+			SjPlaylistEntry& entry = m_playlist->Item(pos);
+			if( !entry.m_urlVerified )
+			{
+				entry.SetVerifiedUrl(urls[r], oks[r]!=0);
+			}
+		}
+	}
+
+	// the enqueued marks of the browser depend on the verified URLs
+	if( g_mainFrame && g_mainFrame->m_browser )
+	{
+		g_mainFrame->m_browser->RefreshSelection();
+	}
+}
@@ -0,0 +1,75 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    urlverifier.h
+ * Authors: Björn Petersen
+ * Purpose: Verify the URLs of playlist entries in background
+ *
+ ******************************************************************************/
+
+
+#ifndef __SJ_URLVERIFIER_H__
+#define __SJ_URLVERIFIER_H__
+
+
+class SjUrlVerifierWorker;
+
+
+class SjUrlVerifier : public wxEvtHandler
+{
+public:
+	                SjUrlVerifier       (SjPlaylist*);
+	                ~SjUrlVerifier      ();
+
+	// add an unverified entry; the verification is started if not yet running.
+	// Entries verified meanwhile by SjPlaylistEntry::VerifyUrl() are skipped
+	// when the results are applied.  As the entry IDs are increasing, IDs not
+	// larger than the last one added are ignored.
+	void            Add                 (long entryId, const wxString& unverifiedUrl);
+
+	// stop the worker; this function waits for the worker to terminate.
+	// pending results are dropped, the entries are verified lazily then.
+	void            Stop                ();
+
+private:
+	SjPlaylist*     m_playlist;
+	long            m_lastAddedId;
+	void            OnVerified          (wxCommandEvent&);
+
+	// the worker takes all entries from m_todo at once and adds the results
+	// to m_results; all these members are protected by m_critical
+	wxCriticalSection m_critical;
+	wxArrayLong     m_todoIds;
+	wxArrayString   m_todoUrls;
+	wxArrayLong     m_resultIds;
+	wxArrayString   m_resultUrls;
+	wxArrayLong     m_resultOk;
+	bool            m_running;
+	bool            m_stop;
+
+	SjUrlVerifierWorker* m_worker;
+
+	friend class    SjUrlVerifierWorker;
+	DECLARE_EVENT_TABLE ()
+};
+
+
+#endif // __SJ_URLVERIFIER_H__
@@ -0,0 +1,505 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    autovolanalyzer.cpp
+ * Authors: Björn Petersen
+ * Purpose: Calculate the auto-volume of not yet played tracks in background
+ *
+ *******************************************************************************
+ *
+ * Normally, the auto-volume of a track is calculated while it is played, see
+ * SjPlayer_BackendCallback(), so a track played the first time starts with a
+ * guessed gain that is corrected while playing.
+ *
+ * The analyzer decodes the tracks without an auto-volume in some low-priority
+ * worker threads, faster than realtime, and feeds the samples to the same
+ * SjVolumeCalc used while playing - so the stored gains are comparable to the
+ * ones calculated on playback and SjLibraryModule::PlaybackDone() can still
+ * merge them.  The results are written to the library in the main thread.
+ *
+ ******************************************************************************/
+
+
+#include <sjbase/base.h>
+#include <sjmodules/autovolanalyzer.h>
+#include <sjmodules/library.h>
+#include <sjtools/volumecalc.h>
+#include <sjtools/wavework.h>
+#if SJ_USE_GSTREAMER
+#include <gst/gst.h>
+#endif
+
+
+#define SJ_AUTOVOL_MAX_WORKERS  4
+#define SJ_AUTOVOL_LOG_EVERY    100
+#define SJ_AUTOVOL_WRITE_EVERY  50
+#define SJ_AUTOVOL_POLL_MS      100
+
+
+/*******************************************************************************
+ * SjAutoVolWorker
+ ******************************************************************************/
+
+
+class SjAutoVolWorker : public wxThread
+{
+public:
+	                SjAutoVolWorker     (SjAutoVolAnalyzer*);
+	void*           Entry               ();
+
+private:
+	SjAutoVolAnalyzer* m_analyzer;
+
+	bool            Analyze             (const wxString& url, double& retGain, long& retDecodedMs);
+
+	// only used while Analyze() runs; set by the streaming thread of the pipeline
+	SjVolumeCalc*   m_volumeCalc;
+	int             m_samplerate;
+	int             m_channels;
+	double          m_decodedSamples;
+
+	#if SJ_USE_GSTREAMER
+	friend void     on_autovol_pad_added(GstElement*, GstPad*, gpointer);
+	friend void     on_autovol_handoff  (GstElement*, GstBuffer*, GstPad*, gpointer);
+	#endif
+};
+
+
+SjAutoVolWorker::SjAutoVolWorker(SjAutoVolAnalyzer* analyzer)
+	: wxThread(wxTHREAD_JOINABLE)
+{
+	m_analyzer       = analyzer;
+	m_volumeCalc     = NULL;
+	m_samplerate     = 44100;
+	m_channels       = 2;
+	m_decodedSamples = 0.0;
+
+	Create();
+	SetPriority(WXTHREAD_MIN_PRIORITY);
+	Run();
+}
+
+
+void* SjAutoVolWorker::Entry()
+{
+	wxString url;
+	while( m_analyzer->GetNextUrl(url) )
+	{
+		// the list of URLs may be collected some time ago; skip tracks
+		// that got their volume by playback or were removed meanwhile
+		bool skip = false;
+		{
+			wxSqltReader reader;
+			if( reader.GetDb() )
+			{
+				wxSqlt sql(reader.GetDb());
+				sql.Query(wxT("SELECT autovol FROM tracks WHERE url='") + wxSqlt::QParam(url) + wxT("';"));
+				skip = ( !sql.Next() || sql.GetLong(0) != 0 );
+			}
+		}
+
+		double  gain = -1.0;
+		long    decodedMs = -1; // -1 = skipped
+		if( !skip )
+		{
+			decodedMs = 0;
+			if( !Analyze(url, gain, decodedMs) )
+			{
+				gain = -1.0;
+			}
+		}
+
+		wxCommandEvent* event = new wxCommandEvent(wxEVT_COMMAND_MENU_SELECTED, IDO_AUTOVOLANALYZED);
+		event->SetString(url.Clone()); // deep copy, the event is processed in another thread
+		event->SetExtraLong(gain > 0.0? ::SjGain2Long(gain) : 0);
+		event->SetInt((int)decodedMs);
+		m_analyzer->QueueEvent(event);
+	}
+
+	return 0;
+}
+
+
+#if SJ_USE_GSTREAMER
+
+
+void on_autovol_pad_added(GstElement* decodebin, GstPad* newSourcePad, gpointer userdata)
+{
+	// link the first audio pad to the converter, other pads (video etc.) are left unlinked
+	GstElement* audioconvert = (GstElement*)userdata;
+
+	GstCaps* caps = gst_pad_get_current_caps(newSourcePad);
+	if( caps == NULL ) { return; }
+		bool isAudio = g_str_has_prefix(gst_structure_get_name(gst_caps_get_structure(caps, 0)), "audio");
+	gst_caps_unref(caps);
+
+	if( isAudio )
+	{
+		GstPad* sinkPad = gst_element_get_static_pad(audioconvert, "sink");
+		if( !gst_pad_is_linked(sinkPad) )
+		{
+			gst_pad_link(newSourcePad, sinkPad);
+		}
+		gst_object_unref(sinkPad);
+	}
+}
+
+
+void on_autovol_handoff(GstElement* fakesink, GstBuffer* buffer, GstPad* pad, gpointer userdata)
+{
+	SjAutoVolWorker* worker = (SjAutoVolWorker*)userdata;
+
+	if( worker->m_decodedSamples == 0.0 )
+	{
+		GstCaps* caps = gst_pad_get_current_caps(pad);
+		if( caps ) {
+			GstStructure* s = gst_caps_get_structure(caps, 0);
+			gint v;
+			if( gst_structure_get_int(s, "rate", &v) && v >= 1000 && v <= 1000000 ) { worker->m_samplerate = v; }
+			if( gst_structure_get_int(s, "channels", &v) && v >= 1 && v <= 32 ) { worker->m_channels = v; }
+			gst_caps_unref(caps);
+		}
+	}
+
+	GstMapInfo map;
+	if( gst_buffer_map(buffer, &map, GST_MAP_READ) )
+	{
+		worker->m_volumeCalc->AddBuffer((const float*)map.data, map.size, worker->m_samplerate, worker->m_channels);
+		worker->m_decodedSamples += (double)(map.size / sizeof(float) / worker->m_channels);
+		gst_buffer_unmap(buffer, &map);
+	}
+}
+
+
+bool SjAutoVolWorker::Analyze(const wxString& url, double& retGain, long& retDecodedMs)
+{
+	/*
+	uridecodebin --> audioconvert --> capsfilter (F32LE) --> fakesink (not synced to the clock, so we're faster than realtime)
+	*/
+	GstElement* pipeline     = gst_pipeline_new        (NULL);
+	GstElement* decodebin    = gst_element_factory_make("uridecodebin", NULL);
+	GstElement* audioconvert = gst_element_factory_make("audioconvert", NULL);
+	GstElement* capsfilter   = gst_element_factory_make("capsfilter",   NULL);
+	GstElement* fakesink     = gst_element_factory_make("fakesink",     NULL);
+	if( !pipeline || !decodebin || !audioconvert || !capsfilter || !fakesink ) {
+		if( pipeline )     { gst_object_unref(pipeline);     }
+		if( decodebin )    { gst_object_unref(decodebin);    }
+		if( audioconvert ) { gst_object_unref(audioconvert); }
+		if( capsfilter )   { gst_object_unref(capsfilter);   }
+		if( fakesink )     { gst_object_unref(fakesink);     }
+		return false;
+	}
+
+	gst_bin_add_many(GST_BIN(pipeline), decodebin, audioconvert, capsfilter, fakesink, NULL);
+	gst_element_link_many(audioconvert, capsfilter, fakesink, NULL);
+
+	GstCaps* caps = gst_caps_new_simple("audio/x-raw",
+				"format", G_TYPE_STRING, "F32LE",
+				"layout", G_TYPE_STRING, "interleaved",
+				NULL);
+		g_object_set(G_OBJECT(capsfilter), "caps", caps, NULL);
+	gst_caps_unref(caps);
+
+	g_object_set(G_OBJECT(fakesink), "sync", FALSE, "signal-handoffs", TRUE, NULL);
+	g_signal_connect(fakesink, "handoff", G_CALLBACK(on_autovol_handoff), this);
+	g_signal_connect(decodebin, "pad-added", G_CALLBACK(on_autovol_pad_added), audioconvert);
+
+	{
+		const wxCharBuffer uri = url.mb_str(wxConvUTF8);
+		g_object_set(G_OBJECT(decodebin), "uri", uri.data(), NULL);
+	}
+
+	// decode, wait for the end of the stream or for an error
+	SjVolumeCalc volumeCalc;
+	m_volumeCalc     = &volumeCalc;
+	m_samplerate     = 44100;
+	m_channels       = 2;
+	m_decodedSamples = 0.0;
+
+	bool ok = false;
+	gst_element_set_state(pipeline, GST_STATE_PLAYING);
+	GstBus* bus = gst_element_get_bus(pipeline);
+	while( 1 )
+	{
+		GstMessage* msg = gst_bus_timed_pop_filtered(bus, SJ_AUTOVOL_POLL_MS*GST_MSECOND, (GstMessageType)(GST_MESSAGE_EOS|GST_MESSAGE_ERROR));
+		if( msg )
+		{
+			ok = (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS);
+			gst_message_unref(msg);
+			break;
+		}
+
+		if( m_analyzer->m_stop ) // just reading a bool, no need to lock
+		{
+			break;
+		}
+	}
+	gst_object_unref(bus);
+	gst_element_set_state(pipeline, GST_STATE_NULL);
+	gst_object_unref(pipeline);
+	m_volumeCalc = NULL;
+
+	if( !ok || !volumeCalc.IsGainWorthSaving() )
+	{
+		return false;
+	}
+
+	retGain      = volumeCalc.GetGain();
+	retDecodedMs = (long)(m_decodedSamples * 1000.0 / (double)m_samplerate);
+	return true;
+}
+
+
+#else
+
+
+bool SjAutoVolWorker::Analyze(const wxString& url, double& retGain, long& retDecodedMs)
+{
+	return false; // decoding without playing is not supported by the other backends
+}
+
+
+#endif
+
+
+/*******************************************************************************
+ * SjAutoVolAnalyzer
+ ******************************************************************************/
+
+
+BEGIN_EVENT_TABLE(SjAutoVolAnalyzer, wxEvtHandler)
+	EVT_TIMER       (IDTIMER_AUTOVOLANALYZER,   SjAutoVolAnalyzer::OnTimer      )
+	EVT_MENU        (IDO_AUTOVOLANALYZED,       SjAutoVolAnalyzer::OnAnalyzed   )
+END_EVENT_TABLE()
+
+
+SjAutoVolAnalyzer::SjAutoVolAnalyzer()
+	: m_timer(this, IDTIMER_AUTOVOLANALYZER)
+{
+	m_todoIndex      = 0;
+	m_stop           = false;
+	m_doneCount      = 0;
+	m_failedCount    = 0;
+	m_skippedCount   = 0;
+	m_decodedMs      = 0.0;
+	m_startTimestamp = 0;
+}
+
+
+SjAutoVolAnalyzer::~SjAutoVolAnalyzer()
+{
+	Stop();
+}
+
+
+void SjAutoVolAnalyzer::StartDelayed(long ms)
+{
+	if( !IsRunning() )
+	{
+		m_timer.Start(ms, wxTIMER_ONE_SHOT);
+	}
+}
+
+
+void SjAutoVolAnalyzer::OnTimer(wxTimerEvent&)
+{
+	Start();
+}
+
+
+void SjAutoVolAnalyzer::Start()
+{
+	#if SJ_USE_GSTREAMER
+	if( IsRunning()
+	 || SjMainApp::IsInShutdown()
+	 || !g_mainFrame->m_player.AvIsEnabled() )
+	{
+		return;
+	}
+
+	// collect the tracks to analyze; streams are skipped as they do not end
+	m_todo.Empty();
+	m_todoIndex = 0;
+	{
+		wxSqlt sql;
+		sql.Query(wxT("SELECT url FROM tracks WHERE autovol=0 AND url LIKE 'file:%';"));
+		while( sql.Next() )
+		{
+			wxString url = sql.GetString(0);
+			if( !m_failedUrls.Lookup(url) )
+			{
+				m_todo.Add(url);
+			}
+		}
+	}
+
+	if( m_todo.IsEmpty() )
+	{
+		return;
+	}
+
+	if( !gst_is_initialized() )
+	{
+		gst_init(NULL, NULL);
+	}
+
+	// start the workers; we leave one CPU for playback and the GUI
+	int workerCount = wxThread::GetCPUCount() - 1;
+	if( workerCount > SJ_AUTOVOL_MAX_WORKERS ) workerCount = SJ_AUTOVOL_MAX_WORKERS;
+	if( workerCount > (int)m_todo.GetCount() ) workerCount = (int)m_todo.GetCount();
+	if( workerCount < 1 ) workerCount = 1;
+
+	m_stop           = false;
+	m_doneCount      = 0;
+	m_failedCount    = 0;
+	m_skippedCount   = 0;
+	m_decodedMs      = 0.0;
+	m_startTimestamp = SjTools::GetMsTicks();
+
+	wxLogInfo(wxT("Analyzing the volume of %i tracks using %i threads"), (int)m_todo.GetCount(), workerCount);
+	for( int i = 0; i < workerCount; i++ )
+	{
+		m_workers.Add(new SjAutoVolWorker(this));
+	}
+	#endif
+}
+
+
+void SjAutoVolAnalyzer::Stop()
+{
+	m_timer.Stop();
+
+	{
+		wxCriticalSectionLocker locker(m_critical);
+		m_stop = true;
+	}
+
+	int i, iCount = m_workers.GetCount();
+	for( i = 0; i < iCount; i++ )
+	{
+		SjAutoVolWorker* worker = (SjAutoVolWorker*)m_workers[i];
+		worker->Wait();
+		delete worker;
+	}
+	m_workers.Empty();
+
+	WritePending();
+}
+
+
+void SjAutoVolAnalyzer::WritePending()
+{
+	// write the gains analyzed so far in a single transaction; writing
+	// every track on its own would cost a sync per track and would change
+	// the library generation again and again
+	if( m_pendingUrls.IsEmpty() )
+	{
+		return;
+	}
+
+	if( g_mainFrame && g_mainFrame->m_libraryModule )
+	{
+		g_mainFrame->m_libraryModule->SetAnalyzedAutoVol(m_pendingUrls, m_pendingGains);
+	}
+
+	m_pendingUrls.Empty();
+	m_pendingGains.Empty();
+}
+
+
+bool SjAutoVolAnalyzer::GetNextUrl(wxString& retUrl)
+{
+	wxCriticalSectionLocker locker(m_critical);
+	if( m_stop || m_todoIndex >= m_todo.GetCount() )
+	{
+		return false;
+	}
+
+	retUrl = m_todo[m_todoIndex].Clone(); // deep copy, the string is used in another thread
+	m_todoIndex++;
+	return true;
+}
+
+
+void SjAutoVolAnalyzer::OnAnalyzed(wxCommandEvent& event)
+{
+	if( !IsRunning() || SjMainApp::IsInShutdown() )
+	{
+		return; // a late event of a stopped analyzer
+	}
+
+	wxString url = event.GetString();
+	long gainLong = event.GetExtraLong();
+	if( event.GetInt() < 0 )
+	{
+		m_skippedCount++;
+	}
+	else if( gainLong > 0 )
+	{
+		m_pendingUrls.Add(url);
+		m_pendingGains.Add(gainLong);
+		if( m_pendingUrls.GetCount() >= SJ_AUTOVOL_WRITE_EVERY )
+		{
+			WritePending();
+		}
+		m_doneCount++;
+		m_decodedMs += event.GetInt();
+	}
+	else
+	{
+		m_failedUrls.Insert(url, 1);
+		m_failedCount++;
+	}
+
+	long finishedCount = m_doneCount + m_failedCount + m_skippedCount;
+	if( finishedCount >= (long)m_todo.GetCount() )
+	{
+		wxLogInfo(wxT("%s"), GetStatus().c_str());
+		Stop();
+	}
+	else if( (finishedCount % SJ_AUTOVOL_LOG_EVERY) == 0 )
+	{
+		wxLogInfo(wxT("%s"), GetStatus().c_str());
+	}
+}
+
+
+wxString SjAutoVolAnalyzer::GetStatus() const
+{
+	long finishedCount = m_doneCount + m_failedCount + m_skippedCount;
+	double elapsedMs = (double)(SjTools::GetMsTicks() - m_startTimestamp);
+	double speed = elapsedMs > 0.0? (m_decodedMs / elapsedMs) : 0.0;
+	return wxString::Format(wxT("Volume analysis: %i of %i tracks done, %i failed, %.1fx realtime"),
+	                        (int)finishedCount, (int)m_todo.GetCount(), (int)m_failedCount, speed);
+}
+
+
+wxString SjAutoVolAnalyzer::GetProgress() const
+{
+	if( !IsRunning() )
+	{
+		return wxEmptyString;
+	}
+
+	long finishedCount = m_doneCount + m_failedCount + m_skippedCount;
+	return wxString::Format(_("%s of %s tracks analyzed"),
+	                        SjTools::FormatNumber(finishedCount).c_str(), SjTools::FormatNumber(m_todo.GetCount()).c_str());
+}
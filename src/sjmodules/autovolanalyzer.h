@@ -0,0 +1,93 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    autovolanalyzer.h
+ * Authors: Björn Petersen
+ * Purpose: Calculate the auto-volume of not yet played tracks in background
+ *
+ ******************************************************************************/
+
+
+#ifndef __SJ_AUTOVOLANALYZER_H__
+#define __SJ_AUTOVOLANALYZER_H__
+
+
+class SjAutoVolWorker;
+
+
+class SjAutoVolAnalyzer : public wxEvtHandler
+{
+public:
+	                SjAutoVolAnalyzer   ();
+	                ~SjAutoVolAnalyzer  ();
+
+	// start analyzing all tracks without an auto-volume after the given delay;
+	// nothing happens if auto-volume is disabled or if we're already running.
+	void            StartDelayed        (long ms);
+
+	// stop all workers; this function waits for the workers to terminate
+	// and should be called before the library is unloaded.
+	void            Stop                ();
+
+	bool            IsRunning           () const { return m_workers.GetCount()>0; }
+
+	// get a human readable progress and throughput information; GetStatus() is
+	// logged, GetProgress() is a shorter, translated text for the dialogs
+	wxString        GetStatus           () const;
+	wxString        GetProgress         () const;
+
+private:
+	void            Start               ();
+	void            OnTimer             (wxTimerEvent&);
+	void            OnAnalyzed          (wxCommandEvent&);
+
+	// the workers take the URLs from m_todo, m_todoIndex and m_stop are
+	// protected by m_critical
+	bool            GetNextUrl          (wxString& retUrl);
+	wxCriticalSection m_critical;
+	wxArrayString   m_todo;
+	size_t          m_todoIndex;
+	bool            m_stop;
+
+	wxArrayPtrVoid  m_workers;
+	wxTimer         m_timer;
+
+	// URLs that cannot be decoded are not retried in this session
+	SjSLHash        m_failedUrls;
+
+	// the analyzed gains are written in batches, see WritePending()
+	void            WritePending        ();
+	wxArrayString   m_pendingUrls;
+	wxArrayLong     m_pendingGains;
+
+	// statistics, only used in the main thread
+	long            m_doneCount;
+	long            m_failedCount;
+	long            m_skippedCount;
+	double          m_decodedMs;
+	unsigned long   m_startTimestamp;
+
+	friend class    SjAutoVolWorker;
+	DECLARE_EVENT_TABLE ()
+};
+
+
+#endif // __SJ_AUTOVOLANALYZER_H__
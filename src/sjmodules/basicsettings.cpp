@@ -718,6 +718,7 @@ private:
 	void            ApplyOrCancelLittleMisc (bool apply, bool& wantsToBeRestarted);
 	long            m_miscOldIdxCacheIndex, m_miscNewIdxCacheIndex,
 	                m_miscOldIdxSync, m_miscNewIdxSync,
+	                m_miscOldIdxWal, m_miscNewIdxWal,
 	                m_miscIndexImgDiskCache,
 	                m_miscIndexImgRamCache,
 	                m_miscIndexImgRegardTimestamp;
@@ -865,6 +866,11 @@ void SjBasicSettingsConfigPage::GetLittleMiscOptions(SjArrayLittleOption& lo)
 	                        _("Fast")+SEP+_("Save but slower")+SEP+_("Very save and slow"),
 	                        &m_miscNewIdxSync, 0L, 0L, wxT(""), SJ_ICON_LITTLEDEFAULT, FALSE));
 
+	m_miscOldIdxWal = m_miscNewIdxWal =  g_tools->m_config->Read(wxT("main/idxWal"), SJ_DEF_SQLITE_WAL);
+	lo.Add(new SjLittleBit (_("Write-ahead logging"),
+	                        _("No")+SEP+_("Yes"),
+	                        &m_miscNewIdxWal, SJ_DEF_SQLITE_WAL, 0L, wxT(""), SJ_ICON_LITTLEDEFAULT, FALSE));
+
 	// ...files: temp. directory
 	g_tools->m_cache.GetLittleOptions(lo);
 
@@ -939,6 +945,14 @@ void SjBasicSettingsConfigPage::ApplyOrCancelLittleMisc(bool apply, bool& wantsT
 			g_tools->m_config->Write(wxT("main/idxCacheSync"), m_miscNewIdxSync);
 		}
 
+		if( m_miscOldIdxWal != m_miscNewIdxWal )
+		{
+			// the journal mode is changed on the next start, readers may be in use now
+			g_tools->m_config->Write(wxT("main/idxWal"), m_miscNewIdxWal);
+			wantsToBeRestarted = TRUE;
+			m_miscOldIdxWal = m_miscNewIdxWal; // avoid recursion
+		}
+
 		// apply language
 		if( m_oldLanguageValue != m_newLanguageValue )
 		{
@@ -99,7 +99,7 @@ SJPARAM SjCPlugin::CallPlugin(SJPARAM msg, SJPARAM param1, SJPARAM param2, SJPAR
 {
 	wxASSERT( msg >= 10000 && msg <= 19999 );
 
-	if( !m_initError )
+	if( !m_initError && m_cinterf )
 	{
 		return m_cinterf->CallPlugin(m_cinterf, msg, param1, param2, param3);
 	}
@@ -113,27 +113,62 @@ SjCPlugin::SjCPlugin(   SjInterfaceBase* interf,
                         wxDynamicLibrary* dynlib, SjInterface* cinterf)
 	:   SjCommonModule(interf)
 {
-	wxASSERT( interf && dynlib && cinterf );
+	wxASSERT( interf );
+	wxASSERT( (dynlib && cinterf) || (!dynlib && !cinterf) );
 
 	// init structures
 	m_returnStringStack     = 0;
 	m_file                  = file;
 	m_name                  = SjTools::GetFileNameFromUrl(file, NULL, true/*strip ext.*/);
-	m_dynlib                = dynlib;
-
-	m_cinterf               = cinterf;
-	m_cinterf->rsvd         = (SJPARAM)this;
-	m_cinterf->CallMaster   = SjCPlugin__CallMaster__;
+	m_dynlib                = NULL;
+	m_cinterf               = NULL;
 
 	m_initDone              = false;
 	m_initError             = false;
 
 	m_see                   = NULL;
+
+	// if the library is not given, it is opened on the first load
+	if( dynlib )
+	{
+		SetLibrary(dynlib, cinterf);
+	}
+}
+
+
+void SjCPlugin::SetLibrary(wxDynamicLibrary* dynlib, SjInterface* cinterf)
+{
+	m_dynlib                = dynlib;
+
+	m_cinterf               = cinterf;
+	m_cinterf->rsvd         = (SJPARAM)this;
+	m_cinterf->CallMaster   = SjCPlugin__CallMaster__;
 }
 
 
 bool SjCPlugin::FirstLoad()
 {
+	// a plugin that failed on initialisation is not opened again until the file is replaced
+	if( m_manifestFlags & SJ_CPLUGIN_INIT_FAILED )
+	{
+		wxLogInfo(wxT("Skipping %s, SJ_PLUGIN_INIT failed before"), m_file.c_str());
+		return false;
+	}
+
+	// open the library, if not yet done
+	if( m_cinterf == NULL )
+	{
+		wxDynamicLibrary*   dynlib;
+		SjInterface*        cinterf;
+		if( !g_cInterface->OpenLibrary(m_file, dynlib, cinterf) )
+		{
+			// the manifest entry is out of date, the file is probed again on the next program start
+			m_interface->UpdateManifest(this, true/*remove*/);
+			return false;
+		}
+		SetLibrary(dynlib, cinterf);
+	}
+
 	// call PL_INIT
 	m_initError = false;
 	if( CallPlugin(SJ_PLUGIN_INIT) == 0 )
@@ -141,6 +176,8 @@ bool SjCPlugin::FirstLoad()
 		wxLogError(wxT("SJ_PLUGIN_INIT failed."));
 		wxLogError(_("Cannot open \"%s\"."), m_file.c_str());
 		m_initError = true;
+		m_manifestFlags |= SJ_CPLUGIN_INIT_FAILED;
+		m_interface->UpdateManifest(this, false);
 		return false;
 	}
 	m_initDone = true;
@@ -207,60 +244,92 @@ SjCInterface::SjCInterface()
 typedef SjInterface *(*dllMainEntryFuncType) (void);
 
 
-void SjCInterface::AddModulesFromFile(SjModuleList& list, const wxFileName& fn, bool suppressNoAccessErrors)
+bool SjCInterface::OpenLibrary(const wxString& file, wxDynamicLibrary*& retDynlib, SjInterface*& retCinterf)
 {
 	#if SJ_USE_C_INTERFACE
 		wxDynamicLibrary*       dynlib;
 		dllMainEntryFuncType    entryPoint;
 		SjInterface*            cinterf;
 
-		// rough filename check
-		{
-			wxString name = fn.GetName().Lower();
-			if( name.StartsWith("bass")
-			 || name.StartsWith("dwlgina")
-			 || name.StartsWith("msvc")
-			 || name.StartsWith("sjmmkeybd") )
-			{
-				return; // these are libraries used internally
-			}
-		}
-
 		// load a DLL
 		{
 			wxLogNull null;
 
-			dynlib = new wxDynamicLibrary(fn.GetFullPath());
+			dynlib = new wxDynamicLibrary(file);
 			if( dynlib == NULL )
-				return; // nothing to log - this is no valid library
+				return false; // nothing to log - this is no valid library
 
 			if( !dynlib->IsLoaded() )
 			{
 				delete dynlib;
-				return; // nothing to log - this is no valid library
+				return false; // nothing to log - this is no valid library
 			}
 
 			entryPoint = (dllMainEntryFuncType)dynlib->GetSymbol(wxT("SjGetInterface"));
 			if( entryPoint == NULL )
 			{
 				delete dynlib;
-				return; // nothing to log - this is no valid library
+				return false; // nothing to log - this is no valid library
 			}
 		}
 
-		wxLogInfo(wxT("Loading %s"), fn.GetFullPath().c_str());
+		wxLogInfo(wxT("Loading %s"), file.c_str());
 
 		cinterf = entryPoint();
 		if( cinterf == NULL || cinterf->CallPlugin == NULL )
 		{
 			wxLogError(wxT("SjGetInterface returns 0 or CallPlugin set to 0."));
-			wxLogError(_("Cannot open \"%s\"."), fn.GetFullPath().c_str());
+			wxLogError(_("Cannot open \"%s\"."), file.c_str());
 			delete dynlib;
-			return; // error
+			return false; // error
+		}
+
+		retDynlib = dynlib;
+		retCinterf = cinterf;
+		return true;
+	#else
+		return false;
+	#endif
+}
+
+
+bool SjCInterface::AddModulesFromFile(SjModuleList& list, const wxFileName& fn, bool suppressNoAccessErrors, bool fromManifest)
+{
+	#if SJ_USE_C_INTERFACE
+		wxDynamicLibrary*       dynlib;
+		SjInterface*            cinterf;
+
+		// files from the manifest were plugins on the last run; the library
+		// is opened when the plugin is loaded the first time
+		if( fromManifest )
+		{
+			if( !fn.FileExists() )
+				return false;
+
+			list.Append(new SjCPlugin(this, fn.GetFullPath(), NULL, NULL));
+			return true;
+		}
+
+		// rough filename check
+		{
+			wxString name = fn.GetName().Lower();
+			if( name.StartsWith("bass")
+			 || name.StartsWith("dwlgina")
+			 || name.StartsWith("msvc")
+			 || name.StartsWith("sjmmkeybd") )
+			{
+				return false; // these are libraries used internally
+			}
 		}
 
+		if( !OpenLibrary(fn.GetFullPath(), dynlib, cinterf) )
+			return false;
+
 		// success so far - create the plugin and add it to the list
 		list.Append(new SjCPlugin(this, fn.GetFullPath(), dynlib, cinterf));
+		return true;
+	#else
+		return false;
 	#endif
 }
 
@@ -42,10 +42,13 @@ class SjCInterface;
 class SjCPlugin : public SjCommonModule
 {
 public:
-	// Constructor / Destructor
+	// Constructor / Destructor; if the library is not given, it is opened by FirstLoad()
 	                    SjCPlugin           (SjInterfaceBase* interf, const wxString& file, wxDynamicLibrary*, SjInterface*);
 	virtual             ~SjCPlugin          ();
 
+	// flags in m_manifestFlags
+	#define             SJ_CPLUGIN_INIT_FAILED 0x01
+
 	// Reimplementations
 	bool                FirstLoad           ();
 	void                LastUnload          ();
@@ -58,6 +61,7 @@ public:
 
 private:
 	// private stuff
+	void                SetLibrary          (wxDynamicLibrary*, SjInterface*);
 	wxDynamicLibrary*   m_dynlib;
 	SjInterface*       m_cinterf;
 
@@ -79,8 +83,12 @@ class SjCInterface : public SjInterfaceBase
 {
 public:
 	                SjCInterface        ();
-	void            AddModulesFromFile  (SjModuleList&, const wxFileName&, bool suppressNoAccessErrors);
+	bool            AddModulesFromFile  (SjModuleList&, const wxFileName&, bool suppressNoAccessErrors, bool fromManifest);
 	void            LoadModules         (SjModuleList&);
+
+	// open the library and get the plugin interface; returns false for no
+	// valid plugin, errors are logged
+	bool            OpenLibrary         (const wxString& file, wxDynamicLibrary*& retDynlib, SjInterface*& retCinterf);
 };
 
 extern SjCInterface* g_cInterface;
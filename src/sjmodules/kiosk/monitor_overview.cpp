@@ -54,6 +54,7 @@ SjMonitorOverview::SjMonitorOverview(wxWindow* parent, int id, long style)
 	m_fontIcon   = wxFont(10/*recalculated later*/, wxFONTFAMILY_ROMAN, wxFONTSTYLE_ITALIC/*style*/, wxBOLD/*weight*/, false/*underline*/);
 
 	m_nonDummy = 0;
+	m_offscreenValid = false;
 }
 
 
@@ -103,6 +104,7 @@ void SjMonitorOverview::SetMonitorUsage(long index, long flag, bool set)
 	if( index >= 0 && index < (long)m_monitors.GetCount() )
 	{
 		SjTools::SetFlag(m_monitors[index].m_monitorUsage, flag, set);
+		m_offscreenValid = false;
 	}
 }
 
@@ -116,6 +118,8 @@ void SjMonitorOverview::OnSize(wxSizeEvent&)
 
 void SjMonitorOverview::CalcPositions()
 {
+	m_offscreenValid = false;
+
 	// overall calculations based on the given geometries
 	wxRect geomOverall;
 	long geomOffsetX = 0x7FFFFFFFL, geomOffsetY = 0x7FFFFFFFL, geomMinH = 0x7FFFFFFFL, geomMinW = 0x7FFFFFFFL;
@@ -211,10 +215,34 @@ void SjMonitorOverview::CalcPositions()
 }
 
 
-void SjMonitorOverview::DoPaint(wxDC& dc__)
+void SjMonitorOverview::DoPaint(wxDC& dc)
 {
-	wxSize      clientSize = GetClientSize();
+	wxSize clientSize = GetClientSize();
+
+	// prepare offscreen drawing
+	if( !m_offscreenBitmap.IsOk()
+	 ||  m_offscreenBitmap.GetWidth() != clientSize.x
+	 ||  m_offscreenBitmap.GetHeight() != clientSize.y )
+	{
+		m_offscreenDc.SelectObject(wxNullBitmap);
+		m_offscreenBitmap.Create(clientSize.x, clientSize.y);
+		m_offscreenDc.SelectObject(m_offscreenBitmap);
+		m_offscreenValid = false;
+	}
+
+	if( !m_offscreenValid )
+	{
+		RenderOffscreen(clientSize);
+		m_offscreenValid = true;
+	}
+
+	// copy offscreen to screen
+	dc.Blit(0, 0, clientSize.x, clientSize.y, &m_offscreenDc, 0, 0);
+}
+
 
+void SjMonitorOverview::RenderOffscreen(const wxSize& clientSize)
+{
 	wxColour    bgColour = wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOW);
 	wxBrush     bgBrush(bgColour, wxSOLID);
 
@@ -231,18 +259,7 @@ void SjMonitorOverview::DoPaint(wxDC& dc__)
 
 	#define     digitColour *wxWHITE
 
-	wxDC* drawDc = &dc__;
-
-	// prepare offscreen drawing
-	if( !m_offscreenBitmap.IsOk()
-	 ||  m_offscreenBitmap.GetWidth() != clientSize.x
-	 ||  m_offscreenBitmap.GetHeight() != clientSize.y )
-	{
-		m_offscreenBitmap.Create(clientSize.x, clientSize.y);
-		m_offscreenDc.SelectObject(m_offscreenBitmap);
-	}
-
-	drawDc = &m_offscreenDc;
+	wxDC* drawDc = &m_offscreenDc;
 
 	// draw the background
 	drawDc->SetPen(*wxTRANSPARENT_PEN);
@@ -290,9 +307,6 @@ void SjMonitorOverview::DoPaint(wxDC& dc__)
 		drawDc->GetTextExtent(str, &textW, &textH);
 		drawDc->DrawText(str, drawRect.x+drawRect.width/2-textW/2, drawRect.y+drawRect.height/2-textH/2);
 	}
-
-	// finish offscreen drawing
-	dc__.Blit(0, 0, clientSize.x, clientSize.y, &m_offscreenDc, 0, 0);
 }
 
 
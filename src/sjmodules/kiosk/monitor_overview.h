@@ -62,8 +62,12 @@ private:
 	wxFont          m_fontNumber;
 	wxFont          m_fontIcon;
 
+	// the offscreen bitmap is only re-rendered if the monitors, their usage
+	// or the size have changed; otherwise, painting is a simple blit
 	wxBitmap        m_offscreenBitmap;
 	wxMemoryDC      m_offscreenDc;
+	bool            m_offscreenValid;
+	void            RenderOffscreen     (const wxSize& clientSize);
 
 	void            CalcPositions       ();
 
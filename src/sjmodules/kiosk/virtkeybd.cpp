@@ -648,7 +648,18 @@ private:
 
 	wxTimer         m_closeWatchTimer;
 
-	void            RedrawAllOffscreen  (wxDC&);
+	// persistent offscreen surface; m_drawnStates holds the state of each key
+	// as drawn to the surface, so that only changed keys are redrawn.
+	// Rendered keys are kept as tiles by size and state for reuse.
+	wxBitmap        m_offscreenBitmap;
+	bool            m_offscreenValid;
+	wxArrayString   m_drawnStates;
+	SjSPHash        m_tiles; // "<w>x<h>:<state>" -> wxBitmap*
+	void            ClearTiles          ();
+	bool            IsButtonInverted    (SjVirtKeybdKey* button) const;
+	wxString        GetButtonState      (SjVirtKeybdKey* button) const;
+
+	void            RedrawAllOffscreen  (wxDC&, bool blitAll=FALSE);
 	void            RedrawAllOnscreen   (wxDC&);
 	void            RedrawButtonOnscreen(wxDC&, SjVirtKeybdKey* button);
 	void            DrawButtonRect      (wxDC& dc, const wxRect& rect, bool invert, bool drawTopLine=TRUE, bool drawBottomLine=TRUE);
@@ -709,12 +720,28 @@ SjVirtKeybdFrame::SjVirtKeybdFrame(wxWindow* parent)
 	m_autoClose = true;
 	m_isActive = true;
 
+	m_offscreenValid = false;
+
 	SetCursor(SjVirtKeybdModule::GetStandardCursor());
 }
 
 
 SjVirtKeybdFrame::~SjVirtKeybdFrame()
 {
+	ClearTiles();
+}
+
+
+void SjVirtKeybdFrame::ClearTiles()
+{
+	SjHashIterator  iterator;
+	wxString        tileKey;
+	wxBitmap*       tile;
+	while( (tile=(wxBitmap*)m_tiles.Iterate(iterator, tileKey)) )
+	{
+		delete tile;
+	}
+	m_tiles.Clear();
 }
 
 
@@ -729,6 +756,10 @@ void SjVirtKeybdFrame::OnActivate(wxActivateEvent& event)
 
 void SjVirtKeybdFrame::InitKeybdFrame()
 {
+	// colours, fonts and sizes may change, forget everything drawn before
+	m_offscreenValid = false;
+	ClearTiles();
+
 	// create the needed pens and colours
 	if( g_virtKeybd->GetKeybdFlags() & SJ_VIRTKEYBD_BLACK )
 	{
@@ -936,19 +967,31 @@ void SjVirtKeybdFrame::DrawButtonRect(wxDC& dc, const wxRect& rect, bool invert,
 	}
 	dc.DrawLine(rect.x+rect.width-1, rect.y, rect.x+rect.width-1, rect.y+rect.height);
 }
-void SjVirtKeybdFrame::RedrawButtonOnscreen(wxDC& dc, SjVirtKeybdKey* button)
+bool SjVirtKeybdFrame::IsButtonInverted(SjVirtKeybdKey* button) const
 {
-	wxRect rect(button->m_rect);
-	rect.Deflate(1);
-
-	// invert?
-	bool invert = FALSE;
 	if( (m_shift && button->IsShift()               == m_shift)
 	 || (m_alt   && button->IsAlt  (m_shift, m_alt) == m_alt  )
 	 || (button == m_clicked)  )
 	{
-		invert = TRUE;
+		return TRUE;
 	}
+	return FALSE;
+}
+
+
+wxString SjVirtKeybdFrame::GetButtonState(SjVirtKeybdKey* button) const
+{
+	return button->GetKeyTitle(m_shift, m_alt) + (IsButtonInverted(button)? wxT("\t1") : wxT("\t0"));
+}
+
+
+void SjVirtKeybdFrame::RedrawButtonOnscreen(wxDC& dc, SjVirtKeybdKey* button)
+{
+	wxRect rect(button->m_rect);
+	rect.Deflate(1);
+
+	// invert?
+	bool invert = IsButtonInverted(button);
 
 	// get text to draw
 	wxString textAll = button->GetKeyTitle(m_shift, m_alt);
@@ -1085,20 +1128,94 @@ void SjVirtKeybdFrame::RedrawAllOnscreen(wxDC& dc)
 }
 
 
-void SjVirtKeybdFrame::RedrawAllOffscreen(wxDC& clientDc)
+void SjVirtKeybdFrame::RedrawAllOffscreen(wxDC& clientDc, bool blitAll)
 {
-	wxSize clientSize = GetClientSize();
+	wxSize  clientSize = GetClientSize();
+	long    i, iCount = m_layout.m_keys.GetCount();
+	if( clientSize.x <= 0 || clientSize.y <= 0 )
+	{
+		return;
+	}
+
+	wxMemoryDC offscreenDc;
+
+	// (re-)create the offscreen surface, if needed
+	if( !m_offscreenValid
+	 || !m_offscreenBitmap.IsOk()
+	 ||  m_offscreenBitmap.GetWidth() != clientSize.x
+	 ||  m_offscreenBitmap.GetHeight() != clientSize.y )
+	{
+		m_offscreenBitmap.Create(clientSize.x, clientSize.y);
+		offscreenDc.SelectObject(m_offscreenBitmap);
+		RedrawAllOnscreen(offscreenDc);
+
+		m_drawnStates.Empty();
+		for( i = 0; i < iCount; i++ )
+		{
+			m_drawnStates.Add(GetButtonState(&(m_layout.m_keys[i])));
+		}
+
+		m_offscreenValid = true;
+		clientDc.Blit(0, 0, clientSize.x, clientSize.y, &offscreenDc, 0, 0);
+		return;
+	}
+
+	offscreenDc.SelectObject(m_offscreenBitmap);
 
-	// prepare offscreen drawing
-	wxBitmap            offscreenBitmap(clientSize.x, clientSize.y);
-	wxMemoryDC          offscreenDc;
-	offscreenDc.SelectObject(offscreenBitmap);
+	// redraw the changed keys, if possible from the tiles
+	for( i = 0; i < iCount; i++ )
+	{
+		SjVirtKeybdKey* button = &(m_layout.m_keys[i]);
+		if( button->IsSpacer() || button->IsNextLine() || button->IsEnterCont() )
+		{
+			continue;
+		}
+
+		wxString state = GetButtonState(button);
+		if( state == m_drawnStates[i] )
+		{
+			continue;
+		}
+		m_drawnStates[i] = state;
+
+		wxRect rect(button->m_rect);
+		if( button->IsEnter() && m_layout.m_enterCont )
+		{
+			// the enter key spans over two rows, we do not use tiles for it
+			RedrawButtonOnscreen(offscreenDc, button);
+			rect.Union(m_layout.m_enterCont->m_rect);
+		}
+		else
+		{
+			wxString tileKey = wxString::Format(wxT("%ix%i:"), rect.width, rect.height) + state;
+			wxBitmap* tile = (wxBitmap*)m_tiles.Lookup(tileKey);
+			if( tile )
+			{
+				offscreenDc.DrawBitmap(*tile, rect.x, rect.y, FALSE);
+			}
+			else
+			{
+				RedrawButtonOnscreen(offscreenDc, button);
+
+				tile = new wxBitmap(rect.width, rect.height);
+				wxMemoryDC tileDc;
+				tileDc.SelectObject(*tile);
+				tileDc.Blit(0, 0, rect.width, rect.height, &offscreenDc, rect.x, rect.y);
+				tileDc.SelectObject(wxNullBitmap);
+				m_tiles.Insert(tileKey, tile);
+			}
+		}
 
-	// draw offscreen
-	RedrawAllOnscreen(offscreenDc);
+		if( !blitAll )
+		{
+			clientDc.Blit(rect.x, rect.y, rect.width, rect.height, &offscreenDc, rect.x, rect.y);
+		}
+	}
 
-	// copy offscreen to screen
-	clientDc.Blit(0, 0, clientSize.x, clientSize.y, &offscreenDc, 0, 0);
+	if( blitAll )
+	{
+		clientDc.Blit(0, 0, clientSize.x, clientSize.y, &offscreenDc, 0, 0);
+	}
 }
 
 
@@ -1106,7 +1223,7 @@ void SjVirtKeybdFrame::OnPaint(wxPaintEvent&)
 {
 	wxPaintDC dc(this);
 
-	RedrawAllOnscreen(dc);
+	RedrawAllOffscreen(dc, TRUE/*blitAll*/);
 }
 
 
@@ -1169,7 +1286,7 @@ void SjVirtKeybdFrame::OnMouseDown(wxMouseEvent& event)
 		m_clicked = button;
 
 		wxClientDC dc(this);
-		RedrawButtonOnscreen(dc, button);
+		RedrawAllOffscreen(dc);
 	}
 }
 
@@ -1210,7 +1327,6 @@ void SjVirtKeybdFrame::OnMouseUp(wxMouseEvent& event)
 		}
 
 		// reset the alt/shift keys
-		bool redrawAll = false;
 		if( m_alt || m_shift )
 		{
 			if( !m_altLock )
@@ -1222,21 +1338,11 @@ void SjVirtKeybdFrame::OnMouseUp(wxMouseEvent& event)
 			{
 				m_shift = 0;
 			}
-
-			redrawAll = true;
 		}
 
-		// redraw
-		if( redrawAll )
-		{
-			wxClientDC dc(this);
-			RedrawAllOffscreen(dc);
-		}
-		else
-		{
-			wxClientDC dc(this);
-			RedrawButtonOnscreen(dc, clicked);
-		}
+		// redraw (only the changed keys are really redrawn)
+		wxClientDC dc(this);
+		RedrawAllOffscreen(dc);
 	}
 }
 
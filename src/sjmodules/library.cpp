@@ -108,6 +108,8 @@
 #include <sjmodules/arteditor.h>
 #include <sjmodules/tageditor/tageditor.h>
 #include <sjmodules/weblinks.h>
+#include <sjmodules/autovolanalyzer.h>
+#include <sjmodules/trackcache.h>
 
 
 #define DEFAULT_OMIT_ARTISTS    SjTools::LocaleConfigRead(wxT("__STOP_ARTISTS__"), wxT("the, der, die, die happy, das"))
@@ -417,6 +419,16 @@ SjLibraryModule::SjLibraryModule(SjInterfaceBase* interf)
 	m_searchOffsetsCount = -1; // no search
 	m_filterAzFirstHidden = FALSE;
 	m_hiliteRegExOk = false;
+	m_autoVolAnalyzer = NULL;
+	m_trackCache = NULL;
+	m_trackCacheLoader = NULL;
+	m_trackCacheDirty = false;
+	m_updateReader = NULL;
+	m_generation = 0;
+	m_navAz = NULL;
+	m_navAlbumCount = 0;
+	m_searchOffsetsInv = NULL;
+	m_searchOffsetsInvValid = false;
 
 	ForgetRememberedValues();
 }
@@ -452,6 +464,18 @@ void SjLibraryModule::SaveSettings()
 }
 
 
+extern "C"
+{
+	static void sqlite_tracks_changed(void* library, int op, char const* dbName, char const* tableName, sqlite3_int64 rowid)
+	{
+		if( strcmp(tableName, "tracks") == 0 )
+		{
+			((SjLibraryModule*)library)->OnTrackChanged((long)rowid);
+		}
+	}
+};
+
+
 bool SjLibraryModule::FirstLoad()
 {
 	bool needsRecombiningAlbums = FALSE;
@@ -555,18 +579,71 @@ bool SjLibraryModule::FirstLoad()
 		CombineTracksToAlbums();
 	}
 
+	// calculate the missing auto-volumes in background, give the startup some time
+	m_autoVolAnalyzer = new SjAutoVolAnalyzer();
+	m_autoVolAnalyzer->StartDelayed(60*1000);
+
+	// the track cache is loaded on the first use
+	m_trackCache = new SjTrackCache();
+
+	// count the changes of the tracks table, see GetGeneration(), and patch
+	// the track cache; the hook is not called for "DELETE FROM tracks;" but
+	// then, the remembered values are forgotten and the cache is reloaded
+	sqlite3_update_hook(wxSqltDb::GetDefault()->GetDb(), sqlite_tracks_changed, this);
+
 	return TRUE;
 }
 
 
 void SjLibraryModule::LastUnload()
 {
+	if( m_autoVolAnalyzer )
+	{
+		delete m_autoVolAnalyzer; // waits for the workers
+		m_autoVolAnalyzer = NULL;
+	}
+
+	if( m_trackCacheLoader )
+	{
+		m_trackCacheLoader->Wait();
+		delete m_trackCacheLoader;
+		m_trackCacheLoader = NULL;
+	}
+
+	if( m_trackCache )
+	{
+		delete m_trackCache;
+		m_trackCache = NULL;
+	}
+	m_trackCachePending.Clear();
+
+	if( wxSqltDb::GetDefault() )
+	{
+		sqlite3_update_hook(wxSqltDb::GetDefault()->GetDb(), NULL, NULL);
+	}
+
 	if( m_searchOffsets )
 	{
 		free(m_searchOffsets);
 		m_searchOffsets = NULL;
 	}
 
+	if( m_searchOffsetsInv )
+	{
+		free(m_searchOffsetsInv);
+		m_searchOffsetsInv = NULL;
+	}
+	m_searchOffsetsInvValid = false;
+
+	if( m_navAz )
+	{
+		free(m_navAz);
+		m_navAz = NULL;
+	}
+	m_navAlbumUrls.Clear();
+	m_navAlbumIds.Clear();
+	ForgetRememberedValues();
+
 	SavePendingData();
 }
 
@@ -672,7 +749,7 @@ bool SjLibraryModule::Callback_MarkAsUpdated(const wxString& urlBegin, long chec
 {
 	if( !m_deepUpdate && checkTrackCount > 0 )
 	{
-		wxSqlt sql;
+		wxSqlt sql(m_updateReader);
 
 		sql.Query(wxT("SELECT COUNT(*) FROM tracks WHERE url LIKE '") + sql.QParam(urlBegin) + wxT("%'"));
 		if( sql.GetLong(0) == checkTrackCount )
@@ -690,11 +767,67 @@ bool SjLibraryModule::Callback_MarkAsUpdated(const wxString& urlBegin, long chec
 }
 
 
+long SjLibraryModule::Callback_MarkAsUpdatedExcept(const wxString& urlBegin, const wxArrayString& exceptUrlBegins, const wxArrayString& exceptDirs)
+{
+	if( m_deepUpdate )
+	{
+		return -1;
+	}
+
+	SjSLHash dirs;
+	size_t d, dCount = exceptDirs.GetCount();
+	for( d = 0; d < dCount; d++ )
+	{
+		dirs.Insert(exceptDirs[d], 1);
+	}
+
+	// the exceptions may be too many for a single SQL statement, so we check
+	// them here: as they are sorted and not nested, only the largest
+	// exception less than or equal to the URL may be a prefix of it
+	wxSqlt  sql(m_updateReader);
+	long    markedCount = 0;
+	int     exceptCount = (int)exceptUrlBegins.GetCount();
+	sql.Query(wxT("SELECT id, url FROM tracks WHERE url LIKE '") + sql.QParam(urlBegin) + wxT("%'"));
+	while( sql.Next() )
+	{
+		wxString url = sql.GetString(1);
+
+		int lo = 0, hi = exceptCount;
+		while( lo < hi )
+		{
+			int mid = (lo+hi) / 2;
+			if( exceptUrlBegins[mid].Cmp(url) <= 0 ) { lo = mid+1; } else { hi = mid; }
+		}
+
+		if( lo > 0 && url.StartsWith(exceptUrlBegins[lo-1]) )
+		{
+			continue;
+		}
+
+		if( dCount )
+		{
+			// the directory of the track or of the archive containing the track
+			wxString dir = url.BeforeFirst('#');
+			dir = dir.Left(dir.Find('/', true/*from end*/)+1);
+			if( dirs.Lookup(dir) )
+			{
+				continue;
+			}
+		}
+
+		m_updatedTracks.Add(sql.GetLong(0));
+		markedCount++;
+	}
+
+	return markedCount;
+}
+
+
 bool SjLibraryModule::Callback_CheckTrackInfo(const wxString& url, uint32_t actualCrc)
 {
 	if( !m_deepUpdate )
 	{
-		wxSqlt sql;
+		wxSqlt sql(m_updateReader);
 
 		sql.Query(wxT("SELECT id, updatecrc FROM tracks WHERE url='") + sql.QParam(url) + wxT("'"));
 		if( sql.Next() )
@@ -799,6 +932,21 @@ bool SjLibraryModule::Callback_ReceiveTrackInfo(SjTrackInfo* trackInfo)
 
 
 bool SjLibraryModule::UpdateAllCol(wxWindow* parent, bool deepUpdate)
+{
+	// the scanners check the tracks against the state before the update;
+	// these reads need not to see the changes of the update, so they're done
+	// by a reader connection opened before the transaction starts
+	wxSqltReader reader(NULL, TRUE);
+	m_updateReader = reader.GetDb();
+
+	bool ret = UpdateAllCol__(parent, deepUpdate);
+
+	m_updateReader = NULL;
+	return ret;
+}
+
+
+bool SjLibraryModule::UpdateAllCol__(wxWindow* parent, bool deepUpdate)
 {
 	wxSqlt               sql;
 	wxSqltTransaction    transaction;
@@ -813,7 +961,7 @@ bool SjLibraryModule::UpdateAllCol(wxWindow* parent, bool deepUpdate)
 	// go through all music library scanner modules
 	// and receive the track information by SjLibraryModule::ReceiveTrackInfo()
 	{
-		SjModuleList* moduleList = g_mainFrame->m_moduleSystem.GetModules(SJ_MODULETYPE_SCANNER);
+		SjModuleList* moduleList = m_interface->m_moduleSystem->GetModules(SJ_MODULETYPE_SCANNER);
 		wxASSERT(moduleList);
 		SjModuleList::Node* moduleNode = moduleList->GetFirst();
 		while( moduleNode )
@@ -853,6 +1001,7 @@ bool SjLibraryModule::UpdateAllCol(wxWindow* parent, bool deepUpdate)
 			{
 				return FALSE;
 			}
+			m_trackCacheDirty = true; // not seen by the update hook
 
 			transaction.Vacuum(); // GetChangedRows() won't work as DELETE FROM without WHERE recreates the table in sqlite
 		}
@@ -871,6 +1020,12 @@ bool SjLibraryModule::UpdateAllCol(wxWindow* parent, bool deepUpdate)
 	// success
 	transaction.Commit();
 	ForgetRememberedValues();
+
+	if( m_autoVolAnalyzer )
+	{
+		m_autoVolAnalyzer->StartDelayed(5*1000);
+	}
+
 	return TRUE;
 }
 
@@ -1223,21 +1378,26 @@ bool SjLibraryModule::CombineTracksToAlbums()
 
 	SjBusyInfo::Set(_("Combining tracks to albums..."), TRUE);
 
-	// read all tracks
-	if( (m_flags&SJ_LIB_CREATEALBUMSBY_DIR) )
+	// read all tracks; within an update, the tracks are not yet committed
+	// and are read from the database, see wxSqltReader
 	{
-		sql.Query(wxT("SELECT id, leadartistname, albumname, genrename, year, albumid, url FROM tracks;"));
-		while( sql.Next() )
+		wxSqltReader reader(NULL, TRUE);
+		wxSqlt readerSql(reader.GetDb());
+		if( (m_flags&SJ_LIB_CREATEALBUMSBY_DIR) )
 		{
-			allTracks.Insert(sql.GetLong(0), (long)new SjUpdateAlbumTrack(sql.GetString(1), sql.GetString(2), sql.GetString(3), sql.GetLong(4), sql.GetLong(5), sql.GetString(6)));
+			readerSql.Query(wxT("SELECT id, leadartistname, albumname, genrename, year, albumid, url FROM tracks;"));
+			while( readerSql.Next() )
+			{
+				allTracks.Insert(readerSql.GetLong(0), (long)new SjUpdateAlbumTrack(readerSql.GetString(1), readerSql.GetString(2), readerSql.GetString(3), readerSql.GetLong(4), readerSql.GetLong(5), readerSql.GetString(6)));
+			}
 		}
-	}
-	else
-	{
-		sql.Query(wxT("SELECT id, leadartistname, albumname, genrename, year, albumid FROM tracks;"));
-		while( sql.Next() )
+		else
 		{
-			allTracks.Insert(sql.GetLong(0), (long)new SjUpdateAlbumTrack(sql.GetString(1), sql.GetString(2), sql.GetString(3), sql.GetLong(4), sql.GetLong(5), wxT("")));
+			readerSql.Query(wxT("SELECT id, leadartistname, albumname, genrename, year, albumid FROM tracks;"));
+			while( readerSql.Next() )
+			{
+				allTracks.Insert(readerSql.GetLong(0), (long)new SjUpdateAlbumTrack(readerSql.GetString(1), readerSql.GetString(2), readerSql.GetString(3), readerSql.GetLong(4), readerSql.GetLong(5), wxT("")));
+			}
 		}
 	}
 
@@ -1688,6 +1848,7 @@ Cleanup:
 	}
 
 	m_searchOffsetsCount = -1; // no search
+	m_searchOffsetsInvValid = false;
 	m_searchTracksHash.Clear();
 	m_selectedTrackIds.Clear();
 	UpdateMenuBar();
@@ -2184,6 +2345,7 @@ SjSearchStat SjLibraryModule::SetSearch(const SjSearch& search, bool deepSearch)
 		retStat = search.m_adv.GetAsSql(&m_filterHash, m_filterCond);
 	}
 	m_search = search;
+	m_searchOffsetsInvValid = false;
 
 	// cancel search?
 	if( !search.IsSet() )
@@ -2288,9 +2450,15 @@ SjSearchStat SjLibraryModule::SetSearch(const SjSearch& search, bool deepSearch)
 	query += wxT(" AND albums.id=albumid ") // <-- should be the last condition as this won't eliminate any row itself
 	         wxT("ORDER BY albumindex;");
 
-	// query database
+	// query database; if possible, this is done by a reader connection
+	// which needs its own infilter() function
 	{
-		wxSqlt  sql;
+		wxSqltReader reader(NULL, TRUE);
+		wxSqlt  sql(reader.GetDb());
+		if( !reader.UsesDb() && search.m_adv.IsSet() )
+		{
+			sqlite3_create_function(reader.GetDb()->GetDb(), "infilter", 1, SQLITE_ANY, NULL, sqlite_infilter, NULL, NULL);
+		}
 		#if 0//def __WXDEBUG__
 				wxString queryDebug__(query);
 				queryDebug__.Replace(wxT("%"), wxT("%%"));
@@ -2338,6 +2506,13 @@ SjSearchStat SjLibraryModule::SetSearch(const SjSearch& search, bool deepSearch)
 
 			m_searchTracksHash.Insert(sql.GetLong(0), 1);
 		}
+
+		if( !reader.UsesDb() && search.m_adv.IsSet() )
+		{
+			// the reader may be used by other threads afterwards
+			sql.CloseQuery();
+			sqlite3_create_function(reader.GetDb()->GetDb(), "infilter", 1, SQLITE_ANY, NULL, NULL, NULL, NULL);
+		}
 	}
 
 	// check, if the selected tracks are still in search
@@ -2571,12 +2746,123 @@ long SjLibraryModule::GetUnmaskedTrackCount()
 }
 
 
+SjTrackCache* SjLibraryModule::GetTrackCache()
+{
+	if( m_trackCache == NULL )
+	{
+		return NULL;
+	}
+
+	// take over a cache loaded in background
+	if( m_trackCacheLoader )
+	{
+		if( !m_trackCacheLoader->IsDone() )
+		{
+			return NULL; // use the database meanwhile
+		}
+
+		m_trackCacheLoader->Wait();
+		delete m_trackCache;
+		m_trackCache = m_trackCacheLoader->TakeCache();
+		delete m_trackCacheLoader;
+		m_trackCacheLoader = NULL;
+	}
+
+	if( m_trackCacheDirty )
+	{
+		m_trackCache->Invalidate();
+		m_trackCacheDirty = false;
+	}
+
+	if( !m_trackCache->IsLoaded() )
+	{
+		if( m_trackCache->IsTooLarge() )
+		{
+			return NULL;
+		}
+		else if( wxSqltDb::GetDefault()->IsWal() )
+		{
+			// changes made from now on are patched after loading
+			m_trackCachePending.Clear();
+			m_trackCacheLoader = new SjTrackCacheLoader();
+			return NULL;
+		}
+		else
+		{
+			// without write-ahead logging, there are no readers for other
+			// threads; load the cache here, but not from a pending transaction
+			if( wxSqltDb::GetDefault()->InTransaction() )
+			{
+				return NULL;
+			}
+			m_trackCachePending.Clear();
+			if( !m_trackCache->Load() )
+			{
+				return NULL;
+			}
+		}
+	}
+
+	if( wxSqltDb::GetDefault()->InTransaction() )
+	{
+		return NULL; // the pending changes may be rolled back, use the database
+	}
+
+	if( m_trackCachePending.GetCount() )
+	{
+		m_trackCache->Patch(m_trackCachePending);
+		m_trackCachePending.Clear();
+		if( !m_trackCache->IsLoaded() )
+		{
+			return NULL; // grown too large, reloaded on next use
+		}
+	}
+
+	return m_trackCache;
+}
+
+
+void SjLibraryModule::OnTrackChanged(long trackId)
+{
+	m_generation++;
+
+	if( m_trackCache && !m_trackCacheDirty )
+	{
+		if( m_trackCachePending.GetCount() < SJ_TRACKCACHE_MAX_PENDING )
+		{
+			m_trackCachePending.Insert(trackId, 1);
+		}
+		else
+		{
+			m_trackCachePending.Clear();
+			m_trackCacheDirty = true;
+		}
+	}
+}
+
+
 bool SjLibraryModule::GetTrackInfo(const wxString& url, SjTrackInfo& trackInfo, long flags, bool logErrors)
 {
 	bool    ret = true;
 	wxSqlt  sql;
 
-	if( flags & SJ_TI_QUICKINFO )
+	SjTrackCache* cache = GetTrackCache();
+	if( (flags & SJ_TI_QUICKINFO) && cache )
+	{
+		long row = cache->GetRowByUrl(url);
+		if( row >= 0 )
+		{
+			trackInfo.m_trackName = cache->GetTrackName(row);
+			trackInfo.m_leadArtistName = cache->GetLeadArtistName(row);
+			trackInfo.m_playtimeMs = cache->GetPlaytimeMs(row);
+			trackInfo.m_albumName = cache->GetAlbumName(row);
+		}
+		else
+		{
+			ret = false;
+		}
+	}
+	else if( flags & SJ_TI_QUICKINFO )
 	{
 		sql.Query(wxT("SELECT trackName, leadArtistName, playtimeMs, albumName FROM tracks WHERE url='") + sql.QParam(url) + wxT("';"));
 		if( sql.Next() )
@@ -2643,9 +2929,18 @@ bool SjLibraryModule::GetTrackInfo(const wxString& url, SjTrackInfo& trackInfo,
 	{
 		// find out the album ID
 		long albumId = 0;
-		sql.Query(wxT("SELECT albumid FROM tracks WHERE url='") + sql.QParam(url) + wxT("';"));
-		if( sql.Next() )
-			albumId = sql.GetLong(0);
+		if( cache )
+		{
+			long row = cache->GetRowByUrl(url);
+			if( row >= 0 )
+				albumId = cache->GetAlbumId(row);
+		}
+		else
+		{
+			sql.Query(wxT("SELECT albumid FROM tracks WHERE url='") + sql.QParam(url) + wxT("';"));
+			if( sql.Next() )
+				albumId = sql.GetLong(0);
+		}
 
 		if( flags & SJ_TI_TRACKCOVERURL )
 		{
@@ -2845,43 +3140,133 @@ void SjLibraryModule::DoAutoComplete(long what, int& oldTypedLen, wxWindow* wind
 }
 
 
+void SjLibraryModule::BuildNavIndex()
+{
+	wxSqlt      sql;
+	long        albumIndex, azFirst, i;
+
+	m_navAlbumUrls.Clear();
+	m_navAlbumIds.Clear();
+	for( i = 0; i < 27; i++ )
+	{
+		m_navAzFirst[i] = -1;
+	}
+
+	sql.Query(wxT("SELECT COUNT(*) FROM albums;"));
+	m_navAlbumCount = sql.Next()? sql.GetLong(0) : 0;
+	m_navAz = (unsigned char*)realloc(m_navAz, m_navAlbumCount+1);
+	memset(m_navAz, 0, m_navAlbumCount+1);
+
+	// albums
+	sql.Query(wxT("SELECT id, albumindex, az, azfirst, url FROM albums;"));
+	while( sql.Next() )
+	{
+		albumIndex = sql.GetLong(1);
+		if( albumIndex < 0 || albumIndex >= m_navAlbumCount )
+		{
+			continue; // proofe anyway for corrupted databases
+		}
+
+		m_navAz[albumIndex] = (unsigned char)sql.GetLong(2);
+
+		azFirst = sql.GetLong(3);
+		if( azFirst >= 'a' && azFirst <= ('z'+1) )
+		{
+			m_navAzFirst[azFirst-'a'] = albumIndex;
+		}
+
+		m_navAlbumIds.Insert(sql.GetLong(0), albumIndex+1);
+		m_navAlbumUrls.Insert(sql.GetString(4), albumIndex+1);
+	}
+
+	m_navIndexBuilt = true;
+}
+
+
+long SjLibraryModule::AlbumIndex2MaskedIndex(long albumIndex)
+{
+	if( !HasSearch() )
+	{
+		return albumIndex;
+	}
+
+	if( m_searchOffsets == NULL || albumIndex < 0 || albumIndex >= m_searchOffsetsMax )
+	{
+		return -1;
+	}
+
+	if( !m_searchOffsetsInvValid )
+	{
+		long i;
+		m_searchOffsetsInv = (long*)realloc(m_searchOffsetsInv, sizeof(long)*m_searchOffsetsMax);
+		for( i = 0; i < m_searchOffsetsMax; i++ )
+		{
+			m_searchOffsetsInv[i] = -1;
+		}
+
+		for( i = 0; i < m_searchOffsetsCount; i++ )
+		{
+			if( m_searchOffsets[i] >= 0 && m_searchOffsets[i] < m_searchOffsetsMax )
+			{
+				m_searchOffsetsInv[m_searchOffsets[i]] = i;
+			}
+		}
+
+		m_searchOffsetsInvValid = true;
+	}
+
+	return m_searchOffsetsInv[albumIndex];
+}
+
+
 long SjLibraryModule::GetMaskedColIndexByAz(int targetId)
 {
 	char az = 'a' + (targetId-IDT_WORKSPACE_GOTO_A);
-	wxSqlt sql;
 
 	if( !m_search.m_simple.IsSet() )
 	{
+		if( !m_navIndexBuilt )
+		{
+			BuildNavIndex();
+		}
+
 		while( az >= 'a' )
 		{
-			sql.Query(wxString::Format(wxT("SELECT albumindex FROM albums WHERE azfirst=%i;"), (int)az));
-			if( sql.Next() )
+			long orgIndex = m_navAzFirst[az-'a'];
+			if( orgIndex >= 0 )
 			{
-				long orgIndex = sql.GetLong(0);
-
 				if( m_search.m_adv.IsSet() )
 				{
-					// search correct index in adv. search
-					long i;
-					for( i = m_searchOffsetsCount-1; i >= 0; i-- )
+					// search correct index in adv. search; as there is no simple search,
+					// the offsets are sorted by the album index and we can use a binary search
+					long lo = 0, hi = m_searchOffsetsCount-1, mid, i = -1;
+					while( lo <= hi )
 					{
-						if( m_searchOffsets[i] <= orgIndex )
+						mid = (lo + hi) / 2;
+						if( m_searchOffsets[mid] <= orgIndex )
 						{
-							// here is our offset -- but there may be a better one when looking forward
-							sql.Query(wxString::Format(wxT("SELECT az FROM albums WHERE albumindex=%i;"), (int)m_searchOffsets[i]));
-							if( sql.Next() && sql.GetLong(0) != az )
-							{
-								sql.Query(wxString::Format(wxT("SELECT az FROM albums WHERE albumindex=%i;"), (int)m_searchOffsets[i+1]));
-								if( sql.Next() && sql.GetLong(0) == az )
-								{
-									return i+1;
-								}
-							}
-							return i;
+							i = mid; // here is our offset -- but there may be a better one when looking forward
+							lo = mid + 1;
 						}
+						else
+						{
+							hi = mid - 1;
+						}
+					}
+
+					if( i < 0 )
+					{
+						return 0; // first column
 					}
 
-					return 0; // first column
+					if( GetNavAz(m_searchOffsets[i]) != az
+					 && i+1 < m_searchOffsetsCount
+					 && GetNavAz(m_searchOffsets[i+1]) == az )
+					{
+						return i+1;
+					}
+
+					return i;
 				}
 				else
 				{
@@ -2899,29 +3284,15 @@ long SjLibraryModule::GetMaskedColIndexByAz(int targetId)
 
 long SjLibraryModule::GetMaskedColIndexByColUrl(const wxString& colUrl)
 {
-	long   index = -1, i;
-	wxSqlt sql;
-
-	sql.Query(wxT("SELECT albumindex FROM albums WHERE url='") + sql.QParam(colUrl) + wxT("';"));
-	if( sql.Next() )
+	if( !m_navIndexBuilt )
 	{
-		index = sql.GetLong(0);
-		if( HasSearch() )
-		{
-			for( i = 0; i < m_searchOffsetsCount; i++ )
-			{
-				if( m_searchOffsets[i] == index )
-				{
-					index = i;
-					break;
-				}
-			}
+		BuildNavIndex();
+	}
 
-			if( i >= m_searchOffsetsCount )
-			{
-				index = -1; // column does not exist in the current search
-			}
-		}
+	long index = m_navAlbumUrls.Lookup(colUrl) - 1;
+	if( index >= 0 )
+	{
+		index = AlbumIndex2MaskedIndex(index); // -1 if the column does not exist in the current search
 	}
 
 	return index;
@@ -2930,6 +3301,13 @@ long SjLibraryModule::GetMaskedColIndexByColUrl(const wxString& colUrl)
 
 wxString SjLibraryModule::GetUrl(long id)
 {
+	SjTrackCache* cache = GetTrackCache();
+	if( cache )
+	{
+		long row = cache->GetRowById(id);
+		return row >= 0? cache->GetUrl(row) : wxString();
+	}
+
 	wxSqlt sql;
 	sql.Query(wxString::Format(wxT("SELECT url FROM tracks WHERE id=%i;"), (int)id));
 	if( sql.Next() )
@@ -3311,28 +3689,67 @@ SjCol* SjLibraryModule::GetCol__(long dbAlbumIndex, long virtualAlbumIndex, bool
 	long        diskNr, albumDiskNr = 0, albumDiskCount = 0;
 	SjRow*      diskNrRow = NULL;
 
-	sql.Query(wxString::Format(wxT("SELECT id, albumname, trackname, leadartistname, orgartistname, composername, ")
-	                           wxT("year, tracknr, playtimems, url, disknr, comment, genrename, rating FROM tracks WHERE albumid=%lu ORDER BY disknr, tracknr, trackname, id;"), albumId));
-	while( sql.Next() )
+	// the tracks are taken from the track cache if possible; the comments
+	// are not cached (they may also be shown if a search hilites the artist)
+	SjTrackCache* cache = GetTrackCache();
+	wxArrayLong cacheRows;
+	long        cacheIndex = 0;
+	if( m_flags&SJ_LIB_SHOWCOMMENT )
+	{
+		cache = NULL;
+	}
+
+	if( cache )
+	{
+		cache->GetRowsByAlbum(albumId, cacheRows);
+	}
+	else
+	{
+		sql.Query(wxString::Format(wxT("SELECT id, albumname, trackname, leadartistname, orgartistname, composername, ")
+		                           wxT("year, tracknr, playtimems, url, disknr, comment, genrename, rating FROM tracks WHERE albumid=%lu ORDER BY disknr, tracknr, trackname, id;"), albumId));
+	}
+
+	while( cache? cacheIndex < (long)cacheRows.GetCount() : sql.Next() )
 	{
 		showDiffLeadArtistName
 		    = (m_flags&SJ_LIB_SHOWDIFFLEADARTISTNAME)!=0;
 		showDiffAlbumName   = (m_flags&SJ_LIB_SHOWDIFFALBUMNAME)!=0;
 
-		trackId             = sql.GetLong(0);
-		trackAlbumName      = sql.GetString(1);
-		trackName           = sql.GetString(2);
-		trackLeadArtistName = sql.GetString(3);
-		trackOrgArtistName  = sql.GetString(4);
-		trackComposerName   = sql.GetString(5);
-		trackYear           = sql.GetLong(6);
-		trackNr             = sql.GetLong(7);
-		trackPlaytimeMs     = sql.GetLong(8);
-		trackUrl            = sql.GetString(9);
-		diskNr              = sql.GetLong(10);
-		trackComment        = sql.GetString(11);
-		trackGenre          = sql.GetString(12);
-		trackRating         = sql.GetLong(13);
+		if( cache )
+		{
+			long row = cacheRows[cacheIndex++];
+			trackId             = cache->GetId(row);
+			trackAlbumName      = cache->GetAlbumName(row);
+			trackName           = cache->GetTrackName(row);
+			trackLeadArtistName = cache->GetLeadArtistName(row);
+			trackOrgArtistName  = cache->GetOrgArtistName(row);
+			trackComposerName   = cache->GetComposerName(row);
+			trackYear           = cache->GetYear(row);
+			trackNr             = cache->GetTrackNr(row);
+			trackPlaytimeMs     = cache->GetPlaytimeMs(row);
+			trackUrl            = cache->GetUrl(row);
+			diskNr              = cache->GetDiskNr(row);
+			trackComment.Empty();
+			trackGenre          = cache->GetGenreName(row);
+			trackRating         = cache->GetRating(row);
+		}
+		else
+		{
+			trackId             = sql.GetLong(0);
+			trackAlbumName      = sql.GetString(1);
+			trackName           = sql.GetString(2);
+			trackLeadArtistName = sql.GetString(3);
+			trackOrgArtistName  = sql.GetString(4);
+			trackComposerName   = sql.GetString(5);
+			trackYear           = sql.GetLong(6);
+			trackNr             = sql.GetLong(7);
+			trackPlaytimeMs     = sql.GetLong(8);
+			trackUrl            = sql.GetString(9);
+			diskNr              = sql.GetLong(10);
+			trackComment        = sql.GetString(11);
+			trackGenre          = sql.GetString(12);
+			trackRating         = sql.GetLong(13);
+		}
 
 		// Avoid double tracks.
 		// The comparison implies the same artis- and albumname
@@ -3567,34 +3984,41 @@ SjCol* SjLibraryModule::GetCol__(long dbAlbumIndex, long virtualAlbumIndex, bool
 
 SjCol* SjLibraryModule::GetMaskedCol(const wxString& trackUrl, long& retIndex /*-1 if currently hidden eg. by search*/)
 {
-	wxSqlt sql;
-	sql.Query(wxT("SELECT albumid FROM tracks WHERE url='") + sql.QParam(trackUrl) + wxT("';"));
-	if( sql.Next() )
+	if( !m_navIndexBuilt )
 	{
-		long albumId = sql.GetLong(0);
-		sql.Query(wxString::Format(wxT("SELECT albumindex FROM albums WHERE id=%lu;"), albumId));
+		BuildNavIndex();
+	}
+
+	// the track -> album mapping is taken from the track cache, which is
+	// kept up to date on changes; only if there is no cache, the database is asked
+	long albumIndex = 0;
+	SjTrackCache* cache = GetTrackCache();
+	if( cache )
+	{
+		long row = cache->GetRowByUrl(trackUrl);
+		if( row >= 0 )
+		{
+			albumIndex = m_navAlbumIds.Lookup(cache->GetAlbumId(row));
+		}
+	}
+	else
+	{
+		wxSqlt sql;
+		sql.Query(wxT("SELECT albumid FROM tracks WHERE url='") + sql.QParam(trackUrl) + wxT("';"));
 		if( sql.Next() )
 		{
-			retIndex = sql.GetLong(0);
-			SjCol* ret = GetCol__(retIndex, retIndex, TRUE/*regardSearch*/);
-			if( ret )
-			{
-				if( HasSearch() )
-				{
-					int i; bool indexFound = FALSE;
-					for( i = 0; i < m_searchOffsetsCount; i++ )
-					{
-						if( m_searchOffsets[i] == retIndex )
-						{
-							retIndex = i;
-							indexFound = TRUE;
-							break;
-						}
-					}
-					if( !indexFound ) retIndex = -1;
-				}
-				return ret;
-			}
+			albumIndex = m_navAlbumIds.Lookup(sql.GetLong(0));
+		}
+	}
+
+	if( albumIndex > 0 )
+	{
+		retIndex = albumIndex-1;
+		SjCol* ret = GetCol__(retIndex, retIndex, TRUE/*regardSearch*/);
+		if( ret )
+		{
+			retIndex = AlbumIndex2MaskedIndex(retIndex);
+			return ret;
 		}
 	}
 
@@ -3965,12 +4389,26 @@ void SjLibraryModule::CreateRatingMenu(SjMenu& m, int baseId, const wxArrayStrin
 	wxSqlt sql;
 
 	long i, trackCount = urls.GetCount(), rating = 0, ratingCount = 0;
+	SjTrackCache* cache = GetTrackCache();
 	for( i = 0; i < trackCount; i++ )
 	{
-		sql.Query(wxT("SELECT rating FROM tracks WHERE url='") + sql.QParam(urls[i]) + wxT("';"));
-		if( sql.Next() )
+		long currRating = -1;
+		if( cache )
+		{
+			long row = cache->GetRowByUrl(urls[i]);
+			if( row >= 0 )
+				currRating = cache->GetRating(row);
+		}
+		else
 		{
-			long currRating = sql.GetLong(0); if(rating<0)rating=0; if(rating>5)rating=5;
+			sql.Query(wxT("SELECT rating FROM tracks WHERE url='") + sql.QParam(urls[i]) + wxT("';"));
+			if( sql.Next() )
+				currRating = sql.GetLong(0);
+		}
+
+		if( currRating >= 0 )
+		{
+			if(rating<0)rating=0; if(rating>5)rating=5;
 			if( currRating )
 			{
 				rating += currRating;
@@ -4351,35 +4789,72 @@ double SjLibraryModule::GetAutoVol(const wxString& url, bool useAlbumGainIfPossi
 }
 
 
+void SjLibraryModule::SetAnalyzedAutoVol(const wxArrayString& urls, const wxArrayLong& gainLongs)
+{
+	// the analyzed gain is only used if the track was not played in the meantime,
+	// otherwise PlaybackDone() has already written a gain
+	wxSqltTransaction transaction;
+	wxSqlt sql;
+
+	size_t i, iCount = urls.GetCount();
+	for( i = 0; i < iCount; i++ )
+	{
+		double gain = ::SjLong2Gain(gainLongs[i]);
+		if( gain >= VALID_GAIN_MIN && gain <= VALID_GAIN_MAX )
+		{
+			sql.Query(wxString::Format(wxT("UPDATE tracks SET autovol=%i WHERE autovol=0 AND url='"), (int)gainLongs[i])
+			          + sql.QParam(urls[i]) + wxT("';"));
+		}
+	}
+
+	transaction.Commit();
+}
+
+
 bool SjLibraryModule::AreTracksSubsequent(const wxString& url1, const wxString& url2)
 {
 	wxSqlt sql;
 
-	sql.Query(wxT("SELECT albumid FROM tracks WHERE url='") + sql.QParam(url1) + wxT("' OR url='") + sql.QParam(url2) + wxT("';"));
-	if( sql.Next() )
+	long albumId1 = -1, albumId2 = -2;
+	SjTrackCache* cache = GetTrackCache();
+	if( cache )
 	{
-		long albumId1 = sql.GetLong(0);
+		long row1 = cache->GetRowByUrl(url1), row2 = cache->GetRowByUrl(url2);
+		if( row1 >= 0 && row2 >= 0 )
+		{
+			albumId1 = cache->GetAlbumId(row1);
+			albumId2 = cache->GetAlbumId(row2);
+		}
+	}
+	else
+	{
+		sql.Query(wxT("SELECT albumid FROM tracks WHERE url='") + sql.QParam(url1) + wxT("' OR url='") + sql.QParam(url2) + wxT("';"));
 		if( sql.Next() )
 		{
-			long albumId2 = sql.GetLong(0);
-			if( albumId1 == albumId2 )
+			albumId1 = sql.GetLong(0);
+			if( sql.Next() )
+			{
+				albumId2 = sql.GetLong(0);
+			}
+		}
+	}
+
+	if( albumId1 == albumId2 )
+	{
+		sql.Query(wxString::Format(wxT("SELECT url FROM tracks WHERE albumid=%lu ORDER BY disknr, tracknr, trackname, id;"), albumId1));
+		while( sql.Next() )
+		{
+			if( sql.GetString(0) == url1 )
 			{
-				sql.Query(wxString::Format(wxT("SELECT url FROM tracks WHERE albumid=%lu ORDER BY disknr, tracknr, trackname, id;"), albumId1));
-				while( sql.Next() )
+				if( sql.Next() )
 				{
-					if( sql.GetString(0) == url1 )
+					if( sql.GetString(0) == url2 )
 					{
-						if( sql.Next() )
-						{
-							if( sql.GetString(0) == url2 )
-							{
-								return TRUE;
-							}
-						}
-
-						break;
+						return TRUE;
 					}
 				}
+
+				break;
 			}
 		}
 	}
@@ -4398,24 +4873,40 @@ wxArrayString SjLibraryModule::GetMoreFrom(const wxString& url, int targetId, Sj
 	wxArrayString ret;
 
 	wxSqlt sql;
+	SjTrackCache* cache = GetTrackCache();
+	long row = cache? cache->GetRowByUrl(url) : -1;
 	if( targetId == IDT_MORE_FROM_CURR_ALBUM )
 	{
-		sql.Query(wxT("SELECT albumid FROM tracks WHERE url='") + sql.QParam(url) + wxT("';"));
-		if( sql.Next() )
+		if( row >= 0 )
 		{
-			long albumId = sql.GetLong(0);
-			sql.Query(wxString::Format(wxT("SELECT url FROM tracks WHERE albumid=%lu;"), albumId));
-			// we go through the query below
+			sql.Query(wxString::Format(wxT("SELECT url FROM tracks WHERE albumid=%lu;"), cache->GetAlbumId(row)));
+		}
+		else if( cache == NULL )
+		{
+			sql.Query(wxT("SELECT albumid FROM tracks WHERE url='") + sql.QParam(url) + wxT("';"));
+			if( sql.Next() )
+			{
+				long albumId = sql.GetLong(0);
+				sql.Query(wxString::Format(wxT("SELECT url FROM tracks WHERE albumid=%lu;"), albumId));
+				// we go through the query below
+			}
 		}
 	}
 	else if( targetId == IDT_MORE_FROM_CURR_ARTIST )
 	{
-		sql.Query(wxT("SELECT leadartistname FROM tracks WHERE url='") + sql.QParam(url) + wxT("';"));
-		if( sql.Next() )
+		if( row >= 0 )
 		{
-			wxString leadArtistName = sql.GetString(0);
-			sql.Query(wxT("SELECT url FROM tracks WHERE leadartistname='") + sql.QParam(leadArtistName) + wxT("';"));
-			// we go through the query below
+			sql.Query(wxT("SELECT url FROM tracks WHERE leadartistname='") + sql.QParam(cache->GetLeadArtistName(row)) + wxT("';"));
+		}
+		else if( cache == NULL )
+		{
+			sql.Query(wxT("SELECT leadartistname FROM tracks WHERE url='") + sql.QParam(url) + wxT("';"));
+			if( sql.Next() )
+			{
+				wxString leadArtistName = sql.GetString(0);
+				sql.Query(wxT("SELECT url FROM tracks WHERE leadartistname='") + sql.QParam(leadArtistName) + wxT("';"));
+				// we go through the query below
+			}
 		}
 	}
 
@@ -5048,6 +5539,7 @@ public:
 	void            ChangeOrder         (long orderField, bool orderDesc);
 	long            GetTrackCount       () { return m_idsCount; }
 	void            GetTrack            (long offset, SjTrackInfo&, long& albumId, long& special);
+	void            GetTrackUrl         (long offset, wxString& url, long& albumId);
 	long            GetTrackSpecial     (long offset);
 	bool            IsTrackSelected     (long offset) { return m_module->m_selectedTrackIds.Lookup(m_ids[offset].id)!=0; }
 	void            SelectTrack         (long offset, bool select) { m_module->m_selectedTrackIds.InsertOrRemove(m_ids[offset].id, select? 1L : 0L); }
@@ -5333,6 +5825,30 @@ void SjLibraryListView::GetTrack(long offset, SjTrackInfo& trackInfo, long& retA
 }
 
 
+void SjLibraryListView::GetTrackUrl(long offset, wxString& retUrl, long& retAlbumId)
+{
+	SjTrackCache* cache = m_module->GetTrackCache();
+	long row = cache? cache->GetRowById(m_ids[offset].id) : -1;
+	if( row >= 0 )
+	{
+		retUrl      = cache->GetUrl(row);
+		retAlbumId  = cache->GetAlbumId(row);
+		return;
+	}
+
+	retUrl.Empty();
+	retAlbumId = 0;
+
+	wxSqlt sql;
+	sql.Query(wxString::Format(wxT("SELECT url, albumid FROM tracks WHERE id=%lu;"), m_ids[offset].id));
+	if( sql.Next() )
+	{
+		retUrl      = sql.GetString(0);
+		retAlbumId  = sql.GetLong(1);
+	}
+}
+
+
 void SjLibraryListView::CreateContextMenu(long offset, SjMenu& m)
 {
 	m_module->CreateMenu(&m, &m);
@@ -5377,6 +5893,16 @@ long SjLibraryListView::Url2TrackOffset(const wxString& url)
 	long        i, iCount = m_idsCount;
 	const SjId* ids = m_ids;
 
+	SjTrackCache* cache = m_module->GetTrackCache();
+	if( cache )
+	{
+		long row = cache->GetRowByUrl(url);
+		if( row >= 0 )
+		{
+			wantedId = cache->GetId(row);
+		}
+	}
+	else
 	{
 		wxSqlt sql;
 		sql.Query(wxT("SELECT id FROM tracks WHERE url='") + sql.QParam(url) + wxT("';"));
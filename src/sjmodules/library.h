@@ -79,6 +79,11 @@ private:
 #define SJ_SHORTENED_ARTISTNAME_LEN 24
 
 
+class SjAutoVolAnalyzer;
+class SjTrackCache;
+class SjTrackCacheLoader;
+
+
 class SjLibraryModule : public SjColModule
 {
 public:
@@ -131,8 +136,24 @@ public:
 	void            PlaybackDone        (const wxString& url, unsigned long startingTime, double newGain, long realDecodedBytes);
 	void            GetAutoVol          (const wxString& url, double* trackGain, double* albumGain) const; // set to < 0 if unknown
 	double          GetAutoVol          (const wxString& url, bool useAlbumGainIfPossible);
+	void            SetAnalyzedAutoVol  (const wxArrayString& urls, const wxArrayLong& gainLongs); // called by SjAutoVolAnalyzer
+	SjAutoVolAnalyzer* GetAutoVolAnalyzer () const { return m_autoVolAnalyzer; } // may be NULL
 	bool            AreTracksSubsequent (const wxString& url1, const wxString& url2);
 
+	// the memory-resident copy of the most used track fields, NULL if not
+	// available, eg. while it is loaded in background or if the library is
+	// too large; written tracks are patched using the update hook
+	SjTrackCache*   GetTrackCache       ();
+
+	// called by the update hook of the database for every written track,
+	// no queries must be done here
+	void            OnTrackChanged      (long trackId);
+
+	// the generation is incremented on every change of the tracks table;
+	// results calculated from the tracks may be cached as long as the
+	// generation does not change
+	unsigned long   GetGeneration       () const { return m_generation; }
+
 	// Get more tracks from an artist or album,
 	// targetId is one of IDT_MORE_FROM_CURR_ALBUM or IDT_MORE_FROM_CURR_ARTIST
 	// if alreadyEnqueued is set, URLs already in the given queue are not returned.
@@ -218,7 +239,35 @@ private:
 	// remembered values - use eg. GetUnmaskedTrackCount() and GetMaskedColCount() instead
 	long            m_rememberedUnmaskedTrackCount;
 	long            m_rememberedUnmaskedColCount;
-	void            ForgetRememberedValues() { m_rememberedUnmaskedTrackCount=-1; m_rememberedUnmaskedColCount=-1; }
+	void            ForgetRememberedValues() { m_rememberedUnmaskedTrackCount=-1; m_rememberedUnmaskedColCount=-1; m_navIndexBuilt=false; m_generation++; }
+	unsigned long   m_generation;
+
+	// the track cache is loaded in background on the first use; the IDs of
+	// changed tracks are collected by OnTrackChanged() and patched on the
+	// next use, after too many changes, the cache is reloaded instead
+	#define         SJ_TRACKCACHE_MAX_PENDING 1000
+	SjTrackCache*   m_trackCache;
+	SjTrackCacheLoader* m_trackCacheLoader;
+	SjLLHash        m_trackCachePending;
+	bool            m_trackCacheDirty;
+
+	// navigation index, built on demand from the albums table so that jumping to
+	// letters, albums or tracks does not need any database query (tracks are
+	// found by the track cache); the index is forgotten together with the other
+	// remembered values
+	bool            m_navIndexBuilt;
+	long            m_navAlbumCount;
+	unsigned char*  m_navAz;            // album index -> az
+	long            m_navAzFirst[27];   // az-'a' -> album index of the first album with this az, -1 for none
+	SjSLHash        m_navAlbumUrls;     // album url -> album index+1
+	SjLLHash        m_navAlbumIds;      // album id -> album index+1
+	void            BuildNavIndex       ();
+	int             GetNavAz            (long albumIndex) const { return (albumIndex>=0 && albumIndex<m_navAlbumCount)? m_navAz[albumIndex] : 0; }
+
+	// inverse of m_searchOffsets: album index -> masked index or -1, built on demand
+	long*           m_searchOffsetsInv;
+	bool            m_searchOffsetsInvValid;
+	long            AlbumIndex2MaskedIndex(long albumIndex);
 
 	// other
 	SjOmitWords     m_omitArtist;
@@ -229,15 +278,20 @@ private:
 	bool            m_deepUpdate;
 	unsigned long   m_updateStartingTime; // the DOS timestamp the update process started
 	SjIdCollector   m_updatedTracks;
+	wxSqltDb*       m_updateReader; // the state before the update, used by the scanner callbacks checking tracks
+	bool            UpdateAllCol__      (wxWindow* parent, bool deepUpdate);
 
 	SjCoverFinder   m_coverFinder;
 
+	SjAutoVolAnalyzer* m_autoVolAnalyzer;
+
 	static wxString GetDummyCoverUrl    (long albumId);
 
 	void            LoadSettings        ();
 	void            SaveSettings        ();
 
 	bool            Callback_MarkAsUpdated	(const wxString& urlBegin, long checkTrackCount);
+	long            Callback_MarkAsUpdatedExcept (const wxString& urlBegin, const wxArrayString& exceptUrlBegins, const wxArrayString& exceptDirs);
 	bool            Callback_CheckTrackInfo	(const wxString& url, uint32_t actualTimestamp);
 	bool            Callback_ReceiveTrackInfo (SjTrackInfo*);
 
@@ -273,6 +327,7 @@ private:
 	friend class    SjTagEditorDlg;
 	friend class    SjUpdateAlbum;
 	friend class    SjLibraryListView;
+	friend class    SjBenchmarkInterface;
 };
 
 
@@ -147,6 +147,27 @@ void SjModuleSystem::Init()
 		if( !db->IsOk() ) { SjMainApp::FatalError(); }
 		db->SetDefault();
 
+		// ...with write-ahead logging, worker threads can read while the
+		// main thread is writing, see the threading notes in sqlt.h
+		if( g_tools->m_config->Read("main/idxWal", SJ_DEF_SQLITE_WAL) )
+		{
+			if( !db->SetWal(true) )
+			{
+				wxLogInfo("Write-ahead logging not used for %s", g_tools->m_dbFile.c_str());
+			}
+		}
+		else
+		{
+			db->SetWal(false);
+		}
+
+		// ...settings that cannot be restored after a crash are written at once
+		db->ConfigWriteThrough("dbversion");
+		db->ConfigWriteThrough("created");
+		db->ConfigWriteThrough("folderscanner/");
+		db->ConfigWriteThrough("serverscanner/");
+		db->ConfigWriteThrough("upnpscanner/");
+
 		// ...the database version: if the major version of the database is
 		// _larger_, the database cannot be opened.  However, the version
 		// normally does not change at all as we can add tables and fields as
@@ -644,11 +665,154 @@ SjInterfaceBase::SjInterfaceBase(const wxString& name)
 
 
 static bool s_searchedForScripts = false;
+
+
+static unsigned long GetManifestTimestamp(const wxString& path)
+{
+	wxLogNull null;
+	long t = (long)::wxFileModificationTime(path);
+	return t > 0? (unsigned long)t : 0;
+}
+
+
+static wxString GetManifestEntries(const wxFileName& fn, SjModuleList& list, size_t firstNewModule)
+{
+	// the entries for a file that provided the modules from firstNewModule on:
+	// "m<file>", "t<timestamp of the file>" and "i<type>:<flags>:<name>" for each module
+	wxString entries = "m" + fn.GetFullPath() + "\t"
+	                 + wxString::Format("t%lu\t", GetManifestTimestamp(fn.GetFullPath()));
+
+	SjModuleList::Node* node = firstNewModule < list.GetCount()? list.Item(firstNewModule) : NULL;
+	while( node )
+	{
+		SjModule* module = node->GetData();
+		entries += wxString::Format("i%i:%li:", (int)module->m_type, module->m_manifestFlags) + module->m_name + "\t";
+		node = node->GetNext();
+	}
+
+	return entries;
+}
+
+
+bool SjInterfaceBase::AddModulesFromManifest(SjModuleList& list, const wxString& file, unsigned long fileTimestamp,
+                                             const wxArrayString& moduleInfo, bool suppressNoAccessErrors, wxString& newManifest)
+{
+	// add the modules of a file from the manifest; if the file was replaced,
+	// it is probed again.  returns false if the manifest entry is out of date.
+	wxFileName fn(file);
+	if( !fn.FileExists() )
+	{
+		return false;
+	}
+
+	size_t firstNewModule = list.GetCount();
+	if( fileTimestamp != GetManifestTimestamp(file) )
+	{
+		if( AddModulesFromFile(list, fn, suppressNoAccessErrors, false) )
+		{
+			newManifest += GetManifestEntries(fn, list, firstNewModule);
+		}
+		return false;
+	}
+
+	if( !AddModulesFromFile(list, fn, suppressNoAccessErrors, true/*fromManifest*/) )
+	{
+		return false;
+	}
+
+	// restore the name and the flags as they were when the modules were probed or loaded
+	SjModuleList::Node* node = firstNewModule < list.GetCount()? list.Item(firstNewModule) : NULL;
+	for( size_t i = 0; node && i < moduleInfo.GetCount(); i++ )
+	{
+		SjModule* module = node->GetData();
+		wxString  info = moduleInfo.Item(i);
+		long      type, flags;
+		if( info.BeforeFirst(':').ToLong(&type) && type == (long)module->m_type
+		 && info.AfterFirst(':').BeforeFirst(':').ToLong(&flags) )
+		{
+			module->m_name          = info.AfterFirst(':').AfterFirst(':');
+			module->m_manifestFlags = flags;
+		}
+		node = node->GetNext();
+	}
+
+	newManifest += GetManifestEntries(fn, list, firstNewModule);
+	return true;
+}
+
+
 void SjInterfaceBase::AddModulesFromDir(SjModuleList& list, const wxString& dirName, bool suppressNoAccessErrors)
 {
+	// The manifest: for each search directory, we remember the files that
+	// provided modules together with their timestamps and the name, type and
+	// flags of each module, and the scripts found.  As long as the modification
+	// time of the directory is unchanged (adding, removing or renaming files
+	// changes it), we use the manifest instead of enumerating the directory and
+	// probing every library in it; only files replaced in place are probed
+	// again.  Entries are prefixed by "m" for module files, "t" for their
+	// timestamps, "i" for the modules and by "s" for scripts.
+	unsigned long dirTimestamp = 0;
+	if( ::wxDirExists(dirName) )
+	{
+		dirTimestamp = GetManifestTimestamp(dirName);
+	}
+
+	wxArrayString manifest;
+	if( dirTimestamp && ReadFromCache(dirName, manifest, dirTimestamp) )
+	{
+		wxString      newManifest, currFile;
+		unsigned long currTimestamp = 0;
+		wxArrayString currInfo;
+		bool          manifestValid = true;
+		manifest.Add("s"); // flushes the last module file
+		for( size_t m = 0; m < manifest.GetCount(); m++ )
+		{
+			wxString entry = manifest.Item(m);
+			if( entry.StartsWith("t") )
+			{
+				entry.Mid(1).ToULong(&currTimestamp);
+			}
+			else if( entry.StartsWith("i") )
+			{
+				currInfo.Add(entry.Mid(1));
+			}
+			else
+			{
+				if( !currFile.IsEmpty()
+				 && !AddModulesFromManifest(list, currFile, currTimestamp, currInfo, suppressNoAccessErrors, newManifest) )
+				{
+					manifestValid = false;
+				}
+				currFile.Clear();
+				currTimestamp = 0;
+				currInfo.Clear();
+
+				if( entry.StartsWith("m") )
+				{
+					currFile = entry.Mid(1);
+				}
+				else if( entry.Len() > 1 )
+				{
+					if( !s_searchedForScripts )
+					{
+						m_moduleSystem->m_scripts.Add(entry.Mid(1));
+					}
+					newManifest += entry + "\t";
+				}
+			}
+		}
+
+		if( !manifestValid )
+		{
+			WriteToCache(dirName, newManifest, dirTimestamp);
+		}
+		return;
+	}
+
 	wxFileSystem        fs;
 	wxString            entryStr;
 	wxArrayString       entryStrings;
+	wxString            newManifest;
 
 	fs.ChangePathTo(dirName, TRUE);
 
@@ -679,20 +843,86 @@ void SjInterfaceBase::AddModulesFromDir(SjModuleList& list, const wxString& dirN
 	for( size_t e = 0; e < entryStrings.GetCount(); e++ )
 	{
 		wxFileName fn = wxFileSystem::URLToFileName(entryStrings.Item(e));
-		AddModulesFromFile(list, fn, suppressNoAccessErrors);
+		size_t firstNewModule = list.GetCount();
+		if( AddModulesFromFile(list, fn, suppressNoAccessErrors, false) )
+		{
+			newManifest += GetManifestEntries(fn, list, firstNewModule);
+		}
 	}
 
-	// search for scripts
+	// search for scripts; they're always added to the manifest as the
+	// manifest may be used by a later call with s_searchedForScripts unset
 
-	if( !s_searchedForScripts )
+	entryStr = fs.FindFirst("*.js", wxFILE);
+	while( !entryStr.IsEmpty() )
 	{
-		entryStrings.Clear();
-		entryStr = fs.FindFirst("*.js", wxFILE);
-		while( !entryStr.IsEmpty() )
+		if( !s_searchedForScripts )
 		{
 			m_moduleSystem->m_scripts.Add(entryStr);
-			entryStr = fs.FindNext();
 		}
+		newManifest += "s" + entryStr + "\t";
+		entryStr = fs.FindNext();
+	}
+
+	// update the manifest
+	if( dirTimestamp )
+	{
+		WriteToCache(dirName, newManifest, dirTimestamp);
+	}
+}
+
+
+void SjInterfaceBase::UpdateManifest(SjModule* module, bool remove)
+{
+	// called if a module from the manifest turns out to be no longer valid (remove set)
+	// or if its flags have changed; only the entries of the module's file are touched
+	wxString file = module->m_file;
+	int searchPathCount = g_tools->GetSearchPathCount();
+	int searchPathIndex;
+	for( searchPathIndex = 0; searchPathIndex < searchPathCount; searchPathIndex++ )
+	{
+		wxString      dirName = g_tools->GetSearchPath(searchPathIndex);
+		unsigned long dirTimestamp = GetManifestTimestamp(dirName);
+		wxArrayString manifest;
+		if( !dirTimestamp || !ReadFromCache(dirName, manifest, dirTimestamp) || manifest.Index("m" + file) == wxNOT_FOUND )
+		{
+			continue;
+		}
+
+		wxString newManifest;
+		bool     inFile = false;
+		int      moduleIndex = 0;
+		for( size_t m = 0; m < manifest.GetCount(); m++ )
+		{
+			wxString entry = manifest.Item(m);
+			if( entry.IsEmpty() )
+			{
+				continue;
+			}
+
+			if( entry.StartsWith("m") || entry.StartsWith("s") )
+			{
+				inFile = (entry == "m" + file);
+				moduleIndex = 0;
+			}
+
+			if( inFile )
+			{
+				if( remove )
+				{
+					continue;
+				}
+
+				if( entry.StartsWith("i") && moduleIndex++ == module->m_fileIndex )
+				{
+					entry = wxString::Format("i%i:%li:", (int)module->m_type, module->m_manifestFlags) + module->m_name;
+				}
+			}
+
+			newManifest += entry + "\t";
+		}
+
+		WriteToCache(dirName, newManifest, dirTimestamp);
 	}
 }
 
@@ -746,7 +976,6 @@ bool SjInterfaceBase::IsModuleAdded(SjModuleList& list,
 #endif // 0
 
 
-#if 0
 void SjInterfaceBase::WriteToCache(const wxString& file, const wxString& info__, unsigned long fileTimestamp)
 {
 	// This function may only be called from the main thread.
@@ -837,7 +1066,6 @@ wxString SjInterfaceBase::ReadFromCache(const wxString& file, unsigned long file
 	ReadFromCache(file, a, fileTimestamp);
 	return a.GetCount()? a.Item(0) : wxString();
 }
-#endif
 
 
 /*******************************************************************************
@@ -986,6 +1214,7 @@ SjModule::SjModule(SjInterfaceBase* interf, SjModuleType type)
 	m_usage                 = 0;
 	m_fileIndex             = 0;
 	m_sort                  = 1000;
+	m_manifestFlags         = 0;
 
 	m_pushPendingTimestamp  = 0;
 	m_destroyPending        = FALSE;
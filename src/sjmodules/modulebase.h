@@ -199,6 +199,7 @@ public:
 	wxString        m_name;                 // name and (optional) version
 	wxString        m_file;                 // full path to the module, internal modules should use "memory:module_name.lib"
 	int             m_fileIndex;            // if a module file has several modules, this defines the zero-based index
+	long            m_manifestFlags;        // interface-defined flags, remembered in the manifest, see SjInterfaceBase::UpdateManifest()
 
 	// Load/unload module.  You have to load a module before using
 	// any other module function (beside some exceptions which are
@@ -391,6 +392,14 @@ public:
 	virtual bool    Callback_ReceiveTrackInfo(SjTrackInfo* trackInfo) = 0;
 
 	virtual bool    Callback_MarkAsUpdated(const wxString& urlBegin, long checkTrackCount) = 0;
+
+	// ...MarkAsUpdatedExcept() marks all tracks starting with urlBegin as
+	// updated, except those starting with one of the given (sorted, not
+	// nested) URLs and those directly in one of the given directories
+	// (tracks in archives belong to the directory of the archive) - these
+	// are rescanned by the caller.  returns the number of marked tracks or
+	// -1 if the caller should do a full scan.
+	virtual long    Callback_MarkAsUpdatedExcept(const wxString& urlBegin, const wxArrayString& exceptUrlBegins, const wxArrayString& exceptDirs) = 0;
 };
 
 
@@ -417,6 +426,9 @@ public:
 	virtual void    GetTrack            (long offset, SjTrackInfo&, long& albumId, long& special) = 0;
 	virtual long    GetTrackSpecial     (long offset) = 0;
 
+	// get only the URL and the album ID of a track, may be faster than GetTrack()
+	virtual void    GetTrackUrl         (long offset, wxString& url, long& albumId) { SjTrackInfo ti; long special; GetTrack(offset, ti, albumId, special); url = ti.m_url; }
+
 
 	virtual wxString GetUpText          () = 0;
 
@@ -644,12 +656,16 @@ public:
 
 	// the cache, the module is only identified by m_file and NOT by m_fileIndex,
 	// so if a file contains several modules and should be written to the cache, all
-	// information about all modules should be placed in addInfo
-	#if 0
+	// information about all modules should be placed in addInfo.
+	// AddModulesFromDir() uses the cache as a manifest for the directories.
 	void            WriteToCache        (const wxString& file, const wxString& info, unsigned long fileTimestamp=0);
 	bool            ReadFromCache       (const wxString& file, wxArrayString& info, unsigned long fileTimestamp=0);
 	wxString        ReadFromCache       (const wxString& file, unsigned long fileTimestamp=0);
-	#endif
+
+	// UpdateManifest() removes the entries of a module from the manifest, eg. if
+	// it cannot be loaded, or stores the changed name or m_manifestFlags;
+	// the entries of the other files in the directory stay valid.
+	void            UpdateManifest      (SjModule*, bool remove);
 
 protected:
 
@@ -659,8 +675,15 @@ protected:
 	// and calls AddModulesFromFile() for each file found. Moreover,
 	// AddModulesFromDir() recurses into some special directories as
 	// "plugins" or "modules".
+	//
+	// AddModulesFromFile() should return TRUE if the file provides modules;
+	// only these files are remembered in the manifest and are given again
+	// with fromManifest set on the next program start - in this case, the
+	// file should not be probed but the modules should be created lazily;
+	// AddModulesFromManifest() restores their name and m_manifestFlags then.
 	void            AddModulesFromDir   (SjModuleList&, const wxString& dirName, bool suppressNoAccessErrors=FALSE);
-	virtual void    AddModulesFromFile  (SjModuleList&, const wxFileName& fn, bool suppressNoAccessErrors) {  }
+	virtual bool    AddModulesFromFile  (SjModuleList&, const wxFileName& fn, bool suppressNoAccessErrors, bool fromManifest) { return FALSE; }
+	bool            AddModulesFromManifest(SjModuleList&, const wxString& file, unsigned long fileTimestamp, const wxArrayString& moduleInfo, bool suppressNoAccessErrors, wxString& newManifest);
 
 	// AddModulesFromSearchPaths() calls AddModulesFromDir() for each search path
 	// and returns TRUE if sth. was changed.
@@ -31,6 +31,7 @@
 #include <wx/spinctrl.h>
 #include <wx/notebook.h>
 #include <sjmodules/playbacksettings.h>
+#include <sjmodules/autovolanalyzer.h>
 #include <sjmodules/advsearch.h>
 #include <sjmodules/settings.h>
 #include <sjmodules/kiosk/kiosk.h>
@@ -144,6 +145,7 @@ private:
 #define IDC_MAXGAINSLIDER           (IDM_FIRSTPRIVATE+2)
 #define IDC_AUTOVOLRESET            (IDM_FIRSTPRIVATE+4)
 #define IDC_STATE_CURR_TRACK        (IDM_FIRSTPRIVATE+5)
+#define IDC_STATE_ANALYSIS          (IDM_FIRSTPRIVATE+6)
 #define IDC_USE_ALBUM_VOL           (IDM_FIRSTPRIVATE+10)
 #define IDC_AUTO_VOL_ENABLED        (IDM_FIRSTPRIVATE+11)
 
@@ -275,6 +277,7 @@ SjAutovolDlg::SjAutovolDlg(wxWindow* parent)
 	AddStateBox(sizer1);
 
 	AddState(_("Current volume:"),  IDC_STATE_CURR_TRACK);
+	AddState(_("Volume analysis:"), IDC_STATE_ANALYSIS);
 
 	UpdateState();
 	StartStateTimer();
@@ -300,6 +303,11 @@ void SjAutovolDlg::UpdateState()
 		str = SjTools::FormatGain(g_mainFrame->m_player.AvGetCalculatedGain());
 	}
 	UpdateStateText(IDC_STATE_CURR_TRACK, str);
+
+	// tracks analyzed in background, see SjAutoVolAnalyzer
+	SjAutoVolAnalyzer* analyzer = g_mainFrame->m_libraryModule? g_mainFrame->m_libraryModule->GetAutoVolAnalyzer() : NULL;
+	str = analyzer? analyzer->GetProgress() : wxString();
+	UpdateStateText(IDC_STATE_ANALYSIS, str.IsEmpty()? _("n/a") : str);
 }
 
 
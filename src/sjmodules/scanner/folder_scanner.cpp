@@ -32,6 +32,7 @@
 
 #include <sjbase/base.h>
 #include <sjmodules/scanner/folder_scanner.h>
+#include <sjmodules/scanner/folder_watcher.h>
 #include <sjtools/msgbox.h>
 #include <tagger/tg_a_tagger_frontend.h>
 #include <wx/dir.h>
@@ -66,6 +67,16 @@ SjIcon SjFolderScannerSource::GetIcon()
 }
 
 
+SjFolderScannerSource::~SjFolderScannerSource()
+{
+	if( m_watcher )
+	{
+		m_watcher->Shutdown();
+		delete m_watcher;
+	}
+}
+
+
 /*******************************************************************************
  *  Settings
  ******************************************************************************/
@@ -81,6 +92,7 @@ private:
 
 	wxCheckBox*     m_enabledCheckBox;
 	wxCheckBox*     m_doUpdateCheckBox;
+	wxCheckBox*     m_watchCheckBox;
 	wxCheckBox*     m_readHiddenFilesCheckBox;
 	wxCheckBox*     m_readHiddenDirsCheckBox;
 	wxCheckBox*     m_readZipCheckBox;
@@ -152,6 +164,7 @@ SjFolderSettingsDialog::SjFolderSettingsDialog(SjFolderScannerModule* folderScan
 	m_additionalExtTextCtrl = NULL;
 	m_ignoreExtTextCtrl = NULL;
 	m_doUpdateCheckBox = NULL;
+	m_watchCheckBox = NULL;
 	m_readHiddenFilesCheckBox = NULL;
 	m_readHiddenDirsCheckBox = NULL;
 	m_readZipCheckBox = NULL;
@@ -162,6 +175,11 @@ SjFolderSettingsDialog::SjFolderSettingsDialog(SjFolderScannerModule* folderScan
 		sizer2->Add(m_doUpdateCheckBox, 0, wxLEFT|wxTOP|wxRIGHT, SJ_DLG_SPACE);
 		sizer2->Add(SJ_DLG_SPACE, SJ_DLG_SPACE/2);
 
+		m_watchCheckBox = new wxCheckBox(this, -1, _("Watch folder for changes (faster updates)"));
+		m_watchCheckBox->SetValue(source->m_flags&SJ_FOLDERSCANNER_WATCH? TRUE : FALSE);
+		sizer2->Add(m_watchCheckBox, 0, wxLEFT|wxRIGHT, SJ_DLG_SPACE);
+		sizer2->Add(SJ_DLG_SPACE, SJ_DLG_SPACE/2);
+
 		m_readHiddenFilesCheckBox = new wxCheckBox(this, -1, _("Read hidden files"));
 		m_readHiddenFilesCheckBox->SetValue(source->m_flags&SJ_FOLDERSCANNER_READHIDDENFILES? TRUE : FALSE);
 		sizer2->Add(m_readHiddenFilesCheckBox, 0, wxLEFT|wxRIGHT, SJ_DLG_SPACE);
@@ -266,6 +284,11 @@ void SjFolderSettingsDialog::OnReset(wxCommandEvent&)
 		m_doUpdateCheckBox->SetValue((SJ_FOLDERSCANNER_DOUPDATE&SJ_FOLDERSCANNER_DEFFLAGS)!=0);
 	}
 
+	if( m_watchCheckBox )
+	{
+		m_watchCheckBox->SetValue((SJ_FOLDERSCANNER_WATCH&SJ_FOLDERSCANNER_DEFFLAGS)!=0);
+	}
+
 	if( m_readHiddenFilesCheckBox )
 	{
 		m_readHiddenFilesCheckBox->SetValue((SJ_FOLDERSCANNER_READHIDDENFILES&SJ_FOLDERSCANNER_DEFFLAGS)!=0);
@@ -324,6 +347,11 @@ bool SjFolderScannerModule::ConfigSource(long index, wxWindow* parent)
 		SjDialog::ApplyToBitfield(dlg.m_doUpdateCheckBox, currSourceObj->m_flags, SJ_FOLDERSCANNER_DOUPDATE);
 	}
 
+	if( dlg.m_watchCheckBox )
+	{
+		SjDialog::ApplyToBitfield(dlg.m_watchCheckBox, currSourceObj->m_flags, SJ_FOLDERSCANNER_WATCH);
+	}
+
 	// check HIDDEN / ID3 read
 	if( dlg.m_readHiddenFilesCheckBox )
 	{
@@ -383,6 +411,12 @@ bool SjFolderScannerModule::ConfigSource(long index, wxWindow* parent)
 		needsDeepUpdate = TRUE;
 	}
 
+	// the journal of the watcher does not reflect changed settings
+	if( needsUpdate || needsDeepUpdate )
+	{
+		currSourceObj->m_watchSynced = false;
+	}
+
 	// deep update?
 	if( needsDeepUpdate )
 	{
@@ -502,16 +536,61 @@ void SjFolderScannerModule::SaveSettings__()
 
 		currSourceIndex++;
 	}
+
+	UpdateWatchers__();
+}
+
+
+void SjFolderScannerModule::UpdateWatchers__()
+{
+	// start or stop the watchers as needed by the source flags
+	SjFolderScannerSourceList::Node* currSourceNode = m_listOfSources.GetFirst();
+	SjFolderScannerSource*           currSourceObj;
+	while( currSourceNode )
+	{
+		currSourceObj = currSourceNode->GetData();
+		wxASSERT(currSourceObj);
+
+		bool watch = currSourceObj->IsDir()
+		          && (currSourceObj->m_flags&SJ_FOLDERSCANNER_ENABLED)
+		          && (currSourceObj->m_flags&SJ_FOLDERSCANNER_DOUPDATE)
+		          && (currSourceObj->m_flags&SJ_FOLDERSCANNER_WATCH);
+		bool watchHiddenDirs = (currSourceObj->m_flags&SJ_FOLDERSCANNER_READHIDDENDIRS)!=0;
+
+		if( currSourceObj->m_watcher
+		 && (!watch || currSourceObj->m_watcher->GetWatchHiddenDirs()!=watchHiddenDirs) )
+		{
+			currSourceObj->m_watcher->Shutdown();
+			delete currSourceObj->m_watcher;
+			currSourceObj->m_watcher = NULL;
+			currSourceObj->m_watchSynced = false;
+		}
+
+		if( watch && currSourceObj->m_watcher == NULL )
+		{
+			currSourceObj->m_watcher = new SjFolderWatcher(currSourceObj->m_url, watchHiddenDirs);
+			currSourceObj->m_watchSynced = false; // the first update is always a full one
+		}
+
+		currSourceNode = currSourceNode->GetNext();
+	}
 }
 
 
 bool SjFolderScannerModule::FirstLoad()
 {
 	LoadSettings__();
+	UpdateWatchers__();
 	return TRUE;
 }
 
 
+void SjFolderScannerModule::LastUnload()
+{
+	m_listOfSources.Clear(); // stops the watchers
+}
+
+
 /*******************************************************************************
  * Handling Sources
  ******************************************************************************/
@@ -848,6 +927,7 @@ Cleanup:
 bool SjFolderScannerModule::IterateDir__(const wxString&        url, // may or may not terminate with a slash
                                          const wxString&        onlyThisFile,
                                          bool                   deepUpdate,
+                                         bool                   recursive, // if false, subdirectories are skipped, archives are read anyway
                                          SjFolderScannerSource* source,
                                          SjColModule*           receiver,
                                          long&                  retTrackCount )
@@ -907,9 +987,9 @@ bool SjFolderScannerModule::IterateDir__(const wxString&        url, // may or m
 
 
 		// collect all DIRECTORIES
-		scanUsingFS = true;
+		scanUsingFS = recursive;
 
-		if( source->m_flags&SJ_FOLDERSCANNER_READHIDDENDIRS )
+		if( recursive && (source->m_flags&SJ_FOLDERSCANNER_READHIDDENDIRS) )
 		{
 			// ... collect all DIRECTORIES using wxDir (allows us to read HIDDEN files - see http://www.silverjuke.net/forum/topic-3765.html)
 			wxFileName dirEntryFn  = wxFileSystem::URLToFileName(url);
@@ -1016,7 +1096,7 @@ bool SjFolderScannerModule::IterateDir__(const wxString&        url, // may or m
 	{
 		currUrl = subdirEntries.Item(entryIndex);
 
-		if( !IterateDir__(currUrl, "", deepUpdate, source, receiver, retTrackCount) )
+		if( !IterateDir__(currUrl, "", deepUpdate, TRUE, source, receiver, retTrackCount) )
 		{
 			return FALSE; // user abort
 		}
@@ -1027,6 +1107,105 @@ bool SjFolderScannerModule::IterateDir__(const wxString&        url, // may or m
 }
 
 
+void SjFolderScannerModule::JournalToUrls__(const wxArrayString& dirs, wxArrayString& retUrls)
+{
+	size_t i, iCount = dirs.GetCount();
+	for( i = 0; i < iCount; i++ )
+	{
+		wxFileName fn(dirs[i]);
+		wxString url = wxFileSystem::FileNameToURL(fn);
+		if( url.Last()!='/' ) url += '/';
+		retUrls.Add(url);
+	}
+	retUrls.Sort();
+}
+
+
+bool SjFolderScannerModule::IterateJournal__(SjFolderScannerSource* source, SjColModule* receiver,
+                                             long& retTrackCount, bool& retUserAbort)
+{
+	// update only the directories journaled by the watcher, the tracks in
+	// all other directories are marked as being updated.  returns FALSE if
+	// this is not possible and a full scan is needed.
+	retUserAbort = FALSE;
+
+	wxArrayString fileDirs, treeDirs;
+	if( !source->m_watcher->TakeJournal(fileDirs, treeDirs) )
+	{
+		return FALSE; // overflow
+	}
+
+	// convert the journal to URLs; the trees are rescanned recursively, so
+	// nested trees and directories are covered by their parents (in a sorted
+	// list, a nested directory always follows its parent)
+	wxArrayString   treeUrls, dirUrls;
+	JournalToUrls__(treeDirs, treeUrls);
+	JournalToUrls__(fileDirs, dirUrls);
+
+	wxArrayString   topUrls;
+	size_t          i, iCount = treeUrls.GetCount();
+	for( i = 0; i < iCount; i++ )
+	{
+		if( topUrls.IsEmpty() || !treeUrls[i].StartsWith(topUrls.Last()) )
+		{
+			topUrls.Add(treeUrls[i]);
+		}
+	}
+
+	// as the trees are not nested, only the largest tree less than or equal
+	// to a directory may cover it
+	wxArrayString   fileUrls;
+	size_t          t = 0, tCount = topUrls.GetCount();
+	iCount = dirUrls.GetCount();
+	for( i = 0; i < iCount; i++ )
+	{
+		while( t < tCount && topUrls[t].Cmp(dirUrls[i]) <= 0 )
+		{
+			t++;
+		}
+
+		if( t == 0 || !dirUrls[i].StartsWith(topUrls[t-1]) )
+		{
+			fileUrls.Add(dirUrls[i]);
+		}
+	}
+
+	// mark the unchanged tracks
+	wxFileName fn(source->m_url);
+	wxString urlBegin = wxFileSystem::FileNameToURL(fn);
+	if( urlBegin.Last()!='/' ) urlBegin += '/';
+
+	long markedCount = receiver->Callback_MarkAsUpdatedExcept(urlBegin, topUrls, fileUrls);
+	if( markedCount < 0 )
+	{
+		return FALSE; // the column module wants to see all tracks
+	}
+	retTrackCount = markedCount;
+
+	// rescan the changed trees with all subdirectories and the changed
+	// directories without; vanished directories are just skipped so that
+	// their tracks are removed by the column module
+	for( int recursive = 1; recursive >= 0 && !retUserAbort; recursive-- )
+	{
+		const wxArrayString& urls = recursive? topUrls : fileUrls;
+		iCount = urls.GetCount();
+		for( i = 0; i < iCount; i++ )
+		{
+			if( ::wxDirExists(wxFileSystem::URLToFileName(urls[i]).GetFullPath()) )
+			{
+				if( !IterateDir__(urls[i], "", FALSE, recursive!=0, source, receiver, retTrackCount) )
+				{
+					retUserAbort = TRUE;
+					break;
+				}
+			}
+		}
+	}
+
+	return TRUE;
+}
+
+
 long SjFolderScannerModule::GetTrackCount__(SjFolderScannerSource* source)
 {
 	wxASSERT( source );
@@ -1094,12 +1273,39 @@ bool SjFolderScannerModule::IterateTrackInfo(SjColModule* receiver)
 			// start source iteration
 			if( doIterateDir )
 			{
-				wxFileName fn(currSource->m_url);
 				long trackCount = 0;
-				if( !IterateDir__(wxFileSystem::FileNameToURL(fn), onlyThisFile, deepUpdate, currSource, receiver, trackCount) )
+				bool userAbort;
+				if( currSource->m_watcher && currSource->m_watchSynced && !deepUpdate
+				 && IterateJournal__(currSource, receiver, trackCount, userAbort) )
 				{
-					ret = FALSE;  // user abort
-					break;
+					// incremental update done
+					if( userAbort )
+					{
+						ret = FALSE;
+						break;
+					}
+				}
+				else
+				{
+					// full update; changes made while scanning are journaled
+					// by the watcher and picked up by the next update
+					bool watchReady = FALSE;
+					if( currSource->m_watcher )
+					{
+						currSource->m_watcher->ClearJournal();
+						watchReady = currSource->m_watcher->IsReady();
+					}
+					currSource->m_watchSynced = FALSE;
+
+					wxFileName fn(currSource->m_url);
+					trackCount = 0;
+					if( !IterateDir__(wxFileSystem::FileNameToURL(fn), onlyThisFile, deepUpdate, TRUE, currSource, receiver, trackCount) )
+					{
+						ret = FALSE;  // user abort
+						break;
+					}
+
+					currSource->m_watchSynced = watchReady;
 				}
 
 				if( GetTrackCount__(currSource) != trackCount )
@@ -1119,6 +1325,14 @@ bool SjFolderScannerModule::IterateTrackInfo(SjColModule* receiver)
 	{
 		transaction.Commit();
 	}
+	else
+	{
+		// the journals taken are lost now
+		for( currSourceNode = m_listOfSources.GetFirst(); currSourceNode; currSourceNode = currSourceNode->GetNext() )
+		{
+			currSourceNode->GetData()->m_watchSynced = FALSE;
+		}
+	}
 
 	return ret;
 }
@@ -33,6 +33,9 @@
 WX_DECLARE_STRING_HASH_MAP(int/*data not interesting*/, SjIgnoreExtHash);
 
 
+class SjFolderWatcher;
+
+
 class SjFolderScannerSource
 {
 public:
@@ -45,8 +48,12 @@ public:
 		#define SJ_FOLDERSCANNER_READZIP            0x00010000L
 		#define SJ_FOLDERSCANNER_READHIDDENFILES    0x00020000L
 		#define SJ_FOLDERSCANNER_READHIDDENDIRS     0x00040000L
+		#define SJ_FOLDERSCANNER_WATCH              0x00080000L
 		m_flags = SJ_FOLDERSCANNER_DEFFLAGS;
+		m_watcher = NULL;
+		m_watchSynced = false;
 	}
+	                ~SjFolderScannerSource();
 
 	wxString        m_url;
 	wxString        m_file; // empty if the URL specifies a directory that should be read recursive
@@ -56,6 +63,11 @@ public:
 	SjTrackInfoMatcher m_trackInfoMatcher;
 	long            m_flags;
 
+	// if SJ_FOLDERSCANNER_WATCH is set, changes are journaled by m_watcher;
+	// m_watchSynced is set after a full scan that started with a ready watcher
+	SjFolderWatcher* m_watcher;
+	bool            m_watchSynced;
+
 	wxString        UrlPlusFile         ();
 	SjIcon          GetIcon             ();
 	bool            IsDir               () { return m_file.IsEmpty(); }
@@ -87,6 +99,7 @@ public:
 
 protected:
 	bool            FirstLoad           ();
+	void            LastUnload          ();
 
 private:
 	SjFolderScannerSourceList m_listOfSources;
@@ -97,14 +110,17 @@ private:
 
 	void            LoadSettings__      ();
 	void            SaveSettings__      ();
+	void            UpdateWatchers__    ();
 
-	bool            IterateDir__        (const wxString& url, const wxString& onlyThisFile, bool deepUpdate,
+	bool            IterateDir__        (const wxString& url, const wxString& onlyThisFile, bool deepUpdate, bool recursive,
 	                                     SjFolderScannerSource*, SjColModule* receiver,
 	                                     long& retTrackCount);
 	bool            IterateFile__       (const wxString& url, bool deepUpdate,
 	                                     const wxString& arts, uint32_t crc32,
 	                                     SjFolderScannerSource*, SjColModule* receiver,
 	                                     long& retTrackCount);
+	void            JournalToUrls__     (const wxArrayString& dirs, wxArrayString& retUrls);
+	bool            IterateJournal__    (SjFolderScannerSource*, SjColModule* receiver, long& retTrackCount, bool& retUserAbort);
 	long            GetTrackCount__     (SjFolderScannerSource*);
 	long            DoAddUrl            (const wxString& newUrl, const wxString& newFile, bool& sthAdded);
 
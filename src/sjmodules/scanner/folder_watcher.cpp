@@ -0,0 +1,497 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    folder_watcher.cpp
+ * Authors: Björn Petersen
+ * Purpose: Watch a folder tree and journal the changed directories
+ *
+ *******************************************************************************
+ *
+ * The journal only holds directories, not single files: for a changed file,
+ * the folder scanner rescans the files of its directory but not the
+ * subdirectories; only new, moved or removed directories are rescanned with
+ * all their subdirectories.  All other tracks of the source are kept
+ * untouched.  If the journal grows too large, or if events got lost, the
+ * journal is marked as overflowed and the next update is a full one.
+ *
+ * The polling fallback compares the modification times of the directories
+ * and the modification times and sizes of their files; so the journal also
+ * covers files that are modified in place and the incremental update can be
+ * trusted as with inotify.  As walking a large tree is expensive, the time
+ * between two walks grows with the time a walk needs.
+ *
+ ******************************************************************************/
+
+
+#include <sjbase/base.h>
+#include <sjmodules/scanner/folder_watcher.h>
+#include <wx/dir.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+
+#define SJ_FOLDERWATCHER_MAX_JOURNAL    4096
+#define SJ_FOLDERWATCHER_POLL_MS        60000   // min. time between two walks of the polling fallback
+#define SJ_FOLDERWATCHER_POLL_FACTOR    50      // ... at least this factor of the time a walk needs
+#define SJ_FOLDERWATCHER_SLEEP_MS       500
+
+
+SjFolderWatcher::SjFolderWatcher(const wxString& dir, bool watchHiddenDirs)
+	: wxThread(wxTHREAD_JOINABLE)
+{
+	m_dir               = SjTools::EnsureTrailingSlash(dir);
+	m_watchHiddenDirs   = watchHiddenDirs;
+	m_overflow          = false;
+	m_ready             = false;
+	m_stop              = false;
+
+	#ifdef __linux__
+		m_inotifyFd     = -1;
+	#endif
+
+	Create();
+	SetPriority(WXTHREAD_MIN_PRIORITY);
+	Run();
+}
+
+
+void SjFolderWatcher::Shutdown()
+{
+	{
+		wxCriticalSectionLocker locker(m_critical);
+		m_stop = true;
+	}
+
+	Wait();
+}
+
+
+bool SjFolderWatcher::IsReady()
+{
+	wxCriticalSectionLocker locker(m_critical);
+	return m_ready;
+}
+
+
+/*******************************************************************************
+ * The Journal
+ ******************************************************************************/
+
+
+void SjFolderWatcher::AddToJournal(const wxString& dir__, long what)
+{
+	wxCriticalSectionLocker locker(m_critical);
+	if( !m_overflow )
+	{
+		wxString dir = SjTools::EnsureTrailingSlash(dir__);
+		m_journal.Insert(dir, m_journal.Lookup(dir) | what);
+		if( m_journal.GetCount() > SJ_FOLDERWATCHER_MAX_JOURNAL )
+		{
+			m_journal.Clear();
+			m_overflow = true;
+		}
+	}
+}
+
+
+void SjFolderWatcher::SetOverflow()
+{
+	wxCriticalSectionLocker locker(m_critical);
+	m_journal.Clear();
+	m_overflow = true;
+}
+
+
+bool SjFolderWatcher::TakeJournal(wxArrayString& retFileDirs, wxArrayString& retTreeDirs)
+{
+	wxCriticalSectionLocker locker(m_critical);
+
+	retFileDirs.Empty();
+	retTreeDirs.Empty();
+	bool ret = !m_overflow;
+	if( ret )
+	{
+		SjHashIterator  iterator;
+		wxString        dir;
+		long            what;
+		while( (what=m_journal.Iterate(iterator, dir)) )
+		{
+			if( what & SJ_FOLDERWATCHER_TREE )
+			{
+				retTreeDirs.Add(dir); // includes the files
+			}
+			else
+			{
+				retFileDirs.Add(dir);
+			}
+		}
+	}
+
+	m_journal.Clear();
+	m_overflow = false;
+	return ret;
+}
+
+
+void SjFolderWatcher::ClearJournal()
+{
+	wxCriticalSectionLocker locker(m_critical);
+	m_journal.Clear();
+	m_overflow = false;
+}
+
+
+/*******************************************************************************
+ * The Thread
+ ******************************************************************************/
+
+
+void* SjFolderWatcher::Entry()
+{
+	#ifdef __linux__
+		if( InotifyLoop() )
+		{
+			return 0; // done, m_stop was set
+		}
+		// else: inotify not available or the watches are exhausted, fall back to polling
+		SetOverflow();
+	#endif
+
+	PollLoop();
+	return 0;
+}
+
+
+#ifdef __linux__
+
+
+bool SjFolderWatcher::InotifyAddTree(const wxString& dir__)
+{
+	// add a watch for the given directory and for all subdirectories;
+	// returns false if the watches are exhausted
+	wxString dir = SjTools::EnsureTrailingSlash(dir__);
+
+	int wd = inotify_add_watch(m_inotifyFd, dir.fn_str(),
+	                           IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO
+	                           | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+	if( wd < 0 )
+	{
+		return (errno != ENOSPC && errno != ENOMEM); // other errors, eg. a directory deleted in the meantime, are no reason to give up
+	}
+
+	wxString* old = (wxString*)m_inotifyWd2Dir.Insert(wd, new wxString(dir));
+	if( old )
+	{
+		delete old;
+	}
+
+	wxDir theDir(dir);
+	if( theDir.IsOpened() )
+	{
+		wxString theEntry;
+		bool cont = theDir.GetFirst(&theEntry, "*", wxDIR_DIRS | (m_watchHiddenDirs? wxDIR_HIDDEN : 0));
+		while( cont )
+		{
+			if( !InotifyAddTree(dir + theEntry) )
+			{
+				return false;
+			}
+			cont = theDir.GetNext(&theEntry);
+		}
+	}
+
+	return true;
+}
+
+
+void SjFolderWatcher::InotifyRemoveAll()
+{
+	SjHashIterator  iterator;
+	long            wd;
+	wxString*       dir;
+	while( (dir=(wxString*)m_inotifyWd2Dir.Iterate(iterator, &wd)) )
+	{
+		delete dir;
+	}
+	m_inotifyWd2Dir.Clear();
+
+	if( m_inotifyFd >= 0 )
+	{
+		close(m_inotifyFd);
+		m_inotifyFd = -1;
+	}
+}
+
+
+bool SjFolderWatcher::InotifyLoop()
+{
+	// returns true if the loop was left regularly by Shutdown()
+	// and false if we should fall back to polling
+	m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if( m_inotifyFd < 0 )
+	{
+		return false;
+	}
+
+	if( !InotifyAddTree(m_dir) )
+	{
+		InotifyRemoveAll();
+		return false;
+	}
+
+	{
+		wxCriticalSectionLocker locker(m_critical);
+		m_ready = true;
+	}
+
+	char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	while( 1 )
+	{
+		{
+			wxCriticalSectionLocker locker(m_critical);
+			if( m_stop )
+			{
+				break;
+			}
+		}
+
+		struct pollfd pfd;
+		pfd.fd = m_inotifyFd;
+		pfd.events = POLLIN;
+		if( poll(&pfd, 1, SJ_FOLDERWATCHER_SLEEP_MS) <= 0 )
+		{
+			continue; // timeout or EINTR
+		}
+
+		ssize_t len = read(m_inotifyFd, buffer, sizeof(buffer));
+		if( len <= 0 )
+		{
+			continue;
+		}
+
+		const struct inotify_event* event;
+		for( char* ptr = buffer; ptr < buffer + len; ptr += sizeof(struct inotify_event) + event->len )
+		{
+			event = (const struct inotify_event*)ptr;
+
+			if( event->mask & IN_Q_OVERFLOW )
+			{
+				SetOverflow();
+				continue;
+			}
+
+			wxString* dir = (wxString*)m_inotifyWd2Dir.Lookup(event->wd);
+			if( dir == NULL )
+			{
+				continue;
+			}
+
+			if( event->mask & IN_IGNORED )
+			{
+				// the watch was removed (directory deleted or unmounted), the parent is journaled by IN_DELETE
+				m_inotifyWd2Dir.Remove(event->wd);
+				delete dir;
+				continue;
+			}
+
+			if( event->mask & IN_MOVE_SELF )
+			{
+				// the watched directory was moved; the parent has journaled the old and the new path by
+				// IN_MOVED_FROM/IN_MOVED_TO.  if it was moved inside our tree, the watch was re-added for the
+				// new path then (the watch descriptor stays the same); otherwise, it is no longer needed.
+				if( *dir == m_dir )
+				{
+					SetOverflow();
+				}
+				else if( !::wxDirExists(*dir) )
+				{
+					inotify_rm_watch(m_inotifyFd, event->wd); // the entry is removed on IN_IGNORED
+				}
+				continue;
+			}
+
+			if( event->len == 0 )
+			{
+				continue; // other events for the watched directory itself, not for an entry
+			}
+
+			wxString name(event->name, wxConvFile);
+			if( event->mask & IN_ISDIR )
+			{
+				// a subdirectory was created, moved or deleted - rescan it with all subdirectories;
+				// vanished directories are skipped by the scanner so that their tracks are removed
+				if( !m_watchHiddenDirs && name.Left(1) == "." )
+				{
+					continue;
+				}
+
+				if( event->mask & (IN_CREATE|IN_MOVED_TO) )
+				{
+					if( !InotifyAddTree(*dir + name) )
+					{
+						InotifyRemoveAll();
+						return false;
+					}
+				}
+
+				if( event->mask & (IN_CREATE|IN_MOVED_TO|IN_DELETE|IN_MOVED_FROM) )
+				{
+					AddToJournal(*dir + name, SJ_FOLDERWATCHER_TREE);
+				}
+			}
+			else
+			{
+				// a file was added, changed, moved or deleted - rescan the files of the directory
+				AddToJournal(*dir, SJ_FOLDERWATCHER_FILES);
+			}
+		}
+	}
+
+	InotifyRemoveAll();
+	return true;
+}
+
+
+#endif // __linux__
+
+
+void SjFolderWatcher::PollCollect(const wxString& dir__, SjSLHash& mtimes)
+{
+	// for each directory, we remember a signature of the modification time of the directory
+	// and of the modification times and sizes of its files: files modified in place do not
+	// change the modification time of the directory, but they must be journaled as well.
+	wxString dir = SjTools::EnsureTrailingSlash(dir__);
+
+	unsigned long sig = (unsigned long)::wxFileModificationTime(dir);
+
+	wxDir theDir(dir);
+	if( theDir.IsOpened() )
+	{
+		wxString theEntry;
+		wxStructStat buf;
+		bool cont = theDir.GetFirst(&theEntry, "*", wxDIR_FILES | (m_watchHiddenDirs? wxDIR_HIDDEN : 0));
+		while( cont )
+		{
+			if( wxStat(dir + theEntry, &buf) == 0 )
+			{
+				sig = sig*33 + (unsigned long)buf.st_mtime;
+				sig = sig*33 + (unsigned long)buf.st_size;
+			}
+			cont = theDir.GetNext(&theEntry);
+		}
+
+		cont = theDir.GetFirst(&theEntry, "*", wxDIR_DIRS | (m_watchHiddenDirs? wxDIR_HIDDEN : 0));
+		while( cont )
+		{
+			PollCollect(dir + theEntry, mtimes);
+			cont = theDir.GetNext(&theEntry);
+		}
+	}
+
+	mtimes.Insert(dir, sig? (long)sig : 1 /*zero cannot be inserted*/);
+}
+
+
+void SjFolderWatcher::PollLoop()
+{
+	wxLogNull   null; // directories may vanish while we're reading them
+	SjSLHash*   lastMtimes = new SjSLHash;
+	long        sleptMs = 0;
+
+	unsigned long startMs = SjTools::GetMsTicks();
+	PollCollect(m_dir, *lastMtimes);
+	long pollMs = (long)(SjTools::GetMsTicks()-startMs) * SJ_FOLDERWATCHER_POLL_FACTOR;
+	if( pollMs < SJ_FOLDERWATCHER_POLL_MS )
+	{
+		pollMs = SJ_FOLDERWATCHER_POLL_MS;
+	}
+
+	{
+		wxCriticalSectionLocker locker(m_critical);
+		m_ready = true;
+	}
+
+	while( 1 )
+	{
+		{
+			wxCriticalSectionLocker locker(m_critical);
+			if( m_stop )
+			{
+				break;
+			}
+		}
+
+		Sleep(SJ_FOLDERWATCHER_SLEEP_MS);
+		sleptMs += SJ_FOLDERWATCHER_SLEEP_MS;
+		if( sleptMs < pollMs )
+		{
+			continue;
+		}
+		sleptMs = 0;
+
+		// compare the current state against the last one; the files of directories with another
+		// signature are journaled, new and vanished directories are journaled with their subdirectories
+		SjSLHash*       currMtimes = new SjSLHash;
+		SjHashIterator  iterator;
+		wxString        dir;
+		long            mtime, lastMtime;
+
+		startMs = SjTools::GetMsTicks();
+		PollCollect(m_dir, *currMtimes);
+		pollMs = (long)(SjTools::GetMsTicks()-startMs) * SJ_FOLDERWATCHER_POLL_FACTOR;
+		if( pollMs < SJ_FOLDERWATCHER_POLL_MS )
+		{
+			pollMs = SJ_FOLDERWATCHER_POLL_MS;
+		}
+
+		while( (mtime=currMtimes->Iterate(iterator, dir)) )
+		{
+			lastMtime = lastMtimes->Lookup(dir);
+			if( lastMtime == 0 )
+			{
+				AddToJournal(dir, SJ_FOLDERWATCHER_TREE);
+			}
+			else if( lastMtime != mtime )
+			{
+				AddToJournal(dir, SJ_FOLDERWATCHER_FILES);
+			}
+		}
+
+		SjHashIterator lastIterator;
+		while( lastMtimes->Iterate(lastIterator, dir) )
+		{
+			if( currMtimes->Lookup(dir) == 0 )
+			{
+				AddToJournal(dir, SJ_FOLDERWATCHER_TREE);
+			}
+		}
+
+		delete lastMtimes;
+		lastMtimes = currMtimes;
+	}
+
+	delete lastMtimes;
+}
@@ -0,0 +1,95 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    folder_watcher.h
+ * Authors: Björn Petersen
+ * Purpose: Watch a folder tree and journal the changed directories
+ *
+ ******************************************************************************/
+
+
+#ifndef __SJ_FOLDER_WATCHER_H__
+#define __SJ_FOLDER_WATCHER_H__
+
+
+class SjFolderWatcher : public wxThread
+{
+public:
+	/* Create a watcher for the given native directory and all its
+	 * subdirectories.  The thread is started implicitly.  Where available,
+	 * inotify is used, otherwise (or if the inotify watches are exhausted)
+	 * we fall back to polling the modification times of the directories
+	 * and of their files.
+	 */
+	                SjFolderWatcher     (const wxString& dir, bool watchHiddenDirs);
+
+	/* Shutdown() waits for the thread to terminate, this MUST be called
+	 * before the object is deleted.
+	 */
+	void            Shutdown            ();
+
+	/* IsReady() returns true if the initial set of watches is installed;
+	 * changes made before this point may be missed by the journal.
+	 */
+	bool            IsReady             ();
+	bool            GetWatchHiddenDirs  () const { return m_watchHiddenDirs; }
+
+	/* Get and clear the directories that have changed since the last
+	 * call: in retFileDirs, only the files of the directory have changed;
+	 * retTreeDirs are new, moved or removed directories that should be
+	 * rescanned with all subdirectories.  If the journal overflowed or the
+	 * watcher cannot guarantee its completeness, false is returned and the
+	 * caller should do a full scan; the overflow state is reset in this case.
+	 */
+	bool            TakeJournal         (wxArrayString& retFileDirs, wxArrayString& retTreeDirs);
+	void            ClearJournal        ();
+
+private:
+	void*           Entry               ();
+
+	#define         SJ_FOLDERWATCHER_FILES  0x01
+	#define         SJ_FOLDERWATCHER_TREE   0x02
+	void            AddToJournal        (const wxString& dir, long what);
+	void            SetOverflow         ();
+
+	#ifdef __linux__
+	bool            InotifyLoop         ();
+	bool            InotifyAddTree      (const wxString& dir);
+	void            InotifyRemoveAll    ();
+	int             m_inotifyFd;
+	SjLPHash        m_inotifyWd2Dir;    // watch descriptor => wxString* directory
+	#endif
+
+	void            PollLoop            ();
+	void            PollCollect         (const wxString& dir, SjSLHash& mtimes); // directory => signature of the directory and its files
+
+	wxString        m_dir;
+	bool            m_watchHiddenDirs;
+
+	wxCriticalSection m_critical;       // protects the following members
+	SjSLHash        m_journal;          // directory => SJ_FOLDERWATCHER_FILES and/or SJ_FOLDERWATCHER_TREE
+	bool            m_overflow;
+	bool            m_ready;
+	bool            m_stop;
+};
+
+
+#endif // __SJ_FOLDER_WATCHER_H__
@@ -0,0 +1,708 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    trackcache.cpp
+ * Authors: Björn Petersen
+ * Purpose: Memory-resident copy of the most used track fields
+ *
+ *******************************************************************************
+ *
+ * The cache holds the ID, URL, track name, artist, composer, album and genre
+ * names, album ID, year, track and disk number, playing time and rating of
+ * all tracks in columns.  With typical URLs, this needs about 100-150 bytes
+ * per track.  Except for Load(), the cache may only be used from the main
+ * thread.
+ *
+ ******************************************************************************/
+
+
+#include <sjbase/base.h>
+#include <sjmodules/trackcache.h>
+
+
+#define SJ_TRACKCACHE_FIELDS wxT("id, url, trackname, leadartistname, orgartistname, composername, albumname, genrename, albumid, year, tracknr, disknr, playtimems, rating")
+
+
+SjTrackCache::SjTrackCache()
+{
+	m_loaded            = false;
+	m_tooLarge          = false;
+
+	m_count             = 0;
+	m_allocated         = 0;
+	m_ids               = NULL;
+	m_albumIds          = NULL;
+	m_playtimeMs        = NULL;
+	m_ratings           = NULL;
+	m_years             = NULL;
+	m_trackNrs          = NULL;
+	m_diskNrs           = NULL;
+	m_leadArtistNames   = NULL;
+	m_orgArtistNames    = NULL;
+	m_composerNames     = NULL;
+	m_albumNames        = NULL;
+	m_genreNames        = NULL;
+	m_urlOffsets        = NULL;
+	m_trackNameOffsets  = NULL;
+
+	m_stringBytes       = 0;
+
+	m_arena             = NULL;
+	m_arenaUsed         = 0;
+	m_arenaAllocated    = 0;
+
+	m_urlTable          = NULL;
+	m_urlTableMask      = 0;
+
+	m_albumIndexValid   = false;
+	m_albumNext         = NULL;
+}
+
+
+SjTrackCache::~SjTrackCache()
+{
+	Invalidate();
+}
+
+
+void SjTrackCache::Invalidate()
+{
+	#define FREE_COLUMN(a) if( a ) { free(a); a = NULL; }
+	FREE_COLUMN(m_ids)
+	FREE_COLUMN(m_albumIds)
+	FREE_COLUMN(m_playtimeMs)
+	FREE_COLUMN(m_ratings)
+	FREE_COLUMN(m_years)
+	FREE_COLUMN(m_trackNrs)
+	FREE_COLUMN(m_diskNrs)
+	FREE_COLUMN(m_leadArtistNames)
+	FREE_COLUMN(m_orgArtistNames)
+	FREE_COLUMN(m_composerNames)
+	FREE_COLUMN(m_albumNames)
+	FREE_COLUMN(m_genreNames)
+	FREE_COLUMN(m_urlOffsets)
+	FREE_COLUMN(m_trackNameOffsets)
+	FREE_COLUMN(m_albumNext)
+	FREE_COLUMN(m_arena)
+	FREE_COLUMN(m_urlTable)
+
+	m_count             = 0;
+	m_allocated         = 0;
+	m_arenaUsed         = 0;
+	m_arenaAllocated    = 0;
+	m_urlTableMask      = 0;
+
+	m_strings.Empty();
+	m_stringIndex.Clear();
+	m_stringBytes       = 0;
+
+	m_albumFirst.Clear();
+	m_albumIndexValid   = false;
+
+	m_loaded            = false;
+	m_tooLarge          = false;
+}
+
+
+size_t SjTrackCache::GetMemoryBytes() const
+{
+	return (size_t)m_allocated * (14*4 + 1)
+	       + m_arenaAllocated
+	       + (m_urlTable? (m_urlTableMask+1)*4 : 0)
+	       + m_stringBytes
+	       + m_albumFirst.GetCount()*32 /*hash element*/;
+}
+
+
+/*******************************************************************************
+ * Loading
+ ******************************************************************************/
+
+
+bool SjTrackCache::Load(wxSqltDb* db)
+{
+	Invalidate();
+
+	unsigned long startTimestamp = SjTools::GetMsTicks();
+
+	wxSqlt sql(db);
+	sql.Query(wxT("SELECT ") SJ_TRACKCACHE_FIELDS wxT(" FROM tracks ORDER BY id;"));
+	while( sql.Next() )
+	{
+		AddRow();
+		SetRow(m_count-1, sql, true);
+
+		if( GetMemoryBytes() > SJ_TRACKCACHE_MAX_BYTES )
+		{
+			wxLogInfo(wxT("Track cache disabled, more than %i MB needed"), (int)(SJ_TRACKCACHE_MAX_BYTES/SJ_ONE_MB));
+			Invalidate();
+			m_tooLarge = true;
+			return false;
+		}
+	}
+
+	if( !BuildUrlTable() )
+	{
+		Invalidate();
+		m_tooLarge = true;
+		return false;
+	}
+
+	m_loaded = true;
+
+	wxLogInfo(wxT("Track cache loaded: %i tracks, %i KB, %i ms"),
+	          (int)m_count, (int)(GetMemoryBytes()/1024), (int)(SjTools::GetMsTicks()-startTimestamp));
+	return true;
+}
+
+
+void SjTrackCache::AddRow()
+{
+	if( m_count >= m_allocated )
+	{
+		m_allocated = m_allocated? m_allocated*2 : 4096;
+
+		#define REALLOC_COLUMN(a, t) a = (t*)realloc(a, m_allocated*sizeof(t));
+		REALLOC_COLUMN(m_ids,               int32_t)
+		REALLOC_COLUMN(m_albumIds,          int32_t)
+		REALLOC_COLUMN(m_playtimeMs,        int32_t)
+		REALLOC_COLUMN(m_ratings,           unsigned char)
+		REALLOC_COLUMN(m_years,             int32_t)
+		REALLOC_COLUMN(m_trackNrs,          int32_t)
+		REALLOC_COLUMN(m_diskNrs,           int32_t)
+		REALLOC_COLUMN(m_leadArtistNames,   int32_t)
+		REALLOC_COLUMN(m_orgArtistNames,    int32_t)
+		REALLOC_COLUMN(m_composerNames,     int32_t)
+		REALLOC_COLUMN(m_albumNames,        int32_t)
+		REALLOC_COLUMN(m_genreNames,        int32_t)
+		REALLOC_COLUMN(m_urlOffsets,        uint32_t)
+		REALLOC_COLUMN(m_trackNameOffsets,  uint32_t)
+		REALLOC_COLUMN(m_albumNext,         int32_t)
+
+		if( m_ids == NULL || m_albumIds == NULL || m_playtimeMs == NULL || m_ratings == NULL
+		 || m_years == NULL || m_trackNrs == NULL || m_diskNrs == NULL
+		 || m_leadArtistNames == NULL || m_orgArtistNames == NULL || m_composerNames == NULL
+		 || m_albumNames == NULL || m_genreNames == NULL
+		 || m_urlOffsets == NULL || m_trackNameOffsets == NULL || m_albumNext == NULL )
+		{
+			SjMainApp::FatalError();
+		}
+	}
+
+	m_count++;
+}
+
+
+void SjTrackCache::SetRow(long row, wxSqlt& sql, bool isNew)
+{
+	m_ids[row]              = sql.GetLong(0);
+
+	// on changes, URLs and track names are only added if they differ;
+	// the old strings stay unused in the arena
+	wxString url = sql.GetString(1);
+	if( isNew || url != GetUrl(row) )
+	{
+		m_urlOffsets[row] = AddToArena(url);
+	}
+
+	wxString trackName = sql.GetString(2);
+	if( isNew || trackName != GetTrackName(row) )
+	{
+		m_trackNameOffsets[row] = AddToArena(trackName);
+	}
+
+	m_leadArtistNames[row]  = Intern(sql.GetString(3));
+	m_orgArtistNames[row]   = Intern(sql.GetString(4));
+	m_composerNames[row]    = Intern(sql.GetString(5));
+	m_albumNames[row]       = Intern(sql.GetString(6));
+	m_genreNames[row]       = Intern(sql.GetString(7));
+	m_albumIds[row]         = sql.GetLong(8);
+	m_years[row]            = sql.GetLong(9);
+	m_trackNrs[row]         = sql.GetLong(10);
+	m_diskNrs[row]          = sql.GetLong(11);
+	m_playtimeMs[row]       = sql.GetLong(12);
+	m_ratings[row]          = (unsigned char)sql.GetLong(13);
+}
+
+
+long SjTrackCache::Intern(const wxString& str)
+{
+	long index = m_stringIndex.Lookup(str);
+	if( index == 0 )
+	{
+		m_strings.Add(str);
+		index = m_strings.GetCount();
+		m_stringIndex.Insert(str, index);
+		m_stringBytes += (str.Len()+1)*sizeof(wxChar)*2 /*array and hash*/ + 64 /*overhead*/;
+	}
+	return index-1;
+}
+
+
+uint32_t SjTrackCache::AddToArena(const wxString& str)
+{
+	const wxCharBuffer utf8 = str.utf8_str();
+	size_t bytes = strlen(utf8.data()) + 1;
+
+	if( m_arenaUsed + bytes > m_arenaAllocated )
+	{
+		m_arenaAllocated = m_arenaAllocated? m_arenaAllocated*2 : 256*1024;
+		if( m_arenaAllocated < m_arenaUsed + bytes )
+		{
+			m_arenaAllocated = m_arenaUsed + bytes;
+		}
+
+		m_arena = (char*)realloc(m_arena, m_arenaAllocated);
+		if( m_arena == NULL )
+		{
+			SjMainApp::FatalError();
+		}
+	}
+
+	uint32_t offset = (uint32_t)m_arenaUsed;
+	memcpy(m_arena + offset, utf8.data(), bytes);
+	m_arenaUsed += bytes;
+	return offset;
+}
+
+
+/*******************************************************************************
+ * Patching
+ ******************************************************************************/
+
+
+void SjTrackCache::Patch(const SjLLHash& trackIds)
+{
+	wxASSERT( wxThread::IsMain() );
+
+	if( !m_loaded )
+	{
+		return;
+	}
+
+	// if rows are inserted before the end or removed, the following rows
+	// move; the URL table is rebuilt once at the end then
+	bool rebuildUrlTable = false;
+
+	wxSqlt sql;
+	SjHashIterator iterator;
+	long trackId;
+	while( trackIds.Iterate(iterator, &trackId) )
+	{
+		long row = GetRowById(trackId);
+		sql.Query(wxString::Format(wxT("SELECT ") SJ_TRACKCACHE_FIELDS wxT(" FROM tracks WHERE id=%i;"), (int)trackId));
+		if( !sql.Next() )
+		{
+			// the track was deleted
+			if( row >= 0 )
+			{
+				if( row == m_count-1 && !rebuildUrlTable )
+				{
+					RemoveUrl(row);
+				}
+				else
+				{
+					rebuildUrlTable = true;
+				}
+				RemoveRow(row);
+				m_albumIndexValid = false;
+			}
+		}
+		else if( row < 0 )
+		{
+			// a new track, normally, it has the largest ID and is appended
+			row = InsertRow(trackId);
+			SetRow(row, sql, true);
+			if( row != m_count-1 || (uint32_t)m_count*2 > m_urlTableMask+1 )
+			{
+				rebuildUrlTable = true; // rows moved or the table must grow
+			}
+			else if( !rebuildUrlTable )
+			{
+				InsertUrl(row);
+			}
+			m_albumIndexValid = false;
+		}
+		else
+		{
+			// a changed track
+			long oldAlbumId = m_albumIds[row];
+			if( !rebuildUrlTable )
+			{
+				RemoveUrl(row);
+			}
+			SetRow(row, sql, false);
+			if( !rebuildUrlTable )
+			{
+				InsertUrl(row);
+			}
+			if( m_albumIds[row] != oldAlbumId )
+			{
+				m_albumIndexValid = false;
+			}
+		}
+	}
+
+	if( (rebuildUrlTable && !BuildUrlTable())
+	 || GetMemoryBytes() > SJ_TRACKCACHE_MAX_BYTES )
+	{
+		Invalidate(); // grown by many patches, reload on next use
+	}
+}
+
+
+long SjTrackCache::InsertRow(long trackId)
+{
+	// find the position, the rows are sorted by the ID
+	long lo = 0, hi = m_count;
+	while( lo < hi )
+	{
+		long mid = (lo+hi) / 2;
+		if( m_ids[mid] < trackId )
+		{
+			lo = mid+1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	AddRow();
+
+	if( lo < m_count-1 )
+	{
+		#define MOVE_COLUMN_UP(a) memmove(a+lo+1, a+lo, (m_count-1-lo)*sizeof(*a));
+		MOVE_COLUMN_UP(m_ids)
+		MOVE_COLUMN_UP(m_albumIds)
+		MOVE_COLUMN_UP(m_playtimeMs)
+		MOVE_COLUMN_UP(m_ratings)
+		MOVE_COLUMN_UP(m_years)
+		MOVE_COLUMN_UP(m_trackNrs)
+		MOVE_COLUMN_UP(m_diskNrs)
+		MOVE_COLUMN_UP(m_leadArtistNames)
+		MOVE_COLUMN_UP(m_orgArtistNames)
+		MOVE_COLUMN_UP(m_composerNames)
+		MOVE_COLUMN_UP(m_albumNames)
+		MOVE_COLUMN_UP(m_genreNames)
+		MOVE_COLUMN_UP(m_urlOffsets)
+		MOVE_COLUMN_UP(m_trackNameOffsets)
+	}
+
+	m_ids[lo] = trackId;
+	return lo;
+}
+
+
+void SjTrackCache::RemoveRow(long row)
+{
+	if( row < m_count-1 )
+	{
+		#define MOVE_COLUMN_DOWN(a) memmove(a+row, a+row+1, (m_count-1-row)*sizeof(*a));
+		MOVE_COLUMN_DOWN(m_ids)
+		MOVE_COLUMN_DOWN(m_albumIds)
+		MOVE_COLUMN_DOWN(m_playtimeMs)
+		MOVE_COLUMN_DOWN(m_ratings)
+		MOVE_COLUMN_DOWN(m_years)
+		MOVE_COLUMN_DOWN(m_trackNrs)
+		MOVE_COLUMN_DOWN(m_diskNrs)
+		MOVE_COLUMN_DOWN(m_leadArtistNames)
+		MOVE_COLUMN_DOWN(m_orgArtistNames)
+		MOVE_COLUMN_DOWN(m_composerNames)
+		MOVE_COLUMN_DOWN(m_albumNames)
+		MOVE_COLUMN_DOWN(m_genreNames)
+		MOVE_COLUMN_DOWN(m_urlOffsets)
+		MOVE_COLUMN_DOWN(m_trackNameOffsets)
+	}
+
+	m_count--;
+}
+
+
+/*******************************************************************************
+ * Lookup
+ ******************************************************************************/
+
+
+long SjTrackCache::GetRowById(long trackId) const
+{
+	// the rows are sorted by the ID
+	long lo = 0, hi = m_count-1;
+	while( lo <= hi )
+	{
+		long mid = (lo+hi) / 2;
+		if( m_ids[mid] < trackId )
+		{
+			lo = mid+1;
+		}
+		else if( m_ids[mid] > trackId )
+		{
+			hi = mid-1;
+		}
+		else
+		{
+			return mid;
+		}
+	}
+	return -1;
+}
+
+
+long SjTrackCache::GetRowByUrl(const wxString& url) const
+{
+	if( !m_loaded )
+	{
+		return -1;
+	}
+
+	const wxCharBuffer utf8 = url.utf8_str();
+	return LookupUrl(utf8.data());
+}
+
+
+static SjTrackCache* s_sortCache = NULL;
+int SjTrackCache_CmpAlbumRows(long* row1, long* row2)
+{
+	// the same order as "ORDER BY disknr, tracknr, trackname, id"
+	const SjTrackCache* c = s_sortCache;
+	if( c->GetDiskNr(*row1) != c->GetDiskNr(*row2) )
+	{
+		return c->GetDiskNr(*row1) < c->GetDiskNr(*row2)? -1 : 1;
+	}
+
+	if( c->GetTrackNr(*row1) != c->GetTrackNr(*row2) )
+	{
+		return c->GetTrackNr(*row1) < c->GetTrackNr(*row2)? -1 : 1;
+	}
+
+	int cmp = c->GetTrackName(*row1).Cmp(c->GetTrackName(*row2));
+	if( cmp != 0 )
+	{
+		return cmp;
+	}
+
+	return (int)(*row1 - *row2); // the rows are sorted by the ID
+}
+
+
+void SjTrackCache::GetRowsByAlbum(long albumId, wxArrayLong& retRows)
+{
+	retRows.Empty();
+
+	if( !m_loaded )
+	{
+		return;
+	}
+
+	if( !m_albumIndexValid )
+	{
+		BuildAlbumIndex();
+	}
+
+	long next = m_albumFirst.Lookup(albumId);
+	while( next )
+	{
+		retRows.Add(next-1);
+		next = m_albumNext[next-1];
+	}
+
+	s_sortCache = this;
+	retRows.Sort(SjTrackCache_CmpAlbumRows);
+}
+
+
+void SjTrackCache::BuildAlbumIndex()
+{
+	// going backwards, the rows of an album are chained in ascending order
+	m_albumFirst.Clear();
+	for( long row = m_count-1; row >= 0; row-- )
+	{
+		m_albumNext[row] = m_albumFirst.Insert(m_albumIds[row], row+1);
+	}
+
+	m_albumIndexValid = true;
+}
+
+
+/*******************************************************************************
+ * URL table
+ ******************************************************************************/
+
+
+bool SjTrackCache::BuildUrlTable()
+{
+	// the load factor is 50% at most
+	uint32_t tableSize = 64;
+	while( tableSize < (uint32_t)m_count*2 )
+	{
+		tableSize *= 2;
+	}
+
+	if( m_urlTable )
+	{
+		free(m_urlTable);
+	}
+
+	m_urlTable = (int32_t*)calloc(tableSize, sizeof(int32_t));
+	if( m_urlTable == NULL )
+	{
+		m_urlTableMask = 0;
+		return false;
+	}
+	m_urlTableMask = tableSize-1;
+
+	for( long row = 0; row < m_count; row++ )
+	{
+		InsertUrl(row);
+	}
+
+	return true;
+}
+
+
+uint32_t SjTrackCache::HashUrl(const char* p)
+{
+	// FNV-1a
+	uint32_t hash = 2166136261U;
+	while( *p )
+	{
+		hash ^= (unsigned char)*p++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+
+long SjTrackCache::LookupUrl(const char* utf8) const
+{
+	uint32_t i = HashUrl(utf8) & m_urlTableMask;
+	while( m_urlTable[i] )
+	{
+		long row = m_urlTable[i]-1;
+		if( strcmp(m_arena+m_urlOffsets[row], utf8) == 0 )
+		{
+			return row;
+		}
+		i = (i+1) & m_urlTableMask;
+	}
+	return -1;
+}
+
+
+void SjTrackCache::InsertUrl(long row)
+{
+	uint32_t i = HashUrl(m_arena+m_urlOffsets[row]) & m_urlTableMask;
+	while( m_urlTable[i] )
+	{
+		i = (i+1) & m_urlTableMask;
+	}
+	m_urlTable[i] = row+1;
+}
+
+
+void SjTrackCache::RemoveUrl(long row)
+{
+	// find the slot of the row
+	uint32_t i = HashUrl(m_arena+m_urlOffsets[row]) & m_urlTableMask;
+	while( m_urlTable[i] != row+1 )
+	{
+		if( m_urlTable[i] == 0 )
+		{
+			return; // not found
+		}
+		i = (i+1) & m_urlTableMask;
+	}
+
+	// remove it by shifting back the following entries that would not be
+	// found otherwise, so that no tombstones are needed
+	uint32_t j = i;
+	while( 1 )
+	{
+		j = (j+1) & m_urlTableMask;
+		if( m_urlTable[j] == 0 )
+		{
+			break;
+		}
+
+		uint32_t k = HashUrl(m_arena+m_urlOffsets[m_urlTable[j]-1]) & m_urlTableMask;
+		bool kInRange = (i <= j)? (i < k && k <= j) : (i < k || k <= j);
+		if( !kInRange )
+		{
+			m_urlTable[i] = m_urlTable[j];
+			i = j;
+		}
+	}
+
+	m_urlTable[i] = 0;
+}
+
+
+/*******************************************************************************
+ * SjTrackCacheLoader
+ ******************************************************************************/
+
+
+SjTrackCacheLoader::SjTrackCacheLoader()
+	: wxThread(wxTHREAD_JOINABLE)
+{
+	m_cache = new SjTrackCache();
+	m_done  = false;
+
+	Create();
+	Run();
+}
+
+
+SjTrackCacheLoader::~SjTrackCacheLoader()
+{
+	delete m_cache; // NULL if taken
+}
+
+
+void* SjTrackCacheLoader::Entry()
+{
+	{
+		wxSqltReader reader;
+		if( reader.GetDb() )
+		{
+			m_cache->Load(reader.GetDb());
+		}
+	}
+
+	wxCriticalSectionLocker locker(m_critical);
+	m_done = true;
+	return 0;
+}
+
+
+bool SjTrackCacheLoader::IsDone()
+{
+	wxCriticalSectionLocker locker(m_critical);
+	return m_done;
+}
+
+
+SjTrackCache* SjTrackCacheLoader::TakeCache()
+{
+	SjTrackCache* cache = m_cache;
+	m_cache = NULL;
+	return cache;
+}
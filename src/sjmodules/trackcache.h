@@ -0,0 +1,161 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    trackcache.h
+ * Authors: Björn Petersen
+ * Purpose: Memory-resident copy of the most used track fields
+ *
+ ******************************************************************************/
+
+
+#ifndef __SJ_TRACKCACHE_H__
+#define __SJ_TRACKCACHE_H__
+
+
+// the cache is not loaded if it would need more memory
+#define SJ_TRACKCACHE_MAX_BYTES (64*SJ_ONE_MB)
+
+
+class SjTrackCache
+{
+public:
+	                SjTrackCache        ();
+	                ~SjTrackCache       ();
+
+	// Load() reads all tracks in a single scan from the given or from the
+	// default database; it may be called from any thread, the other
+	// functions are for the main thread only.  If the library is too large
+	// for SJ_TRACKCACHE_MAX_BYTES, nothing is kept and Load() is not retried
+	// until Invalidate() is called; the callers should use the database then.
+	bool            Load                (wxSqltDb* db = NULL);
+	void            Invalidate          ();
+	bool            IsLoaded            () const { return m_loaded; }
+	bool            IsTooLarge          () const { return m_tooLarge; }
+
+	// re-read the given tracks after they were written to the database;
+	// new tracks are added, deleted tracks are removed
+	void            Patch               (const SjLLHash& trackIds);
+
+	// lookup rows, -1 is returned for tracks not in the library
+	long            GetRowById          (long trackId) const;
+	long            GetRowByUrl         (const wxString& url) const;
+
+	// get the rows of an album in the order of the album view, that is
+	// sorted by disk number, track number, track name and ID
+	void            GetRowsByAlbum      (long albumId, wxArrayLong& retRows);
+
+	// get the fields of a row
+	long            GetId               (long row) const { return m_ids[row]; }
+	long            GetAlbumId          (long row) const { return m_albumIds[row]; }
+	long            GetPlaytimeMs       (long row) const { return m_playtimeMs[row]; }
+	long            GetRating           (long row) const { return m_ratings[row]; }
+	long            GetYear             (long row) const { return m_years[row]; }
+	long            GetTrackNr          (long row) const { return m_trackNrs[row]; }
+	long            GetDiskNr           (long row) const { return m_diskNrs[row]; }
+	wxString        GetUrl              (long row) const { return wxString::FromUTF8(m_arena+m_urlOffsets[row]); }
+	wxString        GetTrackName        (long row) const { return wxString::FromUTF8(m_arena+m_trackNameOffsets[row]); }
+	const wxString& GetLeadArtistName   (long row) const { return m_strings[m_leadArtistNames[row]]; }
+	const wxString& GetOrgArtistName    (long row) const { return m_strings[m_orgArtistNames[row]]; }
+	const wxString& GetComposerName     (long row) const { return m_strings[m_composerNames[row]]; }
+	const wxString& GetAlbumName        (long row) const { return m_strings[m_albumNames[row]]; }
+	const wxString& GetGenreName        (long row) const { return m_strings[m_genreNames[row]]; }
+
+	// statistics
+	long            GetCount            () const { return m_count; }
+	size_t          GetMemoryBytes      () const;
+
+private:
+	bool            m_loaded;
+	bool            m_tooLarge;
+
+	// the columns, the rows are sorted by the track ID
+	long            m_count;
+	long            m_allocated;
+	int32_t*        m_ids;
+	int32_t*        m_albumIds;
+	int32_t*        m_playtimeMs;
+	unsigned char*  m_ratings;
+	int32_t*        m_years;
+	int32_t*        m_trackNrs;
+	int32_t*        m_diskNrs;
+	int32_t*        m_leadArtistNames;  // index into m_strings
+	int32_t*        m_orgArtistNames;   // index into m_strings
+	int32_t*        m_composerNames;    // index into m_strings
+	int32_t*        m_albumNames;       // index into m_strings
+	int32_t*        m_genreNames;       // index into m_strings
+	uint32_t*       m_urlOffsets;       // offset in m_arena
+	uint32_t*       m_trackNameOffsets; // offset in m_arena
+	void            AddRow              ();
+	long            InsertRow           (long trackId);
+	void            RemoveRow           (long row);
+	void            SetRow              (long row, wxSqlt&, bool isNew);
+
+	// artist and album names are repeated often and are interned
+	wxArrayString   m_strings;
+	SjSLHash        m_stringIndex;      // string -> index+1
+	size_t          m_stringBytes;
+	long            Intern              (const wxString&);
+
+	// URLs and track names are mostly unique and are stored as null-terminated
+	// UTF-8 strings one after another
+	char*           m_arena;
+	size_t          m_arenaUsed;
+	size_t          m_arenaAllocated;
+	uint32_t        AddToArena          (const wxString&);
+
+	// open addressing with linear probing, the entries are row+1, 0 for unused
+	int32_t*        m_urlTable;
+	uint32_t        m_urlTableMask;
+	bool            BuildUrlTable       ();
+	static uint32_t HashUrl             (const char* utf8);
+	void            InsertUrl           (long row);
+	void            RemoveUrl           (long row);
+	long            LookupUrl           (const char* utf8) const;
+
+	// the rows of an album are chained by m_albumNext, built on demand and
+	// forgotten if rows are added, removed or moved to another album
+	bool            m_albumIndexValid;
+	SjLLHash        m_albumFirst;       // album ID -> first row+1
+	int32_t*        m_albumNext;        // next row+1 of the same album, 0 for the last
+	void            BuildAlbumIndex     ();
+};
+
+
+// SjTrackCacheLoader loads a track cache in a thread using a read-only
+// connection to the default database.  The main thread polls IsDone()
+// and takes the cache using Wait() and TakeCache() then.
+class SjTrackCacheLoader : public wxThread
+{
+public:
+	                SjTrackCacheLoader  ();
+	                ~SjTrackCacheLoader ();
+	bool            IsDone              ();
+	SjTrackCache*   TakeCache           ();
+
+private:
+	void*           Entry               ();
+	SjTrackCache*   m_cache;
+	wxCriticalSection m_critical;
+	bool            m_done;
+};
+
+
+#endif // __SJ_TRACKCACHE_H__
@@ -42,12 +42,19 @@ SjCdgReader::SjCdgReader(wxFSFile* fsFile)
 	m_fsFileDataAllocated   = SJ_CDG_REALLOC_EVERY;
 	m_fsFileDataLoaded      = 0;
 	m_fsFileDataPos         = 0;
+
+	m_surfacePartW          = 0;
+	m_surfacePartH          = 0;
+	m_xTable                = NULL;
+	m_yTable                = NULL;
 }
 
 
 SjCdgReader::~SjCdgReader()
 {
 	free(m_fsFileData);
+	free(m_xTable);
+	free(m_yTable);
 	delete m_fsFile;
 }
 
@@ -162,6 +169,33 @@ bool SjCdgReader::SetPosition(long ms)
 }
 
 
+bool SjCdgReader::PrepareSurface(long scaledPartW, long scaledPartH)
+{
+	// returns true if the surface was (re-)created and all parts must be drawn
+	if( scaledPartW == m_surfacePartW && scaledPartH == m_surfacePartH && m_surface.IsOk() )
+	{
+		return false;
+	}
+
+	m_surface.Create((int)(scaledPartW*PARTS_PER_ROW), (int)(scaledPartH*PARTS_PER_COL), false);
+	m_surfacePartW = scaledPartW;
+	m_surfacePartH = scaledPartH;
+
+	// calculate the source positions once instead of a division for every pixel
+	m_xTable = (long*)realloc(m_xTable, scaledPartW*sizeof(long));
+	m_yTable = (long*)realloc(m_yTable, scaledPartH*sizeof(long));
+
+	long i;
+	for( i = 0; i < scaledPartW; i++ )
+		m_xTable[i] = PART_WIDTH * i / scaledPartW;
+
+	for( i = 0; i < scaledPartH; i++ )
+		m_yTable[i] = PART_HEIGHT * i / scaledPartH;
+
+	return true;
+}
+
+
 void SjCdgReader::Render(wxDC& dc, SjVisBg& bg, bool pleaseUpdateAll)
 {
 	wxSize      dcSize = dc.GetSize(); if( dcSize.y <= 0 ) return;
@@ -194,9 +228,14 @@ void SjCdgReader::Render(wxDC& dc, SjVisBg& bg, bool pleaseUpdateAll)
 	scaledX = (dcSize.x - scaledW) / 2;
 	scaledY = (dcSize.y - scaledH) / 2;
 
-	// create an image for the parts
-	wxImage partImage((int)scaledPartW, (int)scaledPartH, false);
-	unsigned char* destData = partImage.GetData();
+	// (re-)create the surface and the scaling tables if the size has changed
+	if( PrepareSurface(scaledPartW, scaledPartH) )
+	{
+		pleaseUpdateAll = true;
+	}
+	unsigned char* destData = m_surface.GetData();
+	const long     destLineBytes = scaledW * 3;
+	const long     partLineBytes = scaledPartW * 3;
 
 	// go through all parts
 	const unsigned char*        palette = m_screen.m_colourTable;
@@ -214,7 +253,8 @@ void SjCdgReader::Render(wxDC& dc, SjVisBg& bg, bool pleaseUpdateAll)
 	const unsigned char* currSrcLinePtr, *currBgLinePtr, *prevSrcLinePtr;
 	unsigned char*       currDestLinePtr;
 	long partX, partY, partIndex = 0, destX, destY, srcY, srcX, colourIndex;
-	bool hasData = m_screen.m_hasData;
+	long dirtyX1 = PARTS_PER_ROW, dirtyY1 = PARTS_PER_COL, dirtyX2 = -1, dirtyY2 = -1;
+	bool hasData = m_screen.m_hasData, lineUsesBg;
 	for( partY = 0; partY < PARTS_PER_COL; partY++ )
 	{
 		for( partX = 0; partX < PARTS_PER_ROW; partX++ )
@@ -222,11 +262,21 @@ void SjCdgReader::Render(wxDC& dc, SjVisBg& bg, bool pleaseUpdateAll)
 			if( m_screen.m_updatedParts & (1<<partIndex)
 			        || pleaseUpdateAll )
 			{
-				// create the part
+				// update the part in the surface
+				lineUsesBg = true;
 				for( destY = 0; destY < scaledPartH; destY++ )
 				{
-					/* calculate current source y position (rounded integer position) */
-					srcY = PART_HEIGHT * destY / scaledPartH;
+					/* buffer current output scanline (saves us some multiplications) */
+					currDestLinePtr = &destData[ (partY*scaledPartH+destY) * destLineBytes + partX * partLineBytes ];
+
+					/* if the source line is the same as for the previous line and no background
+					is visible, we can just copy the previous line */
+					srcY = m_yTable[ destY ];
+					if( destY > 0 && srcY == m_yTable[ destY-1 ] && !lineUsesBg )
+					{
+						memcpy(currDestLinePtr, currDestLinePtr-destLineBytes, partLineBytes);
+						continue;
+					}
 
 					/* buffer current input scanline (saves us some multiplications) */
 					currSrcLinePtr = &m_screen.m_screen[
@@ -235,16 +285,13 @@ void SjCdgReader::Render(wxDC& dc, SjVisBg& bg, bool pleaseUpdateAll)
 
 					prevSrcLinePtr = (currSrcLinePtr > m_screen.m_screen)? currSrcLinePtr-CDG_SCREEN_W : NULL;
 
-					/* buffer current output scanline (saves us some multiplications) */
-					currDestLinePtr = &destData[ scaledPartW * destY * 3 ];
-
 					currBgLinePtr = bg.GetBackgroundBits(
 					                    scaledX+partX*scaledPartW, scaledY+partY*scaledPartH+destY, scaledPartW);
 
+					lineUsesBg = !hasData;
 					for( destX = 0; destX < scaledPartW; destX++ )
 					{
-						/* calculate current source x position (rounded integer position) */
-						srcX = PART_WIDTH * destX / scaledPartW;
+						srcX = m_xTable[ destX ];
 
 						colourIndex = currSrcLinePtr [ srcX ];
 						if( !hasData )
@@ -254,6 +301,7 @@ void SjCdgReader::Render(wxDC& dc, SjVisBg& bg, bool pleaseUpdateAll)
 						else if( colourIndex == transpColourIndex )
 						{
 							colour = &currBgLinePtr[ destX * 3 ];
+							lineUsesBg = true;
 							if( prevSrcLinePtr && srcX > 0
 							        && prevSrcLinePtr[srcX-1] != transpColourIndex )
 							{
@@ -271,8 +319,11 @@ void SjCdgReader::Render(wxDC& dc, SjVisBg& bg, bool pleaseUpdateAll)
 					}
 				}
 
-				wxBitmap scaledBitmap(partImage);
-				dc.DrawBitmap(scaledBitmap, scaledX+partX*scaledPartW, scaledY+partY*scaledPartH, true);
+				// remember the dirty area
+				if( partX < dirtyX1 ) dirtyX1 = partX;
+				if( partX > dirtyX2 ) dirtyX2 = partX;
+				if( partY < dirtyY1 ) dirtyY1 = partY;
+				if( partY > dirtyY2 ) dirtyY2 = partY;
 			}
 
 			partIndex++;
@@ -280,5 +331,15 @@ void SjCdgReader::Render(wxDC& dc, SjVisBg& bg, bool pleaseUpdateAll)
 	}
 
 	m_screen.m_updatedParts = 0;
-}
 
+	// present the dirty area with a single blit
+	if( dirtyX2 >= 0 )
+	{
+		wxRect dirtyRect(dirtyX1*scaledPartW, dirtyY1*scaledPartH,
+		                 (dirtyX2-dirtyX1+1)*scaledPartW, (dirtyY2-dirtyY1+1)*scaledPartH);
+
+		wxBitmap dirtyBitmap((dirtyRect.width==scaledW && dirtyRect.height==scaledH)?
+		                     m_surface : m_surface.GetSubImage(dirtyRect));
+		dc.DrawBitmap(dirtyBitmap, scaledX+dirtyRect.x, scaledY+dirtyRect.y, true);
+	}
+}
@@ -57,6 +57,14 @@ private:
 	long            m_fsFileDataPos;
 
 	static long     Ms2Bytes            (long ms);
+
+	// the output surface is updated in place; it and the scaling tables
+	// are only recreated if the part size changes
+	wxImage         m_surface;
+	long            m_surfacePartW, m_surfacePartH;
+	long*           m_xTable; // destination x -> source x inside a part
+	long*           m_yTable; // destination y -> source y inside a part
+	bool            PrepareSurface      (long scaledPartW, long scaledPartH);
 };
 
 
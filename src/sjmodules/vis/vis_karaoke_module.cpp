@@ -31,6 +31,7 @@
 #include <sjmodules/vis/vis_module.h>
 #include <sjmodules/vis/vis_karaoke_module.h>
 #include <sjmodules/vis/vis_window.h>
+#include <sjmodules/vis/vis_pacer.h>
 #include <sjmodules/vis/vis_cdg_reader.h>
 #include <sjmodules/vis/vis_synctxt_reader.h>
 
@@ -275,6 +276,7 @@ public:
 	SjKaraokeMaster m_karaokeMaster;
 
 	wxTimer         m_timer;
+	SjVisPacer      m_pacer;
 	SjKaraokeModule* m_karaokeModule;
 	bool            m_bgChanged;
 
@@ -310,6 +312,7 @@ private:
 	bool            m_inPaint;
 
 	void            OnTimer             (wxTimerEvent&);
+	void            RenderFrame         ();
 #if SJ_USE_IMG_KARAOKE_BG
 	void            OnImageThere        (SjImageThereEvent& e) { OnImageThere_(e.GetObj()); }
 	void            OnImageThere_       (SjImgThreadObj*);
@@ -340,7 +343,8 @@ END_EVENT_TABLE()
 SjKaraokeWindow::SjKaraokeWindow(SjKaraokeModule* karaokeModule, wxWindow* parent)
 	: wxWindow( parent, -1,
 	            wxPoint(-1000,-1000), wxSize(100,100),
-	            (wxNO_BORDER | wxCLIP_CHILDREN | wxFULL_REPAINT_ON_RESIZE ))
+	            (wxNO_BORDER | wxCLIP_CHILDREN | wxFULL_REPAINT_ON_RESIZE )),
+	m_pacer(SJ_KARAOKE_SLEEP_MS, SJ_KARAOKE_SLEEP_MS)
 {
 	m_karaokeModule     = karaokeModule;
 
@@ -351,8 +355,9 @@ SjKaraokeWindow::SjKaraokeWindow(SjKaraokeModule* karaokeModule, wxWindow* paren
 	m_sjScreen          = NULL;
 	m_bgChanged         = false;
 
+	// the timer is restarted after each frame by OnTimer()
 	m_timer.SetOwner(this, IDC_TIMER);
-	m_timer.Start(SJ_KARAOKE_SLEEP_MS);
+	m_timer.Start(SJ_KARAOKE_SLEEP_MS, wxTIMER_ONE_SHOT);
 }
 
 
@@ -392,6 +397,19 @@ void SjKaraokeWindow::OnPaint(wxPaintEvent&)
 
 
 void SjKaraokeWindow::OnTimer(wxTimerEvent&)
+{
+	if( m_karaokeModule == NULL )
+	{
+		return; // stopped
+	}
+
+	m_pacer.BeginFrame();
+	RenderFrame();
+	m_timer.Start(m_pacer.EndFrame(), wxTIMER_ONE_SHOT);
+}
+
+
+void SjKaraokeWindow::RenderFrame()
 {
 	wxASSERT( wxThread::IsMain() );
 
@@ -725,6 +743,7 @@ void SjKaraokeModule::Stop()
 		SjKaraokeWindow* toDel = m_karaokeWindow;
 
 		toDel->m_timer.Stop();
+		wxLogInfo(wxT("Karaoke: %s"), toDel->m_pacer.GetStatistics().c_str());
 
 		// make sure, there are no more waiting images
 		g_mainFrame->m_imgThread->RequireKill(toDel);
@@ -29,8 +29,9 @@
 #include <sjbase/base.h>
 #include <sjmodules/vis/vis_oscilloscope.h>
 #include <sjmodules/vis/vis_window.h>
+#include <sjmodules/vis/vis_pacer.h>
+#include <sjmodules/vis/vis_spectrum.h>
 #include <math.h>
-#include <kiss_fft/tools/kiss_fftr.h>
 
 // you should not change SLEEP_MS without reasons.
 // IF you change it, also check if really all time-depending calculations are still correct.
@@ -38,6 +39,178 @@
 #define SLEEP_MS 30
 
 
+/*******************************************************************************
+ *  SjOscCanvas
+ ******************************************************************************/
+
+
+// all figures are drawn into a RGB buffer which is converted to a bitmap and
+// blitted once per frame.  single wxDC calls are expensive on some systems (on
+// GTK, each call is a round trip to cairo or X) and the stars, rockets and
+// spectrum bands need some thousand calls per frame at larger sizes.
+class SjOscCanvas
+{
+public:
+	                SjOscCanvas         ();
+	void            SetSize             (const wxSize&);
+
+	void            SetColour           (int r, int g, int b) { m_r = r; m_g = g; m_b = b; }
+	void            SetColour           (const wxColour& c)   { SetColour(c.Red(), c.Green(), c.Blue()); }
+	void            SetGrey             (long intensity)      { SetColour(intensity, intensity, intensity); }
+
+	// the primitives are clipped to the canvas
+	void            FillRect            (int x, int y, int w, int h);
+	void            DrawPoint           (int x, int y)        { if( x >= 0 && y >= 0 && x < m_w && y < m_h ) { Plot(m_data+(y*m_w+x)*3); } }
+	void            DrawLine            (int x1, int y1, int x2, int y2);
+	void            DrawLines           (int n, const wxPoint points[], int xoffset = 0, int yoffset = 0);
+
+	// blit the canvas to the given DC, it is stretched if the sizes differ
+	void            Blit                (wxDC&, const wxSize& dcSize);
+
+private:
+	wxImage         m_image;
+	unsigned char*  m_data;
+	int             m_w, m_h;
+	unsigned char   m_r, m_g, m_b;
+	void            Plot                (unsigned char* p)    { p[0] = m_r; p[1] = m_g; p[2] = m_b; }
+
+	wxBitmap        m_bitmap;
+	wxMemoryDC      m_bitmapDc;
+};
+
+
+SjOscCanvas::SjOscCanvas()
+{
+	m_data  = NULL;
+	m_w     = 0;
+	m_h     = 0;
+	m_r     = 255;
+	m_g     = 255;
+	m_b     = 255;
+	SetSize(wxSize(16, 16));
+}
+
+
+void SjOscCanvas::SetSize(const wxSize& size)
+{
+	int w = size.x > 0? size.x : 1,
+	    h = size.y > 0? size.y : 1;
+	if( w != m_w || h != m_h )
+	{
+		m_image.Create(w, h, false);
+		m_data = m_image.GetData();
+		m_w = w;
+		m_h = h;
+	}
+}
+
+
+void SjOscCanvas::FillRect(int x, int y, int w, int h)
+{
+	if( x < 0 )     { w += x; x = 0; }
+	if( y < 0 )     { h += y; y = 0; }
+	if( x+w > m_w ) { w = m_w-x; }
+	if( y+h > m_h ) { h = m_h-y; }
+	if( w <= 0 || h <= 0 ) { return; }
+
+	// fill the first row and copy it to the other ones
+	unsigned char* row = m_data + (y*m_w+x)*3, *p = row;
+	int i;
+	for( i = 0; i < w; i++, p += 3 )
+	{
+		Plot(p);
+	}
+
+	for( i = 1; i < h; i++ )
+	{
+		memcpy(row + i*m_w*3, row, w*3);
+	}
+}
+
+
+void SjOscCanvas::DrawLine(int x1, int y1, int x2, int y2)
+{
+	if( y1 == y2 )
+	{
+		FillRect(x1 < x2? x1 : x2, y1, abs(x2-x1)+1, 1);
+		return;
+	}
+
+	// clip the line (Liang-Barsky), eg. the rotor lines go far beyond the canvas
+	double t0 = 0.0, t1 = 1.0, dx = x2-x1, dy = y2-y1;
+	const double p[4] = { -dx, dx, -dy, dy };
+	const double q[4] = { (double)x1, (double)(m_w-1-x1), (double)y1, (double)(m_h-1-y1) };
+	int i;
+	for( i = 0; i < 4; i++ )
+	{
+		if( p[i] == 0.0 )
+		{
+			if( q[i] < 0.0 ) { return; } // parallel to the edge and outside
+		}
+		else
+		{
+			double t = q[i] / p[i];
+			if( p[i] < 0.0 )
+			{
+				if( t > t1 ) { return; }
+				if( t > t0 ) { t0 = t; }
+			}
+			else
+			{
+				if( t < t0 ) { return; }
+				if( t < t1 ) { t1 = t; }
+			}
+		}
+	}
+
+	#define CLIP_COORD(a, max) ((a)<0? 0 : ((a)>(max)? (max) : (a)))
+	int cx1 = (int)floor(x1 + t0*dx + 0.5), cy1 = (int)floor(y1 + t0*dy + 0.5),
+	    cx2 = (int)floor(x1 + t1*dx + 0.5), cy2 = (int)floor(y1 + t1*dy + 0.5);
+	cx1 = CLIP_COORD(cx1, m_w-1); cy1 = CLIP_COORD(cy1, m_h-1);
+	cx2 = CLIP_COORD(cx2, m_w-1); cy2 = CLIP_COORD(cy2, m_h-1);
+
+	// draw the clipped line (Bresenham)
+	int adx = abs(cx2-cx1), ady = -abs(cy2-cy1),
+	    sx = cx1 < cx2? 1 : -1, sy = cy1 < cy2? 1 : -1,
+	    err = adx+ady, e2;
+	while( 1 )
+	{
+		Plot(m_data + (cy1*m_w+cx1)*3);
+		if( cx1 == cx2 && cy1 == cy2 ) { break; }
+		e2 = 2*err;
+		if( e2 >= ady ) { err += ady; cx1 += sx; }
+		if( e2 <= adx ) { err += adx; cy1 += sy; }
+	}
+}
+
+
+void SjOscCanvas::DrawLines(int n, const wxPoint points[], int xoffset, int yoffset)
+{
+	int i;
+	for( i = 1; i < n; i++ )
+	{
+		DrawLine(points[i-1].x+xoffset, points[i-1].y+yoffset, points[i].x+xoffset, points[i].y+yoffset);
+	}
+}
+
+
+void SjOscCanvas::Blit(wxDC& dc, const wxSize& dcSize)
+{
+	m_bitmapDc.SelectObject(wxNullBitmap);
+	m_bitmap = wxBitmap(m_image);
+	m_bitmapDc.SelectObject(m_bitmap);
+
+	if( dcSize.x != m_w || dcSize.y != m_h )
+	{
+		dc.StretchBlit(0, 0, dcSize.x, dcSize.y, &m_bitmapDc, 0, 0, m_w, m_h);
+	}
+	else
+	{
+		dc.Blit(0, 0, m_w, m_h, &m_bitmapDc, 0, 0);
+	}
+}
+
+
 /*******************************************************************************
  *  SjOscStarfield
  ******************************************************************************/
@@ -48,7 +221,7 @@ class SjOscStar
 public:
 	void            Init                ();
 	void            Exit                () { m_exitRequest = TRUE; }
-	bool            Draw                (wxDC& dc, const wxSize&, double rot, wxPen&, wxBrush&);
+	bool            Draw                (SjOscCanvas& canvas, const wxSize&, double rot);
 
 private:
 	// internal calculations are done in a 1000 x 1000 map
@@ -75,7 +248,7 @@ void SjOscStar::Init()
 }
 
 
-bool SjOscStar::Draw(wxDC& dc, const wxSize& clientSize, double rot, wxPen& pen, wxBrush& brush)
+bool SjOscStar::Draw(SjOscCanvas& canvas, const wxSize& clientSize, double rot)
 {
 	double  xfloat, yfloat;
 	int     x, y, hh, vv;
@@ -150,20 +323,14 @@ bool SjOscStar::Draw(wxDC& dc, const wxSize& clientSize, double rot, wxPen& pen,
 	if( intensity > 255 )   intensity = 255;
 
 	// draw star
+	canvas.SetGrey(intensity);
 	if( d==1 )
 	{
-		pen.SetColour(intensity, intensity, intensity);
-		dc.SetPen(pen);
-		dc.DrawPoint(x, y);
+		canvas.DrawPoint(x, y);
 	}
 	else
 	{
-		dc.SetPen(*wxTRANSPARENT_PEN);
-
-		brush.SetColour(intensity, intensity, intensity);
-		dc.SetBrush(brush);
-
-		dc.DrawRectangle(x, y, d, d);
+		canvas.FillRect(x, y, d, d);
 	}
 
 	return TRUE;
@@ -177,7 +344,7 @@ public:
 	#define         STARFIELD_MODE_DO       2
 	#define         STARFIELD_MODE_FADEOUT  3
 					SjOscStarfield      ();
-	void            Draw                (wxDC& dc, const wxSize& clientSize,
+	void            Draw                (SjOscCanvas& canvas, const wxSize& clientSize,
 	                                     bool otherRunning, bool newTitle, bool on);
 	bool            IsRunning           () const { return m_mode==STARFIELD_MODE_DO; }
 
@@ -192,9 +359,6 @@ private:
 
 	int             m_mode;
 	long            m_progress;
-
-	wxPen           m_pen;
-	wxBrush         m_brush;
 };
 
 
@@ -205,7 +369,7 @@ SjOscStarfield::SjOscStarfield()
 }
 
 
-void SjOscStarfield::Draw(wxDC& dc, const wxSize& clientSize,
+void SjOscStarfield::Draw(SjOscCanvas& canvas, const wxSize& clientSize,
                           bool otherRunning, bool newTitle, bool on)
 {
 	int     i;
@@ -283,7 +447,7 @@ void SjOscStarfield::Draw(wxDC& dc, const wxSize& clientSize,
 		bool anythingDrawn = FALSE;
 		for( i = 0; i < STAR_COUNT; i++ )
 		{
-			if( pol[i].Draw(dc, clientSize, m_rotate, m_pen, m_brush) )
+			if( pol[i].Draw(canvas, clientSize, m_rotate) )
 			{
 				anythingDrawn = TRUE;
 			}
@@ -309,7 +473,7 @@ public:
 	                SjOscRocket         ();
 	void            Init                (int energy, int patch, int length, long seed, int mx, int my);
 	void            Start               ();
-	void            Show                (wxDC& dc, long light);
+	void            Show                (SjOscCanvas& canvas, long light);
 	double          NextDouble          () { return (double)SjTools::PrivateRand(m_random, 10000)/10000.0F; }
 
 	bool            m_sleep;
@@ -323,7 +487,7 @@ private:
 	                m_vx[MAX_ROCKET_PATCH_NUMBER],
 	                m_vy[MAX_ROCKET_PATCH_NUMBER],
 	                m_t;
-	wxPen           m_pen;
+	wxColour        m_colour;
 	long            m_random;
 };
 
@@ -346,7 +510,7 @@ void SjOscRocket::Init(int energy, int patch, int length, long seed, int mx, int
 	m_length    = length;
 	m_random    = seed;
 
-	m_pen.SetColour(255, 255, 255);
+	m_colour.Set(255, 255, 255);
 
 	m_ox=(int)SjTools::Rand(m_mx/2)+m_mx/4;
 	m_oy=(int)SjTools::Rand(m_my/2)+m_my/4;
@@ -366,7 +530,7 @@ void SjOscRocket::Start()
 }
 
 
-void SjOscRocket::Show(wxDC& dc, long light)
+void SjOscRocket::Show(SjOscCanvas& canvas, long light)
 {
 	if(m_sleep)
 	{
@@ -385,10 +549,10 @@ void SjOscRocket::Show(wxDC& dc, long light)
 			maxL = m_length-m_t;
 			long intensity = (255/VIEW)*(m_length-m_t);
 			if( light > intensity ) intensity = light;
-			m_pen.SetColour(intensity, intensity, intensity);
+			m_colour.Set(intensity, intensity, intensity);
 		}
 
-		dc.SetPen(m_pen);
+		canvas.SetColour(m_colour);
 
 		wxPoint points[VIEW];
 		for(i=0; i<m_patch; i++)
@@ -403,7 +567,7 @@ void SjOscRocket::Show(wxDC& dc, long light)
 				points[j].y = m_oy-y;
 			}
 
-			dc.DrawLines(maxL, points);
+			canvas.DrawLines(maxL, points);
 		}
 
 		m_t++;
@@ -419,7 +583,7 @@ class SjOscFirework
 {
 public:
 	                SjOscFirework       ();
-	void            Draw                (wxDC& dc, const wxSize& clientSize, bool newTitle, bool otherRunning, bool volumeBeat, long light);
+	void            Draw                (SjOscCanvas& canvas, const wxSize& clientSize, bool newTitle, bool otherRunning, bool volumeBeat, long light);
 
 private:
 	#define         MAX_ROCKET_NUMBER       4
@@ -441,7 +605,7 @@ SjOscFirework::SjOscFirework()
 }
 
 
-void SjOscFirework::Draw(wxDC& dc, const wxSize& clientSize,
+void SjOscFirework::Draw(SjOscCanvas& canvas, const wxSize& clientSize,
                          bool newTitle, bool otherRunning, bool volumeBeat,
                          long light)
 {
@@ -497,7 +661,7 @@ void SjOscFirework::Draw(wxDC& dc, const wxSize& clientSize,
 		if( !m_rockets[i].m_sleep )
 		{
 			runningRockets++;
-			m_rockets[i].Show(dc, light);
+			m_rockets[i].Show(canvas, light);
 		}
 	}
 
@@ -518,7 +682,7 @@ class SjOscHands
 {
 public:
 	                SjOscHands          ();
-	void            Draw                (wxDC& dc, const wxSize& clientSize, long volume, long light, bool newTitle);
+	void            Draw                (SjOscCanvas& canvas, const wxSize& clientSize, long volume, long light, bool newTitle);
 
 private:
 	#define         HAND_POINTS         19
@@ -535,7 +699,6 @@ private:
 	long            m_logHandMode;
 	long            m_logHandModeData;
 	bool            m_firstTitle;
-	wxPen           m_pen;
 };
 
 
@@ -557,7 +720,7 @@ SjOscHands::SjOscHands()
 }
 
 
-void SjOscHands::Draw(wxDC& dc, const wxSize& clientSize,
+void SjOscHands::Draw(SjOscCanvas& canvas, const wxSize& clientSize,
                       long volume, long light, bool newTitle)
 {
 	long i, offset = 0;
@@ -636,15 +799,13 @@ void SjOscHands::Draw(wxDC& dc, const wxSize& clientSize,
 	long intensity = 42+light;
 	if( intensity < 70 ) intensity = 70;
 	if( intensity > 255 ) intensity = 255;
-	m_pen.SetColour(intensity, intensity, intensity);
-
-	dc.SetPen(m_pen);
+	canvas.SetGrey(intensity);
 
 	for( i = 0; i < MAX_HANDS; i++ )
 	{
-		dc.DrawLines(HAND_POINTS, scrHandPoints,
-		             (m_logHandsPos[i].x * clientSize.x) / 1024,
-		             offset + (((m_logHandsPos[i].y * clientSize.y) / 768) - volume/m_logHandRnd[i]));
+		canvas.DrawLines(HAND_POINTS, scrHandPoints,
+		                 (m_logHandsPos[i].x * clientSize.x) / 1024,
+		                 offset + (((m_logHandsPos[i].y * clientSize.y) / 768) - volume/m_logHandRnd[i]));
 	}
 }
 
@@ -664,7 +825,7 @@ public:
 	#define         ROTOR_MODE_FADEOUT      3
 	#define         ROTOR_MODE_FADEOUTFAST  4
 	                SjOscRotor          ();
-	void            Draw                (wxDC& dc, const wxSize& clientSize, bool otherRunning, bool newTitle, long volume, long light);
+	void            Draw                (SjOscCanvas& canvas, const wxSize& clientSize, bool otherRunning, bool newTitle, long volume, long light);
 	bool            IsRunning           () const { return (m_mode==ROTOR_MODE_FADEIN||m_mode==ROTOR_MODE_DO); }
 
 private:
@@ -676,7 +837,7 @@ private:
 	long            m_logDo;
 	double          m_delta;
 	bool            m_followVolume;
-	wxPen           m_pen;
+	wxColour        m_colour;
 };
 
 
@@ -688,7 +849,7 @@ SjOscRotor::SjOscRotor()
 }
 
 
-void SjOscRotor::Draw(wxDC& dc, const wxSize& clientSize, bool otherRunning, bool newTitle, long volume, long light)
+void SjOscRotor::Draw(SjOscCanvas& canvas, const wxSize& clientSize, bool otherRunning, bool newTitle, long volume, long light)
 {
 	if( m_mode == ROTOR_MODE_NOP )
 	{
@@ -714,11 +875,11 @@ void SjOscRotor::Draw(wxDC& dc, const wxSize& clientSize, bool otherRunning, boo
 
 		long intensity = m_logColour;
 		if( light > intensity ) intensity = light;
-		m_pen.SetColour(intensity, intensity, intensity);
+		m_colour.Set(intensity, intensity, intensity);
 
 		if( m_logColour == 255 )
 		{
-			m_pen.SetColour(255, 255, 255);
+			m_colour.Set(255, 255, 255);
 			m_mode = ROTOR_MODE_DO;
 		}
 	}
@@ -747,7 +908,7 @@ void SjOscRotor::Draw(wxDC& dc, const wxSize& clientSize, bool otherRunning, boo
 		long intensity = m_logColour;
 		if( light > intensity ) intensity = light;
 
-		m_pen.SetColour(intensity, intensity, intensity);
+		m_colour.Set(intensity, intensity, intensity);
 		if( m_logColour == 0 )
 		{
 			m_mode = ROTOR_MODE_NOP;
@@ -774,12 +935,12 @@ void SjOscRotor::Draw(wxDC& dc, const wxSize& clientSize, bool otherRunning, boo
 	    centery = (clientSize.y*m_logCenterY) / 150/*not:100 - center is not in the lower part*/;
 	int radius = (clientSize.x+clientSize.y)*2;
 
-	dc.SetPen(m_pen);
+	canvas.SetColour(m_colour);
 
-	dc.DrawLine(centerx+sin(m_delta         )*radius, centery+cos(m_delta         )*radius,
-	            centerx+sin(m_delta+PI      )*radius, centery+cos(m_delta+PI      )*radius);
-	dc.DrawLine(centerx+sin(m_delta+PI/2    )*radius, centery+cos(m_delta+PI/2    )*radius,
-	            centerx+sin(m_delta+PI/2+PI )*radius, centery+cos(m_delta+PI/2+PI )*radius);
+	canvas.DrawLine(centerx+sin(m_delta         )*radius, centery+cos(m_delta         )*radius,
+	                centerx+sin(m_delta+PI      )*radius, centery+cos(m_delta+PI      )*radius);
+	canvas.DrawLine(centerx+sin(m_delta+PI/2    )*radius, centery+cos(m_delta+PI/2    )*radius,
+	                centerx+sin(m_delta+PI/2+PI )*radius, centery+cos(m_delta+PI/2+PI )*radius);
 }
 
 
@@ -796,7 +957,7 @@ public:
 	void            Calc                (const wxSize& clientSize,
 	                                     const unsigned char* bufferStart,
 	                                     long& retVolume);
-	void            Draw                (wxDC& dc, bool forceAnim);
+	void            Draw                (SjOscCanvas& canvas, bool forceAnim);
 
 private:
 	wxSize          m_clientSize;
@@ -866,7 +1027,7 @@ void SjOscOscilloscope::Calc(const wxSize& clientSize, const unsigned char* buff
 }
 
 
-void SjOscOscilloscope::Draw(wxDC& dc, bool forceAnim)
+void SjOscOscilloscope::Draw(SjOscCanvas& canvas, bool forceAnim)
 {
 	wxCoord animOffset = 0;
 
@@ -884,11 +1045,11 @@ void SjOscOscilloscope::Draw(wxDC& dc, bool forceAnim)
 		}
 	}
 
-	dc.DrawLines(m_pointsCount, m_lPoints, 0, 0-animOffset);
-	dc.DrawLines(m_pointsCount, m_lPoints, 0, 1-animOffset);
+	canvas.DrawLines(m_pointsCount, m_lPoints, 0, 0-animOffset);
+	canvas.DrawLines(m_pointsCount, m_lPoints, 0, 1-animOffset);
 
-	dc.DrawLines(m_pointsCount, m_rPoints, 0, 0+animOffset);
-	dc.DrawLines(m_pointsCount, m_rPoints, 0, 1+animOffset);
+	canvas.DrawLines(m_pointsCount, m_rPoints, 0, 0+animOffset);
+	canvas.DrawLines(m_pointsCount, m_rPoints, 0, 1+animOffset);
 }
 
 
@@ -900,8 +1061,7 @@ void SjOscOscilloscope::Draw(wxDC& dc, bool forceAnim)
 class SjOscSpectrumChData
 {
 public:
-	#define         NUM_BOXES 20
-	#define         SPEC_NUM  576
+	#define         NUM_BOXES SJ_VIS_SPECTRUM_BANDS
 	long            chNum;
 	double          m_boxMax[NUM_BOXES];
 	double          m_boxY[NUM_BOXES];
@@ -922,24 +1082,20 @@ class SjOscSpectrum
 {
 public:
 	                SjOscSpectrum       ();
-	                ~SjOscSpectrum      ();
 	void            Calc                (const wxSize& clientSize,
 	                                     const unsigned char* bufferStart);
-	void            Draw                (wxDC& dc, bool volumeBeat, bool showFigures, bool forceAnim)
-	{	Draw(dc, &m_chData[0], volumeBeat, showFigures, forceAnim);
-		Draw(dc, &m_chData[1], volumeBeat, showFigures, forceAnim);
+	void            Draw                (SjOscCanvas& canvas, bool volumeBeat, bool showFigures, bool forceAnim)
+	{	Draw(canvas, &m_chData[0], volumeBeat, showFigures, forceAnim);
+		Draw(canvas, &m_chData[1], volumeBeat, showFigures, forceAnim);
 	}
 
 private:
 	wxSize          m_clientSize;
-	kiss_fftr_cfg   m_kiss_fft_setup;
+	SjVisSpectrum   m_analyzer;
 	SjOscSpectrumChData m_chData[2];
 
-	void            Draw                (wxDC&, SjOscSpectrumChData* chData, bool volumeBeat, bool showFigures, bool forceAnim);
-	void            DrawBand            (wxDC& dc, int x, int y, int w, int h, double val, double crazy);
-
-	int             m_freqToBox[SPEC_NUM];
-	long            m_boxSampleCount[NUM_BOXES];
+	void            Draw                (SjOscCanvas&, SjOscSpectrumChData* chData, bool volumeBeat, bool showFigures, bool forceAnim);
+	void            DrawBand            (SjOscCanvas& canvas, int x, int y, int w, int h, double val, double crazy);
 
 	#define         CRAZY_MAX 2.00
 	#define         CRAZY_INC  0.1
@@ -957,29 +1113,11 @@ private:
 
 SjOscSpectrum::SjOscSpectrum()
 {
-	m_kiss_fft_setup    = kiss_fftr_alloc(SPEC_NUM*2, 0, NULL, 0);
 	m_chData[0].chNum   = 0;
 	m_chData[1].chNum   = 1;
 
 	m_crazyState = CRAZY_NONE;
 	m_firstCrazy = FALSE;
-
-	// calculate the frequency band -> box array
-	static const unsigned int analyzer[20]= {1,3,5,7,9,13,19,25,38,58,78,116,156,195,235,274,313,352,391,430};
-	int b;
-	for( b = 0; b < NUM_BOXES; b++ )
-	{
-		int from = b?             analyzer[b-1]+(analyzer[b]  -analyzer[b-1])/2 : 0;
-		int to   = b<NUM_BOXES-1? analyzer[b]  +(analyzer[b+1]-analyzer[b]  )/2 : SPEC_NUM;
-
-		int j;
-		for( j = from; j < to; j++ )
-		{
-			m_freqToBox[j] = b;
-		}
-
-		m_boxSampleCount[b] = to-from;
-	}
 }
 
 
@@ -987,56 +1125,11 @@ void SjOscSpectrum::Calc(const wxSize& clientSize, const unsigned char* bufferSt
 {
 	m_clientSize = clientSize;
 
-	// convert to double
-	signed short*       bufferSShort = (signed short*)bufferStart;
-	long                i, ch;
-	kiss_fft_scalar     kiss_in[2][SPEC_NUM*2];
-
-	for( i = 0; i < SPEC_NUM*2; i++ )
-	{
-		#define  float_to_short ((float)0x7FFF) // Multiplier for making 16-bit integer
-		kiss_in[0][i]  = (float)(*bufferSShort++) / float_to_short;
-		kiss_in[1][i] = (float)(*bufferSShort++) / float_to_short;
-	}
-
-	static const int equalizer[20] = {9,11,12,13,20,23,28,36,52,60,70,90,110,140,140,150,150,150,150,160};
-	kiss_fft_cpx kiss_out[SPEC_NUM*2];
-	for( ch = 0; ch < 2; ch++ )
-	{
-		// get spectrum data
-		kiss_fftr(m_kiss_fft_setup, kiss_in[ch], kiss_out);
-
-		// calculate all boxes
-		double* boxY = m_chData[ch].m_boxY;
-		for( i = 0; i < NUM_BOXES; i++ )
-		{
-			boxY[i] = 0;
-		}
-
-		double amplitude = 0.03f;
-		for( i = 0; i < SPEC_NUM; i++ )
-		{
-			kiss_fft_scalar absval = sqrt(static_cast<double>(kiss_out[i].r * kiss_out[i].r)
-			                              + static_cast<double>(kiss_out[i].i * kiss_out[i].i));
-			double y = amplitude*absval;
-
-			boxY[m_freqToBox[i]] += y;
-		}
-
-		for( i = 0; i < NUM_BOXES; i++ )
-		{
-			boxY[i] /= m_boxSampleCount[i];
-			boxY[i] *= ((double)equalizer[i]/100.0F) * 3;
-			if( boxY[i] > 1.0 )
-			{
-				boxY[i] = 1.0;
-			}
-		}
-	}
+	m_analyzer.Calc((const signed short*)bufferStart, m_chData[0].m_boxY, m_chData[1].m_boxY);
 }
 
 
-void SjOscSpectrum::DrawBand(wxDC& dc, int x, int y, int w, int h, double val, double crazy)
+void SjOscSpectrum::DrawBand(SjOscCanvas& canvas, int x, int y, int w, int h, double val, double crazy)
 {
 	// make sure, "val" is in range.  normally, there should be no overflows, but if, for any reasons,
 	// silverjuke may get very slow as eg. handH gets way too large.
@@ -1058,12 +1151,12 @@ void SjOscSpectrum::DrawBand(wxDC& dc, int x, int y, int w, int h, double val, d
 
 	for( yy = 0; yy < bandH; yy += 4 )
 	{
-		dc.DrawLine(x, y+h-yy+crazy1curr, x+w, y+h-yy+crazy2curr);
+		canvas.DrawLine(x, y+h-yy+crazy1curr, x+w, y+h-yy+crazy2curr);
 	}
 }
 
 
-void SjOscSpectrum::Draw(wxDC& dc, SjOscSpectrumChData* chData, bool volumeBeat, bool showFigures, bool forceAnim)
+void SjOscSpectrum::Draw(SjOscCanvas& canvas, SjOscSpectrumChData* chData, bool volumeBeat, bool showFigures, bool forceAnim)
 {
 	if( forceAnim )
 	{
@@ -1150,7 +1243,7 @@ void SjOscSpectrum::Draw(wxDC& dc, SjOscSpectrumChData* chData, bool volumeBeat,
 				chData->m_boxMax[i] = val;
 			}
 
-			DrawBand(dc,
+			DrawBand(canvas,
 			         (int)( analyzerX + i*cellW ),
 			         (int)( analyzerY + m_clientSize.y/2*chData->chNum ),
 			         (int)( boxW ),
@@ -1162,12 +1255,6 @@ void SjOscSpectrum::Draw(wxDC& dc, SjOscSpectrumChData* chData, bool volumeBeat,
 }
 
 
-SjOscSpectrum::~SjOscSpectrum()
-{
-	kiss_fftr_free(m_kiss_fft_setup);
-}
-
-
 /*******************************************************************************
  *  SjOscWindow
  ******************************************************************************/
@@ -1181,8 +1268,7 @@ public:
 
 private:
 	SjOscModule*        m_oscModule;
-    wxBitmap            m_offscreenBitmap;
-    wxMemoryDC          m_offscreenDc;
+    SjOscCanvas         m_canvas;
     unsigned char*      m_bufferStart;
     unsigned char*      m_bufferTemp;
     #define             BUFFER_MIN_BYTES (576*2*sizeof(float))
@@ -1193,8 +1279,6 @@ private:
     long                m_sampleCount_;
 	wxColour            m_textColour;
 	wxColour            m_fgColour;
-	wxPen               m_fgPen;
-	wxBrush             m_bgBrush;
 	SjOscSpectrum*      m_spectrum;
 	SjOscOscilloscope*  m_oscilloscope;
 	SjOscRotor*         m_rotor;
@@ -1202,6 +1286,8 @@ private:
 	SjOscFirework*      m_firework;
 	SjOscStarfield*     m_starfield;
 	wxTimer             m_timer;
+	SjVisPacer          m_pacer;
+	void                RenderFrame         ();
 	void                ShowFigures         (int show); // -1 = toggle
 	void                OnEraseBackground   (wxEraseEvent&)     { /* we won't erease the background explcitly, this is done in the thread */ }
 	void                OnPaint             (wxPaintEvent&)     { wxPaintDC dc(this); /* even if we do not paint the window here and do this in the thread, wxPaintDC MUST be constructed for validating the window list! */ }
@@ -1247,7 +1333,7 @@ SjOscWindow::SjOscWindow(SjOscModule* oscModule, wxWindow* parent)
 	: wxWindow( parent, -1, /*oscModule->m_name,*/
 	            wxPoint(-1000,-1000), wxSize(100,100),
 	            wxNO_BORDER | wxCLIP_CHILDREN ),
-	m_offscreenBitmap(16,16)
+	m_pacer(SLEEP_MS, SLEEP_MS) // the animations count frames, so only the quality is adapted
 {
 	m_oscModule = oscModule;
 
@@ -1263,7 +1349,6 @@ SjOscWindow::SjOscWindow(SjOscModule* oscModule, wxWindow* parent)
 	// set colors
 	m_textColour = wxColour(0x2F, 0x60, 0xA3);
 	m_fgColour = wxColour(0x3D, 0x80, 0xDF);
-	m_fgPen = wxPen(m_fgColour, 1, wxSOLID);
 
 	// create the drawing objects
 	m_spectrum = new SjOscSpectrum();
@@ -1273,9 +1358,9 @@ SjOscWindow::SjOscWindow(SjOscModule* oscModule, wxWindow* parent)
 	m_firework = new SjOscFirework();
 	m_starfield = new SjOscStarfield();
 
-	// finally, start the timer
+	// finally, start the timer; it is restarted after each frame by OnTimer()
 	m_timer.SetOwner(this, IDC_TIMER);
-	m_timer.Start(SLEEP_MS);
+	m_timer.Start(SLEEP_MS, wxTIMER_ONE_SHOT);
 }
 
 
@@ -1295,6 +1380,19 @@ SjOscWindow::~SjOscWindow()
 
 
 void SjOscWindow::OnTimer(wxTimerEvent&)
+{
+	if( m_oscModule == NULL )
+	{
+		return; // stopped
+	}
+
+	m_pacer.BeginFrame();
+	RenderFrame();
+	m_timer.Start(m_pacer.EndFrame(), wxTIMER_ONE_SHOT);
+}
+
+
+void SjOscWindow::RenderFrame()
 {
 	SJ_FORCE_IN_HERE_ONLY_ONCE;
 
@@ -1325,13 +1423,17 @@ void SjOscWindow::OnTimer(wxTimerEvent&)
 			}
 		m_bufferCritical.Leave();
 
-		// get window client size, correct offscreen DC if needed
-		wxSize clientSize = m_oscModule->m_oscWindow->GetClientSize();
-		if( clientSize.x != m_offscreenBitmap.GetWidth() || clientSize.y != m_offscreenBitmap.GetHeight() )
+		// get window client size, correct the canvas size if needed;
+		// with the lowest quality, we render at the half resolution
+		int quality = m_pacer.GetQuality();
+		wxSize windowSize = m_oscModule->m_oscWindow->GetClientSize();
+		wxSize clientSize(windowSize);
+		if( quality == SJ_VIS_QUALITY_MIN )
 		{
-			m_offscreenBitmap.Create(clientSize.x, clientSize.y);
-			m_offscreenDc.SelectObject(m_offscreenBitmap);
+			clientSize.x = (clientSize.x+1) / 2;
+			clientSize.y = (clientSize.y+1) / 2;
 		}
+		m_canvas.SetSize(clientSize);
 
 		// calculate the points for the lines, collect volume
 		{
@@ -1377,55 +1479,60 @@ void SjOscWindow::OnTimer(wxTimerEvent&)
 		volumeBeat = (volume > maxVolume/2);
 
 		// erase screen
-		m_offscreenDc.SetPen(*wxTRANSPARENT_PEN);
 		{
 			// blue gradient background
 			#define BG_STEPS 88
-			int rowH = (clientSize.y/BG_STEPS)+1;
-			for( i = 0; i < BG_STEPS; i++ )
+			int bgSteps = quality >= 2? BG_STEPS : BG_STEPS/4;
+			int rowH = (clientSize.y/bgSteps)+1;
+			for( i = 0; i < bgSteps; i++ )
 			{
-				m_bgBrush.SetColour(0, 0, i);
-				m_offscreenDc.SetBrush(m_bgBrush);
-				m_offscreenDc.DrawRectangle(0, i*rowH, clientSize.x, rowH);
+				m_canvas.SetColour(0, 0, i*BG_STEPS/bgSteps);
+				m_canvas.FillRect(0, i*rowH, clientSize.x, rowH);
 			}
 		}
 
-		// draw figures (they lay in backgroud)
-		if( m_oscModule->m_showFlags&SJ_OSC_SHOW_FIGURES )
+		// draw figures (they lay in backgroud); with a lower quality, less figures are drawn
+		if( (m_oscModule->m_showFlags&SJ_OSC_SHOW_FIGURES) && quality > SJ_VIS_QUALITY_MIN )
 		{
 			long bgLight = 100;
 
 			// draw hands (optional)
-			m_hands->Draw(m_offscreenDc, clientSize, volume, bgLight, titleChanged);
+			if( quality >= 2 )
+			{
+				m_hands->Draw(m_canvas, clientSize, volume, bgLight, titleChanged);
+			}
 
 			// draw rotor (optional)
-			m_rotor->Draw(m_offscreenDc, clientSize, m_starfield->IsRunning(), titleChanged, volume, bgLight);
+			m_rotor->Draw(m_canvas, clientSize, m_starfield->IsRunning(), titleChanged, volume, bgLight);
 
 			// draw firework (optional)
-			m_firework->Draw(m_offscreenDc, clientSize, titleChanged, m_starfield->IsRunning(), volumeBeat, bgLight);
+			if( quality >= 2 )
+			{
+				m_firework->Draw(m_canvas, clientSize, titleChanged, m_starfield->IsRunning(), volumeBeat, bgLight);
+			}
 		}
 
 		// draw starfield (optional)
-		m_starfield->Draw(m_offscreenDc, clientSize, false, titleChanged, (m_oscModule->m_showFlags&SJ_OSC_SHOW_STARFIELD)!=0);
+		m_starfield->Draw(m_canvas, clientSize, false, titleChanged, (m_oscModule->m_showFlags&SJ_OSC_SHOW_STARFIELD)!=0);
 
 		// draw spectrum and/or oscilloscope (for both, the spectrum lays over the oscillosope)
-		m_offscreenDc.SetPen(m_fgPen);
+		m_canvas.SetColour(m_fgColour);
 
 		if( m_oscModule->m_showFlags&SJ_OSC_SHOW_OSC )
 		{
-			m_oscilloscope->Draw(m_offscreenDc, forceOscAnim);
+			m_oscilloscope->Draw(m_canvas, forceOscAnim);
 		}
 
 		if( m_oscModule->m_showFlags&SJ_OSC_SHOW_SPECTRUM )
 		{
-			m_spectrum->Draw(m_offscreenDc, volumeBeat,
+			m_spectrum->Draw(m_canvas, volumeBeat,
 						  (m_oscModule->m_showFlags&SJ_OSC_SHOW_FIGURES)? true : false,
 						  forceSpectrAnim);
 		}
 
-		// draw offscreen bitmap to screen
+		// draw the canvas to screen
 		wxClientDC dc(this);
-		dc.Blit(0, 0, m_offscreenBitmap.GetWidth(), m_offscreenBitmap.GetHeight(), &m_offscreenDc, 0, 0);
+		m_canvas.Blit(dc, windowSize);
 	}
 }
 
@@ -1479,6 +1586,8 @@ void SjOscModule::Stop()
 {
 	if( m_oscWindow )
 	{
+		wxLogInfo(wxT("Spectrum monitor: %s"), m_oscWindow->m_pacer.GetStatistics().c_str());
+
 		m_oscWindow->m_oscModule = NULL;
 		m_oscWindow->Hide();
 		g_mainFrame->Update();
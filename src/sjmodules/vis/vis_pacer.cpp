@@ -0,0 +1,199 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    vis_pacer.cpp
+ * Authors: Björn Petersen
+ * Purpose: Frame pacing and adaptive quality for the visualizations
+ *
+ *******************************************************************************
+ *
+ * While playing, the frames are aligned to the playback clock, so a frame is
+ * rendered every frameMs of audio; frames missed this way are counted as
+ * dropped.  Without playback, the wall clock is used.
+ *
+ * At least SJ_VIS_MIN_SLEEP_MS are left between two frames for the user
+ * interface.  If rendering needs more than SJ_VIS_BUDGET_PERCENT of the
+ * frame time on average, the quality is lowered step by step and after that,
+ * the frame rate; if rendering is fast again, this is undone in reverse order.
+ *
+ ******************************************************************************/
+
+
+#include <sjbase/base.h>
+#include <sjmodules/vis/vis_pacer.h>
+
+
+#define SJ_VIS_MIN_SLEEP_MS     10
+#define SJ_VIS_BUDGET_PERCENT   60
+#define SJ_VIS_ADAPT_FRAMES     25  // adapt not more often than this
+#define SJ_VIS_AVG_WEIGHT       0.1 // weight of a new frame in the moving average
+
+
+SjVisPacer::SjVisPacer(long frameMs, long maxFrameMs, int maxQuality)
+{
+	m_targetFrameMs = frameMs;
+	m_maxFrameMs    = maxFrameMs > frameMs? maxFrameMs : frameMs;
+	m_maxQuality    = maxQuality;
+	Reset();
+}
+
+
+void SjVisPacer::Reset()
+{
+	m_frameMs           = m_targetFrameMs;
+	m_quality           = m_maxQuality;
+	m_startTimestamp    = SjTools::GetMsTicks();
+	m_frameTimestamp    = m_startTimestamp;
+	m_lastAudioMs       = -1;
+	m_framesSinceAdapt  = 0;
+	m_frameCount        = 0;
+	m_droppedCount      = 0;
+	m_avgCostMs         = 0.0;
+	m_maxCostMs         = 0;
+}
+
+
+long SjVisPacer::GetAudioMs()
+{
+	if( g_mainFrame == NULL || !g_mainFrame->m_player.IsPlaying() )
+	{
+		return -1;
+	}
+
+	long totalMs, elapsedMs, remainingMs;
+	g_mainFrame->m_player.GetTime(totalMs, elapsedMs, remainingMs);
+	return elapsedMs; // may be -1 for unknown
+}
+
+
+void SjVisPacer::BeginFrame()
+{
+	m_frameTimestamp = SjTools::GetMsTicks();
+}
+
+
+long SjVisPacer::EndFrame()
+{
+	// measure the frame cost
+	unsigned long now = SjTools::GetMsTicks();
+	long costMs = (long)(now - m_frameTimestamp);
+	if( costMs < 0 ) { costMs = 0; }
+
+	m_frameCount++;
+	m_avgCostMs = m_frameCount==1? (double)costMs : (m_avgCostMs*(1.0-SJ_VIS_AVG_WEIGHT) + (double)costMs*SJ_VIS_AVG_WEIGHT);
+	if( costMs > m_maxCostMs ) { m_maxCostMs = costMs; }
+
+	// count the frames missed on the audio clock; larger jumps are seeks or track changes
+	long audioMs = GetAudioMs();
+	if( audioMs >= 0 && m_lastAudioMs >= 0 )
+	{
+		long deltaMs = audioMs - m_lastAudioMs;
+		if( deltaMs > m_frameMs + m_frameMs/2 && deltaMs < 5000 )
+		{
+			m_droppedCount += deltaMs/m_frameMs - 1;
+		}
+	}
+	m_lastAudioMs = audioMs;
+
+	if( ++m_framesSinceAdapt >= SJ_VIS_ADAPT_FRAMES )
+	{
+		Adapt();
+	}
+
+	// calculate the time to the next frame
+	long sleepMs;
+	if( audioMs >= 0 )
+	{
+		sleepMs = m_frameMs - ((audioMs+costMs) % m_frameMs); // the audio clock has also advanced while rendering
+	}
+	else
+	{
+		sleepMs = m_frameMs - costMs;
+	}
+
+	if( sleepMs < SJ_VIS_MIN_SLEEP_MS ) { sleepMs = SJ_VIS_MIN_SLEEP_MS; }
+	if( sleepMs > m_frameMs )           { sleepMs = m_frameMs; }
+	return sleepMs;
+}
+
+
+void SjVisPacer::Adapt()
+{
+	m_framesSinceAdapt = 0;
+
+	double budgetMs = (double)(m_frameMs*SJ_VIS_BUDGET_PERCENT/100);
+	if( m_avgCostMs > budgetMs )
+	{
+		// too slow: lower the quality, then the frame rate
+		if( m_quality > SJ_VIS_QUALITY_MIN )
+		{
+			m_quality--;
+		}
+		else if( m_frameMs < m_maxFrameMs )
+		{
+			m_frameMs += m_targetFrameMs/4;
+			if( m_frameMs > m_maxFrameMs ) { m_frameMs = m_maxFrameMs; }
+		}
+		else
+		{
+			return;
+		}
+	}
+	else if( m_avgCostMs < budgetMs/3 )
+	{
+		// fast enough: raise the frame rate, then the quality
+		if( m_frameMs > m_targetFrameMs )
+		{
+			m_frameMs -= m_targetFrameMs/4;
+			if( m_frameMs < m_targetFrameMs ) { m_frameMs = m_targetFrameMs; }
+		}
+		else if( m_quality < m_maxQuality )
+		{
+			m_quality++;
+		}
+		else
+		{
+			return;
+		}
+	}
+	else
+	{
+		return;
+	}
+
+	// the new settings start with a new average
+	m_avgCostMs = budgetMs/2;
+}
+
+
+double SjVisPacer::GetFps() const
+{
+	unsigned long ms = SjTools::GetMsTicks() - m_startTimestamp;
+	return ms > 0? (double)m_frameCount*1000.0/(double)ms : 0.0;
+}
+
+
+wxString SjVisPacer::GetStatistics() const
+{
+	return wxString::Format(wxT("%i frames, %.1f fps, %.1f ms/frame average, %i ms max., %i frames dropped, quality %i/%i, %i ms/frame wanted"),
+	                        (int)m_frameCount, GetFps(), m_avgCostMs, (int)m_maxCostMs, (int)m_droppedCount,
+	                        m_quality, m_maxQuality, (int)m_frameMs);
+}
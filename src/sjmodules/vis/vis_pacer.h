@@ -0,0 +1,88 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    vis_pacer.h
+ * Authors: Björn Petersen
+ * Purpose: Frame pacing and adaptive quality for the visualizations
+ *
+ ******************************************************************************/
+
+
+#ifndef __SJ_VIS_PACER_H__
+#define __SJ_VIS_PACER_H__
+
+
+#define SJ_VIS_QUALITY_MIN      0
+#define SJ_VIS_QUALITY_MAX      3
+
+
+class SjVisPacer
+{
+public:
+	// frameMs is the wanted time between two frames; if rendering takes too
+	// long, the quality is lowered first and then the time between two frames
+	// is raised up to maxFrameMs.  Renderers without quality settings should
+	// use maxQuality=SJ_VIS_QUALITY_MIN, so that only the frame rate is adapted.
+	                SjVisPacer          (long frameMs, long maxFrameMs, int maxQuality=SJ_VIS_QUALITY_MAX);
+	void            Reset               ();
+
+	// use as:
+	//  m_pacer.BeginFrame();
+	//  ... render using m_pacer.GetQuality() ...
+	//  m_timer.Start(m_pacer.EndFrame(), wxTIMER_ONE_SHOT);
+	// a one-shot timer is needed as a continuous one backs up if rendering is slow.
+	void            BeginFrame          ();
+	long            EndFrame            ();
+
+	int             GetQuality          () const { return m_quality; }
+	long            GetFrameMs          () const { return m_frameMs; }
+
+	// frame-time statistics, eg. for logging
+	long            GetFrameCount       () const { return m_frameCount; }
+	long            GetDroppedCount     () const { return m_droppedCount; }
+	double          GetAvgCostMs        () const { return m_avgCostMs; }
+	long            GetMaxCostMs        () const { return m_maxCostMs; }
+	double          GetFps              () const;
+	wxString        GetStatistics       () const;
+
+private:
+	long            m_targetFrameMs;
+	long            m_maxFrameMs;
+	long            m_frameMs;
+	int             m_maxQuality;
+	int             m_quality;
+
+	unsigned long   m_startTimestamp;
+	unsigned long   m_frameTimestamp;
+	long            m_lastAudioMs;      // -1 if not playing
+	long            m_framesSinceAdapt;
+
+	long            m_frameCount;
+	long            m_droppedCount;
+	double          m_avgCostMs;
+	long            m_maxCostMs;
+
+	static long     GetAudioMs          ();
+	void            Adapt               ();
+};
+
+
+#endif // __SJ_VIS_PACER_H__
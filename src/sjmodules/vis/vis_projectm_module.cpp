@@ -31,6 +31,7 @@
 #include <wx/glcanvas.h>
 #include <sjtools/msgbox.h>
 #include <sjmodules/vis/vis_window.h>
+#include <sjmodules/vis/vis_pacer.h>
 #include <sjmodules/vis/vis_projectm_module.h>
 #include <prjm/src/projectM.hpp>
 #include <prjm/src/Renderer/BeatDetect.hpp>
@@ -44,7 +45,8 @@
 static SjProjectmModule* s_theProjectmModule = NULL;
 
 
-#define SLEEP_MS                40 // results in 25 frames/s - TODO: We should adapt this to larger values if rendering takes too long (or render only every Nth frame, so that we need not to change the timer)
+#define SLEEP_MS                40 // results in 25 frames/s; if rendering takes too long, SjVisPacer lowers this down to 12.5 frames/s
+#define MAX_SLEEP_MS            80
 #define IDC_TIMER               (IDM_FIRSTPRIVATE+130)
 
 #define IDC_GO_TO_PREV_PRESET   (IDO_VIS_OPTIONFIRST+1)
@@ -72,8 +74,10 @@ public:
 	void        OnMouseLeftDClick   (wxMouseEvent& e)   { if(ImplOk()) s_theProjectmModule->m_impl->OnMouseLeftDClick(e); }
 
 	void        OnTimer             (wxTimerEvent&);
+	void        RenderFrame         ();
 
 	wxTimer     m_timer;
+	SjVisPacer  m_pacer;
     bool        m_triedCreation;
 
 	DECLARE_EVENT_TABLE ();
@@ -94,7 +98,8 @@ END_EVENT_TABLE()
 
 
 SjProjectmGlCanvas::SjProjectmGlCanvas(wxWindow* parent)
-	: wxGLCanvas(parent, wxID_ANY, NULL, wxDefaultPosition, wxDefaultSize, wxCLIP_CHILDREN)
+	: wxGLCanvas(parent, wxID_ANY, NULL, wxDefaultPosition, wxDefaultSize, wxCLIP_CHILDREN),
+	  m_pacer(SLEEP_MS, MAX_SLEEP_MS, SJ_VIS_QUALITY_MIN) // the mesh size cannot be changed after creation, so only the frame rate is adapted
 {
 	m_triedCreation = false;
 }
@@ -119,6 +124,19 @@ void SjProjectmGlCanvas::OnPaint(wxPaintEvent& e)
 
 
 void SjProjectmGlCanvas::OnTimer(wxTimerEvent&)
+{
+	if( s_theProjectmModule == NULL || s_theProjectmModule->m_glCanvas != this )
+	{
+		return; // stopped
+	}
+
+	m_pacer.BeginFrame();
+	RenderFrame();
+	m_timer.Start(m_pacer.EndFrame(), wxTIMER_ONE_SHOT);
+}
+
+
+void SjProjectmGlCanvas::RenderFrame()
 {
 	SJ_FORCE_IN_HERE_ONLY_ONCE
 
@@ -193,6 +211,10 @@ void SjProjectmGlCanvas::OnTimer(wxTimerEvent&)
 
 			wxSize size = GetSize();
 			s_theProjectmModule->m_projectMobj->projectM_resetGL(size.x, size.y);
+
+			// the creation is no frame
+			m_pacer.Reset();
+			m_pacer.BeginFrame();
 		}
 		catch(...) {
 			s_theProjectmModule->m_projectMobj = NULL;
@@ -295,9 +317,10 @@ bool SjProjectmModule::Start(SjVisWindow* impl)
 	m_glCanvas->SetSize(visRect);
 	m_glCanvas->Show();
 
-	// start timer; the real initialisation is done in the timer if IsShownOnScreen() is true
+	// start timer; the real initialisation is done in the timer if IsShownOnScreen() is true;
+	// the timer is restarted after each frame by OnTimer()
 	m_glCanvas->m_timer.SetOwner(m_glCanvas, IDC_TIMER);
-	m_glCanvas->m_timer.Start(SLEEP_MS, wxTIMER_CONTINUOUS);
+	m_glCanvas->m_timer.Start(SLEEP_MS, wxTIMER_ONE_SHOT);
 
 	return true;
 }
@@ -307,6 +330,7 @@ void SjProjectmModule::Stop()
 {
 	if( m_glCanvas ) {
 		m_glCanvas->m_timer.Stop();
+		wxLogInfo("Visualization: %s", m_glCanvas->m_pacer.GetStatistics().c_str());
 	}
 
 	WritePrjmConfig();
@@ -0,0 +1,111 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    vis_spectrum.cpp
+ * Authors: Björn Petersen
+ * Purpose: Calculate the spectrum bands for the visualizations
+ *
+ *******************************************************************************
+ *
+ * Everything that does not depend on the samples - the band ranges and the
+ * band scaling including the equalizer - is calculated once in the
+ * constructor.  Per channel and frame, there is one real FFT, one pass
+ * calculating the magnitudes and one pass summing up the bands.  The
+ * magnitude pass has no dependencies between the bins, so the compiler may
+ * vectorize it.
+ *
+ ******************************************************************************/
+
+
+#include <sjbase/base.h>
+#include <sjmodules/vis/vis_spectrum.h>
+#include <math.h>
+
+
+SjVisSpectrum::SjVisSpectrum()
+{
+	m_fft = kiss_fftr_alloc(SJ_VIS_SPECTRUM_SAMPLES, 0, NULL, 0);
+
+	// the bins where the bands are centered and the gain of the bands
+	static const int analyzer[SJ_VIS_SPECTRUM_BANDS]  = {1,3,5,7,9,13,19,25,38,58,78,116,156,195,235,274,313,352,391,430};
+	static const int equalizer[SJ_VIS_SPECTRUM_BANDS] = {9,11,12,13,20,23,28,36,52,60,70,90,110,140,140,150,150,150,150,160};
+	#define SPECTRUM_AMPLITUDE 0.03
+
+	for( int b = 0; b < SJ_VIS_SPECTRUM_BANDS; b++ )
+	{
+		m_bandFrom[b] = b?                         analyzer[b-1]+(analyzer[b]  -analyzer[b-1])/2 : 0;
+		m_bandTo[b]   = b<SJ_VIS_SPECTRUM_BANDS-1? analyzer[b]  +(analyzer[b+1]-analyzer[b]  )/2 : SJ_VIS_SPECTRUM_BINS;
+
+		m_bandScale[b] = SPECTRUM_AMPLITUDE * ((double)equalizer[b]/100.0) * 3.0 / (double)(m_bandTo[b]-m_bandFrom[b]);
+	}
+}
+
+
+SjVisSpectrum::~SjVisSpectrum()
+{
+	kiss_fftr_free(m_fft);
+}
+
+
+void SjVisSpectrum::Calc(const signed short* buffer, double* retLeft, double* retRight)
+{
+	// split the channels and convert them to -1.0 - 1.0
+	kiss_fft_scalar in[2][SJ_VIS_SPECTRUM_SAMPLES];
+	const float     toFloat = 1.0F / (float)0x7FFF;
+	for( int i = 0; i < SJ_VIS_SPECTRUM_SAMPLES; i++ )
+	{
+		in[0][i] = (float)buffer[i*2  ] * toFloat;
+		in[1][i] = (float)buffer[i*2+1] * toFloat;
+	}
+
+	CalcChannel(in[0], retLeft);
+	CalcChannel(in[1], retRight);
+}
+
+
+void SjVisSpectrum::CalcChannel(const kiss_fft_scalar* in, double* ret)
+{
+	kiss_fft_cpx out[SJ_VIS_SPECTRUM_BINS+1];
+	float        mag[SJ_VIS_SPECTRUM_BINS];
+	int          i, b;
+
+	kiss_fftr(m_fft, in, out);
+
+	for( i = 0; i < SJ_VIS_SPECTRUM_BINS; i++ )
+	{
+		mag[i] = sqrtf(out[i].r*out[i].r + out[i].i*out[i].i);
+	}
+
+	for( b = 0; b < SJ_VIS_SPECTRUM_BANDS; b++ )
+	{
+		float sum = 0.0F;
+		for( i = m_bandFrom[b]; i < m_bandTo[b]; i++ )
+		{
+			sum += mag[i];
+		}
+
+		ret[b] = (double)sum * m_bandScale[b];
+		if( ret[b] > 1.0 )
+		{
+			ret[b] = 1.0;
+		}
+	}
+}
@@ -0,0 +1,64 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    vis_spectrum.h
+ * Authors: Björn Petersen
+ * Purpose: Calculate the spectrum bands for the visualizations
+ *
+ ******************************************************************************/
+
+
+#ifndef __SJ_VIS_SPECTRUM_H__
+#define __SJ_VIS_SPECTRUM_H__
+
+
+#include <kiss_fft/tools/kiss_fftr.h>
+
+
+#define SJ_VIS_SPECTRUM_SAMPLES 1152 // stereo samples needed for one calculation
+#define SJ_VIS_SPECTRUM_BINS    (SJ_VIS_SPECTRUM_SAMPLES/2)
+#define SJ_VIS_SPECTRUM_BANDS   20
+
+
+class SjVisSpectrum
+{
+public:
+	                SjVisSpectrum       ();
+	                ~SjVisSpectrum      ();
+
+	// buffer must contain SJ_VIS_SPECTRUM_SAMPLES interleaved stereo samples
+	// with 16 bit; the values of the SJ_VIS_SPECTRUM_BANDS bands are written
+	// to retLeft and retRight in the range 0.0 - 1.0
+	void            Calc                (const signed short* buffer, double* retLeft, double* retRight);
+
+private:
+	kiss_fftr_cfg   m_fft;
+
+	// the bins of a band are adjacent, the scale includes the equalizer
+	int             m_bandFrom[SJ_VIS_SPECTRUM_BANDS];
+	int             m_bandTo[SJ_VIS_SPECTRUM_BANDS];
+	double          m_bandScale[SJ_VIS_SPECTRUM_BANDS];
+
+	void            CalcChannel         (const kiss_fft_scalar* in, double* ret);
+};
+
+
+#endif // __SJ_VIS_SPECTRUM_H__
@@ -51,6 +51,7 @@ public:
 		m_pageStartMs   = wordSingMs;
 		m_isStaticPage  = 0;
 		m_colour        = NULL;
+		m_drawnColour   = NULL;
 		m_lineWordCount = 1; // makes adding static frames easied, else set in Finalize()
 	}
 
@@ -76,6 +77,7 @@ public:
 
 	// drawing information, may be used by derived classes or by the user
 	wxColour*       m_colour; // NULL: don't draw
+	wxColour*       m_drawnColour; // the colour used on the last drawing, allows change-only updates
 	wxCoord         m_pixelW;
 };
 
@@ -56,6 +56,7 @@ SjSyncTxtReader::SjSyncTxtReader(wxFSFile* fsFile, SjSyncTxtFormat format,
 	}
 
 	m_raw->Finalize();
+	BuildPageIndex();
 
 	// allocate some drawing objects
 	m_font = wxFont(10/*recalculated later*/, wxFONTFAMILY_SWISS, wxNORMAL/*style*/, wxBOLD/*weight*/, false/*underline*/);
@@ -90,71 +91,114 @@ SjSyncTxtReader::~SjSyncTxtReader()
  ******************************************************************************/
 
 
+void SjSyncTxtReader::BuildPageIndex()
+{
+	long wordIndex, wCount = m_raw->m_words.GetCount(), lastMs = 0;
+
+	m_pageStarts.Empty();
+	m_pageStartsMs.Empty();
+	for( wordIndex = 0; wordIndex < wCount; wordIndex++ )
+	{
+		SjSyncTxtWord& word = m_raw->m_words[wordIndex];
+		if( wordIndex == 0 || word.m_isPageStart )
+		{
+			// the first page is always used if no other page matches; for all
+			// other pages, a page is only reached if all previous pages are reached
+			if( wordIndex == 0 )
+				lastMs = -0x7FFFFFFFL;
+			else if( word.m_pageStartMs > lastMs )
+				lastMs = word.m_pageStartMs;
+
+			m_pageStarts.Add(wordIndex);
+			m_pageStartsMs.Add(lastMs);
+		}
+	}
+}
+
+
+long SjSyncTxtReader::FindPageStart(long ms) const
+{
+	// find the last page starting at or before the given time
+	long lo = 0, hi = (long)m_pageStarts.GetCount()-1, mid, found = 0;
+	while( lo <= hi )
+	{
+		mid = (lo + hi) / 2;
+		if( m_pageStartsMs[mid] <= ms )
+		{
+			found = mid;
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid - 1;
+		}
+	}
+
+	return m_pageStarts.IsEmpty()? 0 : m_pageStarts[found];
+}
+
+
 bool SjSyncTxtReader::SetPosition(long ms)
 {
-	// rewind?
-	if( ms < m_currMs )
+	// going back? words may be uncoloured, which needs a complete redraw
+	bool goingBack = (ms < m_currMs);
+	if( goingBack )
 	{
-		m_currMs = 0;
-		m_currPageStart = 0;
-		m_currWord = 0;
-		m_currWord2 = 0;
 		m_updateAll = true;
 		m_updateSth = true;
 	}
-	else
-	{
-		m_currMs = ms;
-	}
+	m_currMs = ms;
 
-	// current page changed?
-	long wordIndex, wCount = m_raw->m_words.GetCount();
-	for( wordIndex = m_currPageStart+1; wordIndex < wCount; wordIndex++ )
+	// current page changed? this works in both directions
+	long newPageStart = FindPageStart(ms);
+	if( newPageStart != m_currPageStart )
 	{
-		SjSyncTxtWord& word = m_raw->m_words[wordIndex];
-		if( word.m_isPageStart )
-		{
-			if( ms >= word.m_pageStartMs )
-			{
-				m_currPageStart = wordIndex;
-				m_updateAll = true;
-				m_updateSth = true;
-			}
-			else
-			{
-				break;
-			}
-		}
+		m_currPageStart = newPageStart;
+		m_updateAll = true;
+		m_updateSth = true;
 	}
 
-	// check all timing information
-	// (this cannot be combined with the loop above as the prior may change m_currPageStart)
+	// check all timing information of the page; colours are only modified if they change
+	long wordIndex;
 	long newWord = m_currWord;
 	long newWord2 = m_currWord2;
+	if( goingBack )
+	{
+		// the words after the new position are no longer sung, start over at the page
+		newWord = m_currPageStart;
+		newWord2 = m_currPageStart;
+	}
 	long currPageEnd = (m_currPageStart + m_raw->m_words[m_currPageStart].m_pageWordCount) - 1;
 	int isStaticPage = m_raw->m_words[m_currPageStart].m_isStaticPage;
 	long currPageStartMs = m_raw->m_words[m_currPageStart].m_pageStartMs;
 	long chars = 0;
+	wxColour* colour;
 #define CHARS_MS 6
 	for( wordIndex = m_currPageStart; wordIndex <= currPageEnd; wordIndex++ )
 	{
 		SjSyncTxtWord& word = m_raw->m_words[wordIndex];
 		chars += word.m_word.Len();
 
-		word.m_colour = NULL;
+		colour = NULL;
 		if( ms >= word.m_wordSingMs || isStaticPage )
 		{
-			word.m_colour = isStaticPage == 2? &m_colourStatic : &m_colourSung;
+			colour = isStaticPage == 2? &m_colourStatic : &m_colourSung;
 			newWord = wordIndex;
 		}
 		else
 		{
 			if( ms > currPageStartMs+chars*CHARS_MS )
 			{
-				word.m_colour = &m_colourUpcoming;
+				colour = &m_colourUpcoming;
 				newWord2 = wordIndex;
 			}
 		}
+
+		if( word.m_colour != colour )
+		{
+			word.m_colour = colour;
+			m_updateSth = true;
+		}
 	}
 
 	if( newWord != m_currWord
@@ -213,6 +257,7 @@ void SjSyncTxtReader::Render(wxDC& dc, SjVisBg& bg, bool pleaseUpdateAll)
 			wxCoord fontPtSize = SjVisBg::SetFontPixelH(dc, m_font, fontPixelH);
 			m_fontSmall.SetPointSize((wxCoord)((float)fontPtSize*0.6F));
 			m_fontPixelH = fontPixelH;
+			pleaseUpdateAll = true; // the word widths must be recalculated
 		}
 
 		dc.SetFont(isStaticPage==1? m_fontSmall : m_font);
@@ -257,13 +302,16 @@ void SjSyncTxtReader::Render(wxDC& dc, SjVisBg& bg, bool pleaseUpdateAll)
 	     currPageEnd = (m_currPageStart + m_raw->m_words[m_currPageStart].m_pageWordCount) - 1;
 	while( 1 )
 	{
-		// calculate the width of the line
+		// calculate the width of the line; the widths only change if the font changes
 		lineW = 0;
 		lineEndIndex = (lineStartIndex + m_raw->m_words[lineStartIndex].m_lineWordCount) - 1;
 		for( wordIndex = lineStartIndex; wordIndex <= lineEndIndex; wordIndex++ )
 		{
 			SjSyncTxtWord& word = m_raw->m_words[wordIndex];
-			dc.GetTextExtent(word.m_word, &word.m_pixelW, &dummy);
+			if( pleaseUpdateAll )
+			{
+				dc.GetTextExtent(word.m_word, &word.m_pixelW, &dummy);
+			}
 			lineW += word.m_pixelW;
 		}
 
@@ -280,7 +328,8 @@ void SjSyncTxtReader::Render(wxDC& dc, SjVisBg& bg, bool pleaseUpdateAll)
 		{
 			SjSyncTxtWord& word = m_raw->m_words[wordIndex];
 
-			if( word.m_colour )
+			if( word.m_colour
+			 && (pleaseUpdateAll || word.m_colour != word.m_drawnColour) )
 			{
 				// draw shadow
 				if( pleaseUpdateAll || word.m_colour == &m_colourUpcoming )
@@ -293,6 +342,7 @@ void SjSyncTxtReader::Render(wxDC& dc, SjVisBg& bg, bool pleaseUpdateAll)
 				dc.SetTextForeground(*word.m_colour);
 				dc.DrawText(word.m_word, lineX, lineY);
 			}
+			word.m_drawnColour = word.m_colour;
 
 			lineX += word.m_pixelW;
 		}
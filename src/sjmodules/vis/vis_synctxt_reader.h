@@ -69,6 +69,13 @@ private:
 	long            m_currPageStart; // index in the word list
 	long            m_currMs;
 	long            m_currWord, m_currWord2;
+
+	// seeking index: the word indices of all page starts and the times the
+	// pages start; the times are made non-decreasing for the binary search
+	wxArrayLong     m_pageStarts;
+	wxArrayLong     m_pageStartsMs;
+	void            BuildPageIndex      ();
+	long            FindPageStart       (long ms) const;
 };
 
 
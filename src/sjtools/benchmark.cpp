@@ -0,0 +1,607 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    benchmark.cpp
+ * Authors: Björn Petersen
+ * Purpose: Measure some hot paths on synthetic data
+ *
+ *******************************************************************************
+ *
+ * All fixtures are created from fixed seeds, so the results of different
+ * versions are comparable.  The benchmarks are run by the separate program
+ * "sjbenchmark" that needs no display; the user's configuration and library
+ * are never touched, the library benchmarks use the real library module on
+ * a temporary jukebox file, filled by a synthetic scanner module.
+ *
+ * The results are written as tab-separated lines:
+ *     <name> <iterations> <total microseconds> <microseconds per iteration>
+ * lines starting with "#" are comments, they also report the number of
+ * results found, which should be the same for comparable runs.
+ *
+ ******************************************************************************/
+
+
+#include <sjbase/base.h>
+#include <sjtools/benchmark.h>
+#include <sjtools/imgop.h>
+#include <sjtools/volumecalc.h>
+#include <sjmodules/library.h>
+#include <sjmodules/advsearch.h>
+#include <sjmodules/fx/eq_equalizer.h>
+#include <sjmodules/vis/vis_spectrum.h>
+#include <tagger/tg_a_tagger_frontend.h>
+#include <see_dom/sj_see.h>
+#include <math.h>
+
+
+static wxString s_results;
+
+
+static void Report(const wxString& name, long iterations, wxLongLong us)
+{
+	double usTotal = us.ToDouble();
+	s_results += wxString::Format(wxT("%s\t%i\t%.0f\t%.3f\n"),
+	                              name.c_str(), (int)iterations, usTotal, iterations>0? usTotal/(double)iterations : 0.0);
+}
+
+
+static void ReportCount(const wxString& name, long count)
+{
+	s_results += wxString::Format(wxT("# %s\t%i results\n"), name.c_str(), (int)count);
+}
+
+
+static wxString GetBenchmarkFilePath(const wxString& fileName)
+{
+	wxString test = wxFileName::CreateTempFileName(wxT("tmp"));
+	::wxRemoveFile(test);
+
+	wxFileName fn(test);
+	fn.SetFullName(fileName);
+	return fn.GetLongPath();
+}
+
+
+static wxString GetSyntheticName(unsigned long& seed, const wxChar* prefix)
+{
+	// a simple LCG, we want the same names on all systems and on all runs
+	static const wxChar* syllables[] = { wxT("ka"), wxT("lo"), wxT("mi"), wxT("ne"), wxT("\x00E4r"), wxT("tu"), wxT("sch"), wxT("be"), wxT("ro"), wxT("\x00F6n") };
+	wxString ret(prefix);
+	seed = seed * 1103515245UL + 12345UL;
+	int count = 2 + (int)((seed>>16) % 4);
+	for( int i = 0; i < count; i++ )
+	{
+		seed = seed * 1103515245UL + 12345UL;
+		ret += syllables[(seed>>16) % 10];
+	}
+	return ret;
+}
+
+
+/*******************************************************************************
+ * The Single Benchmarks
+ ******************************************************************************/
+
+
+static void BenchHash()
+{
+	#define HASH_N 200000
+	wxStopWatch sw;
+
+	{
+		SjLLHash hash;
+		sw.Start();
+		for( long i = 1; i <= HASH_N; i++ ) { hash.Insert(i*7919, i); }
+		Report(wxT("sjhash.long.insert"), HASH_N, sw.TimeInMicro());
+
+		long found = 0;
+		sw.Start();
+		for( long i = 1; i <= HASH_N; i++ ) { if( hash.Lookup(i*7919) ) found++; }
+		Report(wxT("sjhash.long.lookup"), HASH_N, sw.TimeInMicro());
+		wxASSERT( found == HASH_N );
+	}
+
+	{
+		wxArrayString keys;
+		unsigned long seed = 1;
+		for( long i = 0; i < HASH_N/4; i++ ) { keys.Add(GetSyntheticName(seed, wxT("file:///music/")) + wxString::Format(wxT("/%i.mp3"), (int)i)); }
+
+		SjSLHash hash;
+		sw.Start();
+		for( long i = 0; i < HASH_N/4; i++ ) { hash.Insert(keys[i], i+1); }
+		Report(wxT("sjhash.string.insert"), HASH_N/4, sw.TimeInMicro());
+
+		sw.Start();
+		for( long i = 0; i < HASH_N/4; i++ ) { hash.Lookup(keys[i]); }
+		Report(wxT("sjhash.string.lookup"), HASH_N/4, sw.TimeInMicro());
+	}
+}
+
+
+static void BenchNormalise()
+{
+	// used for sorting, album combining and searching
+	#define NORM_N 50000
+	wxArrayString names;
+	unsigned long seed = 2;
+	for( long i = 0; i < NORM_N; i++ ) { names.Add(GetSyntheticName(seed, wxT("The "))); }
+
+	wxStopWatch sw;
+	for( long i = 0; i < NORM_N; i++ ) { SjNormaliseString(names[i], SJ_NUM_SORTABLE); }
+	Report(wxT("normalise.string"), NORM_N, sw.TimeInMicro());
+}
+
+
+static void BenchImgOp()
+{
+	// a synthetic "cover" with a gradient
+	#define IMG_WH 600
+	wxImage orgImage(IMG_WH, IMG_WH);
+	unsigned char* data = orgImage.GetData();
+	for( int y = 0; y < IMG_WH; y++ )
+	{
+		for( int x = 0; x < IMG_WH; x++ )
+		{
+			*data++ = (unsigned char)x;
+			*data++ = (unsigned char)y;
+			*data++ = (unsigned char)(x^y);
+		}
+	}
+
+	#define IMG_N 10
+	wxStopWatch sw;
+	long i;
+
+	sw.Start();
+	for( i = 0; i < IMG_N; i++ ) { wxImage img(orgImage.Copy()); SjImgOp::DoResize(img, 128, 128, SJ_IMGOP_SMOOTH); }
+	Report(wxT("imgop.resize.smooth"), IMG_N, sw.TimeInMicro());
+
+	sw.Start();
+	for( i = 0; i < IMG_N; i++ ) { wxImage img(orgImage.Copy()); SjImgOp::DoResize(img, 128, 128, 0); }
+	Report(wxT("imgop.resize.fast"), IMG_N, sw.TimeInMicro());
+
+	sw.Start();
+	for( i = 0; i < IMG_N; i++ ) { wxImage img(orgImage.Copy()); SjImgOp::DoGrayscale(img); }
+	Report(wxT("imgop.grayscale"), IMG_N, sw.TimeInMicro());
+
+	sw.Start();
+	for( i = 0; i < IMG_N; i++ ) { wxImage img(orgImage.Copy()); SjImgOp::DoContrast(img, 30, 20); }
+	Report(wxT("imgop.contrast"), IMG_N, sw.TimeInMicro());
+
+	sw.Start();
+	for( i = 0; i < IMG_N; i++ ) { wxImage img(orgImage.Copy()); SjImgOp::DoAddBorder(img, 4); }
+	Report(wxT("imgop.border"), IMG_N, sw.TimeInMicro());
+}
+
+
+static void BenchDsp()
+{
+	// the same steps as done in SjPlayer_BackendCallback() on 60 seconds of stereo audio
+	#define DSP_RATE     44100
+	#define DSP_CH       2
+	#define DSP_SECONDS  60
+	#define DSP_CHUNK    4096 // samples per callback
+	long    totalSamples = DSP_RATE*DSP_SECONDS*DSP_CH;
+	float*  org = (float*)malloc(totalSamples*sizeof(float));
+	float*  buffer = (float*)malloc(DSP_CHUNK*sizeof(float));
+	if( org == NULL || buffer == NULL ) { free(org); free(buffer); return; }
+	for( long i = 0; i < totalSamples; i++ ) { org[i] = (float)(0.5*sin((double)(i/DSP_CH)*0.0627)); }
+
+	SjEqParam eqParam;
+	for( int b = 0; b < SJ_EQ_BANDS; b++ ) { eqParam.m_bandDb[b] = (float)((b%5)-2) * 3.0F; }
+
+	SjVolumeCalc volumeCalc;
+	SjEqualizer  equalizer;
+	equalizer.SetParam(true, eqParam);
+
+	wxStopWatch sw;
+	long callbacks = 0;
+	for( long i = 0; i + DSP_CHUNK <= totalSamples; i += DSP_CHUNK )
+	{
+		memcpy(buffer, org+i, DSP_CHUNK*sizeof(float));
+		volumeCalc.AddBuffer(buffer, DSP_CHUNK*sizeof(float), DSP_RATE, DSP_CH);
+		volumeCalc.AdjustBuffer(buffer, DSP_CHUNK*sizeof(float), 1.0F, 5.0F);
+		equalizer.AdjustBuffer(buffer, DSP_CHUNK*sizeof(float), DSP_RATE, DSP_CH);
+		SjApplyVolume(buffer, DSP_CHUNK*sizeof(float), 0.8F);
+		callbacks++;
+	}
+	Report(wxT("dsp.callback"), callbacks, sw.TimeInMicro());
+
+	free(org);
+	free(buffer);
+
+	// the spectrum bands as calculated for each frame of the oscilloscope
+	#define SPECTRUM_N   2000
+	signed short* samples = (signed short*)malloc(SJ_VIS_SPECTRUM_SAMPLES*DSP_CH*sizeof(signed short));
+	if( samples == NULL ) { return; }
+	unsigned long seed = 0x5EED;
+	for( long i = 0; i < SJ_VIS_SPECTRUM_SAMPLES*DSP_CH; i++ )
+	{
+		seed = seed*1103515245 + 12345;
+		samples[i] = (signed short)(12000.0*sin((double)(i/DSP_CH)*0.0627) + (double)((seed>>16)&0x0FFF) - 2048.0);
+	}
+
+	SjVisSpectrum spectrum;
+	double left[SJ_VIS_SPECTRUM_BANDS], right[SJ_VIS_SPECTRUM_BANDS];
+	sw.Start();
+	for( long i = 0; i < SPECTRUM_N; i++ )
+	{
+		spectrum.Calc(samples, left, right);
+	}
+	Report(wxT("dsp.spectrum"), SPECTRUM_N, sw.TimeInMicro());
+
+	free(samples);
+}
+
+
+static void BenchTagger()
+{
+	// create a small MPEG file: silent frames of 128 kbit/s, 44.1 kHz, followed by tags
+	#define TAGGER_FRAMES 200
+	#define TAGGER_N      200
+	wxString path = GetBenchmarkFilePath(wxT("sjbenchmark.mp3"));
+	{
+		wxFile f;
+		if( !f.Create(path, TRUE) ) { return; }
+		unsigned char frame[417];
+		memset(frame, 0, sizeof(frame));
+		frame[0] = 0xFF; frame[1] = 0xFB; frame[2] = 0x90; frame[3] = 0x64;
+		for( int i = 0; i < TAGGER_FRAMES; i++ ) { f.Write(frame, sizeof(frame)); }
+	}
+
+	wxString url = wxFileSystem::FileNameToURL(wxFileName(path));
+	{
+		SjTrackInfo ti;
+		ti.m_trackName      = wxT("Benchmark Track");
+		ti.m_leadArtistName = wxT("Benchmark Artist");
+		ti.m_albumName      = wxT("Benchmark Album");
+		ti.m_genreName      = wxT("Rock");
+		ti.m_trackNr        = 1;
+		ti.m_year           = 2015;
+		SjSetTrackInfoToID3Etc(url, ti);
+	}
+
+	wxFileSystem fs;
+	long ok = 0;
+	wxStopWatch sw;
+	for( long i = 0; i < TAGGER_N; i++ )
+	{
+		wxFSFile* fsFile = fs.OpenFile(url, wxFS_READ|wxFS_SEEKABLE);
+		if( fsFile )
+		{
+			SjTrackInfo ti;
+			if( SjGetTrackInfoFromID3Etc(fsFile, ti, SJ_TI_FULLINFO) == SJ_SUCCESS ) { ok++; }
+			delete fsFile;
+		}
+	}
+	Report(wxT("tagger.read"), TAGGER_N, sw.TimeInMicro());
+
+	if( ok != TAGGER_N ) {
+		wxLogWarning(wxT("Benchmark: Cannot read the tags of %s."), path.c_str());
+	}
+	::wxRemoveFile(path);
+}
+
+
+static void BenchPlaylist()
+{
+	// write large playlists in the supported formats and import them
+	#define PLAYLIST_N 200000
+	static const wxChar* formats[] = { wxT("m3u"), wxT("pls"), wxT("xspf"), wxT("xml"), NULL };
+	for( int f = 0; formats[f]; f++ )
+	{
+		wxString ext = formats[f];
+		long n = ext == wxT("pls")? 0xFFFFL : PLAYLIST_N; // pls files are limited to 65535 entries
+		wxString path = GetBenchmarkFilePath(wxT("sjbenchmark.") + ext);
+		{
+			wxFile file;
+			if( !file.Create(path, TRUE) ) { return; }
+
+			wxString chunk;
+			unsigned long seed = 3;
+			     if( ext == wxT("pls") )  { chunk = wxT("[playlist]\n"); }
+			else if( ext == wxT("xspf") ) { chunk = wxT("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<playlist version=\"1\" xmlns=\"http://xspf.org/ns/0/\">\n<trackList>\n"); }
+			else if( ext == wxT("xml") )  { chunk = wxT("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<plist version=\"1.0\">\n<dict>\n<key>Tracks</key>\n<dict>\n"); }
+			for( long i = 0; i < n; i++ )
+			{
+				wxString artist = GetSyntheticName(seed, wxT("")), title = GetSyntheticName(seed, wxT(""));
+				wxString url = wxString::Format(wxT("/music/%s/%i %s.mp3"), artist.c_str(), (int)i, title.c_str());
+				if( ext == wxT("m3u") ) {
+					chunk += wxT("#EXTINF:180,") + artist + wxT(" - ") + title + wxT("\n") + url + wxT("\n");
+				}
+				else if( ext == wxT("pls") ) {
+					chunk += wxString::Format(wxT("File%i="), (int)(i+1)) + url + wxString::Format(wxT("\nTitle%i="), (int)(i+1)) + artist + wxT(" - ") + title + wxT("\n");
+				}
+				else if( ext == wxT("xspf") ) {
+					chunk += wxT("\t<track>\n\t\t<location>file://") + url + wxT("</location>\n\t\t<title>") + title + wxT("</title>\n\t\t<creator>") + artist + wxT("</creator>\n\t</track>\n");
+				}
+				else {
+					chunk += wxString::Format(wxT("<key>%i</key>\n<dict>\n\t<key>Track ID</key><integer>%i</integer>\n"), (int)i, (int)i)
+					       + wxT("\t<key>Name</key><string>") + title + wxT("</string>\n\t<key>Artist</key><string>") + artist
+					       + wxT("</string>\n\t<key>Location</key><string>file://localhost") + url + wxT("</string>\n</dict>\n");
+				}
+
+				if( chunk.Len() > 0x10000 ) { file.Write(chunk, wxConvUTF8); chunk.Clear(); }
+			}
+			     if( ext == wxT("xspf") ) { chunk += wxT("</trackList>\n</playlist>\n"); }
+			else if( ext == wxT("xml") )  { chunk += wxT("</dict>\n</dict>\n</plist>\n"); }
+			file.Write(chunk, wxConvUTF8);
+		}
+
+		SjPlaylist playlist;
+		wxStopWatch sw;
+		playlist.AddFromFile(path);
+		Report(wxT("playlist.import.") + ext, n, sw.TimeInMicro());
+
+		if( playlist.GetCount() != n ) {
+			wxLogWarning(wxT("Benchmark: %i of %i tracks read from %s."), (int)playlist.GetCount(), (int)n, path.c_str());
+		}
+		::wxRemoveFile(path);
+	}
+}
+
+
+/*******************************************************************************
+ * The Library Benchmarks
+ ******************************************************************************/
+
+
+#define LIB_N        10000
+#define LIB_URL      wxT("file:///music/")
+
+
+class SjBenchmarkScanner : public SjScannerModule
+{
+public:
+	// a scanner that delivers LIB_N synthetic tracks the same way as the
+	// folder scanner does, but without touching the file system
+	                SjBenchmarkScanner  (SjInterfaceBase* interf) : SjScannerModule(interf)
+	{
+		m_file          = wxT("memory:benchmarkscanner.lib");
+		m_name          = wxT("Benchmark scanner");
+		m_modifiedEvery = 0;
+		m_modifiedCrc   = 0;
+	}
+	long            GetSourceCount      () { return 1; }
+	wxString        GetSourceUrl        (long index) { return LIB_URL; }
+	wxString        GetSourceNotes      (long index) { return wxT(""); }
+	SjIcon          GetSourceIcon       (long index) { return SJ_ICON_MUSIC_FOLDER; }
+	long            AddSources          (int sourceType, wxWindow* parent) { return -1; }
+	bool            DeleteSource        (long index, wxWindow* parent) { return FALSE; }
+	bool            ConfigSource        (long index, wxWindow* parent) { return FALSE; }
+	bool            SetTrackInfo        (const wxString& url, SjTrackInfo&) { return FALSE; }
+	bool            IsMyUrl             (const wxString& url) { return url.StartsWith(LIB_URL); }
+	bool            IterateTrackInfo    (SjColModule* receiver);
+
+	// every m_modifiedEvery-th track gets another CRC, 0=no changes
+	long            m_modifiedEvery;
+	long            m_modifiedCrc;
+};
+
+
+bool SjBenchmarkScanner::IterateTrackInfo(SjColModule* receiver)
+{
+	unsigned long seed = 3;
+	for( long i = 0; i < LIB_N; i++ )
+	{
+		// the names are always created to keep the seed in sync
+		wxString url    = wxString::Format(LIB_URL wxT("%i.mp3"), (int)i);
+		wxString track  = GetSyntheticName(seed, wxT(""));
+		wxString artist = GetSyntheticName(seed, wxT(""));
+		wxString album  = GetSyntheticName(seed, wxT(""));
+		uint32_t crc    = (uint32_t)i + ((m_modifiedEvery && (i%m_modifiedEvery)==0)? m_modifiedCrc : 0);
+
+		if( !receiver->Callback_CheckTrackInfo(url, crc) )
+		{
+			SjTrackInfo* ti = new SjTrackInfo;
+			ti->m_url            = url;
+			ti->m_updatecrc      = crc;
+			ti->m_trackName      = track;
+			ti->m_leadArtistName = artist.Left(3); // some artists with many albums
+			ti->m_albumName      = album;
+			ti->m_genreName      = (i%3)? wxT("Rock") : wxT("Pop");
+			ti->m_trackNr        = (i%12) + 1;
+			ti->m_year           = 1960 + (i%50);
+			ti->m_playtimeMs     = 180000;
+			if( !receiver->Callback_ReceiveTrackInfo(ti) )
+			{
+				return FALSE;
+			}
+		}
+	}
+	return TRUE;
+}
+
+
+class SjBenchmarkInterface : public SjInterfaceBase
+{
+public:
+	                SjBenchmarkInterface() : SjInterfaceBase(wxT("Benchmark")) { }
+	void            LoadModules         (SjModuleList& list)
+	{
+		list.Append(new SjLibraryModule   (this));
+		list.Append(new SjAdvSearchModule (this));
+		list.Append(new SjBenchmarkScanner(this));
+	}
+
+	// a friend of SjLibraryModule, so that the single steps can be measured
+	static void     BenchLibrary        (SjModuleSystem*);
+};
+
+
+void SjBenchmarkInterface::BenchLibrary(SjModuleSystem* moduleSystem)
+{
+	SjLibraryModule*    library = (SjLibraryModule*)moduleSystem->FindModuleByFile(wxT("memory:library.lib"));
+	SjBenchmarkScanner* scanner = (SjBenchmarkScanner*)moduleSystem->FindModuleByFile(wxT("memory:benchmarkscanner.lib"));
+	SjModule*           advSearch = moduleSystem->FindModuleByFile(wxT("memory:advsearch.lib"));
+	if( library == NULL || scanner == NULL || advSearch == NULL
+	 || !library->Load() || !advSearch->Load() )
+	{
+		wxLogError(wxT("Benchmark: Cannot load the library."));
+		return;
+	}
+
+	// "update music library" as done by the user: first all tracks are new,
+	// then nothing has changed, then every tenth track is modified
+	wxStopWatch sw;
+	library->UpdateAllCol(NULL, FALSE);
+	Report(wxT("library.update.new"), LIB_N, sw.TimeInMicro());
+	ReportCount(wxT("library.update.new"), library->GetUnmaskedTrackCount());
+
+	sw.Start();
+	library->UpdateAllCol(NULL, FALSE);
+	Report(wxT("library.update.unchanged"), LIB_N, sw.TimeInMicro());
+
+	scanner->m_modifiedEvery = 10;
+	scanner->m_modifiedCrc   = LIB_N;
+	sw.Start();
+	library->UpdateAllCol(NULL, FALSE);
+	Report(wxT("library.update.modified"), LIB_N, sw.TimeInMicro());
+
+	// the last step of each update
+	sw.Start();
+	library->CombineTracksToAlbums();
+	Report(wxT("library.combine"), LIB_N, sw.TimeInMicro());
+	ReportCount(wxT("library.combine"), library->GetUnmaskedColCount());
+
+	// the searches as typed into the search field and as defined by music selections
+	#define SEARCH_N 20
+	static const wxChar* words[SEARCH_N] = { wxT("ka"), wxT("lomi"), wxT("sch"), wxT("ne"), wxT("tu"), wxT("bero"), wxT("mika"), wxT("x"), wxT("roro"), wxT("\x00E4rka"),
+	                                         wxT("kalo"), wxT("nemi"), wxT("tusch"), wxT("beka"), wxT("lolo"), wxT("mimi"), wxT("z"), wxT("rone"), wxT("sch\x00F6n"), wxT("kakaka") };
+	long i, hits = 0;
+	sw.Start();
+	for( i = 0; i < SEARCH_N; i++ )
+	{
+		hits += library->SetSearch(SjSearch(words[i]), TRUE).m_totalResultCount;
+	}
+	Report(wxT("library.search.simple"), SEARCH_N, sw.TimeInMicro());
+	ReportCount(wxT("library.search.simple"), hits);
+
+	hits = 0;
+	sw.Start();
+	for( i = 0; i < SEARCH_N; i++ )
+	{
+		SjSearch search;
+		search.m_adv.AddRule(SJ_FIELD_YEAR, SJ_FIELDOP_IS_IN_RANGE, wxString::Format(wxT("%i"), (int)(1960+i)), wxString::Format(wxT("%i"), (int)(1970+i)));
+		search.m_adv.AddRule(SJ_FIELD_GENRENAME, SJ_FIELDOP_IS_EQUAL_TO, wxT("Rock"));
+		hits += library->SetSearch(search, TRUE).m_totalResultCount;
+	}
+	Report(wxT("library.search.advanced"), SEARCH_N, sw.TimeInMicro());
+	ReportCount(wxT("library.search.advanced"), hits);
+
+	// the "is similar to" rule of the advanced search
+	hits = 0;
+	sw.Start();
+	for( i = 0; i < SEARCH_N; i++ )
+	{
+		SjSearch search;
+		search.m_adv.AddRule(SJ_FIELD_LEADARTISTNAME, SJ_FIELDOP_IS_SIMELAR_TO, words[i]);
+		hits += library->SetSearch(search, TRUE).m_totalResultCount;
+	}
+	Report(wxT("library.search.simelar"), SEARCH_N, sw.TimeInMicro());
+	ReportCount(wxT("library.search.simelar"), hits);
+
+	library->SetSearch(SjSearch(), FALSE);
+}
+
+
+#if SJ_USE_SCRIPTS
+static void BenchScript()
+{
+	// a typical skin handler; Execute() parses the script on each call,
+	// ExecuteAsFunction() compiles it once and calls the cached function object
+	#define SCRIPT_N 20000
+	wxString script = wxT("var s = 0; for( var i = 0; i < 20; i++ ) { s += i; }");
+	bool ok = true;
+	wxStopWatch sw;
+
+	{
+		SjSee see;
+		see.SetExecutionScope(wxT("benchmark"));
+		see.Execute(wxT("")); // initialise the interpreter outside of the measurement
+		sw.Start();
+		for( long i = 0; i < SCRIPT_N; i++ ) { if( !see.Execute(script) ) ok = false; }
+		Report(wxT("see.execute"), SCRIPT_N, sw.TimeInMicro());
+	}
+
+	{
+		SjSee see;
+		see.SetExecutionScope(wxT("benchmark"));
+		see.Execute(wxT(""));
+		sw.Start();
+		for( long i = 0; i < SCRIPT_N; i++ ) { if( !see.ExecuteAsFunction(script) ) ok = false; }
+		Report(wxT("see.function.cached"), SCRIPT_N, sw.TimeInMicro());
+	}
+
+	wxASSERT( ok );
+}
+#endif
+
+
+/*******************************************************************************
+ * Run them all
+ ******************************************************************************/
+
+
+void SjBenchmark1(const wxString& resultFile)
+{
+	wxASSERT( g_tools ); // with a temporary configuration and jukebox file, see benchmark_app.cpp
+	wxLogInfo(wxT("Benchmark: Running ..."));
+
+	s_results = wxString::Format(wxT("# %s %i.%i.%i benchmark\n# name\titerations\ttotal_us\tus_per_iteration\n"),
+	                             SJ_PROGRAM_NAME, (int)SJ_VERSION_MAJOR, (int)SJ_VERSION_MINOR, (int)SJ_VERSION_REVISION);
+
+	BenchHash();
+	BenchNormalise();
+	BenchImgOp();
+	BenchDsp();
+	BenchTagger();
+	BenchPlaylist();
+#if SJ_USE_SCRIPTS
+	BenchScript();
+#endif
+
+	{
+		SjModuleSystem moduleSystem;
+		moduleSystem.Init(); // opens the jukebox file
+		moduleSystem.AddInterface(new SjBenchmarkInterface());
+		moduleSystem.LoadModules();
+
+		SjBenchmarkInterface::BenchLibrary(&moduleSystem);
+
+		moduleSystem.Exit();
+		delete SjModuleSystem::s_delayedDbDelete;
+		SjModuleSystem::s_delayedDbDelete = NULL;
+	}
+
+	wxFile f;
+	if( f.Create(resultFile, TRUE/*overwrite*/) )
+	{
+		f.Write(s_results, wxConvUTF8);
+		wxLogInfo(wxT("Benchmark: Done, results written to %s."), resultFile.c_str());
+	}
+	else
+	{
+		wxLogError(wxT("Benchmark: Cannot write %s."), resultFile.c_str());
+	}
+
+	s_results.Clear();
+}
@@ -0,0 +1,41 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    benchmark.h
+ * Authors: Björn Petersen
+ * Purpose: Measure some hot paths on synthetic data
+ *
+ ******************************************************************************/
+
+
+
+#ifndef __SJ_BENCHMARK_H__
+#define __SJ_BENCHMARK_H__
+
+
+// run all benchmarks and write the results as tab-separated lines to the
+// given file; this is done by the separate program "sjbenchmark", see
+// benchmark_app.cpp.
+void SjBenchmark1 (const wxString& resultFile);
+
+
+
+#endif // __SJ_BENCHMARK_H__
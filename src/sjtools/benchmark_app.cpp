@@ -0,0 +1,99 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2015 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *
+ * File:    benchmark_app.cpp
+ * Authors: Björn Petersen
+ * Purpose: The benchmark program
+ *
+ *******************************************************************************
+ *
+ * "sjbenchmark" is built from the same sources as Silverjuke (with
+ * SJ_BENCHMARK_APP set, so that SjMainApp is not the entry point) but runs
+ * as a console program without a display; it is not built by default:
+ *
+ *     make sjbenchmark
+ *     sjbenchmark <result file>
+ *
+ * Configuration and jukebox are temporary files, given to SjTools the same
+ * way as the command line options --ini and --jukebox of Silverjuke.
+ *
+ ******************************************************************************/
+
+
+#include <sjbase/base.h>
+#include <sjtools/benchmark.h>
+
+
+class SjBenchmarkApp : public wxAppConsole
+{
+public:
+	int             OnRun               ();
+};
+
+
+IMPLEMENT_APP_CONSOLE(SjBenchmarkApp)
+
+
+int SjBenchmarkApp::OnRun()
+{
+	if( argc != 2 )
+	{
+		wxPrintf(wxT("Usage: sjbenchmark <result file>\n"));
+		return 1;
+	}
+	wxString resultFile = argv[1];
+
+	SetAppName(SJ_PROGRAM_NAME);
+	wxLog::SetVerbose(true); // show the progress written by wxLogInfo()
+
+	// temporary configuration and jukebox files, the user's files are never touched
+	wxString iniFile = wxFileName::CreateTempFileName(wxT("sjbenchmark"));
+	wxString dbFile  = iniFile + wxT(".jukebox");
+	::wxRemoveFile(dbFile);
+
+	static const wxCmdLineEntryDesc s_cmdLineDesc[] =
+	{
+		{ wxCMD_LINE_OPTION, NULL, wxT_2("instance"),    wxT_2("Set the configuration file and the instance to use") },
+		{ wxCMD_LINE_OPTION, NULL, wxT_2("ini"),         wxT_2("Set the configuration file to use") },
+		{ wxCMD_LINE_OPTION, NULL, wxT_2("jukebox"),     wxT_2("Set the jukebox file to use") },
+		{ wxCMD_LINE_OPTION, NULL, wxT_2("temp"),        wxT_2("Set the temporary directory to use") },
+		{ wxCMD_LINE_NONE }
+	};
+	SjMainApp::s_cmdLine = new wxCmdLineParser(s_cmdLineDesc);
+	SjMainApp::s_cmdLine->SetCmdLine(wxT("--ini=\"") + iniFile + wxT("\" --jukebox=\"") + dbFile + wxT("\""));
+	if( SjMainApp::s_cmdLine->Parse(false) != 0 )
+	{
+		return 1;
+	}
+
+	// run the benchmarks, the tools set g_tools
+	new SjTools;
+	SjBenchmark1(resultFile);
+	delete g_tools;
+
+	delete SjMainApp::s_cmdLine;
+	SjMainApp::s_cmdLine = NULL;
+	SjTempNCache::LastCallOnExit();
+
+	::wxRemoveFile(dbFile);
+	::wxRemoveFile(iniFile);
+	return 0;
+}
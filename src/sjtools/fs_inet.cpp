@@ -34,6 +34,7 @@
 #include <sjbase/base.h>
 #include <wx/wfstream.h>
 #include <wx/url.h>
+#include <wx/protocol/http.h>
 #include <sjtools/fs_inet.h>
 
 static SjInternetFSHandler* this_ = NULL;
@@ -66,8 +67,12 @@ public:
 	}
 	virtual bool    Eof                 () const
 	{
-		return ((SjInternetStream*)this)->InitStream()?
-		       (m_dataEof && m_pos>=m_dataValidBytes) : TRUE;
+		if( !((SjInternetStream*)this)->InitStream() )
+		{
+			return TRUE;
+		}
+		long totalBytes = (long)GetSize();
+		return (m_dataEof && m_pos>=m_dataValidBytes) || (totalBytes>0 && m_pos>=totalBytes);
 	}
 
 	virtual bool    IsSeekable          () const
@@ -102,6 +107,17 @@ private:
 
 	#define         DATA_INCR_BYTES 0x20000L // 128K
 
+	// sparse block cache, filled by HTTP range requests for reads far behind
+	// the sequentially buffered data - this way, eg. tag readers seeking to the
+	// end of a file do not force the whole file to be downloaded.
+	// If the server does not support ranges, we fall back to reading sequentially.
+	#define         RANGE_BLOCK_BYTES     0x10000L // 64K
+	#define         RANGE_MIN_SKIP_BYTES  0x40000L // 256K, smaller gaps are read sequentially
+	SjLPHash        m_rangeBlocks;      // block index -> data, RANGE_BLOCK_BYTES bytes but less for the last block
+	bool            m_rangesUnsupported;
+	bool            ReadRangeBlocks     (long firstBlock, long lastBlock, long totalBytes);
+	size_t          ReadFromRangeBlocks (void* buffer, size_t bytesWanted, long totalBytes);
+
 	long            m_pos;
 };
 
@@ -121,6 +137,8 @@ SjInternetStream::SjInternetStream(const wxString& urlWithoutAuth, wxURL* url)
 
 	m_cachedSize                = 0xFFFFFFFFL;
 
+	m_rangesUnsupported         = FALSE;
+
 	m_pos                       = 0;
 }
 
@@ -181,6 +199,16 @@ SjInternetStream::~SjInternetStream()
 		free(m_data);
 	}
 
+	{
+		SjHashIterator  iterator;
+		long            blockIndex;
+		unsigned char*  block;
+		while( (block=(unsigned char*)m_rangeBlocks.Iterate(iterator, &blockIndex)) )
+		{
+			free(block);
+		}
+	}
+
 	// delete the stream AFTER the data; it may be needed eg. for GetSize()
 	if( m_stream )
 	{
@@ -194,6 +222,124 @@ SjInternetStream::~SjInternetStream()
 }
 
 
+bool SjInternetStream::ReadRangeBlocks(long firstBlock, long lastBlock, long totalBytes)
+{
+	// find out the blocks not yet read
+	while( firstBlock <= lastBlock && m_rangeBlocks.Lookup(firstBlock) )
+	{
+		firstBlock++;
+	}
+
+	while( lastBlock >= firstBlock && m_rangeBlocks.Lookup(lastBlock) )
+	{
+		lastBlock--;
+	}
+
+	if( firstBlock > lastBlock )
+	{
+		return TRUE; // all blocks already there
+	}
+
+	// request the range; ranges are only supported for HTTP
+	long rangeStart = firstBlock*RANGE_BLOCK_BYTES;
+	long rangeEnd   = wxMin((lastBlock+1)*RANGE_BLOCK_BYTES, totalBytes) - 1;
+
+	wxURL url(SjInternetFSHandler::AddAuthToUrl(m_urlWithoutAuth));
+	if( url.GetError() != wxURL_NOERR
+	 || url.GetScheme() != wxT("http")
+	 || wxString(url.GetProtocol().GetClassInfo()->GetClassName()) != wxT("wxHTTP") )
+	{
+		m_rangesUnsupported = TRUE;
+		return FALSE;
+	}
+
+	wxHTTP* http = (wxHTTP*)&(url.GetProtocol());
+	http->SetHeader(wxT("Range"), wxString::Format(wxT("bytes=%li-%li"), rangeStart, rangeEnd));
+
+	wxInputStream* stream = url.GetInputStream();
+	if( stream == NULL )
+	{
+		m_rangesUnsupported = TRUE;
+		return FALSE;
+	}
+
+	// the server may ignore the range and send the whole file (response 200) -
+	// in this case, we close the connection and read sequentially from now on
+	if( http->GetResponse() != 206
+	 || !http->GetHeader(wxT("Content-Range")).StartsWith(wxString::Format(wxT("bytes %li-"), rangeStart)) )
+	{
+		delete stream;
+		m_rangesUnsupported = TRUE;
+		return FALSE;
+	}
+
+	// read the blocks
+	bool            ret = TRUE;
+	long            blockIndex, blockBytes;
+	unsigned char*  block;
+	for( blockIndex = firstBlock; blockIndex <= lastBlock; blockIndex++ )
+	{
+		blockBytes = wxMin(RANGE_BLOCK_BYTES, totalBytes - blockIndex*RANGE_BLOCK_BYTES);
+		block = (unsigned char*)malloc(blockBytes);
+		if( block == NULL )
+		{
+			ret = FALSE;
+			break;
+		}
+
+		stream->Read(block, blockBytes);
+		if( (long)stream->LastRead() != blockBytes )
+		{
+			free(block);
+			m_rangesUnsupported = TRUE; // connection closed or an incomplete block
+			ret = FALSE;
+			break;
+		}
+
+		if( m_rangeBlocks.Lookup(blockIndex) )
+		{
+			free(block); // block was already read by a previous request
+		}
+		else
+		{
+			m_rangeBlocks.Insert(blockIndex, block);
+		}
+	}
+
+	delete stream;
+	return ret;
+}
+
+
+size_t SjInternetStream::ReadFromRangeBlocks(void* buffer__, size_t bytesWanted, long totalBytes)
+{
+	unsigned char*  buffer = (unsigned char*)buffer__;
+	size_t          bytesCopied = 0;
+	long            blockIndex, blockOffset, blockBytes, bytesThisBlock;
+	unsigned char*  block;
+
+	while( bytesCopied < bytesWanted && m_pos < totalBytes )
+	{
+		blockIndex  = m_pos / RANGE_BLOCK_BYTES;
+		blockOffset = m_pos % RANGE_BLOCK_BYTES;
+		block = (unsigned char*)m_rangeBlocks.Lookup(blockIndex);
+		if( block == NULL )
+		{
+			break;
+		}
+
+		blockBytes = wxMin(RANGE_BLOCK_BYTES, totalBytes - blockIndex*RANGE_BLOCK_BYTES);
+		bytesThisBlock = wxMin((long)(bytesWanted-bytesCopied), blockBytes-blockOffset);
+		memcpy(buffer+bytesCopied, block+blockOffset, bytesThisBlock);
+
+		bytesCopied += bytesThisBlock;
+		m_pos += bytesThisBlock;
+	}
+
+	return bytesCopied;
+}
+
+
 size_t SjInternetStream::OnSysRead(void* buffer, size_t bytesWanted)
 {
 	// init the stream, if not yet done
@@ -202,6 +348,28 @@ size_t SjInternetStream::OnSysRead(void* buffer, size_t bytesWanted)
 		return 0;
 	}
 
+	// far behind the sequentially buffered data? try to get the data using range requests
+	if( !m_dataEof
+	 && !m_rangesUnsupported
+	 &&  m_pos > m_dataValidBytes+RANGE_MIN_SKIP_BYTES )
+	{
+		long totalBytes = (long)GetSize();
+		if( totalBytes > 0 )
+		{
+			if( m_pos >= totalBytes )
+			{
+				return 0;
+			}
+
+			long bytesToRead = wxMin((long)bytesWanted, totalBytes-m_pos);
+			if( ReadRangeBlocks(m_pos/RANGE_BLOCK_BYTES, (m_pos+bytesToRead-1)/RANGE_BLOCK_BYTES, totalBytes) )
+			{
+				return ReadFromRangeBlocks(buffer, bytesToRead, totalBytes);
+			}
+			// else: ranges not supported, continue reading sequentially
+		}
+	}
+
 	// buffer the data, if not yet done
 	if( !m_dataEof
 	        &&  m_pos+bytesWanted > (size_t)m_dataValidBytes )
@@ -274,7 +442,7 @@ wxFileOffset SjInternetStream::OnSysSeek(wxFileOffset wantedPos, wxSeekMode mode
 		switch( mode )
 		{
 			case wxFromStart:   m_pos = wantedPos;              break;
-			case wxFromEnd:     m_pos = GetSize()-wantedPos;    break;
+			case wxFromEnd:     m_pos = GetSize()+wantedPos;    break; // wantedPos is <= 0 here
 			default:            m_pos += wantedPos;             break;
 		}
 	}
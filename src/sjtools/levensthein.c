@@ -306,7 +306,7 @@ static const unsigned char MAnsiStrStandardizeTable[512] =
     /* 255, kl. "y" m. ".."         */  "Y "
     ;
 
-#define CHARBUF_SIZE 256
+#define CHARBUF_SIZE LEVENSTHEIN_BUF_SIZE
 
 long  MmvStrStandardize (   const unsigned char*    src,
                             unsigned char*          dest    )
@@ -354,38 +354,19 @@ static int MmvStrCalcWldLimit   (   long currLen    )
 }
 
 
-int levensthein (const unsigned char *wort__, const unsigned char *muster__, int limit__)
+/* the distance matrix calculated row by row, used for patterns that do not
+fit into levensthein_bits(); wort and muster must be standardized */
+static int levensthein_rows (const unsigned char *wort, int lw,
+                             const unsigned char *muster, int lm,
+                             int limit, int limit__)
 {
-	#define CHARBUF_SIZE 256
 	register int    spmin,
 	         p,q,r,
-	         lm,lw,
 	         d1,d2,
 	         i,k,
 	         x1,x2,x3;
 	char            c;
 	int             d[CHARBUF_SIZE];
-	int             limit = limit__;
-
-	/* standardize the given strings*/
-	unsigned char   wort[CHARBUF_SIZE];
-	unsigned char   muster[CHARBUF_SIZE];
-
-	lw = MmvStrStandardize(wort__, wort);
-	lm = MmvStrStandardize(muster__, muster);
-
-
-	/* this is done in MmvStrStandardize
-	lw = strlen(wort);
-	lm = strlen(muster);
-	if (lw >= CHARBUF_SIZE) lw = (CHARBUF_SIZE-1);
-	if (lm >= CHARBUF_SIZE) lm = (CHARBUF_SIZE-1);
-	*/
-
-	if( limit <= 0 )
-	{
-		limit = MmvStrCalcWldLimit(lm);
-	}
 
 	/****  Anfangswerte berechnen ****/
 	if (*muster == '*')
@@ -464,4 +445,116 @@ int levensthein (const unsigned char *wort__, const unsigned char *muster__, int
 }
 
 
+/* Myers' bit-parallel algorithm in the formulation of Hyyroe: the vertical
+deltas of a whole column of the distance matrix are held in two bit vectors,
+so only the last row - the distance - has to be tracked.  Patterns with up to
+64 characters can be calculated this way; wort must be standardized. */
+static int levensthein_bits (const unsigned char *wort, int lw,
+                             const LEVENSTHEIN_PATTERN *pattern)
+{
+	uint64_t        pv = ~(uint64_t)0, mv = 0,
+	                eq, xv, xh, ph, mh,
+	                last = (uint64_t)1 << (pattern->lm-1);
+	int             dist = pattern->lm,
+	                k, c;
+
+	for (k=0; k<lw; k++)
+	{
+		c = wort[k] - 'A';
+		eq = (c >= 0 && c < 26) ? pattern->peq[c] : 0;
+
+		xv = eq | mv;
+		xh = (((eq & pv) + pv) ^ pv) | eq;
+		ph = mv | ~(xh | pv);
+		mh = pv & xh;
+
+		if (ph & last)
+		{
+			dist++;
+		}
+		else if (mh & last)
+		{
+			dist--;
+		}
+
+		ph = (ph << 1) | 1; /* the first row is 0, 1, 2, ... */
+		mh = mh << 1;
+		pv = mh | ~(xv | ph);
+		mv = ph & xv;
+
+		/* each remaining column can lower the distance by one at most */
+		if (dist - (lw-k-1) > pattern->limit)
+		{
+			return CHARBUF_SIZE;
+		}
+	}
+
+	return dist;
+}
+
+
+void levensthein_prepare (LEVENSTHEIN_PATTERN *pattern, const unsigned char *muster__, int limit__)
+{
+	int i, c;
+
+	pattern->lm = (int)MmvStrStandardize(muster__, pattern->muster);
+	pattern->limit__ = limit__;
+	pattern->limit = limit__ > 0 ? limit__ : MmvStrCalcWldLimit(pattern->lm);
+
+	memset(pattern->peq, 0, sizeof(pattern->peq));
+	if (pattern->lm <= 64)
+	{
+		for (i=0; i<pattern->lm; i++)
+		{
+			c = pattern->muster[i] - 'A';
+			if (c >= 0 && c < 26)
+			{
+				pattern->peq[c] |= (uint64_t)1 << i;
+			}
+		}
+	}
+}
+
+
+int levensthein_match (const LEVENSTHEIN_PATTERN *pattern, const unsigned char *wort__)
+{
+	unsigned char   wort[CHARBUF_SIZE];
+	int             lw, lm = pattern->lm, d;
+
+	lw = (int)MmvStrStandardize(wort__, wort);
+
+	if (lw - lm > pattern->limit  ||  lm - lw > pattern->limit)
+	{
+		d = CHARBUF_SIZE; /* the distance is at least the difference of the lengths */
+	}
+	else if (lm == 0)
+	{
+		d = lw;
+	}
+	else if (lm <= 64)
+	{
+		d = levensthein_bits(wort, lw, pattern);
+	}
+	else
+	{
+		return levensthein_rows(wort, lw, pattern->muster, lm, pattern->limit, pattern->limit__);
+	}
+
+	if (d <= pattern->limit)
+	{
+		return pattern->limit__? d : 1; // match
+	}
+	else
+	{
+		return pattern->limit__? CHARBUF_SIZE : 0; // no match
+	}
+}
+
+
+int levensthein (const unsigned char *wort__, const unsigned char *muster__, int limit__)
+{
+	LEVENSTHEIN_PATTERN pattern;
 
+	levensthein_prepare(&pattern, muster__, limit__);
+	return levensthein_match(&pattern, wort__);
+}
@@ -30,6 +30,9 @@
 #define _LEVENSTHEIN_H_
 
 
+#include <stdint.h>
+
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -42,6 +45,27 @@ int levensthein(const unsigned char *s1,
                 /*int cost_ins, int cost_rep, int cost_del*/ );
 
 
+/* for matching many strings against the same pattern, the pattern can be
+prepared once; levensthein_match() then gives the same results as
+levensthein(s1, pattern, limit) */
+#define LEVENSTHEIN_BUF_SIZE 256
+typedef struct
+{
+	unsigned char   muster[LEVENSTHEIN_BUF_SIZE];   /* standardized pattern */
+	int             lm;                             /* length of muster */
+	int             limit__;                        /* as given to levensthein_prepare() */
+	int             limit;                          /* maximal distance to use */
+	uint64_t        peq[26];                        /* bit i is set if muster[i] is 'A'+n, only used if lm<=64 */
+} LEVENSTHEIN_PATTERN;
+
+void levensthein_prepare(LEVENSTHEIN_PATTERN *pattern,
+                         const unsigned char *s2,
+                         int limit );
+
+int levensthein_match(const LEVENSTHEIN_PATTERN *pattern,
+                      const unsigned char *s1 );
+
+
 #ifdef __cplusplus
 };
 #endif
@@ -0,0 +1,121 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2016 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *******************************************************************************
+ *
+ * File:    playbackclock.cpp
+ * Authors: Björn Petersen
+ * Purpose: Playback position fed from the DSP callback
+ *
+ *******************************************************************************
+ *
+ * Querying the position from the backend goes through the whole pipeline and
+ * jitters with the size of the buffers.  Instead, the position of the data
+ * processed by the DSP callback is published here and is read without any lock;
+ * between two buffers, the position is extrapolated by the time passed.  The data
+ * is processed some time before it is heard, this latency is subtracted by the
+ * reader.
+ *
+ ******************************************************************************/
+
+
+#include <sjbase/base.h>
+#include <sjtools/playbackclock.h>
+
+
+// after a seek, buffers more distant to the seek position are old buffers still on their way
+#define SEEK_TOLERANCE_MS 3000
+
+
+SjPlaybackClock::SjPlaybackClock()
+	: m_published(0), m_chunkMs(0), m_pendingSeekMs(-1)
+{
+	m_countedBaseMs = 0;
+	m_countedFrames = 0;
+}
+
+
+void SjPlaybackClock::AddBuffer(long posMs, long bytes, int samplerate, int channels)
+{
+	if( samplerate <= 0 || channels <= 0 ) {
+		return;
+	}
+
+	long frames  = bytes / (sizeof(float)*channels);
+	long chunkMs = (long)(((int64_t)frames*1000) / samplerate);
+	long seekMs  = m_pendingSeekMs.load(std::memory_order_acquire);
+	long startMs;
+
+	if( posMs >= 0 )
+	{
+		if( seekMs >= 0 )
+		{
+			if( posMs < seekMs-SEEK_TOLERANCE_MS || posMs > seekMs+SEEK_TOLERANCE_MS ) {
+				return; // data from before the seek
+			}
+			m_pendingSeekMs.compare_exchange_strong(seekMs, -1);
+		}
+		startMs = posMs;
+	}
+	else
+	{
+		// the backend does not know the position, count the samples
+		if( seekMs >= 0 && m_pendingSeekMs.compare_exchange_strong(seekMs, -1) )
+		{
+			m_countedBaseMs = seekMs;
+			m_countedFrames = 0;
+		}
+		startMs = m_countedBaseMs + (long)((m_countedFrames*1000) / samplerate);
+		m_countedFrames += frames;
+	}
+
+	m_chunkMs.store(chunkMs, std::memory_order_relaxed);
+	m_published.store(((uint64_t)(uint32_t)(startMs+1) << 32) | (uint32_t)SjTools::GetMsTicks(), std::memory_order_release);
+}
+
+
+void SjPlaybackClock::Seek(long seekMs)
+{
+	if( seekMs < 0 ) { seekMs = 0; }
+	m_pendingSeekMs.store(seekMs, std::memory_order_release);
+	m_published.store(0, std::memory_order_release);
+}
+
+
+long SjPlaybackClock::GetElapsedMs(long latencyMs, bool running) const
+{
+	uint64_t published = m_published.load(std::memory_order_acquire);
+	if( published == 0 ) {
+		return -1;
+	}
+
+	long elapsedMs = (long)(uint32_t)(published >> 32) - 1;
+
+	if( running )
+	{
+		// extrapolate, but not beyond the length of a buffer - if there are no more buffers, the position stays
+		long passedMs = (long)(uint32_t)((uint32_t)SjTools::GetMsTicks() - (uint32_t)published);
+		long chunkMs  = m_chunkMs.load(std::memory_order_relaxed);
+		elapsedMs += passedMs < chunkMs? passedMs : chunkMs;
+	}
+
+	elapsedMs -= latencyMs;
+	return elapsedMs < 0? 0 : elapsedMs;
+}
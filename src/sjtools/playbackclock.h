@@ -0,0 +1,64 @@
+/*******************************************************************************
+ *
+ *                                 Silverjuke
+ *     Copyright (C) 2016 Björn Petersen Software Design and Development
+ *                   Contact: r10s@b44t.com, http://b44t.com
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see http://www.gnu.org/licenses/ .
+ *
+ *******************************************************************************
+ *******************************************************************************
+ *
+ * File:    playbackclock.h
+ * Authors: Björn Petersen
+ * Purpose: Playback position fed from the DSP callback
+ *
+ ******************************************************************************/
+
+
+#ifndef __SJ_PLAYBACKCLOCK_H__
+#define __SJ_PLAYBACKCLOCK_H__
+
+
+#include <atomic>
+
+
+class SjPlaybackClock
+{
+public:
+	                  SjPlaybackClock     ();
+
+	// AddBuffer() is called from the streaming thread for each DSP buffer; posMs is the
+	// position of the buffer as given by the backend, if -1, the samples are counted.
+	void              AddBuffer           (long posMs, long bytes, int samplerate, int channels);
+
+	// the other functions are called from the main thread.  GetElapsedMs() returns -1
+	// if there was no data since the creation or the last seek.
+	void              Seek                (long seekMs);
+	long              GetElapsedMs        (long latencyMs, bool running) const;
+
+private:
+	// the start position of the last buffer (+1, 0=nothing published) in the upper 32 bits,
+	// the ms-ticks of the update in the lower 32 bits; so both are always consistent
+	std::atomic<uint64_t> m_published;
+	std::atomic<long> m_chunkMs;
+	std::atomic<long> m_pendingSeekMs;
+
+	// owned by the streaming thread, used if the backend does not know the position
+	long              m_countedBaseMs;
+	int64_t           m_countedFrames;
+};
+
+
+#endif // __SJ_PLAYBACKCLOCK_H__
@@ -34,6 +34,9 @@
 #include <windows.h>
 #include <wx/msw/winundef.h> // undef symbols conflicting with wxWidgets
 #endif
+#ifdef __linux__
+#include <sys/vfs.h>
+#endif
 
 
 /*******************************************************************************
@@ -87,13 +90,33 @@ extern "C"
 		// levensthein(str, pattern, max_dist) returns the distance
 		// levensthein(str, pattern) chooses a distance defined by the pattern length
 		// and returns TRUE (1) or FALSE (0)
+		//
+		// the pattern is normally constant, so it is prepared only once and kept
+		// by SQLite as auxiliary data of the argument until the statement ends
 		if( argc >= 2 )
 		{
 			const unsigned char *zA = sqlite3_value_text(argv[0]);
 			const unsigned char *zB = sqlite3_value_text(argv[1]);
 			if( zA && zB )
 			{
-				sqlite3_result_int(context, levensthein(zA, zB, argc==2? 0 : sqlite3_value_int(argv[2])));
+				int limit = argc==2? 0 : sqlite3_value_int(argv[2]);
+				LEVENSTHEIN_PATTERN* pattern = (LEVENSTHEIN_PATTERN*)sqlite3_get_auxdata(context, 1);
+				if( pattern && pattern->limit__ == limit )
+				{
+					sqlite3_result_int(context, levensthein_match(pattern, zA));
+				}
+				else
+				{
+					pattern = (LEVENSTHEIN_PATTERN*)sqlite3_malloc(sizeof(LEVENSTHEIN_PATTERN));
+					if( pattern == NULL )
+					{
+						sqlite3_result_error_nomem(context);
+						return;
+					}
+					levensthein_prepare(pattern, zB, limit);
+					sqlite3_result_int(context, levensthein_match(pattern, zA));
+					sqlite3_set_auxdata(context, 1, pattern, sqlite3_free); // may free the pattern at once, so this comes last
+				}
 				return;
 			}
 		}
@@ -184,13 +207,21 @@ extern "C"
 wxSqltDb* wxSqltDb::s_defaultDb = NULL;
 
 
-wxSqltDb::wxSqltDb(const wxString& file)
+wxSqltDb::wxSqltDb(const wxString& file, bool readOnly)
 {
 	m_transactionCount          = 0;
 	m_transactionVacuumPending  = FALSE;
+	m_wal                       = FALSE;
 	m_file                      = file;
 	m_dbExistsBeforeOpening     = ::wxFileExists(file);
+	m_readOnly                  = readOnly;
 	m_sqlite                    = NULL;
+	m_configDb                  = this;
+	m_configCache               = NULL;
+	m_configDirty               = NULL;
+	m_configUndoKeys            = NULL;
+	m_configUndoValues          = NULL;
+	m_readersInUse              = 0;
 	#ifdef __WXDEBUG__
 	m_instanceCount             = 0;
 	#endif
@@ -218,7 +249,7 @@ wxSqltDb::wxSqltDb(const wxString& file)
 	#endif
 	const char* fileSqlite3Str = fileCharBuf.data();
 
-	if( sqlite3_open(fileSqlite3Str, &m_sqlite) != SQLITE_OK )
+	if( sqlite3_open_v2(fileSqlite3Str, &m_sqlite, readOnly? SQLITE_OPEN_READONLY : (SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE), NULL) != SQLITE_OK )
 	{
 		if( m_sqlite )
 		{
@@ -238,7 +269,7 @@ wxSqltDb::wxSqltDb(const wxString& file)
 		wxSqlt sql(this);
 
 		// ... create the configuration table
-		if( !m_dbExistsBeforeOpening )
+		if( !m_dbExistsBeforeOpening && !readOnly )
 		{
 			sql.Query(wxT("CREATE TABLE config (id INTEGER PRIMARY KEY, keyname TEXT, value TEXT);"));
 			sql.Query(wxT("CREATE INDEX configindex01 ON config (keyname);"));
@@ -249,9 +280,19 @@ wxSqltDb::wxSqltDb(const wxString& file)
 	sqlite3_create_function(m_sqlite, "timestamp",    1/*number of arguments*/,     SQLITE_ANY, this, sqlite_timestamp,   NULL, NULL);
 	sqlite3_create_function(m_sqlite, "filetype",     1/*number of arguments*/,     SQLITE_ANY, this, sqlite_filetype,    NULL, NULL);
 	sqlite3_create_function(m_sqlite, "levensthein", -1/*any number of arguments*/, SQLITE_ANY, this, sqlite_levensthein, NULL, NULL);
-	sqlite3_create_function(m_sqlite, "queuepos",    -1/*any number of arguments*/, SQLITE_ANY, this, sqlite_queuepos,    NULL, NULL);
 	sqlite3_create_function(m_sqlite, "sortable",    -1/*any number of arguments*/, SQLITE_ANY, this, sqlite_sortable,    NULL, NULL);
 	sqlite3_create_function(m_sqlite, "nulltoend",    1/*any number of arguments*/, SQLITE_ANY, this, sqlite_nulltoend,   NULL, NULL);
+	if( !readOnly )
+	{
+		// queuepos() uses the queue of the main thread, readers may be used by any thread
+		sqlite3_create_function(m_sqlite, "queuepos",    -1/*any number of arguments*/, SQLITE_ANY, this, sqlite_queuepos,    NULL, NULL);
+	}
+
+	// readers wait for a checkpoint or for a writer without write-ahead logging
+	if( readOnly )
+	{
+		sqlite3_busy_timeout(m_sqlite, 5000);
+	}
 }
 
 
@@ -264,6 +305,23 @@ wxSqltDb::~wxSqltDb()
 		s_defaultDb = NULL;
 	}
 
+	wxASSERT( m_readersInUse == 0 );
+	for( size_t r = 0; r < m_readers.GetCount(); r++ )
+	{
+		delete (wxSqltDb*)m_readers.Item(r);
+	}
+	m_readers.Empty();
+
+	if( m_sqlite )
+	{
+		ConfigFlush();
+	}
+
+	delete m_configCache;
+	delete m_configDirty;
+	delete m_configUndoKeys;
+	delete m_configUndoValues;
+
 	if( m_sqlite )
 	{
 		#ifdef __WXDEBUG__
@@ -308,6 +366,98 @@ wxSqltDb* wxSqltDb::GetDefault()
 }
 
 
+bool wxSqltDb::IsOnNetworkFs(const wxString& file)
+{
+	#if defined(__WXMSW__)
+		wxFileName fn(file);
+		wxString volume = fn.GetVolume();
+		if( volume.IsEmpty() || volume.StartsWith(wxT("\\\\")) )
+		{
+			return TRUE; // UNC path
+		}
+		return (::GetDriveType((volume+wxT(":\\")).c_str()) == DRIVE_REMOTE);
+	#elif defined(__linux__)
+		struct statfs buf;
+		if( statfs(wxFileName(file).GetPath().mb_str(*wxConvFileName), &buf) != 0 )
+		{
+			return FALSE;
+		}
+		switch( (unsigned long)buf.f_type )
+		{
+			case 0x6969UL:      // NFS
+			case 0x517BUL:      // SMB
+			case 0xFF534D42UL:  // CIFS
+			case 0xFE534D42UL:  // SMB2
+			case 0x564CUL:      // NCP
+			case 0x65735546UL:  // FUSE, eg. sshfs
+				return TRUE;
+		}
+		return FALSE;
+	#else
+		return FALSE;
+	#endif
+}
+
+
+bool wxSqltDb::SetWal(bool enable)
+{
+	if( enable && IsOnNetworkFs(m_file) )
+	{
+		wxLogInfo(wxT("%s is on a network filesystem, write-ahead logging not used"), m_file.c_str());
+		enable = FALSE;
+	}
+
+	// the journal mode is persistent, so it is also set back explicitly;
+	// the pragma returns the new mode and the old one if write-ahead
+	// logging is not supported
+	wxSqlt sql(this);
+	sql.Query(enable? wxT("PRAGMA journal_mode=WAL;") : wxT("PRAGMA journal_mode=DELETE;"));
+	m_wal = (sql.Next() && sql.GetString(0).Lower() == wxT("wal"));
+	return m_wal;
+}
+
+
+wxSqltDb* wxSqltDb::GetReader()
+{
+	wxASSERT( !m_readOnly );
+
+	{
+		wxCriticalSectionLocker locker(m_readersCritical);
+		size_t count = m_readers.GetCount();
+		if( count )
+		{
+			wxSqltDb* reader = (wxSqltDb*)m_readers.Item(count-1);
+			m_readers.RemoveAt(count-1);
+			m_readersInUse++;
+			return reader;
+		}
+	}
+
+	// open a new connection outside the lock; they're only created
+	// if all existing connections are in use
+	wxSqltDb* reader = new wxSqltDb(m_file, TRUE);
+	if( !reader->IsOk() )
+	{
+		delete reader;
+		return NULL;
+	}
+	reader->m_configDb = this; // there is only one configuration cache
+
+	wxCriticalSectionLocker locker(m_readersCritical);
+	m_readersInUse++;
+	return reader;
+}
+
+
+void wxSqltDb::ReleaseReader(wxSqltDb* reader)
+{
+	wxCriticalSectionLocker locker(m_readersCritical);
+	wxASSERT( m_readersInUse > 0 );
+	m_readers.Add(reader);
+	m_readersInUse--;
+}
+
+
 long wxSqltDb::SetCache(long bytes, bool saveInDb)
 {
 	wxSqlt sql(this);
@@ -625,7 +775,141 @@ void wxSqlt::AddColumn(const wxString& tablename, const wxString& column_def)
  ******************************************************************************/
 
 
-void wxSqlt::ConfigWrite(const wxString& keyname, const wxString& value)
+void wxSqltDb::ConfigLoad(wxSqltDb* conn)
+{
+	// read the whole configuration table at once using the given connection, this
+	// may also be a pooled reader; the caller should lock m_configCritical
+	if( m_configCache == NULL )
+	{
+		m_configCache = new SjSSHash;
+		m_configDirty = new SjSLHash;
+		m_configUndoKeys = new SjSLHash;
+		m_configUndoValues = new SjSSHash;
+
+		wxSqlt sql(conn);
+		sql.Query(wxT("SELECT keyname, value FROM config;"));
+		while( sql.Next() )
+		{
+			m_configCache->Insert(sql.GetString(0), sql.GetString(1));
+		}
+	}
+}
+
+
+void wxSqltDb::ConfigFlush()
+{
+	wxCriticalSectionLocker locker(m_configCritical);
+
+	if( m_configDirty == NULL || m_configDirty->GetCount() == 0
+	 || m_transactionCount > 0 /*try again later, the values should not be part of a transaction that may be rolled back*/ )
+	{
+		return;
+	}
+
+	// we do not use wxSqltTransaction here as this would show the busy cursor
+	wxSqlt              sql(this);
+	SjHashIterator      iterator;
+	wxString            keyname;
+	sql.Query(wxT("BEGIN;"));
+	while( m_configDirty->Iterate(iterator, keyname) )
+	{
+		wxString* value = m_configCache->Lookup(keyname);
+		if( value )
+		{
+			sql.ConfigWrite_(keyname, *value);
+		}
+		else
+		{
+			sql.Query(wxT("DELETE FROM config WHERE keyname='") + wxSqlt::QParam(keyname) + wxT("';"));
+		}
+	}
+	m_configDirty->Clear();
+
+	sql.Query(wxT("COMMIT;"));
+}
+
+
+bool wxSqltDb::IsConfigWriteThrough(const wxString& keyname) const
+{
+	size_t i, iCount = m_configWriteThrough.GetCount();
+	for( i = 0; i < iCount; i++ )
+	{
+		if( keyname.StartsWith(m_configWriteThrough.Item(i)) )
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+
+void wxSqltDb::ConfigRememberUndo(const wxString& keyname)
+{
+	// remember the state before the first change in the transaction;
+	// the caller should lock m_configCritical
+	if( m_configUndoKeys->Lookup(keyname) )
+	{
+		return;
+	}
+
+	long flags = SJ_CONFIGUNDO_CHANGED;
+	wxString* oldValue = m_configCache->Lookup(keyname);
+	if( oldValue )
+	{
+		flags |= SJ_CONFIGUNDO_EXISTED;
+		m_configUndoValues->Insert(keyname, *oldValue);
+	}
+
+	if( m_configDirty->Lookup(keyname) )
+	{
+		flags |= SJ_CONFIGUNDO_DIRTY;
+	}
+
+	m_configUndoKeys->Insert(keyname, flags);
+}
+
+
+void wxSqltDb::ConfigEndTransaction(bool commit)
+{
+	// called when the outest transaction is committed or rolled back
+	wxCriticalSectionLocker locker(m_configCritical);
+
+	if( m_configCache == NULL )
+	{
+		return; // nothing read or written
+	}
+
+	if( !commit )
+	{
+		// the values written in the transaction are no longer in the
+		// database, restore the cache as it was before
+		SjHashIterator  iterator;
+		wxString        keyname;
+		long            flags;
+		while( (flags=m_configUndoKeys->Iterate(iterator, keyname)) )
+		{
+			if( flags & SJ_CONFIGUNDO_EXISTED )
+			{
+				m_configCache->Insert(keyname, *m_configUndoValues->Lookup(keyname));
+			}
+			else
+			{
+				m_configCache->Remove(keyname);
+			}
+
+			if( flags & SJ_CONFIGUNDO_DIRTY )
+			{
+				m_configDirty->Insert(keyname, 1);
+			}
+		}
+	}
+
+	m_configUndoKeys->Clear();
+	m_configUndoValues->Clear();
+}
+
+
+void wxSqlt::ConfigWrite_(const wxString& keyname, const wxString& value)
 {
 	Query(wxT("SELECT value FROM config WHERE keyname='") +  QParam(keyname) + wxT("';"));
 	if( !Next() )
@@ -639,23 +923,118 @@ void wxSqlt::ConfigWrite(const wxString& keyname, const wxString& value)
 }
 
 
+void wxSqlt::ConfigWrite(const wxString& keyname, const wxString& value)
+{
+	// the configuration of a pooled reader is the one of its owner, see wxSqltDb::GetReader();
+	// writes from a reader are always collected and written by ConfigFlush()
+	wxSqltDb* cfg = m_db->m_configDb;
+	wxCriticalSectionLocker locker(cfg->m_configCritical);
+	cfg->ConfigLoad(m_db);
+
+	wxString* oldValue = cfg->m_configCache->Lookup(keyname);
+	if( oldValue && *oldValue == value )
+	{
+		return; // nothing changed
+	}
+
+	if( cfg == m_db && m_db->m_transactionCount > 0 )
+	{
+		// inside a transaction, the value is written along with the other changes
+		m_db->ConfigRememberUndo(keyname);
+		m_db->m_configCache->Insert(keyname, value);
+		ConfigWrite_(keyname, value);
+		m_db->m_configDirty->Remove(keyname);
+	}
+	else if( cfg == m_db && m_db->IsConfigWriteThrough(keyname) )
+	{
+		m_db->m_configCache->Insert(keyname, value);
+		ConfigWrite_(keyname, value);
+		m_db->m_configDirty->Remove(keyname);
+	}
+	else
+	{
+		cfg->m_configCache->Insert(keyname, value);
+		cfg->m_configDirty->Insert(keyname, 1);
+	}
+}
+
+
 wxString wxSqlt::ConfigRead(const wxString& keyname, const wxString& def)
 {
-	Query(wxT("SELECT value FROM config WHERE keyname='") + QParam(keyname) + wxT("';"));
-	return Next()? GetString(0) : def;
+	wxSqltDb* cfg = m_db->m_configDb;
+	wxCriticalSectionLocker locker(cfg->m_configCritical);
+	cfg->ConfigLoad(m_db);
+
+	wxString* value = cfg->m_configCache->Lookup(keyname);
+	return value? *value : def;
 }
 
 
 long wxSqlt::ConfigRead(const wxString& keyname, long def)
 {
-	Query(wxT("SELECT value FROM config WHERE keyname='") + QParam(keyname) + wxT("';"));
-	return Next()? GetLong(0) : def;
+	wxString value;
+	{
+		wxSqltDb* cfg = m_db->m_configDb;
+		wxCriticalSectionLocker locker(cfg->m_configCritical);
+		cfg->ConfigLoad(m_db);
+
+		wxString* cached = cfg->m_configCache->Lookup(keyname);
+		if( cached == NULL )
+		{
+			return def;
+		}
+		value = *cached;
+	}
+
+	// convert as sqlite3_column_int() does: leading spaces, a sign and the digits
+	// are used, anything after the digits is ignored ("12 " and "1.0" are fine),
+	// out of range values are clamped to 64 bit and then truncated to int;
+	// so negative values written unsigned by ConfigWrite(long) are read back correctly
+	const wxChar* p = value.c_str();
+	while( *p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' || *p == '\f' || *p == '\v' ) p++;
+
+	bool neg = false;
+	if( *p == '-' )      { neg = true; p++; }
+	else if( *p == '+' ) { p++; }
+
+	wxULongLong_t u = 0;
+	bool overflow = false;
+	while( *p >= '0' && *p <= '9' )
+	{
+		if( u > (wxULongLong_t)(wxINT64_MAX/10) ) overflow = true;
+		u = u*10 + (*p - '0');
+		p++;
+	}
+
+	wxLongLong_t l;
+	if( overflow || u > (wxULongLong_t)wxINT64_MAX ) { l = neg? wxINT64_MIN : wxINT64_MAX; }
+	else                                             { l = neg? -(wxLongLong_t)u : (wxLongLong_t)u; }
+	return (long)(int)l;
 }
 
 
 void wxSqlt::ConfigDeleteEntry(const wxString& keyname)
 {
-	Query(wxT("DELETE FROM config WHERE keyname='") + QParam(keyname) + wxT("';"));
+	wxSqltDb* cfg = m_db->m_configDb;
+	wxCriticalSectionLocker locker(cfg->m_configCritical);
+	cfg->ConfigLoad(m_db);
+
+	if( cfg == m_db && m_db->m_transactionCount > 0 )
+	{
+		m_db->ConfigRememberUndo(keyname);
+	}
+
+	cfg->m_configCache->Remove(keyname);
+
+	if( cfg == m_db && (m_db->m_transactionCount > 0 || m_db->IsConfigWriteThrough(keyname)) )
+	{
+		Query(wxT("DELETE FROM config WHERE keyname='") + QParam(keyname) + wxT("';"));
+		m_db->m_configDirty->Remove(keyname);
+	}
+	else
+	{
+		cfg->m_configDirty->Insert(keyname, 1);
+	}
 }
 
 
@@ -702,6 +1081,7 @@ wxSqltTransaction::~wxSqltTransaction()
 				wxSqlt sql(m_db);
 				sql.Query(wxT("ROLLBACK;"));
 			}
+			m_db->ConfigEndTransaction(FALSE);
 		}
 	}
 
@@ -723,6 +1103,7 @@ bool wxSqltTransaction::Commit()
 			wxBusyCursor busy;
 			wxSqlt sql(m_db);
 			ret = sql.Query(wxT("COMMIT;"));
+			m_db->ConfigEndTransaction(ret);
 
 			if( m_db->m_transactionVacuumPending )
 			{
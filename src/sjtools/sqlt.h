@@ -31,6 +31,7 @@
 
 
 #include <wx/wx.h>
+#include <wx/thread.h>
 #include <sqlite3.h>
 
 
@@ -75,13 +76,30 @@
 
 
 class wxSqlt;
+class SjSSHash;
+class SjSLHash;
+
+
+
+// Threading:
+// - a wxSqltDb object and all wxSqlt objects using it may only be used by
+//   one thread at the same time; for the default database, this is the main
+//   thread.
+// - worker threads that want to read from a database use a read-only
+//   connection from the pool, use wxSqltReader for this purpose.  With
+//   SetWal(), these readers are not blocked by a running write transaction
+//   (they see the state before the transaction) and do not block the writer.
+// - the main thread may also use readers for larger reads, wxSqltReader
+//   decides if this is possible, see there.
+// - the SQL function queuepos() accesses the queue and is only defined for
+//   the main connection, not for the readers.
 
 
 
 class wxSqltDb
 {
 public:
-						wxSqltDb                (const wxString& file);
+						wxSqltDb                (const wxString& file, bool readOnly=FALSE);
 	virtual             ~wxSqltDb               ();
 
 	bool                IsOk                    () const {return m_sqlite? TRUE : FALSE; }
@@ -99,6 +117,19 @@ public:
 	long                GetSync                 ();
 	sqlite3*            GetDb                   () { return m_sqlite; }
 
+	bool                InTransaction           () const { return m_transactionCount>0; }
+
+	// use write-ahead logging or not; as write-ahead logging needs shared
+	// memory, it is never used for databases on network filesystems.  The
+	// journal mode is persistent and should be set before readers are used.
+	// Returns TRUE if write-ahead logging is used.
+	bool                SetWal                  (bool enable);
+	bool                IsWal                   () const { return m_wal; }
+
+	// get a read-only connection from the pool, see the threading notes above
+	wxSqltDb*           GetReader               ();
+	void                ReleaseReader           (wxSqltDb*);
+
 	// some events that may be used by derived classes.
 	// the event are placed here and not in wxSqltTransaction as calling
 	// virtual functions in the constructor/destructor is not straight-forward
@@ -109,12 +140,25 @@ public:
 	// misc.
 	static wxString		GetLibVersion			();
 
+	// the configuration table is read into memory on first access; writes
+	// outside of transactions are collected and written by ConfigFlush()
+	// in a single transaction.  ConfigFlush() is called periodically by the
+	// main frame and on destruction.  Keys starting with a prefix given to
+	// ConfigWriteThrough() are written at once, eg. for settings that must
+	// survive a crash.  Writes inside a transaction are written along with
+	// the transaction and are undone in the cache on rollback.
+	void                ConfigFlush             ();
+	void                ConfigWriteThrough      (const wxString& keynamePrefix) { m_configWriteThrough.Add(keynamePrefix); }
+
 private:
 	wxString            m_file;
 	bool                m_dbExistsBeforeOpening;
+	bool                m_readOnly;
 	sqlite3*            m_sqlite;
 	int                 m_transactionCount;
 	bool                m_transactionVacuumPending;
+	bool                m_wal;
+	static bool         IsOnNetworkFs       (const wxString& file);
 	#ifdef __WXDEBUG__
 	int                 m_instanceCount;
 	#endif
@@ -128,6 +172,33 @@ private:
 	friend class        wxSqltTransaction;
 
 	bool                RecodeToUtf8        (wxSqlt& sql1);
+
+	// configuration cache, protected by m_configCritical; m_configDirty
+	// holds the keys to write, keys not in m_configCache are deleted.
+	// pooled readers have no cache, m_configDb points to their owner then.
+	void                ConfigLoad          (wxSqltDb* conn);
+	wxSqltDb*           m_configDb;
+	wxCriticalSection   m_configCritical;
+	SjSSHash*           m_configCache;
+	SjSLHash*           m_configDirty;
+	wxArrayString       m_configWriteThrough;
+	bool                IsConfigWriteThrough(const wxString& keyname) const;
+
+	// the state of the keys before they were changed in the current
+	// transaction: m_configUndoKeys holds SJ_CONFIGUNDO_* flags,
+	// m_configUndoValues the old values of keys that existed before
+	#define             SJ_CONFIGUNDO_CHANGED   0x01
+	#define             SJ_CONFIGUNDO_EXISTED   0x02
+	#define             SJ_CONFIGUNDO_DIRTY     0x04
+	SjSLHash*           m_configUndoKeys;
+	SjSSHash*           m_configUndoValues;
+	void                ConfigRememberUndo  (const wxString& keyname);
+	void                ConfigEndTransaction(bool commit);
+
+	// unused readers, protected by m_readersCritical
+	wxCriticalSection   m_readersCritical;
+	wxArrayPtrVoid      m_readers;
+	int                 m_readersInUse;
 };
 
 
@@ -221,7 +292,7 @@ public:
 	bool            ColumnExists        (const wxString& tablename, const wxString& rowname);
 	void            AddColumn           (const wxString& tablename, const wxString& column_def);
 
-	// Configuration handling
+	// Configuration handling, see also wxSqltDb::ConfigFlush()
 	void            ConfigWrite         (const wxString& keyname, const wxString& value);
 	void            ConfigWrite         (const wxString& keyname, long value) {ConfigWrite(keyname,wxString::Format(wxT("%lu"),value));}
 	wxString        ConfigRead          (const wxString& keyname, const wxString& def);
@@ -237,6 +308,9 @@ private:
 	int             m_fetchState; // [d]one, [f]irst or 0
 
 	int             m_fieldCount;
+
+	void            ConfigWrite_        (const wxString& keyname, const wxString& value);
+	friend class    wxSqltDb;
 };
 
 
@@ -258,6 +332,55 @@ private:
 };
 
 
+
+class wxSqltReader
+{
+	// Get a read-only connection to the given or to the default database,
+	// usable from any thread, use as:
+	//  wxSqltReader reader;
+	//  wxSqlt sql(reader.GetDb());
+	// GetDb() returns NULL if the connection cannot be opened.
+	//
+	// Connections from the pool are only used with write-ahead logging;
+	// otherwise, their long reads would hold locks that let the writes of
+	// the owner fail at once, and GetDb() returns NULL for other threads.
+	//
+	// With orDb=TRUE, the reader is used by the thread owning the database;
+	// a connection from the pool is only used if write-ahead logging is
+	// enabled and no transaction is running, so that the results are the
+	// same and the reader cannot be blocked by the owner itself.  Otherwise,
+	// GetDb() returns the database.  A reader created before a transaction
+	// starts reads the state before the transaction.
+public:
+	wxSqltReader        (wxSqltDb* db = NULL, bool orDb = FALSE)
+	{
+		m_db = db? db : wxSqltDb::GetDefault();
+		m_reader = NULL;
+		m_usesDb = FALSE;
+		if( m_db )
+		{
+			if( m_db->IsWal() && (!orDb || !m_db->InTransaction()) )
+			{
+				m_reader = m_db->GetReader();
+			}
+
+			m_usesDb = (m_reader == NULL && orDb);
+		}
+	}
+	~wxSqltReader       ()
+	{
+		if( m_reader ) { m_db->ReleaseReader(m_reader); }
+	}
+	bool            UsesDb              () const { return m_usesDb; }
+	wxSqltDb*       GetDb               () const { return m_usesDb? m_db : m_reader; }
+
+private:
+	wxSqltDb*       m_db;
+	wxSqltDb*       m_reader;
+	bool            m_usesDb;
+};
+
+
 #ifdef __WXDEBUG__
 extern "C"
 {
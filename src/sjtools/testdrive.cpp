@@ -29,6 +29,7 @@
 
 #include <sjbase/base.h>
 #include <wx/url.h>
+#include <wx/socket.h>
 #include <sjtools/testdrive.h>
 #include <sjtools/csv_tokenizer.h>
 #include <see_dom/sj_see.h>
@@ -62,6 +63,194 @@ static wxString CreateTestFileUsingWxFile(const wxString& fileName, const wxStri
 }
 
 
+/*******************************************************************************
+ * Loopback HTTP server, used to test the range requests of SjInternetStream
+ ******************************************************************************/
+
+
+#define TEST_HTTP_BYTES 0x200000L // 2 MB
+
+
+static unsigned char TestHttpByte(long pos)
+{
+	return (unsigned char)((pos*7) ^ (pos>>11));
+}
+
+
+class SjTestHttpConnection : public wxThread
+{
+public:
+	                SjTestHttpConnection(wxSocketBase* socket, bool supportRanges);
+	void*           Entry               ();
+
+	static long     s_rangeRequests;
+	static wxCriticalSection s_critical;
+
+private:
+	wxSocketBase*   m_socket;
+	bool            m_supportRanges;
+};
+
+
+long                SjTestHttpConnection::s_rangeRequests = 0;
+wxCriticalSection   SjTestHttpConnection::s_critical;
+
+
+SjTestHttpConnection::SjTestHttpConnection(wxSocketBase* socket, bool supportRanges)
+	: wxThread(wxTHREAD_DETACHED)
+{
+	m_socket = socket;
+	m_supportRanges = supportRanges;
+
+	Create();
+	Run();
+}
+
+
+void* SjTestHttpConnection::Entry()
+{
+	// read the request header up to the empty line
+	wxString header;
+	char     c;
+	while( header.Right(4) != wxT("\r\n\r\n") )
+	{
+		m_socket->Read(&c, 1);
+		if( m_socket->LastCount() != 1 )
+		{
+			delete m_socket;
+			return 0;
+		}
+		header.Append((wxChar)c);
+	}
+
+	// answer a range request with 206 or, if ranges are not supported, with the whole file
+	long rangeStart = 0, rangeEnd = TEST_HTTP_BYTES-1;
+	bool isRange = FALSE;
+	int  p = header.Find(wxT("Range: bytes="));
+	if( p != wxNOT_FOUND && m_supportRanges )
+	{
+		wxString range = header.Mid(p+13).BeforeFirst(wxT('\r'));
+		if( range.BeforeFirst(wxT('-')).ToLong(&rangeStart)
+		 && range.AfterFirst(wxT('-')).ToLong(&rangeEnd)
+		 && rangeStart >= 0 && rangeStart <= rangeEnd && rangeEnd < TEST_HTTP_BYTES )
+		{
+			isRange = TRUE;
+			s_critical.Enter();
+			s_rangeRequests++;
+			s_critical.Leave();
+		}
+		else
+		{
+			rangeStart = 0;
+			rangeEnd = TEST_HTTP_BYTES-1;
+		}
+	}
+
+	wxString response = isRange?
+	                    wxString::Format(wxT("HTTP/1.1 206 Partial Content\r\nContent-Range: bytes %li-%li/%li\r\n"), rangeStart, rangeEnd, (long)TEST_HTTP_BYTES) :
+	                    wxString(wxT("HTTP/1.1 200 OK\r\n"));
+	response += wxString::Format(wxT("Content-Length: %li\r\nConnection: close\r\n\r\n"), rangeEnd-rangeStart+1);
+	const wxCharBuffer responseAscii = response.mb_str(wxConvISO8859_1);
+	m_socket->Write(responseAscii.data(), strlen(responseAscii.data()));
+
+	// send the body; this stops as soon as the client closes the connection
+	unsigned char buffer[0x4000];
+	long pos = rangeStart, bytes, i;
+	while( pos <= rangeEnd && !m_socket->Error() )
+	{
+		bytes = wxMin((long)sizeof(buffer), rangeEnd-pos+1);
+		for( i = 0; i < bytes; i++ )
+		{
+			buffer[i] = TestHttpByte(pos+i);
+		}
+
+		m_socket->Write(buffer, bytes);
+		if( (long)m_socket->LastCount() != bytes )
+		{
+			break;
+		}
+		pos += bytes;
+	}
+
+	delete m_socket;
+	return 0;
+}
+
+
+class SjTestHttpServer : public wxThread
+{
+public:
+	                SjTestHttpServer    (wxSocketServer* server, bool supportRanges);
+	void*           Entry               ();
+	volatile bool   m_stop;
+
+private:
+	wxSocketServer* m_server;
+	bool            m_supportRanges;
+};
+
+
+SjTestHttpServer::SjTestHttpServer(wxSocketServer* server, bool supportRanges)
+	: wxThread(wxTHREAD_JOINABLE)
+{
+	m_server = server;
+	m_supportRanges = supportRanges;
+	m_stop = FALSE;
+
+	Create();
+	Run();
+}
+
+
+void* SjTestHttpServer::Entry()
+{
+	// every connection is served by its own thread as the stream of
+	// SjInternetStream is open while the range requests are done
+	while( !m_stop )
+	{
+		if( m_server->WaitForAccept(0, 100) )
+		{
+			wxSocketBase* socket = m_server->Accept(FALSE);
+			if( socket )
+			{
+				socket->SetFlags(wxSOCKET_BLOCK|wxSOCKET_WAITALL);
+				new SjTestHttpConnection(socket, m_supportRanges);
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+static bool TestHttpRead(wxInputStream* stream, long pos, long bytes)
+{
+	unsigned char buffer[4096];
+	wxASSERT( bytes <= (long)sizeof(buffer) );
+
+	if( stream->SeekI(pos) != pos )
+	{
+		return FALSE;
+	}
+
+	stream->Read(buffer, bytes);
+	if( (long)stream->LastRead() != bytes )
+	{
+		return FALSE;
+	}
+
+	for( long i = 0; i < bytes; i++ )
+	{
+		if( buffer[i] != TestHttpByte(pos+i) )
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+
 void SjTestdrive1()
 {
 
@@ -113,6 +302,25 @@ void SjTestdrive1()
 	}
 
 
+	/* numbers read from the configuration cache should be converted as sqlite3_column_int() does
+	*/
+	{
+		static const struct { const wxChar* str; long val; } tests[] = {
+			{ wxT("12"), 12 }, { wxT(" 12 "), 12 }, { wxT("1.0"), 1 }, { wxT("-7"), -7 },
+			{ wxT("4294967295"), -1 /*negative values are written unsigned*/ }, { wxT("abc"), 0 }, { wxT(""), 0 }
+		};
+		wxSqlt sql;
+		for( size_t t = 0; t < sizeof(tests)/sizeof(tests[0]); t++ )
+		{
+			sql.ConfigWrite(wxT("testdrive/configRead"), tests[t].str);
+			if( sql.ConfigRead(wxT("testdrive/configRead"), 4711L) != tests[t].val ) {
+				wxLogWarning(wxT("Testdrive: ConfigRead() converts \"%s\" wrong"), tests[t].str);
+			}
+		}
+		sql.ConfigDeleteEntry(wxT("testdrive/configRead"));
+	}
+
+
 	/* wxURI::Unescape() does not handle a single percent sign, which is correct, however,
 	if one is a little bit lazy on paths, this may cause problems.
 	*/
@@ -505,6 +713,96 @@ void SjTestdrive1()
 
 
 
+	/* Import a small iTunes playlist; the values are assigned by the preceding <key>,
+	so the closing </key> must not forget the key (see SjPlaylist::AddFromXspfXmlWplFile()) */
+	{
+		wxString path = GetTestFilePath(wxT("testdrive-itunes.xml"));
+		{
+			wxFile f;
+			f.Create(path, TRUE);
+			f.Write(wxT("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n")
+			        wxT("<plist version=\"1.0\"><dict><key>Tracks</key><dict>\n")
+			        wxT("<key>1</key><dict>\n")
+			        wxT("    <key>Track ID</key><integer>1</integer>\n")
+			        wxT("    <key>Name</key><string>Ozone Baby</string>\n")
+			        wxT("    <key>Artist</key><string>Led Zeppelin</string>\n")
+			        wxT("    <key>Album</key><string>Coda</string>\n")
+			        wxT("    <key>Location</key><string>file://localhost/music/05%20Ozone%20Baby.mp3</string>\n")
+			        wxT("</dict>\n")
+			        wxT("<key>2</key><dict>\n")
+			        wxT("    <key>Name</key><string>Darlene</string>\n")
+			        wxT("    <key>Location</key><string>file://localhost/music/06%20Darlene.mp3</string>\n")
+			        wxT("</dict>\n")
+			        wxT("</dict></dict></plist>\n"), wxConvUTF8);
+		}
+
+		SjPlaylist playlist;
+		playlist.AddFromFile(path);
+		if( playlist.GetCount() != 2 )
+		{
+			wxLogWarning(wxT("Testdrive: %i tracks imported from the iTunes playlist %s, 2 expected."), (int)playlist.GetCount(), path.c_str());
+		}
+		::wxRemoveFile(path);
+	}
+
+
+
+	/* Test the HTTP range requests of SjInternetStream (see fs_inet.cpp) against a
+	loopback server: reads far behind the buffered data should be done by range
+	requests if the server supports them, and by reading sequentially otherwise;
+	in both cases, the data must be correct.  */
+	{
+		for( int supportRanges = 1; supportRanges >= 0; supportRanges-- )
+		{
+			wxIPV4address addr;
+			addr.LocalHost();
+			addr.Service(0);
+			wxSocketServer server(addr, wxSOCKET_BLOCK|wxSOCKET_REUSEADDR);
+			if( !server.IsOk() || !server.GetLocal(addr) )
+			{
+				wxLogWarning(wxT("Testdrive: Cannot create the loopback HTTP server."));
+				break;
+			}
+
+			SjTestHttpConnection::s_rangeRequests = 0;
+			SjTestHttpServer* serverThread = new SjTestHttpServer(&server, supportRanges!=0);
+
+			// the name is unique as completely read files are added to the cache
+			wxString url = wxString::Format(wxT("http://127.0.0.1:%i/testdrive%lu.bin"), (int)addr.Service(), (unsigned long)SjTools::GetMsTicks());
+			wxFileSystem fs;
+			wxFSFile* fsFile = fs.OpenFile(url, wxFS_READ|wxFS_SEEKABLE);
+			if( fsFile && fsFile->GetStream() )
+			{
+				wxInputStream* stream = fsFile->GetStream();
+				if( !TestHttpRead(stream, TEST_HTTP_BYTES-0x18000L, 4096)   // 96K before the end, far behind the buffered data
+				 || !TestHttpRead(stream, TEST_HTTP_BYTES-4096, 4096)       // the last bytes
+				 || !TestHttpRead(stream, 0, 4096) )                        // back to the beginning
+				{
+					wxLogWarning(wxT("Testdrive: Bad data read from %s (ranges %s)."), url.c_str(), supportRanges? wxT("supported") : wxT("unsupported"));
+				}
+				delete fsFile;
+			}
+			else
+			{
+				wxLogWarning(wxT("Testdrive: Cannot open %s."), url.c_str());
+			}
+
+			serverThread->m_stop = TRUE;
+			serverThread->Wait();
+			delete serverThread;
+
+			SjTestHttpConnection::s_critical.Enter();
+			long rangeRequests = SjTestHttpConnection::s_rangeRequests;
+			SjTestHttpConnection::s_critical.Leave();
+			if( supportRanges && rangeRequests == 0 )
+			{
+				wxLogWarning(wxT("Testdrive: No HTTP range requests used for %s."), url.c_str());
+			}
+		}
+	}
+
+
+
 	/* Scripting tests */
 	#if SJ_USE_SCRIPTS
 	if( g_debug&0x04 )
@@ -531,6 +829,14 @@ void SjTestdrive1()
 			wxLogWarning(wxT("Testdrive: SjSee::Execute(\"function test ...\") failed"));
 		}
 
+		// the second call uses the cached function object
+		see.Execute(wxT("dyncnt=0;"));
+		see.ExecuteAsFunction(wxT("dyncnt++; return dyncnt;"));
+		see.ExecuteAsFunction(wxT("dyncnt++; return dyncnt;"));
+		if( see.GetResultLong() != 2 ) {
+			wxLogWarning(wxT("Testdrive: SjSee::ExecuteAsFunction() failed"));
+		}
+
 		see.Execute("program.version");
 		wxASSERT( see.GetResultLong() == ((SJ_VERSION_MAJOR<<24)|(SJ_VERSION_MINOR<<16)|(SJ_VERSION_REVISION<<8)) );
 
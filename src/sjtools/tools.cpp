@@ -55,6 +55,7 @@
 #include <wx/fileconf.h>
 #if wxCHECK_VERSION(2, 9, 2)
 #include <wx/numformatter.h>
+#include <wx/mstream.h>
 #endif
 #include <sjtools/tools.h>
 #include <sjtools/csv_tokenizer.h>
@@ -179,7 +180,10 @@ SjTools::SjTools()
 
 	// misc
 	InitCrashPrecaution(); // relies on the search paths, ini and temp. files
-	LoadStaticObjects();
+	if( wxTheApp->IsGUI() )
+	{
+		LoadStaticObjects(); // not for the benchmark program, it has no display
+	}
 	InitExplore();
 	m_uptime.StartWatching();
 }
@@ -3405,6 +3409,232 @@ wxChar* SjLineTokenizer::GetNextLine(bool trimAtBeg)
 }
 
 
+/*******************************************************************************
+ * SjStreamTokenizer Class
+ ******************************************************************************/
+
+
+#define SJ_STREAMTOKENIZER_BLOCK_BYTES 0x10000 // 64 KB
+
+
+SjStreamTokenizer::SjStreamTokenizer(wxInputStream* stream, wxMBConv* mbConv)
+{
+	m_stream        = stream;
+	m_mbConv        = mbConv;
+	m_bufStart      = 0;
+	m_bufEnd        = 0;
+	m_bufAllocated  = SJ_STREAMTOKENIZER_BLOCK_BYTES;
+	m_buf           = (char*)malloc(m_bufAllocated);
+	m_eof           = (m_buf == NULL || m_stream == NULL);
+	m_bomChecked    = false;
+}
+
+
+SjStreamTokenizer::~SjStreamTokenizer()
+{
+	if( m_buf ) free(m_buf);
+}
+
+
+bool SjStreamTokenizer::Fill()
+{
+	// read the next block behind the unused data; returns false if there is no more data
+	if( m_eof )
+	{
+		return false;
+	}
+
+	if( m_bufStart > 0 )
+	{
+		memmove(m_buf, m_buf+m_bufStart, m_bufEnd-m_bufStart);
+		m_bufEnd -= m_bufStart;
+		m_bufStart = 0;
+	}
+
+	if( m_bufAllocated - m_bufEnd < SJ_STREAMTOKENIZER_BLOCK_BYTES )
+	{
+		// a very long line or tag, grow the buffer
+		char* newBuf = (char*)realloc(m_buf, m_bufAllocated*2);
+		if( newBuf == NULL )
+		{
+			m_eof = true;
+			return false;
+		}
+		m_buf = newBuf;
+		m_bufAllocated *= 2;
+	}
+
+	m_stream->Read(m_buf+m_bufEnd, m_bufAllocated-m_bufEnd);
+	size_t bytesRead = m_stream->LastRead();
+	if( bytesRead == 0 )
+	{
+		m_eof = true;
+		return false;
+	}
+	m_bufEnd += bytesRead;
+
+	if( !m_bomChecked && m_bufEnd >= 3 )
+	{
+		m_bomChecked = true;
+		const unsigned char* b = (const unsigned char*)m_buf;
+		if( b[0]==0xEF && b[1]==0xBB && b[2]==0xBF )
+		{
+			// UTF-8 BOM (Byte order mark) detected: Remove the mark and force UTF-8 decoding
+			m_bufStart = 3;
+			m_mbConv = &wxConvUTF8;
+		}
+		#if wxUSE_UNICODE
+		else if( (b[0]==0xFF && b[1]==0xFE) || (b[0]==0xFE && b[1]==0xFF) )
+		{
+			// UTF-16 cannot be split at single bytes; these files are rare and small,
+			// read them completely and continue with their UTF-8 representation.
+			wxMemoryOutputStream mem;
+			mem.Write(m_buf, m_bufEnd);
+			mem.Write(*m_stream);
+
+			SjByteVector v((const unsigned char*)mem.GetOutputStreamBuffer()->GetBufferStart(), mem.GetSize());
+			const wxCharBuffer utf8 = v.toString(SJ_UTF16).utf8_str();
+			size_t utf8Bytes = strlen(utf8.data());
+
+			free(m_buf);
+			m_bufAllocated = utf8Bytes+1;
+			m_buf = (char*)malloc(m_bufAllocated);
+			if( m_buf == NULL )
+			{
+				m_bufStart = m_bufEnd = m_bufAllocated = 0;
+				m_eof = true;
+				return false;
+			}
+			memcpy(m_buf, utf8.data(), utf8Bytes);
+			m_bufStart = 0;
+			m_bufEnd = utf8Bytes;
+			m_mbConv = &wxConvUTF8;
+			m_eof = true; // everything is in the buffer
+		}
+		#endif
+	}
+
+	return true;
+}
+
+
+bool SjStreamTokenizer::Find(char c1, char c2, size_t& pos)
+{
+	// find c1 or c2 at or after pos (relative to m_bufStart), read more data as needed;
+	// if the characters are not found, pos is set to the end of the data and false is returned.
+	while( 1 )
+	{
+		const char* p = m_buf + m_bufStart + pos, *end = m_buf + m_bufEnd;
+		if( c1 == c2 )
+		{
+			p = (const char*)memchr(p, c1, end-p);
+			if( p )
+			{
+				pos = p - (m_buf + m_bufStart);
+				return true;
+			}
+		}
+		else
+		{
+			while( p < end )
+			{
+				if( *p == c1 || *p == c2 )
+				{
+					pos = p - (m_buf + m_bufStart);
+					return true;
+				}
+				p++;
+			}
+		}
+
+		pos = m_bufEnd - m_bufStart;
+		if( !Fill() )
+		{
+			return false;
+		}
+	}
+}
+
+
+wxString SjStreamTokenizer::Decode(const char* p, size_t bytes, bool trim, bool removeLineEnds)
+{
+	if( trim )
+	{
+		while( bytes > 0 && (*p == ' ' || *p == '\t') ) { p++; bytes--; }
+		while( bytes > 0 && (p[bytes-1] == ' ' || p[bytes-1] == '\t') ) { bytes--; }
+	}
+
+	if( bytes == 0 )
+	{
+		return wxEmptyString;
+	}
+
+	wxString ret(p, *m_mbConv, bytes);
+	if( ret.IsEmpty() )
+	{
+		// corrupted UTF-8? try again with Latin-1/ISO8859-1
+		ret = wxString(p, wxConvISO8859_1, bytes);
+	}
+
+	if( removeLineEnds && (memchr(p, '\n', bytes) || memchr(p, '\r', bytes)) )
+	{
+		ret.Replace(wxT("\n"), wxT(""));
+		ret.Replace(wxT("\r"), wxT(""));
+		if( trim )
+		{
+			ret.Trim(TRUE);
+			ret.Trim(FALSE);
+		}
+	}
+
+	return ret;
+}
+
+
+bool SjStreamTokenizer::GetNextLine(wxString& line)
+{
+	if( m_bufStart == m_bufEnd && !Fill() )
+	{
+		return false; // no more lines
+	}
+
+	size_t lineEnd = 0;
+	bool found = Find('\n', '\r', lineEnd);
+
+	line = Decode(m_buf+m_bufStart, lineEnd, true, false);
+
+	m_bufStart += lineEnd + (found? 1 : 0);
+	return true;
+}
+
+
+bool SjStreamTokenizer::GetNextTag(wxString& tag, wxString& text)
+{
+	// skip everything up to the next "<"
+	size_t pos = 0;
+	if( !Find('<', '<', pos) )
+	{
+		m_bufStart = m_bufEnd;
+		return false; // no more tags
+	}
+	m_bufStart += pos + 1;
+
+	// the tag
+	pos = 0;
+	bool found = Find('>', '>', pos);
+	tag = Decode(m_buf+m_bufStart, pos, true, true);
+	m_bufStart += pos + (found? 1 : 0);
+
+	// the text up to the next tag, the "<" is not consumed
+	pos = 0;
+	Find('<', '<', pos);
+	text = Decode(m_buf+m_bufStart, pos, true, true);
+	m_bufStart += pos;
+
+	return true;
+}
+
+
 void SjCfgTokenizer::AddFromString(const wxString& content__)
 {
 	wxString content(content__);
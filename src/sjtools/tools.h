@@ -872,6 +872,47 @@ private:
 };
 
 
+
+/*******************************************************************************
+ *  SjStreamTokenizer Class
+ ******************************************************************************/
+
+
+class SjStreamTokenizer
+{
+public:
+	// SjStreamTokenizer reads the stream in blocks and returns lines or tags
+	// one after another, so even large files are read with little memory.
+	// the stream is not owned by the tokenizer.  mbConv is used unless there
+	// is a BOM (Byte order mark); if decoding fails, Latin-1 is used.
+	                SjStreamTokenizer   (wxInputStream*, wxMBConv* mbConv);
+	                ~SjStreamTokenizer  ();
+
+	// get the next line, "\n" and "\r" are treated as line ends, so there may be
+	// empty lines; the line is trimmed by " " and "\t".  false is returned if
+	// there are no more lines.
+	bool            GetNextLine         (wxString& line);
+
+	// get the next XML tag without "<" and ">" and the text following the tag
+	// up to the next tag.  the text is trimmed and line ends are removed;
+	// entities are not decoded.  false is returned if there are no more tags.
+	bool            GetNextTag          (wxString& tag, wxString& text);
+
+private:
+	wxInputStream*  m_stream;
+	wxMBConv*       m_mbConv;
+	char*           m_buf;
+	size_t          m_bufStart;
+	size_t          m_bufEnd;
+	size_t          m_bufAllocated;
+	bool            m_eof;
+	bool            m_bomChecked;
+	bool            Fill                ();
+	bool            Find                (char c1, char c2, size_t& pos);
+	wxString        Decode              (const char* p, size_t bytes, bool trim, bool removeLineEnds);
+};
+
+
 class SjCfgTokenizer
 {
 public: